@@ -0,0 +1,67 @@
+#include "ast.h"
+
+#include <string.h>
+
+#define NODE_SIZE(member) (offsetof(Node, as) + sizeof(((Node*)0)->as.member))
+
+size_t node_size(NodeType type) {
+    switch (type) {
+    case NODE_PROGRAM:              return NODE_SIZE(program);
+    case NODE_IMPORT_DECL:          return NODE_SIZE(import_decl);
+    case NODE_CONST_DECL:           return NODE_SIZE(const_decl);
+    case NODE_VAR_DECL:             return NODE_SIZE(var_decl);
+    case NODE_FUNC_DECL:            return NODE_SIZE(func_decl);
+    case NODE_STRUCT_DECL:          return NODE_SIZE(struct_decl);
+    case NODE_INTERFACE_DECL:       return NODE_SIZE(interface_decl);
+    case NODE_ENUM_DECL:            return NODE_SIZE(enum_decl);
+    case NODE_RETURN_STMT:          return NODE_SIZE(return_stmt);
+    case NODE_IF_STMT:              return NODE_SIZE(if_stmt);
+    case NODE_FOR_STMT:             return NODE_SIZE(for_stmt);
+    case NODE_WHILE_STMT:           return NODE_SIZE(while_stmt);
+    case NODE_WITH_STMT:            return NODE_SIZE(with_stmt);
+    case NODE_BREAK_STMT:           return NODE_SIZE(break_stmt);
+    case NODE_CONTINUE_STMT:        return NODE_SIZE(continue_stmt);
+    case NODE_MATCH_STMT:           return NODE_SIZE(match_stmt);
+    case NODE_ASSIGN_STMT:          return NODE_SIZE(assign_stmt);
+    case NODE_COMPOUND_ASSIGN_STMT: return NODE_SIZE(compound_assign_stmt);
+    case NODE_EXPR_STMT:            return NODE_SIZE(expr_stmt);
+    case NODE_INTEGER_LITERAL:      return NODE_SIZE(integer_literal);
+    case NODE_FLOAT_LITERAL:        return NODE_SIZE(float_literal);
+    case NODE_STRING_LITERAL:       return NODE_SIZE(string_literal);
+    case NODE_BOOL_LITERAL:         return NODE_SIZE(bool_literal);
+    case NODE_NULL_LITERAL:         return offsetof(Node, as);
+    case NODE_IDENTIFIER:           return NODE_SIZE(identifier);
+    case NODE_SELF:                 return offsetof(Node, as);
+    case NODE_BINARY_EXPR:          return NODE_SIZE(binary_expr);
+    case NODE_UNARY_EXPR:           return NODE_SIZE(unary_expr);
+    case NODE_PAREN_EXPR:           return NODE_SIZE(paren_expr);
+    case NODE_CALL_EXPR: {
+        // sema rewrites `Name()` calls into struct literals in place
+        size_t call = NODE_SIZE(call_expr);
+        size_t literal = NODE_SIZE(struct_literal);
+        return call > literal ? call : literal;
+    }
+    case NODE_FIELD_ACCESS:         return NODE_SIZE(field_access);
+    case NODE_METHOD_CALL:          return NODE_SIZE(method_call);
+    case NODE_STRUCT_LITERAL:       return NODE_SIZE(struct_literal);
+    case NODE_CAST_EXPR:            return NODE_SIZE(cast_expr);
+    case NODE_SIZEOF_EXPR:          return NODE_SIZE(sizeof_expr);
+    case NODE_ARRAY_LITERAL:        return NODE_SIZE(array_literal);
+    case NODE_INDEX_EXPR:           return NODE_SIZE(index_expr);
+    case NODE_TYPE_SIMPLE:          return NODE_SIZE(type_simple);
+    case NODE_TYPE_REFERENCE:       return NODE_SIZE(type_ref);
+    case NODE_TYPE_POINTER:         return NODE_SIZE(type_ptr);
+    case NODE_TYPE_ARRAY:           return NODE_SIZE(type_array);
+    case NODE_TYPE_SLICE:           return NODE_SIZE(type_slice);
+    }
+    return sizeof(Node);
+}
+
+Node* node_new(Arena* arena, NodeType type, SourceLoc loc) {
+    size_t size = node_size(type);
+    Node* node = arena_alloc(arena, size);
+    memset(node, 0, size);
+    node->type = type;
+    node->loc = loc;
+    return node;
+}
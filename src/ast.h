@@ -1,10 +1,12 @@
 #ifndef ANCC_AST_H
 #define ANCC_AST_H
 
+#include "intern.h"
 #include "lexer.h"
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef enum NodeType {
     // program root
@@ -63,129 +65,116 @@ typedef enum NodeType {
 
 typedef struct Node Node;
 
+// Child lists are exact-size arrays; nothing appends to them after parsing.
+
 typedef struct NodeList {
     Node** nodes;
-    size_t count;
-    size_t capacity;
+    uint32_t count;
 } NodeList;
 
 typedef struct Param {
     char* name;
     size_t name_size;
+    Atom name_atom;
     Node* type_node;
-    size_t offset;
-    size_t line;
-    size_t column;
+    SourceLoc loc;
 } Param;
 
 typedef struct ParamList {
     Param* params;
-    size_t count;
-    size_t capacity;
+    uint32_t count;
 } ParamList;
 
 typedef struct Field {
     char* name;
     size_t name_size;
+    Atom name_atom;
     Node* type_node;
-    size_t offset;
-    size_t line;
-    size_t column;
+    SourceLoc loc;
 } Field;
 
 typedef struct FieldList {
     Field* fields;
-    size_t count;
-    size_t capacity;
+    uint32_t count;
 } FieldList;
 
 typedef struct FieldInit {
     char* name;
     size_t name_size;
+    Atom name_atom;
     Node* value;
-    size_t offset;
-    size_t line;
-    size_t column;
+    SourceLoc loc;
 } FieldInit;
 
 typedef struct FieldInitList {
     FieldInit* inits;
-    size_t count;
-    size_t capacity;
+    uint32_t count;
 } FieldInitList;
 
 typedef struct ElseIfBranch {
     Node* condition;
     NodeList body;
-    size_t offset;
-    size_t line;
-    size_t column;
+    SourceLoc loc;
 } ElseIfBranch;
 
 typedef struct ElseIfList {
     ElseIfBranch* branches;
-    size_t count;
-    size_t capacity;
+    uint32_t count;
 } ElseIfList;
 
 typedef struct MatchCase {
     NodeList values;
     NodeList body;
-    size_t offset;
-    size_t line;
-    size_t column;
+    SourceLoc loc;
 } MatchCase;
 
 typedef struct MatchCaseList {
     MatchCase* cases;
-    size_t count;
-    size_t capacity;
+    uint32_t count;
 } MatchCaseList;
 
 typedef struct EnumVariant {
     char* name;
     size_t name_size;
-    size_t offset;
-    size_t line;
-    size_t column;
+    Atom name_atom;
+    SourceLoc loc;
 } EnumVariant;
 
 typedef struct EnumVariantList {
     EnumVariant* variants;
-    size_t count;
-    size_t capacity;
+    uint32_t count;
 } EnumVariantList;
 
 typedef struct TypeParam {
     char* name;
     size_t name_size;
+    Atom name_atom;
+    Node* bound; // interface after ':' that type arguments must satisfy, or NULL
 } TypeParam;
 
 typedef struct TypeParamList {
     TypeParam* params;
-    size_t count;
-    size_t capacity;
+    uint32_t count;
 } TypeParamList;
 
 typedef struct ImportName {
     char* name;
     size_t name_size;
-    size_t offset;
-    size_t line;
-    size_t column;
+    Atom name_atom;
+    SourceLoc loc;
 } ImportName;
 
 typedef struct ImportNameList {
     ImportName* names;
-    size_t count;
-    size_t capacity;
+    uint32_t count;
 } ImportNameList;
 
+// Nodes are allocated with node_new, which sizes each one for its kind:
+// only the header and the union member for that kind exist, so code must
+// never touch another kind's member or copy a Node by value.
 struct Node {
     NodeType type;
-    size_t offset;
-    size_t line;
-    size_t column;
+    SourceLoc loc;
     void* resolved_type;
 
     union {
@@ -202,6 +191,7 @@ struct Node {
             bool is_export;
             char* name;
             size_t name_size;
+            Atom name_atom;
             Node* type_node;
             Node* value;
         } const_decl;
@@ -210,6 +200,7 @@ struct Node {
             bool is_export;
             char* name;
             size_t name_size;
+            Atom name_atom;
             Node* type_node;
             Node* value;
         } var_decl;
@@ -217,27 +208,36 @@ struct Node {
         struct {
             bool is_export;
             bool is_extern;
+            bool is_reached; // instance body: needed by checked code, so checked and emitted
+            bool is_vtable_target; // a vtable slot points at it directly, so self is passed as void*
             char* name;
             size_t name_size;
+            Atom name_atom;
             TypeParamList type_params;
             ParamList params;
             Node* return_type;
             NodeList body;
+            struct LazyBody* lazy_body; // body tokens not parsed yet, see parser_func_body
             void* method_of; // Type* of struct if this is a monomorphized generic method
+            struct GenericInst* inst; // instance whose bindings the shared body is checked under
+            struct InstLayout* layout; // generic template: node numbering shared by its instances
         } func_decl;
 
         struct {
             bool is_export;
             char* name;
             size_t name_size;
+            Atom name_atom;
             TypeParamList type_params;
             FieldList fields;
             NodeList methods;
+            struct InstLayout* layout; // generic template: node numbering shared by its instances
         } struct_decl;
 
         struct {
             char* name;
             size_t name_size;
+            Atom name_atom;
             NodeList method_sigs;
         } interface_decl;
 
@@ -245,6 +245,7 @@ struct Node {
             bool is_export;
             char* name;
             size_t name_size;
+            Atom name_atom;
             EnumVariantList variants;
         } enum_decl;
 
@@ -271,10 +272,15 @@ struct Node {
         struct {
             char* var_name;
             size_t var_name_size;
+            Atom var_name_atom;
             Node* start;
             Node* end;
             Node* step;
             NodeList body;
+            // set by opt when end or step cannot change while the loop runs,
+            // so codegen may read it in the condition instead of a temporary
+            bool end_invariant;
+            bool step_invariant;
         } for_stmt;
 
         struct {
@@ -313,24 +319,27 @@ struct Node {
         struct { char* value; size_t value_size; } float_literal;
         struct { char* value; size_t value_size; } string_literal;
         struct { bool value; } bool_literal;
-        struct { char* name; size_t name_size; } identifier;
+        struct { char* name; size_t name_size; Atom name_atom; } identifier;
 
         struct { TokenType op; Node* left; Node* right; } binary_expr;
         struct { TokenType op; Node* operand; } unary_expr;
         struct { Node* inner; } paren_expr;
         struct { Node* callee; NodeList type_args; NodeList args; } call_expr;
-        struct { Node* object; char* field_name; size_t field_name_size; } field_access;
+        struct { Node* object; char* field_name; size_t field_name_size; Atom field_name_atom; } field_access;
         struct {
             Node* object;
             char* method_name;
             size_t method_name_size;
+            Atom method_name_atom;
             NodeList type_args;
             NodeList args;
             bool is_mono; // set by sema when generic method is monomorphized
+            void* known_struct; // Type* of the struct behind an interface receiver, when sema proves it
         } method_call;
         struct {
             char* struct_name;
             size_t struct_name_size;
+            Atom struct_name_atom;
             NodeList type_args;
             FieldInitList fields;
         } struct_literal;
@@ -339,7 +348,7 @@ struct Node {
         struct { NodeList elements; } array_literal;
         struct { Node* object; Node* index; } index_expr;
 
-        struct { char* name; size_t name_size; NodeList type_args; } type_simple;
+        struct { char* name; size_t name_size; Atom name_atom; NodeList type_args; } type_simple;
         struct { Node* inner; } type_ref;
         struct { Node* inner; } type_ptr;
         struct { Node* inner; Node* size_expr; } type_array;
@@ -347,4 +356,10 @@ struct Node {
     } as;
 };
 
+// Bytes needed for a node of the given kind.
+size_t node_size(NodeType type);
+
+// Zeroed node of the given kind.
+Node* node_new(Arena* arena, NodeType type, SourceLoc loc);
+
 #endif
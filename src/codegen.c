@@ -2,15 +2,31 @@
 #include "sema.h"
 #include "type.h"
 #include "lexer.h"
+#include "parser.h"
 #include "fs.h"
+#include "report.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 // ---------------------------------------------------------------------------
 // CodeGen context
 // ---------------------------------------------------------------------------
 
+// An interface and the only struct coerced to it anywhere in the program
+// (pair is NULL once a second struct shows up).
+typedef struct SoleImpl {
+    Type* interface_type;
+    ImplPair* pair;
+} SoleImpl;
+
+typedef struct SoleImplList {
+    SoleImpl* items;
+    size_t count;
+    size_t capacity;
+} SoleImplList;
+
 typedef struct CodeGen {
     Arena* arena;
     Errors* errors;
@@ -22,6 +38,11 @@ typedef struct CodeGen {
     bool in_method;
     char* struct_name;
     size_t struct_name_size;
+    GenericInst* inst; // instance whose (shared template) body is being emitted
+    Type* return_type; // of the function whose body is being emitted
+    FuncSizeList* sizes; // per-function C size, for --report; NULL when not asked for
+    SoleImplList* sole_impls;
+    DevirtStats* devirt; // interface call counts, for --report; NULL when not asked for
 } CodeGen;
 
 // ---------------------------------------------------------------------------
@@ -46,12 +67,31 @@ static void emit_method_mangled(CodeGen* gen, FILE* f,
             (int)sname_size, sname, (int)mname_size, mname);
 }
 
+// Record the C bytes written for a definition since start; sname is NULL for
+// free functions.
+static void record_func_size(CodeGen* gen, FILE* f, long start,
+                             char* sname, size_t sname_size, char* name, size_t name_size) {
+    if (!gen->sizes) return;
+    char buf[512];
+    int len = sname
+        ? snprintf(buf, sizeof(buf), "anc__%s__%s__%.*s__%.*s", gen->pkg->name, gen->mod->name,
+                   (int)sname_size, sname, (int)name_size, name)
+        : snprintf(buf, sizeof(buf), "anc__%s__%s__%.*s", gen->pkg->name, gen->mod->name,
+                   (int)name_size, name);
+    if (len >= (int)sizeof(buf)) len = (int)sizeof(buf) - 1;
+    char* c_name = arena_alloc(gen->arena, (size_t)len + 1);
+    memcpy(c_name, buf, (size_t)len + 1);
+    func_size_add(gen->sizes, c_name, gen->mod, gen->inst, (size_t)(ftell(f) - start));
+}
+
 // Emit mangled interface name: anc__{pkg}__{mod}__{InterfaceName}
 static void emit_iface_mangled(CodeGen* gen, FILE* f, Type* iface) {
     fprintf(f, "anc__%s__%s__%.*s", gen->pkg->name, gen->mod->name,
             (int)iface->as.interface_type.name_size, iface->as.interface_type.name);
 }
 
+static void emit_slice_suffix(CodeGen* gen, FILE* f, Type* element);
+
 static void emit_type(CodeGen* gen, FILE* f, Type* type) {
     if (!type) { fprintf(f, "void"); return; }
 
@@ -104,7 +144,8 @@ static void emit_type(CodeGen* gen, FILE* f, Type* type) {
         emit_type(gen, f, type->as.array_type.element);
         break;
     case TYPE_SLICE:
-        fprintf(f, "anc__slice");
+        fprintf(f, "anc__slice__");
+        emit_slice_suffix(gen, f, type->as.slice_type.element);
         break;
     case TYPE_ENUM: {
         Module* saved = gen->mod;
@@ -118,12 +159,51 @@ static void emit_type(CodeGen* gen, FILE* f, Type* type) {
     }
 }
 
-// Get the resolved type from a type node, falling back to resolved_type on the node
-static Type* get_type(Node* node) {
+// Each slice type is a C struct of its own, anc__slice__<element>, holding a
+// typed element pointer; the suffix spells the element's C type.
+static void emit_slice_suffix(CodeGen* gen, FILE* f, Type* element) {
+    switch (element->kind) {
+    case TYPE_REF:
+        emit_slice_suffix(gen, f, element->as.ref_type.inner);
+        // an interface ref is its own struct, not a pointer
+        if (element->as.ref_type.inner->kind != TYPE_INTERFACE) fprintf(f, "_ref");
+        break;
+    case TYPE_PTR:
+        emit_slice_suffix(gen, f, element->as.ptr_type.inner);
+        fprintf(f, "_ptr");
+        break;
+    case TYPE_ARRAY:
+        emit_slice_suffix(gen, f, element->as.array_type.element);
+        fprintf(f, "_%d", element->as.array_type.size);
+        break;
+    case TYPE_SLICE:
+        emit_slice_suffix(gen, f, element->as.slice_type.element);
+        fprintf(f, "_slice");
+        break;
+    default:
+        emit_type(gen, f, element);
+        break;
+    }
+}
+
+// Get the resolved type of a node: from the instance's side table inside a
+// generic instance's body, falling back to resolved_type on the node
+static Type* get_type(CodeGen* gen, Node* node) {
     if (!node) return NULL;
+    if (gen->inst) {
+        Type* t = generic_inst_type(gen->inst, node);
+        if (t) return t;
+    }
     return (Type*)node->resolved_type;
 }
 
+// Generic instance a call, method call or struct literal in the current
+// instance's body resolved to, or NULL.
+static GenericInst* get_target(CodeGen* gen, Node* node) {
+    if (!gen->inst) return NULL;
+    return generic_inst_target(gen->inst, node);
+}
+
 // ---------------------------------------------------------------------------
 // Forward declarations
 // ---------------------------------------------------------------------------
@@ -132,6 +212,148 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node);
 static void emit_stmt(CodeGen* gen, FILE* f, Node* node);
 static void emit_body(CodeGen* gen, FILE* f, NodeList* body);
 
+// Emit expr where a value of type target is expected: an array stored or
+// passed as a slice becomes a slice over its elements.
+static void emit_converted(CodeGen* gen, FILE* f, Node* expr, Type* target) {
+    Type* type = get_type(gen, expr);
+    if (target && target->kind == TYPE_SLICE && type && type->kind == TYPE_ARRAY) {
+        fprintf(f, "(");
+        emit_type(gen, f, target);
+        fprintf(f, "){ .ptr = ");
+        emit_expr(gen, f, expr);
+        fprintf(f, ", .len = %d }", type->as.array_type.size);
+        return;
+    }
+    emit_expr(gen, f, expr);
+}
+
+// ---------------------------------------------------------------------------
+// Devirtualization
+// ---------------------------------------------------------------------------
+
+static SoleImpl* sole_impl_find(SoleImplList* list, Type* iface) {
+    for (size_t i = 0; i < list->count; i++) {
+        if (list->items[i].interface_type == iface) return &list->items[i];
+    }
+    return NULL;
+}
+
+static void sole_impls_build(Arena* arena, SoleImplList* list, ModuleGraph* graph) {
+    for (Module* mod = graph->first; mod; mod = mod->next) {
+        for (size_t i = 0; i < mod->impl_pairs.count; i++) {
+            ImplPair* pair = &mod->impl_pairs.pairs[i];
+            SoleImpl* entry = sole_impl_find(list, pair->interface_type);
+            if (entry) {
+                if (entry->pair && entry->pair->struct_type != pair->struct_type) entry->pair = NULL;
+                continue;
+            }
+            if (list->count >= list->capacity) {
+                size_t capacity = list->capacity ? list->capacity * 2 : 16;
+                SoleImpl* items = arena_alloc(arena, sizeof(SoleImpl) * capacity);
+                if (list->count) memcpy(items, list->items, sizeof(SoleImpl) * list->count);
+                list->items = items;
+                list->capacity = capacity;
+            }
+            entry = &list->items[list->count++];
+            entry->interface_type = pair->interface_type;
+            entry->pair = pair;
+        }
+    }
+}
+
+// The current module can name the pair's struct methods if it already emits
+// the pair's vtable wrappers, defines the struct, or imports it exported.
+static bool pair_methods_visible(CodeGen* gen, ImplPair* pair) {
+    ImplPairList* own = &gen->mod->impl_pairs;
+    for (size_t i = 0; i < own->count; i++) {
+        if (own->pairs[i].struct_type == pair->struct_type) return true;
+    }
+    if (pair->struct_module == gen->mod) return true;
+
+    Type* st = pair->struct_type;
+    Symbol* sym = symbol_find(pair->struct_module->symbols,
+                              st->as.struct_type.name, st->as.struct_type.name_size);
+    if (!sym || !sym->is_export) return false;
+
+    if (!gen->mod->ast || gen->mod->ast->type != NODE_PROGRAM) return false;
+    NodeList* decls = &gen->mod->ast->as.program.declarations;
+    for (size_t i = 0; i < decls->count; i++) {
+        Node* node = decls->nodes[i];
+        if (node->type != NODE_IMPORT_DECL) continue;
+        ImportNameList* names = &node->as.import_decl.names;
+        if (names->count == 0) continue;
+        Symbol* imported = symbol_find_atom(gen->mod->symbols, names->names[0].name_atom);
+        if (imported && imported->kind == SYMBOL_IMPORT && imported->source == pair->struct_module) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Emit an interface method call as a direct call to the struct method when
+// the struct behind the receiver is known: sema proved it for this call, or
+// it is the interface's only implementation. Returns false to fall back to
+// the vtable.
+static bool emit_direct_iface_call(CodeGen* gen, FILE* f, Node* node, Type* iface) {
+    ImplPair* pair = NULL;
+    bool known = false;
+
+    Type* known_struct = gen->inst ? NULL : node->as.method_call.known_struct;
+    if (known_struct) {
+        ImplPairList* own = &gen->mod->impl_pairs;
+        for (size_t i = 0; i < own->count; i++) {
+            if (own->pairs[i].struct_type == known_struct &&
+                own->pairs[i].interface_type == iface) {
+                pair = &own->pairs[i];
+                known = true;
+                break;
+            }
+        }
+    }
+    if (!pair) {
+        SoleImpl* sole = sole_impl_find(gen->sole_impls, iface);
+        if (sole && sole->pair && pair_methods_visible(gen, sole->pair)) pair = sole->pair;
+    }
+    if (!pair) return false;
+
+    Node* method = NULL;
+    NodeList* sigs = iface->as.interface_type.method_sigs;
+    for (size_t i = 0; i < sigs->count; i++) {
+        Node* sig = sigs->nodes[i];
+        if (sig->type == NODE_FUNC_DECL &&
+            sig->as.func_decl.name_atom == node->as.method_call.method_name_atom) {
+            method = pair->methods[i];
+            break;
+        }
+    }
+    if (!method) return false;
+
+    // Struct::method((Struct*)obj.data, args...)
+    Type* st = pair->struct_type;
+    Module* saved = gen->mod;
+    gen->mod = pair->struct_module;
+    emit_method_mangled(gen, f, st->as.struct_type.name, st->as.struct_type.name_size,
+                        method->as.func_decl.name, method->as.func_decl.name_size);
+    fprintf(f, "((");
+    emit_mangled(gen, f, st->as.struct_type.name, st->as.struct_type.name_size);
+    gen->mod = saved;
+    fprintf(f, "*)");
+    emit_expr(gen, f, node->as.method_call.object);
+    fprintf(f, ".data");
+    NodeList* args = &node->as.method_call.args;
+    for (size_t i = 0; i < args->count; i++) {
+        fprintf(f, ", ");
+        emit_expr(gen, f, args->nodes[i]);
+    }
+    fprintf(f, ")");
+
+    if (gen->devirt) {
+        if (known) gen->devirt->known_receiver++;
+        else gen->devirt->sole_impl++;
+    }
+    return true;
+}
+
 // ---------------------------------------------------------------------------
 // Expression emitter
 // ---------------------------------------------------------------------------
@@ -171,9 +393,16 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
     case NODE_IDENTIFIER: {
         char* name = node->as.identifier.name;
         size_t name_size = node->as.identifier.name_size;
+        Atom name_atom = node->as.identifier.name_atom;
+        GenericInst* target = get_target(gen, node);
+        if (target) {
+            name = target->mangled_name;
+            name_size = target->mangled_name_size;
+            name_atom = target->mangled_name_atom;
+        }
 
         // check if this is a module-level symbol (needs mangling)
-        Symbol* sym = symbol_find(gen->mod->symbols, name, name_size);
+        Symbol* sym = symbol_find_atom(gen->mod->symbols, name_atom);
         if (sym && sym->kind == SYMBOL_FUNC && sym->node &&
             sym->node->as.func_decl.is_extern) {
             // extern function — emit raw name
@@ -247,7 +476,7 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
     case NODE_CALL_EXPR: {
         // get the callee's function type to check for interface params
         Node* callee = node->as.call_expr.callee;
-        Type* callee_type = get_type(callee);
+        Type* callee_type = get_type(gen, callee);
 
         emit_expr(gen, f, callee);
         fprintf(f, "(");
@@ -256,7 +485,7 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
             if (i > 0) fprintf(f, ", ");
 
             // check if this arg needs fat pointer wrapping
-            Type* arg_type = get_type(args->nodes[i]);
+            Type* arg_type = get_type(gen, args->nodes[i]);
             Type* param_type = NULL;
             if (callee_type && callee_type->kind == TYPE_FUNC &&
                 (int)i < callee_type->as.func_type.param_count) {
@@ -296,7 +525,7 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
                         (int)param_iface->as.interface_type.name_size,
                         param_iface->as.interface_type.name);
             } else {
-                emit_expr(gen, f, args->nodes[i]);
+                emit_converted(gen, f, args->nodes[i], param_type);
             }
         }
         fprintf(f, ")");
@@ -304,7 +533,7 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
     }
 
     case NODE_FIELD_ACCESS: {
-        Type* obj_type = get_type(node->as.field_access.object);
+        Type* obj_type = get_type(gen, node->as.field_access.object);
         char* fname = node->as.field_access.field_name;
         size_t fname_size = node->as.field_access.field_name_size;
 
@@ -322,26 +551,18 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
 
         // array .len -> compile-time constant, .ptr -> array decays to pointer
         if (obj_type && obj_type->kind == TYPE_ARRAY) {
-            if (fname_size == 3 && memcmp(fname, "len", 3) == 0) {
+            if (node->as.field_access.field_name_atom == ATOM_LEN) {
                 fprintf(f, "%d", obj_type->as.array_type.size);
-            } else if (fname_size == 3 && memcmp(fname, "ptr", 3) == 0) {
+            } else if (node->as.field_access.field_name_atom == ATOM_PTR) {
                 emit_expr(gen, f, node->as.field_access.object);
             }
             break;
         }
 
-        // slice .len -> struct field, .ptr -> cast from void*
+        // slice .len and .ptr -> struct fields
         if (obj_type && obj_type->kind == TYPE_SLICE) {
-            if (fname_size == 3 && memcmp(fname, "ptr", 3) == 0) {
-                fprintf(f, "(");
-                emit_type(gen, f, obj_type->as.slice_type.element);
-                fprintf(f, "*)");
-                emit_expr(gen, f, node->as.field_access.object);
-                fprintf(f, ".ptr");
-            } else {
-                emit_expr(gen, f, node->as.field_access.object);
-                fprintf(f, ".%.*s", (int)fname_size, fname);
-            }
+            emit_expr(gen, f, node->as.field_access.object);
+            fprintf(f, ".%.*s", (int)fname_size, fname);
             break;
         }
 
@@ -355,8 +576,18 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
 
     case NODE_METHOD_CALL: {
         Node* object = node->as.method_call.object;
-        Type* obj_type = get_type(object);
+        Type* obj_type = get_type(gen, object);
         Type* inner_type = NULL;
+        char* method_name = node->as.method_call.method_name;
+        size_t method_name_size = node->as.method_call.method_name_size;
+        bool is_mono = node->as.method_call.is_mono;
+        GenericInst* target = get_target(gen, node);
+        if (target) {
+            // monomorphized for the generic instance being emitted
+            method_name = target->mangled_name;
+            method_name_size = target->mangled_name_size;
+            is_mono = true;
+        }
 
         if (obj_type) {
             if (obj_type->kind == TYPE_STRUCT || obj_type->kind == TYPE_INTERFACE)
@@ -365,10 +596,9 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
             else if (obj_type->kind == TYPE_PTR) inner_type = obj_type->as.ptr_type.inner;
         }
 
-        if (node->as.method_call.is_mono) {
+        if (is_mono) {
             // monomorphized generic method — emit as standalone function call
-            emit_mangled(gen, f, node->as.method_call.method_name,
-                         node->as.method_call.method_name_size);
+            emit_mangled(gen, f, method_name, method_name_size);
             fprintf(f, "(");
             bool is_ptr = obj_type && (obj_type->kind == TYPE_REF || obj_type->kind == TYPE_PTR);
             if (!is_ptr) fprintf(f, "&");
@@ -380,6 +610,9 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
             }
             fprintf(f, ")");
         } else if (inner_type && inner_type->kind == TYPE_INTERFACE) {
+            if (gen->devirt) gen->devirt->interface_calls++;
+            if (emit_direct_iface_call(gen, f, node, inner_type)) break;
+
             // vtable dispatch: obj.vtable->method(obj.data, args...)
             emit_expr(gen, f, object);
             fprintf(f, ".vtable->%.*s(",
@@ -428,6 +661,11 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
     case NODE_STRUCT_LITERAL: {
         char* name = node->as.struct_literal.struct_name;
         size_t name_size = node->as.struct_literal.struct_name_size;
+        GenericInst* target = get_target(gen, node);
+        if (target) {
+            name = target->mangled_name;
+            name_size = target->mangled_name_size;
+        }
 
         fprintf(f, "(");
         emit_mangled(gen, f, name, name_size);
@@ -436,7 +674,7 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
         FieldInitList* inits = &node->as.struct_literal.fields;
         if (inits->count == 0) {
             // Only emit 0 if struct has fields (zero-init); skip for empty structs
-            Type* st = get_type(node);
+            Type* st = get_type(gen, node);
             if (st && st->kind == TYPE_STRUCT && st->as.struct_type.fields->count > 0) {
                 fprintf(f, "0");
             }
@@ -451,8 +689,8 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
     }
 
     case NODE_CAST_EXPR: {
-        Type* target = node->as.cast_expr.target_type->resolved_type;
-        Type* source = get_type(node->as.cast_expr.expr);
+        Type* target = get_type(gen, node->as.cast_expr.target_type);
+        Type* source = get_type(gen, node->as.cast_expr.expr);
         // &Interface -> &Struct: extract .data pointer and cast
         bool iface_to_struct = false;
         if (source && target &&
@@ -475,7 +713,7 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
     }
 
     case NODE_SIZEOF_EXPR: {
-        Type* t = node->as.sizeof_expr.type_node->resolved_type;
+        Type* t = get_type(gen, node->as.sizeof_expr.type_node);
         fprintf(f, "sizeof(");
         emit_type(gen, f, t);
         fprintf(f, ")");
@@ -494,14 +732,11 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
     }
 
     case NODE_INDEX_EXPR: {
-        Type* obj_type = get_type(node->as.index_expr.object);
+        Type* obj_type = get_type(gen, node->as.index_expr.object);
         if (obj_type && obj_type->kind == TYPE_SLICE) {
-            // ((element_type*)slice.ptr)[index]
-            fprintf(f, "((");
-            emit_type(gen, f, obj_type->as.slice_type.element);
-            fprintf(f, "*)");
+            // slice.ptr[index]
             emit_expr(gen, f, node->as.index_expr.object);
-            fprintf(f, ".ptr)[");
+            fprintf(f, ".ptr[");
             emit_expr(gen, f, node->as.index_expr.index);
             fprintf(f, "]");
         } else {
@@ -524,14 +759,20 @@ static void emit_expr(CodeGen* gen, FILE* f, Node* node) {
 // Statement emitter
 // ---------------------------------------------------------------------------
 
+// An integer literal, negative ones inside their parentheses.
+static bool is_int_literal(Node* node) {
+    if (node->type == NODE_PAREN_EXPR) node = node->as.paren_expr.inner;
+    return node->type == NODE_INTEGER_LITERAL;
+}
+
 static void emit_stmt(CodeGen* gen, FILE* f, Node* node) {
     if (!node) return;
 
     switch (node->type) {
 
     case NODE_VAR_DECL: {
-        Type* var_type = get_type(node);
-        Type* init_type = node->as.var_decl.value ? get_type(node->as.var_decl.value) : NULL;
+        Type* var_type = get_type(gen, node);
+        Type* init_type = node->as.var_decl.value ? get_type(gen, node->as.var_decl.value) : NULL;
 
         // array variable: element_type name[size] = { ... } or memcpy
         if (var_type && var_type->kind == TYPE_ARRAY) {
@@ -561,17 +802,6 @@ static void emit_stmt(CodeGen* gen, FILE* f, Node* node) {
             break;
         }
 
-        // slice from array: anc__slice name = (anc__slice){ .ptr = expr, .len = N }
-        if (var_type && var_type->kind == TYPE_SLICE &&
-            init_type && init_type->kind == TYPE_ARRAY) {
-            emit_indent(gen, f);
-            fprintf(f, "anc__slice %.*s = (anc__slice){ .ptr = ",
-                    (int)node->as.var_decl.name_size, node->as.var_decl.name);
-            emit_expr(gen, f, node->as.var_decl.value);
-            fprintf(f, ", .len = %d };\n", init_type->as.array_type.size);
-            break;
-        }
-
         emit_indent(gen, f);
         emit_type(gen, f, var_type);
         fprintf(f, " %.*s", (int)node->as.var_decl.name_size, node->as.var_decl.name);
@@ -605,7 +835,7 @@ static void emit_stmt(CodeGen* gen, FILE* f, Node* node) {
                         (int)decl_iface->as.interface_type.name_size,
                         decl_iface->as.interface_type.name);
             } else {
-                emit_expr(gen, f, node->as.var_decl.value);
+                emit_converted(gen, f, node->as.var_decl.value, var_type);
             }
         }
         fprintf(f, ";\n");
@@ -613,7 +843,7 @@ static void emit_stmt(CodeGen* gen, FILE* f, Node* node) {
     }
 
     case NODE_CONST_DECL: {
-        Type* const_type = get_type(node);
+        Type* const_type = get_type(gen, node);
         emit_indent(gen, f);
         fprintf(f, "const ");
         emit_type(gen, f, const_type);
@@ -631,9 +861,9 @@ static void emit_stmt(CodeGen* gen, FILE* f, Node* node) {
             if (node->as.return_stmt.value) {
                 // Evaluate return value before cleanup
                 emit_indent(gen, f);
-                emit_type(gen, f, node->resolved_type);
+                emit_type(gen, f, get_type(gen, node));
                 fprintf(f, " __with_ret = ");
-                emit_expr(gen, f, node->as.return_stmt.value);
+                emit_converted(gen, f, node->as.return_stmt.value, gen->return_type);
                 fprintf(f, ";\n");
                 // Emit cleanup calls
                 for (size_t i = 0; i < node->as.return_stmt.cleanup.count; i++) {
@@ -657,7 +887,7 @@ static void emit_stmt(CodeGen* gen, FILE* f, Node* node) {
             emit_indent(gen, f);
             if (node->as.return_stmt.value) {
                 fprintf(f, "return ");
-                emit_expr(gen, f, node->as.return_stmt.value);
+                emit_converted(gen, f, node->as.return_stmt.value, gen->return_type);
                 fprintf(f, ";\n");
             } else {
                 fprintf(f, "return;\n");
@@ -699,19 +929,68 @@ static void emit_stmt(CodeGen* gen, FILE* f, Node* node) {
     }
 
     case NODE_FOR_STMT: {
-        Type* iter_type = get_type(node->as.for_stmt.start);
-        if (!iter_type) iter_type = get_type(node);
+        Type* iter_type = get_type(gen, node->as.for_stmt.start);
+        if (!iter_type) iter_type = get_type(gen, node);
+        int name_size = (int)node->as.for_stmt.var_name_size;
+        char* name = node->as.for_stmt.var_name;
+        Node* start = node->as.for_stmt.start;
+        Node* end = node->as.for_stmt.end;
+        Node* step = node->as.for_stmt.step;
+
+        // end and step are evaluated once, before the first iteration: any
+        // bound opt did not prove invariant (opt skips generic bodies) goes
+        // to a temporary of its own type, so the comparison stays the one C
+        // makes, with start first to keep the evaluation order
+        bool hoist_end = !node->as.for_stmt.end_invariant && !is_int_literal(end);
+        bool hoist_step = step && !node->as.for_stmt.step_invariant && !is_int_literal(step);
+        bool hoist_start = (hoist_end || hoist_step) && !is_int_literal(start);
+        if (hoist_end || hoist_step) {
+            emit_indent(gen, f);
+            fprintf(f, "{\n");
+            gen->indent++;
+        }
+        if (hoist_start) {
+            emit_indent(gen, f);
+            emit_type(gen, f, iter_type);
+            fprintf(f, " %.*s__start = ", name_size, name);
+            emit_expr(gen, f, start);
+            fprintf(f, ";\n");
+        }
+        if (hoist_end) {
+            emit_indent(gen, f);
+            emit_type(gen, f, get_type(gen, end));
+            fprintf(f, " %.*s__end = ", name_size, name);
+            emit_expr(gen, f, end);
+            fprintf(f, ";\n");
+        }
+        if (hoist_step) {
+            emit_indent(gen, f);
+            emit_type(gen, f, get_type(gen, step));
+            fprintf(f, " %.*s__step = ", name_size, name);
+            emit_expr(gen, f, step);
+            fprintf(f, ";\n");
+        }
 
         emit_indent(gen, f);
         fprintf(f, "for (");
         emit_type(gen, f, iter_type);
-        fprintf(f, " %.*s = ", (int)node->as.for_stmt.var_name_size, node->as.for_stmt.var_name);
-        emit_expr(gen, f, node->as.for_stmt.start);
-        fprintf(f, "; %.*s < ", (int)node->as.for_stmt.var_name_size, node->as.for_stmt.var_name);
-        emit_expr(gen, f, node->as.for_stmt.end);
-        fprintf(f, "; %.*s += ", (int)node->as.for_stmt.var_name_size, node->as.for_stmt.var_name);
-        if (node->as.for_stmt.step) {
-            emit_expr(gen, f, node->as.for_stmt.step);
+        fprintf(f, " %.*s = ", name_size, name);
+        if (hoist_start) {
+            fprintf(f, "%.*s__start", name_size, name);
+        } else {
+            emit_expr(gen, f, start);
+        }
+        fprintf(f, "; %.*s < ", name_size, name);
+        if (hoist_end) {
+            fprintf(f, "%.*s__end", name_size, name);
+        } else {
+            emit_expr(gen, f, end);
+        }
+        fprintf(f, "; %.*s += ", name_size, name);
+        if (hoist_step) {
+            fprintf(f, "%.*s__step", name_size, name);
+        } else if (step) {
+            emit_expr(gen, f, step);
         } else {
             fprintf(f, "1");
         }
@@ -721,6 +1000,11 @@ static void emit_stmt(CodeGen* gen, FILE* f, Node* node) {
         gen->indent--;
         emit_indent(gen, f);
         fprintf(f, "}\n");
+        if (hoist_end || hoist_step) {
+            gen->indent--;
+            emit_indent(gen, f);
+            fprintf(f, "}\n");
+        }
         break;
     }
 
@@ -814,7 +1098,7 @@ static void emit_stmt(CodeGen* gen, FILE* f, Node* node) {
         emit_indent(gen, f);
         emit_expr(gen, f, node->as.assign_stmt.target);
         fprintf(f, " = ");
-        emit_expr(gen, f, node->as.assign_stmt.value);
+        emit_converted(gen, f, node->as.assign_stmt.value, get_type(gen, node->as.assign_stmt.target));
         fprintf(f, ";\n");
         break;
 
@@ -859,7 +1143,7 @@ static void emit_body(CodeGen* gen, FILE* f, NodeList* body) {
 // ---------------------------------------------------------------------------
 
 static void emit_func_signature(CodeGen* gen, FILE* f, Node* func_node, bool is_static) {
-    Type* func_type = get_type(func_node);
+    Type* func_type = get_type(gen, func_node);
     if (!func_type || func_type->kind != TYPE_FUNC) return;
 
     Type* method_of = (Type*)func_node->as.func_decl.method_of;
@@ -893,9 +1177,20 @@ static void emit_func_signature(CodeGen* gen, FILE* f, Node* func_node, bool is_
     fprintf(f, ")");
 }
 
+static Type* func_return_type(CodeGen* gen, Node* func_node) {
+    Type* func_type = get_type(gen, func_node);
+    if (!func_type || func_type->kind != TYPE_FUNC) return NULL;
+    return func_type->as.func_type.return_type;
+}
+
+// Methods of generic struct instances exist only if checked code reached them.
+static bool method_is_emitted(Node* method) {
+    return !method->as.func_decl.inst || method->as.func_decl.is_reached;
+}
+
 static void emit_method_signature(CodeGen* gen, FILE* f, Node* method_node,
                                     char* sname, size_t sname_size, bool is_static) {
-    Type* func_type = get_type(method_node);
+    Type* func_type = get_type(gen, method_node);
     if (!func_type || func_type->kind != TYPE_FUNC) return;
 
     if (is_static) fprintf(f, "static ");
@@ -905,9 +1200,13 @@ static void emit_method_signature(CodeGen* gen, FILE* f, Node* method_node,
                         method_node->as.func_decl.name, method_node->as.func_decl.name_size);
     fprintf(f, "(");
 
-    // self parameter
-    emit_mangled(gen, f, sname, sname_size);
-    fprintf(f, "* self");
+    // self parameter (untyped when a vtable calls the method directly)
+    if (method_node->as.func_decl.is_vtable_target) {
+        fprintf(f, "void* anc__self");
+    } else {
+        emit_mangled(gen, f, sname, sname_size);
+        fprintf(f, "* self");
+    }
 
     // other parameters
     ParamList* params = &method_node->as.func_decl.params;
@@ -935,7 +1234,7 @@ static void emit_interface_typedefs(CodeGen* gen, FILE* f, Type* iface) {
         Node* sig = sigs->nodes[i];
         if (sig->type != NODE_FUNC_DECL) continue;
         if (sig->as.func_decl.type_params.count > 0) continue; // skip generic methods
-        Type* sig_type = get_type(sig);
+        Type* sig_type = get_type(gen, sig);
         fprintf(f, "    ");
         // return type
         if (sig_type && sig_type->kind == TYPE_FUNC) {
@@ -974,6 +1273,44 @@ static void emit_interface_typedefs(CodeGen* gen, FILE* f, Type* iface) {
     fprintf(f, "__ref;\n\n");
 }
 
+// A vtable slot can hold the struct method itself when, self aside, its C
+// signature is the slot's. Sema only matches parameter counts, so other
+// methods are reached through a wrapper that converts the arguments.
+static bool slot_takes_method(Node* sig, Node* method) {
+    if (!method || sig->as.func_decl.type_params.count > 0) return false;
+    Type* sig_type = (Type*)sig->resolved_type;
+    Type* method_type = (Type*)method->resolved_type;
+    if (!sig_type || sig_type->kind != TYPE_FUNC) return false;
+    if (!method_type || method_type->kind != TYPE_FUNC) return false;
+    if (sig_type->as.func_type.param_count != method_type->as.func_type.param_count) return false;
+    if (!type_equals(sig_type->as.func_type.return_type, method_type->as.func_type.return_type)) {
+        return false;
+    }
+    for (int i = 0; i < sig_type->as.func_type.param_count; i++) {
+        if (!type_equals(sig_type->as.func_type.param_types[i],
+                         method_type->as.func_type.param_types[i])) return false;
+    }
+    return true;
+}
+
+// Decide, before any module is emitted, which methods take self as void* so
+// that vtables can point at them.
+static void vtable_targets_mark(ModuleGraph* graph) {
+    for (Module* mod = graph->first; mod; mod = mod->next) {
+        for (size_t i = 0; i < mod->impl_pairs.count; i++) {
+            ImplPair* pair = &mod->impl_pairs.pairs[i];
+            NodeList* sigs = pair->interface_type->as.interface_type.method_sigs;
+            for (size_t j = 0; j < sigs->count; j++) {
+                Node* sig = sigs->nodes[j];
+                if (sig->type != NODE_FUNC_DECL) continue;
+                if (slot_takes_method(sig, pair->methods[j])) {
+                    pair->methods[j]->as.func_decl.is_vtable_target = true;
+                }
+            }
+        }
+    }
+}
+
 // Emit wrapper functions and vtable instance for a (struct, interface) pair
 static void emit_vtable_instance(CodeGen* gen, FILE* f, ImplPair* pair) {
     Type* st = pair->struct_type;
@@ -984,12 +1321,13 @@ static void emit_vtable_instance(CodeGen* gen, FILE* f, ImplPair* pair) {
     Module* saved = gen->mod;
     gen->mod = pair->struct_module;
 
-    // emit wrapper functions
+    // emit wrapper functions for slots that cannot hold the method itself
     for (size_t i = 0; i < sigs->count; i++) {
         Node* sig = sigs->nodes[i];
         if (sig->type != NODE_FUNC_DECL) continue;
         if (sig->as.func_decl.type_params.count > 0) continue; // skip generic methods
-        Type* sig_type = get_type(sig);
+        if (slot_takes_method(sig, pair->methods[i])) continue;
+        Type* sig_type = get_type(gen, sig);
 
         fprintf(f, "static ");
         if (sig_type && sig_type->kind == TYPE_FUNC) {
@@ -1012,9 +1350,10 @@ static void emit_vtable_instance(CodeGen* gen, FILE* f, ImplPair* pair) {
         }
         fprintf(f, ") {\n");
         fprintf(f, "    return ");
+        Node* method = pair->methods[i];
         emit_method_mangled(gen, f,
             st->as.struct_type.name, st->as.struct_type.name_size,
-            sig->as.func_decl.name, sig->as.func_decl.name_size);
+            method->as.func_decl.name, method->as.func_decl.name_size);
         fprintf(f, "((");
         emit_mangled(gen, f, st->as.struct_type.name, st->as.struct_type.name_size);
         fprintf(f, "*)self");
@@ -1046,17 +1385,229 @@ static void emit_vtable_instance(CodeGen* gen, FILE* f, ImplPair* pair) {
         if (sig->as.func_decl.type_params.count > 0) continue; // skip generic methods
         fprintf(f, "    .%.*s = ",
                 (int)sig->as.func_decl.name_size, sig->as.func_decl.name);
+        Node* method = pair->methods[i];
         gen->mod = pair->struct_module;
-        emit_mangled(gen, f, st->as.struct_type.name, st->as.struct_type.name_size);
-        gen->mod = saved;
-        fprintf(f, "__%.*s__wrapper",
-                (int)sig->as.func_decl.name_size, sig->as.func_decl.name);
+        if (slot_takes_method(sig, method)) {
+            emit_method_mangled(gen, f,
+                st->as.struct_type.name, st->as.struct_type.name_size,
+                method->as.func_decl.name, method->as.func_decl.name_size);
+            gen->mod = saved;
+        } else {
+            emit_mangled(gen, f, st->as.struct_type.name, st->as.struct_type.name_size);
+            gen->mod = saved;
+            fprintf(f, "__%.*s__wrapper",
+                    (int)sig->as.func_decl.name_size, sig->as.func_decl.name);
+        }
         fprintf(f, ",\n");
     }
 
     fprintf(f, "};\n\n");
 }
 
+// A global const/var's type and mangled name; an array puts its length
+// after the name.
+static void emit_global_declarator(CodeGen* gen, FILE* f, Symbol* sym) {
+    Type* t = get_type(gen, sym->node);
+    bool is_array = t && t->kind == TYPE_ARRAY;
+    emit_type(gen, f, is_array ? t->as.array_type.element : t);
+    fprintf(f, " ");
+    emit_mangled(gen, f, sym->name, sym->name_size);
+    if (is_array) fprintf(f, "[%d]", t->as.array_type.size);
+}
+
+// ---------------------------------------------------------------------------
+// Slice typedefs
+// ---------------------------------------------------------------------------
+
+// Slice types a file names, element slices before the slices over them.
+typedef struct SliceTypeList {
+    Type** items;
+    size_t count;
+    size_t capacity;
+} SliceTypeList;
+
+static void slice_types_add(SliceTypeList* list, Type* type) {
+    if (!type) return;
+    switch (type->kind) {
+    case TYPE_REF:
+        slice_types_add(list, type->as.ref_type.inner);
+        return;
+    case TYPE_PTR:
+        slice_types_add(list, type->as.ptr_type.inner);
+        return;
+    case TYPE_ARRAY:
+        slice_types_add(list, type->as.array_type.element);
+        return;
+    case TYPE_FUNC:
+        for (int i = 0; i < type->as.func_type.param_count; i++) {
+            slice_types_add(list, type->as.func_type.param_types[i]);
+        }
+        slice_types_add(list, type->as.func_type.return_type);
+        return;
+    case TYPE_SLICE:
+        break;
+    default:
+        return;
+    }
+
+    slice_types_add(list, type->as.slice_type.element);
+    for (size_t i = 0; i < list->count; i++) {
+        if (list->items[i] == type) return;
+    }
+    if (list->count >= list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 16;
+        list->items = realloc(list->items, list->capacity * sizeof(Type*));
+    }
+    list->items[list->count++] = type;
+}
+
+// Declared types of locals; every other slice a body handles is named by a
+// signature, field or global, here or in an included header.
+static void slice_types_body(CodeGen* gen, SliceTypeList* list, NodeList* body) {
+    for (size_t i = 0; i < body->count; i++) {
+        Node* node = body->nodes[i];
+        switch (node->type) {
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+            slice_types_add(list, get_type(gen, node));
+            break;
+        case NODE_IF_STMT: {
+            slice_types_body(gen, list, &node->as.if_stmt.then_body);
+            ElseIfList* elseifs = &node->as.if_stmt.elseifs;
+            for (size_t j = 0; j < elseifs->count; j++) slice_types_body(gen, list, &elseifs->branches[j].body);
+            slice_types_body(gen, list, &node->as.if_stmt.else_body);
+            break;
+        }
+        case NODE_FOR_STMT:
+            slice_types_body(gen, list, &node->as.for_stmt.body);
+            break;
+        case NODE_WHILE_STMT:
+            slice_types_body(gen, list, &node->as.while_stmt.body);
+            break;
+        case NODE_WITH_STMT:
+            if (node->as.with_stmt.resource->type == NODE_VAR_DECL) {
+                slice_types_add(list, get_type(gen, node->as.with_stmt.resource));
+            }
+            slice_types_body(gen, list, &node->as.with_stmt.body);
+            break;
+        case NODE_MATCH_STMT: {
+            MatchCaseList* cases = &node->as.match_stmt.cases;
+            for (size_t j = 0; j < cases->count; j++) slice_types_body(gen, list, &cases->cases[j].body);
+            slice_types_body(gen, list, &node->as.match_stmt.else_body);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+static void slice_types_func(CodeGen* gen, SliceTypeList* list, Node* func, bool with_body) {
+    gen->inst = func->as.func_decl.inst;
+    slice_types_add(list, get_type(gen, func));
+    if (with_body && !func->as.func_decl.is_extern) {
+        slice_types_body(gen, list, parser_func_body(func));
+    }
+    gen->inst = NULL;
+}
+
+// Slice types the module's header (exported_only) or C file names.
+static void slice_types_collect(CodeGen* gen, SliceTypeList* list, bool exported_only) {
+    for (Symbol* sym = gen->mod->symbols->first; sym; sym = sym->next) {
+        if (!sym->node || (exported_only && !sym->is_export)) continue;
+
+        switch (sym->kind) {
+        case SYMBOL_FUNC:
+            if (sym->node->as.func_decl.type_params.count > 0) break;
+            slice_types_func(gen, list, sym->node, !exported_only);
+            break;
+        case SYMBOL_STRUCT: {
+            if (sym->node->as.struct_decl.type_params.count > 0) break;
+            FieldList* fields = &sym->node->as.struct_decl.fields;
+            for (size_t i = 0; i < fields->count; i++) {
+                slice_types_add(list, (Type*)fields->fields[i].type_node->resolved_type);
+            }
+            NodeList* methods = &sym->node->as.struct_decl.methods;
+            for (size_t i = 0; i < methods->count; i++) {
+                Node* method = methods->nodes[i];
+                if (method->type != NODE_FUNC_DECL) continue;
+                if (method->as.func_decl.type_params.count > 0) continue;
+                if (!method_is_emitted(method)) continue;
+                slice_types_func(gen, list, method, !exported_only);
+            }
+            break;
+        }
+        case SYMBOL_INTERFACE: {
+            NodeList* sigs = &sym->node->as.interface_decl.method_sigs;
+            for (size_t i = 0; i < sigs->count; i++) {
+                if (sigs->nodes[i]->as.func_decl.type_params.count > 0) continue;
+                slice_types_add(list, get_type(gen, sigs->nodes[i]));
+            }
+            break;
+        }
+        case SYMBOL_CONST:
+        case SYMBOL_VAR:
+            slice_types_add(list, get_type(gen, sym->node));
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// Element type as a slice's pointer target. Structs and interface refs are
+// named by tag, so a slice may be defined ahead of their typedefs.
+static void emit_tagged_type(CodeGen* gen, FILE* f, Type* type) {
+    switch (type->kind) {
+    case TYPE_STRUCT:
+    case TYPE_INTERFACE:
+        fprintf(f, "struct ");
+        emit_type(gen, f, type);
+        break;
+    case TYPE_REF:
+        emit_tagged_type(gen, f, type->as.ref_type.inner);
+        if (type->as.ref_type.inner->kind != TYPE_INTERFACE) fprintf(f, "*");
+        break;
+    case TYPE_PTR:
+        emit_tagged_type(gen, f, type->as.ptr_type.inner);
+        fprintf(f, "*");
+        break;
+    default:
+        emit_type(gen, f, type);
+        break;
+    }
+}
+
+// One guarded typedef per slice type: headers of several modules may
+// define the same one.
+static void emit_slice_typedefs(CodeGen* gen, FILE* f, bool exported_only) {
+    SliceTypeList slices = {0};
+    slice_types_collect(gen, &slices, exported_only);
+
+    for (size_t i = 0; i < slices.count; i++) {
+        Type* slice = slices.items[i];
+        Type* element = slice->as.slice_type.element;
+        fprintf(f, "#ifndef ANC__SLICE__");
+        emit_slice_suffix(gen, f, element);
+        fprintf(f, "_DEFINED\n#define ANC__SLICE__");
+        emit_slice_suffix(gen, f, element);
+        fprintf(f, "_DEFINED\ntypedef struct ");
+        emit_type(gen, f, slice);
+        fprintf(f, " {\n    ");
+        if (element->kind == TYPE_ARRAY) {
+            emit_tagged_type(gen, f, element->as.array_type.element);
+            fprintf(f, " (*ptr)[%d];\n", element->as.array_type.size);
+        } else {
+            emit_tagged_type(gen, f, element);
+            fprintf(f, "* ptr;\n");
+        }
+        fprintf(f, "    size_t len;\n} ");
+        emit_type(gen, f, slice);
+        fprintf(f, ";\n#endif\n\n");
+    }
+    free(slices.items);
+}
+
 // ---------------------------------------------------------------------------
 // .h file generation
 // ---------------------------------------------------------------------------
@@ -1082,14 +1633,6 @@ static void emit_h_file(CodeGen* gen) {
     fprintf(f, "} anc__string;\n");
     fprintf(f, "#endif\n\n");
 
-    fprintf(f, "#ifndef ANC__SLICE_DEFINED\n");
-    fprintf(f, "#define ANC__SLICE_DEFINED\n");
-    fprintf(f, "typedef struct anc__slice {\n");
-    fprintf(f, "    void* ptr;\n");
-    fprintf(f, "    size_t len;\n");
-    fprintf(f, "} anc__slice;\n");
-    fprintf(f, "#endif\n\n");
-
     // pass 1a: forward declarations for exported structs
     for (Symbol* sym = gen->mod->symbols->first; sym; sym = sym->next) {
         if (sym->kind != SYMBOL_STRUCT || !sym->is_export || !sym->node) continue;
@@ -1102,6 +1645,32 @@ static void emit_h_file(CodeGen* gen) {
     }
     fprintf(f, "\n");
 
+    // exported enum typedefs
+    for (Symbol* sym = gen->mod->symbols->first; sym; sym = sym->next) {
+        if (sym->kind != SYMBOL_ENUM || !sym->is_export || !sym->node) continue;
+
+        Node* node = sym->node;
+        fprintf(f, "typedef enum ");
+        emit_mangled(gen, f, node->as.enum_decl.name, node->as.enum_decl.name_size);
+        fprintf(f, " {\n");
+
+        EnumVariantList* variants = &node->as.enum_decl.variants;
+        for (size_t i = 0; i < variants->count; i++) {
+            fprintf(f, "    ");
+            emit_mangled(gen, f, node->as.enum_decl.name, node->as.enum_decl.name_size);
+            fprintf(f, "__%.*s", (int)variants->variants[i].name_size, variants->variants[i].name);
+            if (i + 1 < variants->count) fprintf(f, ",");
+            fprintf(f, "\n");
+        }
+
+        fprintf(f, "} ");
+        emit_mangled(gen, f, node->as.enum_decl.name, node->as.enum_decl.name_size);
+        fprintf(f, ";\n\n");
+    }
+
+    // slice typedefs for the exported declarations
+    emit_slice_typedefs(gen, f, true);
+
     // pass 1b: exported struct bodies
     for (Symbol* sym = gen->mod->symbols->first; sym; sym = sym->next) {
         if (sym->kind != SYMBOL_STRUCT || !sym->is_export || !sym->node) continue;
@@ -1129,6 +1698,7 @@ static void emit_h_file(CodeGen* gen) {
             Node* method = methods->nodes[i];
             if (method->type != NODE_FUNC_DECL) continue;
             if (method->as.func_decl.type_params.count > 0) continue; // skip generic
+            if (!method_is_emitted(method)) continue;
             emit_method_signature(gen, f, method,
                 node->as.struct_decl.name, node->as.struct_decl.name_size, false);
             fprintf(f, ";\n");
@@ -1136,46 +1706,17 @@ static void emit_h_file(CodeGen* gen) {
         if (methods->count > 0) fprintf(f, "\n");
     }
 
-    // pass 1b: exported enum typedefs
-    for (Symbol* sym = gen->mod->symbols->first; sym; sym = sym->next) {
-        if (sym->kind != SYMBOL_ENUM || !sym->is_export || !sym->node) continue;
-
-        Node* node = sym->node;
-        fprintf(f, "typedef enum ");
-        emit_mangled(gen, f, node->as.enum_decl.name, node->as.enum_decl.name_size);
-        fprintf(f, " {\n");
-
-        EnumVariantList* variants = &node->as.enum_decl.variants;
-        for (size_t i = 0; i < variants->count; i++) {
-            fprintf(f, "    ");
-            emit_mangled(gen, f, node->as.enum_decl.name, node->as.enum_decl.name_size);
-            fprintf(f, "__%.*s", (int)variants->variants[i].name_size, variants->variants[i].name);
-            if (i + 1 < variants->count) fprintf(f, ",");
-            fprintf(f, "\n");
-        }
-
-        fprintf(f, "} ");
-        emit_mangled(gen, f, node->as.enum_decl.name, node->as.enum_decl.name_size);
-        fprintf(f, ";\n\n");
-    }
-
     // pass 2: exported extern const/var
     for (Symbol* sym = gen->mod->symbols->first; sym; sym = sym->next) {
         if (!sym->is_export || !sym->node) continue;
 
         if (sym->kind == SYMBOL_CONST) {
-            Type* t = get_type(sym->node);
             fprintf(f, "extern const ");
-            emit_type(gen, f, t);
-            fprintf(f, " ");
-            emit_mangled(gen, f, sym->name, sym->name_size);
+            emit_global_declarator(gen, f, sym);
             fprintf(f, ";\n");
         } else if (sym->kind == SYMBOL_VAR) {
-            Type* t = get_type(sym->node);
             fprintf(f, "extern ");
-            emit_type(gen, f, t);
-            fprintf(f, " ");
-            emit_mangled(gen, f, sym->name, sym->name_size);
+            emit_global_declarator(gen, f, sym);
             fprintf(f, ";\n");
         }
     }
@@ -1184,7 +1725,7 @@ static void emit_h_file(CodeGen* gen) {
     for (Symbol* sym = gen->mod->symbols->first; sym; sym = sym->next) {
         if (sym->kind != SYMBOL_FUNC || !sym->node) continue;
         if (!sym->node->as.func_decl.is_extern || !sym->is_export) continue;
-        Type* func_type = get_type(sym->node);
+        Type* func_type = get_type(gen, sym->node);
         if (!func_type || func_type->kind != TYPE_FUNC) continue;
         emit_type(gen, f, func_type->as.func_type.return_type);
         fprintf(f, " %.*s(", (int)sym->name_size, sym->name);
@@ -1233,8 +1774,7 @@ static void emit_c_file(CodeGen* gen) {
             // find the source module for this import
             ImportNameList* names = &node->as.import_decl.names;
             if (names->count > 0) {
-                Symbol* sym = symbol_find(gen->mod->symbols, names->names[0].name,
-                                           names->names[0].name_size);
+                Symbol* sym = symbol_find_atom(gen->mod->symbols, names->names[0].name_atom);
                 if (sym && sym->kind == SYMBOL_IMPORT && sym->source) {
                     fprintf(f, "#include \"anc__%s__%s.h\"\n",
                             gen->pkg->name, sym->source->name);
@@ -1253,7 +1793,7 @@ static void emit_c_file(CodeGen* gen) {
     for (Symbol* sym = gen->mod->symbols->first; sym; sym = sym->next) {
         if (sym->kind != SYMBOL_FUNC || !sym->node) continue;
         if (!sym->node->as.func_decl.is_extern || sym->is_export) continue;
-        Type* func_type = get_type(sym->node);
+        Type* func_type = get_type(gen, sym->node);
         if (!func_type || func_type->kind != TYPE_FUNC) continue;
         emit_type(gen, f, func_type->as.func_type.return_type);
         fprintf(f, " %.*s(", (int)sym->name_size, sym->name);
@@ -1282,28 +1822,6 @@ static void emit_c_file(CodeGen* gen) {
     }
     fprintf(f, "\n");
 
-    // pass 1b: non-exported struct bodies
-    for (Symbol* sym = gen->mod->symbols->first; sym; sym = sym->next) {
-        if (sym->kind != SYMBOL_STRUCT || sym->is_export || !sym->node) continue;
-        if (sym->node->as.struct_decl.type_params.count > 0) continue;
-
-        Node* node = sym->node;
-        fprintf(f, "struct ");
-        emit_mangled(gen, f, node->as.struct_decl.name, node->as.struct_decl.name_size);
-        fprintf(f, " {\n");
-
-        FieldList* fields = &node->as.struct_decl.fields;
-        for (size_t i = 0; i < fields->count; i++) {
-            Field* field = &fields->fields[i];
-            Type* ft = (Type*)field->type_node->resolved_type;
-            fprintf(f, "    ");
-            emit_type(gen, f, ft);
-            fprintf(f, " %.*s;\n", (int)field->name_size, field->name);
-        }
-
-        fprintf(f, "};\n\n");
-    }
-
     // non-exported enum typedefs
     for (Symbol* sym = gen->mod->symbols->first; sym; sym = sym->next) {
         if (sym->kind != SYMBOL_ENUM || sym->is_export || !sym->node) continue;
@@ -1327,10 +1845,35 @@ static void emit_c_file(CodeGen* gen) {
         fprintf(f, ";\n\n");
     }
 
+    // slice typedefs the header did not define
+    emit_slice_typedefs(gen, f, false);
+
+    // pass 1b: non-exported struct bodies
+    for (Symbol* sym = gen->mod->symbols->first; sym; sym = sym->next) {
+        if (sym->kind != SYMBOL_STRUCT || sym->is_export || !sym->node) continue;
+        if (sym->node->as.struct_decl.type_params.count > 0) continue;
+
+        Node* node = sym->node;
+        fprintf(f, "struct ");
+        emit_mangled(gen, f, node->as.struct_decl.name, node->as.struct_decl.name_size);
+        fprintf(f, " {\n");
+
+        FieldList* fields = &node->as.struct_decl.fields;
+        for (size_t i = 0; i < fields->count; i++) {
+            Field* field = &fields->fields[i];
+            Type* ft = (Type*)field->type_node->resolved_type;
+            fprintf(f, "    ");
+            emit_type(gen, f, ft);
+            fprintf(f, " %.*s;\n", (int)field->name_size, field->name);
+        }
+
+        fprintf(f, "};\n\n");
+    }
+
     // interface vtable and fat pointer typedefs
     for (Symbol* sym = gen->mod->symbols->first; sym; sym = sym->next) {
         if (sym->kind != SYMBOL_INTERFACE || !sym->node) continue;
-        Type* iface_type = get_type(sym->node);
+        Type* iface_type = get_type(gen, sym->node);
         if (!iface_type || iface_type->kind != TYPE_INTERFACE) continue;
         emit_interface_typedefs(gen, f, iface_type);
     }
@@ -1354,6 +1897,7 @@ static void emit_c_file(CodeGen* gen) {
             Node* method = methods->nodes[i];
             if (method->type != NODE_FUNC_DECL) continue;
             if (method->as.func_decl.type_params.count > 0) continue; // skip generic
+            if (!method_is_emitted(method)) continue;
             if (!is_exported_struct) {
                 // non-exported struct: methods are static
                 emit_method_signature(gen, f, method,
@@ -1375,28 +1919,22 @@ static void emit_c_file(CodeGen* gen) {
         if (!sym->node) continue;
 
         if (sym->kind == SYMBOL_CONST) {
-            Type* t = get_type(sym->node);
             if (sym->is_export) {
                 fprintf(f, "const ");
             } else {
                 fprintf(f, "static const ");
             }
-            emit_type(gen, f, t);
-            fprintf(f, " ");
-            emit_mangled(gen, f, sym->name, sym->name_size);
+            emit_global_declarator(gen, f, sym);
             if (sym->node->as.const_decl.value) {
                 fprintf(f, " = ");
                 emit_expr(gen, f, sym->node->as.const_decl.value);
             }
             fprintf(f, ";\n");
         } else if (sym->kind == SYMBOL_VAR) {
-            Type* t = get_type(sym->node);
             if (!sym->is_export) {
                 fprintf(f, "static ");
             }
-            emit_type(gen, f, t);
-            fprintf(f, " ");
-            emit_mangled(gen, f, sym->name, sym->name_size);
+            emit_global_declarator(gen, f, sym);
             if (sym->node->as.var_decl.value) {
                 fprintf(f, " = ");
                 emit_expr(gen, f, sym->node->as.var_decl.value);
@@ -1413,12 +1951,19 @@ static void emit_c_file(CodeGen* gen) {
         if (sym->node->as.func_decl.is_extern) continue;
 
         bool is_static = !sym->is_export;
+        long start = ftell(f);
         emit_func_signature(gen, f, sym->node, is_static);
         fprintf(f, " {\n");
         gen->indent = 1;
-        emit_body(gen, f, &sym->node->as.func_decl.body);
+        gen->inst = sym->node->as.func_decl.inst;
+        gen->return_type = func_return_type(gen, sym->node);
+        emit_body(gen, f, parser_func_body(sym->node));
         gen->indent = 0;
-        fprintf(f, "}\n\n");
+        fprintf(f, "}\n");
+        record_func_size(gen, f, start, NULL, 0,
+                         sym->node->as.func_decl.name, sym->node->as.func_decl.name_size);
+        gen->inst = NULL;
+        fprintf(f, "\n");
     }
 
     // pass 5: struct method definitions
@@ -1434,14 +1979,27 @@ static void emit_c_file(CodeGen* gen) {
             Node* method = methods->nodes[i];
             if (method->type != NODE_FUNC_DECL) continue;
             if (method->as.func_decl.type_params.count > 0) continue; // skip generic
+            if (!method_is_emitted(method)) continue;
 
+            long start = ftell(f);
             emit_method_signature(gen, f, method,
                 snode->as.struct_decl.name, snode->as.struct_decl.name_size, is_static);
             fprintf(f, " {\n");
+            if (method->as.func_decl.is_vtable_target) {
+                fprintf(f, "    ");
+                emit_mangled(gen, f, snode->as.struct_decl.name, snode->as.struct_decl.name_size);
+                fprintf(f, "* self = anc__self;\n");
+            }
             gen->indent = 1;
-            emit_body(gen, f, &method->as.func_decl.body);
+            gen->inst = method->as.func_decl.inst;
+            gen->return_type = func_return_type(gen, method);
+            emit_body(gen, f, parser_func_body(method));
             gen->indent = 0;
-            fprintf(f, "}\n\n");
+            fprintf(f, "}\n");
+            record_func_size(gen, f, start, snode->as.struct_decl.name, snode->as.struct_decl.name_size,
+                             method->as.func_decl.name, method->as.func_decl.name_size);
+            gen->inst = NULL;
+            fprintf(f, "\n");
         }
     }
 }
@@ -1453,6 +2011,10 @@ static void emit_c_file(CodeGen* gen) {
 bool codegen(Arena* arena, Errors* errors, Package* pkg, ModuleGraph* graph, Module* entry, char* output_dir) {
     dir_ensure(output_dir);
 
+    SoleImplList sole_impls = {0};
+    sole_impls_build(arena, &sole_impls, graph);
+    vtable_targets_mark(graph);
+
     for (Module* mod = graph->first; mod; mod = mod->next) {
         if (!mod->symbols) continue;
 
@@ -1484,6 +2046,11 @@ bool codegen(Arena* arena, Errors* errors, Package* pkg, ModuleGraph* graph, Mod
         gen.in_method = false;
         gen.struct_name = NULL;
         gen.struct_name_size = 0;
+        gen.inst = NULL;
+        gen.return_type = NULL;
+        gen.sizes = graph->func_sizes;
+        gen.sole_impls = &sole_impls;
+        gen.devirt = graph->devirt;
 
         // resolve field types (they may not have resolved_type set yet)
         for (Symbol* sym = mod->symbols->first; sym; sym = sym->next) {
@@ -1503,7 +2070,7 @@ bool codegen(Arena* arena, Errors* errors, Package* pkg, ModuleGraph* graph, Mod
 
         // emit C main() wrapper in entry module
         if (mod == entry) {
-            Symbol* main_sym = symbol_find(mod->symbols, "main", 4);
+            Symbol* main_sym = symbol_find_atom(mod->symbols, ATOM_MAIN);
             if (!main_sym || main_sym->kind != SYMBOL_FUNC) {
                 errors_push(errors, SEVERITY_ERROR, 0, 0, 0,
                             "entry module '%s' has no 'main' function", mod->name);
@@ -0,0 +1,694 @@
+#include "consteval.h"
+#include "module.h"
+#include "parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Limits that keep a runaway or recursive function from stalling the build;
+// past them the call is simply not a constant.
+#define CONST_MAX_STEPS  (1u << 20)
+#define CONST_MAX_DEPTH  64
+#define CONST_MAX_PARAMS 16
+
+void const_eval_init(ConstEval* ev, TypeRegistry* reg, SymbolTable* table) {
+    memset(ev, 0, sizeof(ConstEval));
+    ev->reg = reg;
+    ev->table = table;
+}
+
+void const_eval_free(ConstEval* ev) {
+    free(ev->locals);
+    ev->locals = NULL;
+    ev->local_count = 0;
+    ev->local_capacity = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Integer semantics
+// ---------------------------------------------------------------------------
+
+bool const_int_range(Type* type, int64_t* min, int64_t* max) {
+    if (!type) return false;
+    switch (type->kind) {
+    case TYPE_BYTE:   *min = 0;              *max = UINT8_MAX;  return true;
+    case TYPE_SHORT:  *min = INT16_MIN + 1;  *max = INT16_MAX;  return true;
+    case TYPE_USHORT: *min = 0;              *max = UINT16_MAX; return true;
+    case TYPE_INT:    *min = INT32_MIN + 1;  *max = INT32_MAX;  return true;
+    case TYPE_UINT:   *min = 0;              *max = UINT32_MAX; return true;
+    case TYPE_LONG:   *min = INT64_MIN + 1;  *max = INT64_MAX;  return true;
+    case TYPE_ULONG:  *min = 0;              *max = INT64_MAX;  return true;
+    case TYPE_ISIZE:  *min = INT32_MIN + 1;  *max = INT32_MAX;  return true;
+    case TYPE_USIZE:  *min = 0;              *max = UINT32_MAX; return true;
+    default:          return false;
+    }
+}
+
+bool const_int_fits(Type* type, int64_t value) {
+    int64_t min, max;
+    return const_int_range(type, &min, &max) && value >= min && value <= max;
+}
+
+bool const_int_signed(Type* type) {
+    if (!type) return false;
+    return type->kind == TYPE_SHORT || type->kind == TYPE_INT ||
+           type->kind == TYPE_LONG || type->kind == TYPE_ISIZE;
+}
+
+bool const_int_arith(TokenType op, int64_t a, int64_t b, int64_t* out) {
+    switch (op) {
+    case TOKEN_PLUS:
+        if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b)) return false;
+        *out = a + b;
+        return true;
+    case TOKEN_MINUS:
+        if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b)) return false;
+        *out = a - b;
+        return true;
+    case TOKEN_STAR:
+        if (a != 0 && b != 0) {
+            if (a == INT64_MIN || b == INT64_MIN) return false;
+            int64_t abs_a = a < 0 ? -a : a;
+            int64_t abs_b = b < 0 ? -b : b;
+            if (abs_a > INT64_MAX / abs_b) return false;
+        }
+        *out = a * b;
+        return true;
+    case TOKEN_SLASH:
+        if (b == 0 || (a == INT64_MIN && b == -1)) return false;
+        *out = a / b; // C99 truncates toward zero too
+        return true;
+    case TOKEN_CARET:
+        if (a < 0 || b < 0) return false;
+        *out = a ^ b;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool const_int_compare(TokenType op, int64_t a, int64_t b, bool* out) {
+    switch (op) {
+    case TOKEN_EQUAL:                 *out = a == b; return true;
+    case TOKEN_NOT_EQUAL:             *out = a != b; return true;
+    case TOKEN_LESS_THAN:             *out = a < b;  return true;
+    case TOKEN_GREATER_THAN:          *out = a > b;  return true;
+    case TOKEN_LESS_THAN_OR_EQUAL:    *out = a <= b; return true;
+    case TOKEN_GREATER_THAN_OR_EQUAL: *out = a >= b; return true;
+    default:                          return false;
+    }
+}
+
+// Conversion of `x as T`: truncating to the width of T the way C does.
+static bool int_convert(Type* to, int64_t v, int64_t* out) {
+    switch (to->kind) {
+    case TYPE_BYTE:   *out = (int64_t)(uint8_t)v; break;
+    case TYPE_SHORT:  *out = (int64_t)(int16_t)(uint16_t)v; break;
+    case TYPE_USHORT: *out = (int64_t)(uint16_t)v; break;
+    case TYPE_INT:    *out = (int64_t)(int32_t)(uint32_t)v; break;
+    case TYPE_UINT:   *out = (int64_t)(uint32_t)v; break;
+    default:          *out = v; break; // wider types: exact or not at all
+    }
+    return const_int_fits(to, *out);
+}
+
+static bool is_bool(ConstValue* v) {
+    return v->type && v->type->kind == TYPE_BOOL;
+}
+
+static bool is_int(ConstValue* v) {
+    return !v->type || type_is_integer(v->type);
+}
+
+// A value stored into a place of type `type` (NULL: the value's own type).
+static bool const_store(ConstEval* ev, Type* type, ConstValue* v, ConstValue* out) {
+    if (!type) type = v->type ? v->type : type_int(ev->reg);
+    if (type->kind == TYPE_BOOL) {
+        if (!is_bool(v)) return false;
+    } else if (type_is_integer(type)) {
+        if (!is_int(v) || !const_int_fits(type, v->value)) return false;
+        if (v->type && !type_equals(v->type, type) && !type_integer_convertible(v->type, type)) return false;
+    } else if (type->kind == TYPE_ENUM) {
+        if (!v->type || !type_equals(v->type, type)) return false;
+    } else {
+        return false;
+    }
+    out->type = type;
+    out->value = v->value;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Names
+// ---------------------------------------------------------------------------
+
+static Type* const_type(ConstEval* ev, Node* type_node) {
+    if (!type_node) return NULL;
+    if (type_node->resolved_type) return (Type*)type_node->resolved_type;
+    if (type_node->type == NODE_TYPE_SIMPLE) return type_primitive(ev->reg, type_node->as.type_simple.name_atom);
+    return NULL;
+}
+
+static ConstLocal* local_find(ConstEval* ev, Atom atom) {
+    for (size_t i = ev->local_count; i > ev->frame_start; i--) {
+        if (ev->locals[i - 1].atom == atom) return &ev->locals[i - 1];
+    }
+    return NULL;
+}
+
+// The name is local to the expression, so module symbols do not apply.
+static bool is_local(ConstEval* ev, Atom atom) {
+    Node* decl;
+    return local_find(ev, atom) || (ev->lookup && ev->lookup(ev->lookup_data, atom, &decl));
+}
+
+static void local_bind(ConstEval* ev, Atom atom, ConstValue* v) {
+    if (ev->local_count >= ev->local_capacity) {
+        ev->local_capacity = ev->local_capacity ? ev->local_capacity * 2 : 16;
+        ev->locals = realloc(ev->locals, ev->local_capacity * sizeof(ConstLocal));
+    }
+    ConstLocal* local = &ev->locals[ev->local_count++];
+    local->atom = atom;
+    local->type = v->type;
+    local->value = v->value;
+}
+
+// Module-scope symbol for a name, following an import to the module that
+// declares it; *table is set to that module's table.
+static Symbol* scope_symbol(ConstEval* ev, Atom atom, SymbolTable** table) {
+    *table = ev->table;
+    Symbol* sym = symbol_find_atom(ev->table, atom);
+    if (sym && sym->kind == SYMBOL_IMPORT && sym->source) {
+        *table = sym->source->symbols;
+        sym = symbol_find_atom(*table, atom);
+    }
+    return sym;
+}
+
+static bool eval_expr(ConstEval* ev, Node* node, ConstValue* out);
+
+// The value of a constant declaration. A module constant is evaluated in
+// its own module, where no local names are visible.
+static bool eval_const_decl(ConstEval* ev, Node* decl, SymbolTable* table, bool is_module, ConstValue* out) {
+    if (decl->type != NODE_CONST_DECL || !decl->as.const_decl.value) return false;
+    if (ev->depth >= CONST_MAX_DEPTH) return false;
+
+    SymbolTable* saved_table = ev->table;
+    bool (*saved_lookup)(void*, Atom, Node**) = ev->lookup;
+    size_t saved_start = ev->frame_start;
+    if (is_module) {
+        ev->table = table;
+        ev->lookup = NULL;
+        ev->frame_start = ev->local_count;
+    }
+    ev->depth++;
+
+    ConstValue v;
+    Type* type = decl->resolved_type ? (Type*)decl->resolved_type : const_type(ev, decl->as.const_decl.type_node);
+    bool ok = eval_expr(ev, decl->as.const_decl.value, &v) && const_store(ev, type, &v, out);
+
+    ev->depth--;
+    ev->table = saved_table;
+    ev->lookup = saved_lookup;
+    ev->frame_start = saved_start;
+    return ok;
+}
+
+static bool eval_identifier(ConstEval* ev, Node* node, ConstValue* out) {
+    Atom atom = node->as.identifier.name_atom;
+    ConstLocal* local = local_find(ev, atom);
+    if (local) {
+        out->type = local->type;
+        out->value = local->value;
+        return true;
+    }
+    Node* decl;
+    if (ev->lookup && ev->lookup(ev->lookup_data, atom, &decl)) {
+        return decl && eval_const_decl(ev, decl, ev->table, false, out);
+    }
+    SymbolTable* table;
+    Symbol* sym = scope_symbol(ev, atom, &table);
+    if (!sym || sym->kind != SYMBOL_CONST || !sym->node) return false;
+    return eval_const_decl(ev, sym->node, table, true, out);
+}
+
+// Color.Red: the variant's position, which is its C enumerator value.
+static bool eval_enum_variant(ConstEval* ev, Node* node, ConstValue* out) {
+    Node* object = node->as.field_access.object;
+    if (object->type != NODE_IDENTIFIER) return false;
+    if (is_local(ev, object->as.identifier.name_atom)) return false;
+    SymbolTable* table;
+    Symbol* sym = scope_symbol(ev, object->as.identifier.name_atom, &table);
+    if (!sym || sym->kind != SYMBOL_ENUM || !sym->node) return false;
+
+    EnumVariantList* variants = &sym->node->as.enum_decl.variants;
+    for (size_t i = 0; i < variants->count; i++) {
+        if (variants->variants[i].name_atom == node->as.field_access.field_name_atom) {
+            out->type = (Type*)sym->node->resolved_type;
+            out->value = (int64_t)i;
+            return out->type != NULL;
+        }
+    }
+    return false;
+}
+
+// sizeof of types whose size does not depend on the target.
+static bool type_size(Type* type, int64_t* out) {
+    if (!type) return false;
+    switch (type->kind) {
+    case TYPE_BOOL:
+    case TYPE_BYTE:   *out = 1; return true;
+    case TYPE_SHORT:
+    case TYPE_USHORT: *out = 2; return true;
+    case TYPE_INT:
+    case TYPE_UINT:
+    case TYPE_FLOAT:  *out = 4; return true;
+    case TYPE_LONG:
+    case TYPE_ULONG:
+    case TYPE_DOUBLE: *out = 8; return true;
+    case TYPE_ARRAY: {
+        int64_t element;
+        if (!type_size(type->as.array_type.element, &element)) return false;
+        return const_int_arith(TOKEN_STAR, element, type->as.array_type.size, out);
+    }
+    default:
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Operators
+// ---------------------------------------------------------------------------
+
+static bool eval_arith(ConstEval* ev, TokenType op, ConstValue* a, ConstValue* b, ConstValue* out) {
+    if (!is_int(a) || !is_int(b)) return false;
+    if (a->type && b->type && !type_equals(a->type, b->type)) return false;
+    Type* type = a->type ? a->type : b->type;
+    // unsigned arithmetic wraps in C where exact arithmetic would not
+    if (type && !const_int_signed(type) && (a->value < 0 || b->value < 0)) return false;
+    int64_t result;
+    if (!const_int_arith(op, a->value, b->value, &result)) return false;
+    if (!const_int_fits(type ? type : type_int(ev->reg), result)) return false;
+    out->type = type;
+    out->value = result;
+    return true;
+}
+
+static bool eval_compare(ConstEval* ev, TokenType op, ConstValue* a, ConstValue* b, ConstValue* out) {
+    bool result;
+    if (is_int(a) && is_int(b)) {
+        // a negative value meets an unsigned one as a huge number in C
+        bool both_signed = (!a->type || const_int_signed(a->type)) && (!b->type || const_int_signed(b->type));
+        if ((a->value < 0 || b->value < 0) && !both_signed) return false;
+    } else {
+        // bools and enum values compare for equality only
+        if (!a->type || !b->type || !type_equals(a->type, b->type)) return false;
+        if (op != TOKEN_EQUAL && op != TOKEN_NOT_EQUAL) return false;
+    }
+    if (!const_int_compare(op, a->value, b->value, &result)) return false;
+    out->type = type_bool(ev->reg);
+    out->value = result;
+    return true;
+}
+
+static bool eval_binary(ConstEval* ev, Node* node, ConstValue* out) {
+    TokenType op = node->as.binary_expr.op;
+    ConstValue a, b;
+    if (!eval_expr(ev, node->as.binary_expr.left, &a)) return false;
+
+    if (op == TOKEN_AND || op == TOKEN_OR) {
+        if (!is_bool(&a)) return false;
+        // the right operand is not evaluated once the left decides
+        if (op == TOKEN_AND ? !a.value : a.value) {
+            *out = a;
+            return true;
+        }
+        if (!eval_expr(ev, node->as.binary_expr.right, &b) || !is_bool(&b)) return false;
+        *out = b;
+        return true;
+    }
+
+    if (!eval_expr(ev, node->as.binary_expr.right, &b)) return false;
+    switch (op) {
+    case TOKEN_PLUS:
+    case TOKEN_MINUS:
+    case TOKEN_STAR:
+    case TOKEN_SLASH:
+    case TOKEN_CARET:
+        return eval_arith(ev, op, &a, &b, out);
+    default:
+        return eval_compare(ev, op, &a, &b, out);
+    }
+}
+
+static bool eval_unary(ConstEval* ev, Node* node, ConstValue* out) {
+    ConstValue v;
+    if (!eval_expr(ev, node->as.unary_expr.operand, &v)) return false;
+    switch (node->as.unary_expr.op) {
+    case TOKEN_MINUS:
+        if (!is_int(&v) || (v.type && !const_int_signed(v.type))) return false;
+        if (!const_int_fits(v.type ? v.type : type_int(ev->reg), -v.value)) return false;
+        out->type = v.type;
+        out->value = -v.value;
+        return true;
+    case TOKEN_NOT:
+        if (!is_bool(&v)) return false;
+        out->type = v.type;
+        out->value = !v.value;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool eval_cast(ConstEval* ev, Node* node, ConstValue* out) {
+    Type* target = const_type(ev, node->as.cast_expr.target_type);
+    ConstValue v;
+    if (!type_is_integer(target) || !eval_expr(ev, node->as.cast_expr.expr, &v)) return false;
+    // integers and enum values convert; bools do not
+    if (is_bool(&v)) return false;
+    if (v.type && !type_is_integer(v.type) && v.type->kind != TYPE_ENUM) return false;
+    out->type = target;
+    return int_convert(target, v.value, &out->value);
+}
+
+// ---------------------------------------------------------------------------
+// Function calls
+// ---------------------------------------------------------------------------
+
+typedef enum ExecResult {
+    EXEC_NEXT,
+    EXEC_RETURN,
+    EXEC_BREAK,
+    EXEC_CONTINUE,
+    EXEC_FAIL,
+} ExecResult;
+
+static ExecResult exec_body(ConstEval* ev, NodeList* body);
+
+static bool eval_bool(ConstEval* ev, Node* node, bool* out) {
+    ConstValue v;
+    if (!eval_expr(ev, node, &v) || !is_bool(&v)) return false;
+    *out = v.value != 0;
+    return true;
+}
+
+static TokenType compound_op(TokenType op) {
+    switch (op) {
+    case TOKEN_PLUS_ASSIGN:  return TOKEN_PLUS;
+    case TOKEN_MINUS_ASSIGN: return TOKEN_MINUS;
+    case TOKEN_STAR_ASSIGN:  return TOKEN_STAR;
+    case TOKEN_SLASH_ASSIGN: return TOKEN_SLASH;
+    default:                 return TOKEN_ERROR;
+    }
+}
+
+// Store into a local of the interpreted function; index, not pointer, since
+// evaluating the value may grow the locals array.
+static bool local_assign(ConstEval* ev, Node* target, ConstValue* v) {
+    if (target->type != NODE_IDENTIFIER) return false;
+    ConstLocal* local = local_find(ev, target->as.identifier.name_atom);
+    if (!local) return false;
+    ConstValue stored;
+    if (!const_store(ev, local->type, v, &stored)) return false;
+    local->value = stored.value;
+    return true;
+}
+
+static ExecResult exec_for(ConstEval* ev, Node* node) {
+    ConstValue start, end;
+    if (!eval_expr(ev, node->as.for_stmt.start, &start) || !is_int(&start)) return EXEC_FAIL;
+    if (!const_store(ev, NULL, &start, &start)) return EXEC_FAIL;
+    // end and step are evaluated once, before the first iteration
+    if (!eval_expr(ev, node->as.for_stmt.end, &end)) return EXEC_FAIL;
+    ConstValue step = { NULL, 1 };
+    if (node->as.for_stmt.step && !eval_expr(ev, node->as.for_stmt.step, &step)) return EXEC_FAIL;
+
+    size_t mark = ev->local_count;
+    local_bind(ev, node->as.for_stmt.var_name_atom, &start);
+    size_t index = ev->local_count - 1;
+    ExecResult result = EXEC_NEXT;
+    for (;;) {
+        if (++ev->steps > CONST_MAX_STEPS) { result = EXEC_FAIL; break; }
+        ConstValue i = { ev->locals[index].type, ev->locals[index].value };
+        ConstValue cond;
+        if (!eval_compare(ev, TOKEN_LESS_THAN, &i, &end, &cond)) {
+            result = EXEC_FAIL;
+            break;
+        }
+        if (!cond.value) break;
+
+        ExecResult r = exec_body(ev, &node->as.for_stmt.body);
+        if (r == EXEC_RETURN || r == EXEC_FAIL) { result = r; break; }
+        if (r == EXEC_BREAK) break;
+
+        ConstValue next;
+        i.type = ev->locals[index].type;
+        i.value = ev->locals[index].value;
+        if (!eval_arith(ev, TOKEN_PLUS, &i, &step, &next) || !const_store(ev, i.type, &next, &next)) {
+            result = EXEC_FAIL;
+            break;
+        }
+        ev->locals[index].value = next.value;
+    }
+    ev->local_count = mark;
+    return result;
+}
+
+static ExecResult exec_match(ConstEval* ev, Node* node) {
+    ConstValue subject;
+    if (!eval_expr(ev, node->as.match_stmt.subject, &subject)) return EXEC_FAIL;
+
+    NodeList* body = &node->as.match_stmt.else_body;
+    MatchCaseList* cases = &node->as.match_stmt.cases;
+    for (size_t i = 0; i < cases->count && body == &node->as.match_stmt.else_body; i++) {
+        NodeList* values = &cases->cases[i].values;
+        for (size_t j = 0; j < values->count; j++) {
+            ConstValue v, eq;
+            if (!eval_expr(ev, values->nodes[j], &v) ||
+                !eval_compare(ev, TOKEN_EQUAL, &subject, &v, &eq)) {
+                return EXEC_FAIL;
+            }
+            if (eq.value) {
+                body = &cases->cases[i].body;
+                break;
+            }
+        }
+    }
+    ExecResult r = exec_body(ev, body);
+    // match is a C switch: break leaves the match, not the loop
+    return r == EXEC_BREAK ? EXEC_NEXT : r;
+}
+
+static ExecResult exec_stmt(ConstEval* ev, Node* node) {
+    if (++ev->steps > CONST_MAX_STEPS) return EXEC_FAIL;
+
+    switch (node->type) {
+    case NODE_VAR_DECL:
+    case NODE_CONST_DECL: {
+        bool is_var = node->type == NODE_VAR_DECL;
+        Node* value = is_var ? node->as.var_decl.value : node->as.const_decl.value;
+        Node* type_node = is_var ? node->as.var_decl.type_node : node->as.const_decl.type_node;
+        ConstValue v;
+        if (!value || !eval_expr(ev, value, &v)) return EXEC_FAIL;
+        Type* type = type_node ? const_type(ev, type_node) : NULL;
+        if (type_node && !type) return EXEC_FAIL;
+        if (!const_store(ev, type, &v, &v)) return EXEC_FAIL;
+        local_bind(ev, is_var ? node->as.var_decl.name_atom : node->as.const_decl.name_atom, &v);
+        return EXEC_NEXT;
+    }
+    case NODE_ASSIGN_STMT: {
+        ConstValue v;
+        if (!eval_expr(ev, node->as.assign_stmt.value, &v)) return EXEC_FAIL;
+        return local_assign(ev, node->as.assign_stmt.target, &v) ? EXEC_NEXT : EXEC_FAIL;
+    }
+    case NODE_COMPOUND_ASSIGN_STMT: {
+        ConstValue current, v, result;
+        Node* target = node->as.compound_assign_stmt.target;
+        if (target->type != NODE_IDENTIFIER || !local_find(ev, target->as.identifier.name_atom)) return EXEC_FAIL;
+        if (!eval_expr(ev, target, &current) || !eval_expr(ev, node->as.compound_assign_stmt.value, &v)) return EXEC_FAIL;
+        if (!eval_arith(ev, compound_op(node->as.compound_assign_stmt.op), &current, &v, &result)) return EXEC_FAIL;
+        return local_assign(ev, target, &result) ? EXEC_NEXT : EXEC_FAIL;
+    }
+    case NODE_IF_STMT: {
+        bool cond;
+        if (!eval_bool(ev, node->as.if_stmt.condition, &cond)) return EXEC_FAIL;
+        if (cond) return exec_body(ev, &node->as.if_stmt.then_body);
+        ElseIfList* elseifs = &node->as.if_stmt.elseifs;
+        for (size_t i = 0; i < elseifs->count; i++) {
+            if (!eval_bool(ev, elseifs->branches[i].condition, &cond)) return EXEC_FAIL;
+            if (cond) return exec_body(ev, &elseifs->branches[i].body);
+        }
+        return exec_body(ev, &node->as.if_stmt.else_body);
+    }
+    case NODE_WHILE_STMT:
+        for (;;) {
+            bool cond;
+            if (++ev->steps > CONST_MAX_STEPS) return EXEC_FAIL;
+            if (!eval_bool(ev, node->as.while_stmt.condition, &cond)) return EXEC_FAIL;
+            if (!cond) return EXEC_NEXT;
+            ExecResult r = exec_body(ev, &node->as.while_stmt.body);
+            if (r == EXEC_RETURN || r == EXEC_FAIL) return r;
+            if (r == EXEC_BREAK) return EXEC_NEXT;
+        }
+    case NODE_FOR_STMT:
+        return exec_for(ev, node);
+    case NODE_MATCH_STMT:
+        return exec_match(ev, node);
+    case NODE_RETURN_STMT:
+        if (!node->as.return_stmt.value || !eval_expr(ev, node->as.return_stmt.value, &ev->ret)) return EXEC_FAIL;
+        return EXEC_RETURN;
+    case NODE_BREAK_STMT:
+        return EXEC_BREAK;
+    case NODE_CONTINUE_STMT:
+        return EXEC_CONTINUE;
+    case NODE_EXPR_STMT: {
+        ConstValue ignored;
+        return eval_expr(ev, node->as.expr_stmt.expr, &ignored) ? EXEC_NEXT : EXEC_FAIL;
+    }
+    default:
+        return EXEC_FAIL;
+    }
+}
+
+static ExecResult exec_body(ConstEval* ev, NodeList* body) {
+    size_t mark = ev->local_count;
+    ExecResult result = EXEC_NEXT;
+    for (size_t i = 0; i < body->count && result == EXEC_NEXT; i++) {
+        result = exec_stmt(ev, body->nodes[i]);
+    }
+    ev->local_count = mark;
+    return result;
+}
+
+// A call to a plain function of the program, run by interpreting its body
+// in its own module with the evaluated arguments.
+static bool eval_call(ConstEval* ev, Node* node, ConstValue* out) {
+    Node* callee = node->as.call_expr.callee;
+    NodeList* args = &node->as.call_expr.args;
+    if (callee->type != NODE_IDENTIFIER || node->as.call_expr.type_args.count > 0) return false;
+    if (is_local(ev, callee->as.identifier.name_atom)) return false;
+
+    SymbolTable* table;
+    Symbol* sym = scope_symbol(ev, callee->as.identifier.name_atom, &table);
+    if (!sym || sym->kind != SYMBOL_FUNC || !sym->node) return false;
+    Node* func = sym->node;
+    if (func->as.func_decl.is_extern || func->as.func_decl.type_params.count > 0 || func->as.func_decl.inst) return false;
+    ParamList* params = &func->as.func_decl.params;
+    if (params->count != args->count || params->count > CONST_MAX_PARAMS) return false;
+    if (ev->depth >= CONST_MAX_DEPTH) return false;
+
+    ConstValue values[CONST_MAX_PARAMS];
+    for (size_t i = 0; i < args->count; i++) {
+        if (!eval_expr(ev, args->nodes[i], &values[i])) return false;
+    }
+
+    SymbolTable* saved_table = ev->table;
+    bool (*saved_lookup)(void*, Atom, Node**) = ev->lookup;
+    size_t saved_start = ev->frame_start;
+    size_t saved_count = ev->local_count;
+    ev->table = table;
+    ev->lookup = NULL;
+    ev->frame_start = ev->local_count;
+    ev->depth++;
+
+    bool ok = true;
+    for (size_t i = 0; i < params->count && ok; i++) {
+        Type* type = const_type(ev, params->params[i].type_node);
+        ConstValue v;
+        ok = type && const_store(ev, type, &values[i], &v);
+        if (ok) local_bind(ev, params->params[i].name_atom, &v);
+    }
+    Type* return_type = const_type(ev, func->as.func_decl.return_type);
+    ok = ok && return_type && exec_body(ev, parser_func_body(func)) == EXEC_RETURN &&
+         const_store(ev, return_type, &ev->ret, out);
+
+    ev->depth--;
+    ev->table = saved_table;
+    ev->lookup = saved_lookup;
+    ev->frame_start = saved_start;
+    ev->local_count = saved_count;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Expressions
+// ---------------------------------------------------------------------------
+
+static bool eval_expr(ConstEval* ev, Node* node, ConstValue* out) {
+    if (!node) return false;
+    switch (node->type) {
+    case NODE_INTEGER_LITERAL: {
+        char* s = node->as.integer_literal.value;
+        size_t n = node->as.integer_literal.value_size;
+        size_t i = 0;
+        bool negative = n > 0 && s[0] == '-';
+        if (negative) i++;
+        if (i == n) return false;
+        int64_t value = 0;
+        for (; i < n; i++) {
+            if (s[i] < '0' || s[i] > '9') return false;
+            int digit = s[i] - '0';
+            if (value > (INT64_MAX - digit) / 10) return false;
+            value = value * 10 + digit;
+        }
+        out->type = NULL;
+        out->value = negative ? -value : value;
+        return true;
+    }
+    case NODE_BOOL_LITERAL:
+        out->type = type_bool(ev->reg);
+        out->value = node->as.bool_literal.value;
+        return true;
+    case NODE_PAREN_EXPR:
+        return eval_expr(ev, node->as.paren_expr.inner, out);
+    case NODE_IDENTIFIER:
+        return eval_identifier(ev, node, out);
+    case NODE_UNARY_EXPR:
+        return eval_unary(ev, node, out);
+    case NODE_BINARY_EXPR:
+        return eval_binary(ev, node, out);
+    case NODE_CAST_EXPR:
+        return eval_cast(ev, node, out);
+    case NODE_SIZEOF_EXPR:
+        out->type = type_usize(ev->reg);
+        return type_size(const_type(ev, node->as.sizeof_expr.type_node), &out->value);
+    case NODE_FIELD_ACCESS:
+        return eval_enum_variant(ev, node, out);
+    case NODE_CALL_EXPR:
+        return eval_call(ev, node, out);
+    default:
+        return false;
+    }
+}
+
+bool const_eval(ConstEval* ev, Node* expr, ConstValue* out) {
+    ev->steps = 0;
+    return eval_expr(ev, expr, out);
+}
+
+Node* const_value_node(Arena* arena, ConstValue* value, Type* type, SourceLoc loc) {
+    if (type->kind == TYPE_BOOL) {
+        Node* literal = node_new(arena, NODE_BOOL_LITERAL, loc);
+        literal->as.bool_literal.value = value->value != 0;
+        literal->resolved_type = type;
+        return literal;
+    }
+
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%lld", (long long)value->value);
+    char* text = arena_alloc(arena, (size_t)len + 1);
+    memcpy(text, buf, (size_t)len + 1);
+    Node* literal = node_new(arena, NODE_INTEGER_LITERAL, loc);
+    literal->as.integer_literal.value = text;
+    literal->as.integer_literal.value_size = (size_t)len;
+    literal->resolved_type = type;
+    if (value->value >= 0) return literal;
+
+    // keep "-5" from merging with a preceding '-'
+    Node* paren = node_new(arena, NODE_PAREN_EXPR, loc);
+    paren->as.paren_expr.inner = literal;
+    paren->resolved_type = type;
+    return paren;
+}
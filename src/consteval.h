@@ -0,0 +1,76 @@
+#ifndef ANCC_CONSTEVAL_H
+#define ANCC_CONSTEVAL_H
+
+#include "arena.h"
+#include "ast.h"
+#include "sema.h"
+#include "type.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Compile-time evaluation of integer and bool expressions: literals,
+// arithmetic, xor, comparisons, casts, sizeof of primitive types, enum
+// variants, constants, and calls to functions whose bodies only compute with
+// such values. It drives everything C needs as a constant: array sizes,
+// match case labels and global initializers.
+//
+// Values are exact: an operation whose result would wrap or overflow in C
+// is not evaluated, so the C program never disagrees with the constant.
+
+typedef struct ConstValue {
+    Type* type;    // NULL for an integer literal that takes the other operand's type
+    int64_t value; // bools are 0 or 1
+} ConstValue;
+
+typedef struct ConstLocal {
+    Atom atom;
+    Type* type;
+    int64_t value;
+} ConstLocal;
+
+typedef struct ConstEval {
+    TypeRegistry* reg;
+    SymbolTable* table; // module scope names resolve in
+
+    // Whether the body the expression is in declares a name; *decl is set to
+    // its constant declaration, or NULL for anything else. Lets sema fold
+    // expressions over local constants.
+    bool (*lookup)(void* data, Atom name_atom, Node** decl);
+    void* lookup_data;
+
+    // locals of the function calls being interpreted
+    ConstLocal* locals;
+    size_t local_count;
+    size_t local_capacity;
+    size_t frame_start;
+
+    ConstValue ret;  // value of the last return statement
+    uint32_t steps;  // statements interpreted, against a fixed budget
+    uint32_t depth;  // nested calls and constant definitions
+} ConstEval;
+
+void const_eval_init(ConstEval* ev, TypeRegistry* reg, SymbolTable* table);
+void const_eval_free(ConstEval* ev);
+
+// Evaluate expr. Returns false when it is not a compile-time constant.
+bool const_eval(ConstEval* ev, Node* expr, ConstValue* out);
+
+// Range of an integer type that every evaluation stays within. The most
+// negative value is left out so each value prints as a C literal of the
+// right sign; pointer-sized types take the narrowest target's range.
+bool const_int_range(Type* type, int64_t* min, int64_t* max);
+bool const_int_fits(Type* type, int64_t value);
+bool const_int_signed(Type* type);
+
+// Exact integer arithmetic (+ - * / ^) and comparisons; false when the
+// result leaves int64 or the operation has no value (division by zero).
+bool const_int_arith(TokenType op, int64_t a, int64_t b, int64_t* out);
+bool const_int_compare(TokenType op, int64_t a, int64_t b, bool* out);
+
+// An integer or bool literal node holding value, with resolved type `type`.
+// A negative integer is wrapped in parentheses.
+Node* const_value_node(Arena* arena, ConstValue* value, Type* type, SourceLoc loc);
+
+#endif
@@ -12,12 +12,10 @@ void errors_init(Arena* arena, Errors* errors) {
     errors->count = 0;
 }
 
-void errors_push(Errors* errors, Severity severity, size_t offset, size_t line, size_t column, char* message, ...) {
+static void errors_append(Errors* errors, Severity severity, size_t offset, size_t line, size_t column,
+                          char* message, va_list args) {
     char buffer[1024];
-    va_list args;
-    va_start(args, message);
     int written = vsnprintf(buffer, sizeof(buffer), message, args);
-    va_end(args);
 
     size_t message_length = written < 0 ? 0 : (written >= sizeof(buffer) ? sizeof(buffer) - 1 : (size_t)written);
 
@@ -39,3 +37,20 @@ void errors_push(Errors* errors, Severity severity, size_t offset, size_t line,
     errors->last = error;
     errors->count++;
 }
+
+void errors_push(Errors* errors, Severity severity, size_t offset, size_t line, size_t column, char* message, ...) {
+    va_list args;
+    va_start(args, message);
+    errors_append(errors, severity, offset, line, column, message, args);
+    va_end(args);
+}
+
+void errors_push_at(Errors* errors, Severity severity, SourceLoc loc, char* message, ...) {
+    size_t line, column;
+    location_resolve(loc, &line, &column);
+
+    va_list args;
+    va_start(args, message);
+    errors_append(errors, severity, loc, line, column, message, args);
+    va_end(args);
+}
@@ -2,6 +2,7 @@
 #define ANCC_ERROR_H
 
 #include "arena.h"
+#include "location.h"
 
 #include <stddef.h>
 
@@ -14,7 +15,7 @@ typedef enum Severity {
 typedef struct Error {
     struct Error* next;
     Severity severity;
-    size_t offset;
+    size_t offset; // file offset, or the SourceLoc for errors_push_at
     size_t line;
     size_t column;
     char message[];
@@ -31,4 +32,7 @@ void errors_init(Arena* arena, Errors* errors);
 
 void errors_push(Errors* errors, Severity severity, size_t offset, size_t line, size_t column, char* message, ...);
 
+// Like errors_push, with line and column resolved from a source location.
+void errors_push_at(Errors* errors, Severity severity, SourceLoc loc, char* message, ...);
+
 #endif
@@ -23,8 +23,11 @@ bool dir_ensure(char* path) {
     return CreateDirectoryA(path, NULL) != 0;
 }
 #else
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 bool dir_exists(char* path) {
     struct stat st;
@@ -63,6 +66,116 @@ char* file_read(Arena* arena, char* path, size_t* out_size) {
     return data;
 }
 
+// ----------------------------------------------------------------------------
+// source mappings
+// ----------------------------------------------------------------------------
+
+#ifdef _WIN32
+
+char* source_load(Arena* arena, char* path, size_t* out_size) {
+    return file_read(arena, path, out_size);
+}
+
+#else
+
+typedef struct SourceMapping {
+    struct SourceMapping* next;
+    char* path;
+    char* data;
+    size_t size;
+    size_t map_size;
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime;
+} SourceMapping;
+
+static SourceMapping* source_mappings;
+
+static bool source_mapping_current(SourceMapping* mapping, struct stat* st) {
+    return mapping->dev == st->st_dev && mapping->ino == st->st_ino &&
+           mapping->size == (size_t)st->st_size &&
+           mapping->mtime.tv_sec == st->st_mtim.tv_sec &&
+           mapping->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+// Maps the file followed by at least one zero byte. A zeroed anonymous region
+// one page larger than the file is reserved and the file is mapped over its
+// start, so the byte after the last one is always a NUL sentinel: either the
+// zero tail of the final file page or the spare page itself.
+static char* source_map(int fd, size_t size, size_t* out_map_size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t map_size = ((size + page - 1) & ~(page - 1)) + page;
+
+    void* reserve = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserve == MAP_FAILED) return NULL;
+
+    void* data = mmap(reserve, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if (data == MAP_FAILED) {
+        munmap(reserve, map_size);
+        return NULL;
+    }
+
+    *out_map_size = map_size;
+    return data;
+}
+
+char* source_load(Arena* arena, char* path, size_t* out_size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+
+    SourceMapping** link = &source_mappings;
+    for (SourceMapping* mapping = source_mappings; mapping; mapping = mapping->next) {
+        if (strcmp(mapping->path, path) == 0) {
+            if (source_mapping_current(mapping, &st)) {
+                close(fd);
+                if (out_size) *out_size = mapping->size;
+                return mapping->data;
+            }
+            // stale: unlink and release, then map the new contents below
+            *link = mapping->next;
+            munmap(mapping->data, mapping->map_size);
+            free(mapping->path);
+            free(mapping);
+            break;
+        }
+        link = &mapping->next;
+    }
+
+    size_t size = (size_t)st.st_size;
+    size_t map_size = 0;
+    char* data = size > 0 ? source_map(fd, size, &map_size) : NULL;
+    close(fd);
+
+    // empty files can't be mapped; anything else that failed to map is read
+    if (!data) {
+        return file_read(arena, path, out_size);
+    }
+
+    SourceMapping* mapping = malloc(sizeof(SourceMapping));
+    size_t path_size = strlen(path);
+    mapping->path = malloc(path_size + 1);
+    memcpy(mapping->path, path, path_size + 1);
+    mapping->data = data;
+    mapping->size = size;
+    mapping->map_size = map_size;
+    mapping->dev = st.st_dev;
+    mapping->ino = st.st_ino;
+    mapping->mtime = st.st_mtim;
+    mapping->next = source_mappings;
+    source_mappings = mapping;
+
+    if (out_size) *out_size = size;
+    return data;
+}
+
+#endif
+
 bool has_extension(char* path, char* extension) {
     size_t path_len = strlen(path);
     size_t ext_len = strlen(extension);
@@ -25,6 +25,13 @@ bool file_exists(char* path);
 
 char* file_read(Arena* arena, char* path, size_t* out_size);
 
+// Read-only, NUL-terminated view of a source file. On POSIX the file is
+// mmapped and the mapping is kept for the life of the process; loading an
+// unchanged file again returns the same mapping. A changed file gets a new
+// mapping and the old one is released, so callers must not hold data from a
+// previous load of the same path. Falls back to file_read elsewhere.
+char* source_load(Arena* arena, char* path, size_t* out_size);
+
 bool has_extension(char* path, char* extension);
 
 bool dir_ensure(char* path);
@@ -0,0 +1,158 @@
+#include "intern.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct AtomEntry {
+    char* name;
+    size_t name_size;
+    uint32_t hash;
+} AtomEntry;
+
+typedef struct Interner {
+    AtomEntry* entries;   // indexed by atom
+    size_t count;
+    size_t capacity;
+    Atom* slots;          // open-addressed index, 0 = empty
+    size_t slot_capacity;
+    char* chunk;          // bump storage for interned bytes
+    size_t chunk_used;
+    size_t chunk_size;
+} Interner;
+
+static Interner interner;
+
+static char* builtin_names[ATOM_BUILTIN_COUNT] = {
+    [ATOM_NONE] = "",
+    [ATOM_VOID] = "void",
+    [ATOM_BOOL] = "bool",
+    [ATOM_BYTE] = "byte",
+    [ATOM_SHORT] = "short",
+    [ATOM_USHORT] = "ushort",
+    [ATOM_INT] = "int",
+    [ATOM_UINT] = "uint",
+    [ATOM_LONG] = "long",
+    [ATOM_ULONG] = "ulong",
+    [ATOM_ISIZE] = "isize",
+    [ATOM_USIZE] = "usize",
+    [ATOM_FLOAT] = "float",
+    [ATOM_DOUBLE] = "double",
+    [ATOM_STRING] = "string",
+    [ATOM_PTR] = "ptr",
+    [ATOM_LEN] = "len",
+    [ATOM_RELEASE] = "release",
+    [ATOM_MAIN] = "main",
+};
+
+uint32_t intern_hash(char* name, size_t name_size) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < name_size; i++) {
+        h ^= (uint8_t)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static char* intern_store(char* name, size_t name_size) {
+    if (interner.chunk_used + name_size + 1 > interner.chunk_size) {
+        // old chunks are never freed: atoms point into them for the process lifetime
+        size_t size = name_size + 1 > 64 * 1024 ? name_size + 1 : 64 * 1024;
+        interner.chunk = malloc(size);
+        interner.chunk_used = 0;
+        interner.chunk_size = size;
+    }
+    char* dst = interner.chunk + interner.chunk_used;
+    memcpy(dst, name, name_size);
+    dst[name_size] = '\0';
+    interner.chunk_used += name_size + 1;
+    return dst;
+}
+
+static void intern_index_put(Atom* slots, size_t capacity, Atom atom) {
+    size_t mask = capacity - 1;
+    size_t i = interner.entries[atom].hash & mask;
+    while (slots[i]) i = (i + 1) & mask;
+    slots[i] = atom;
+}
+
+static void intern_grow(void) {
+    size_t capacity = interner.slot_capacity ? interner.slot_capacity * 2 : 1024;
+    Atom* slots = calloc(capacity, sizeof(Atom));
+    for (Atom a = 1; a < interner.count; a++) {
+        intern_index_put(slots, capacity, a);
+    }
+    free(interner.slots);
+    interner.slots = slots;
+    interner.slot_capacity = capacity;
+}
+
+static Atom intern_insert(char* name, size_t name_size, uint32_t hash) {
+    if (interner.count >= interner.capacity) {
+        size_t capacity = interner.capacity ? interner.capacity * 2 : 512;
+        interner.entries = realloc(interner.entries, capacity * sizeof(AtomEntry));
+        interner.capacity = capacity;
+    }
+    Atom atom = (Atom)interner.count++;
+    AtomEntry* e = &interner.entries[atom];
+    e->name = intern_store(name, name_size);
+    e->name_size = name_size;
+    e->hash = hash;
+
+    // keep the load factor under 1/2
+    if (atom != ATOM_NONE) {
+        if (interner.count * 2 > interner.slot_capacity) {
+            intern_grow();
+        } else {
+            intern_index_put(interner.slots, interner.slot_capacity, atom);
+        }
+    }
+    return atom;
+}
+
+static void intern_init(void) {
+    for (int i = 0; i < ATOM_BUILTIN_COUNT; i++) {
+        size_t size = strlen(builtin_names[i]);
+        intern_insert(builtin_names[i], size, intern_hash(builtin_names[i], size));
+    }
+}
+
+static Atom intern_lookup(char* name, size_t name_size, uint32_t hash) {
+    size_t mask = interner.slot_capacity - 1;
+    for (size_t i = hash & mask; interner.slots[i]; i = (i + 1) & mask) {
+        AtomEntry* e = &interner.entries[interner.slots[i]];
+        if (e->hash == hash && e->name_size == name_size &&
+            memcmp(e->name, name, name_size) == 0) {
+            return interner.slots[i];
+        }
+    }
+    return ATOM_NONE;
+}
+
+Atom intern(char* name, size_t name_size) {
+    if (!interner.entries) intern_init();
+    if (name_size == 0) return ATOM_NONE;
+
+    uint32_t hash = intern_hash(name, name_size);
+    Atom atom = intern_lookup(name, name_size, hash);
+    if (atom != ATOM_NONE) return atom;
+    return intern_insert(name, name_size, hash);
+}
+
+Atom intern_find(char* name, size_t name_size) {
+    if (!interner.entries) intern_init();
+    if (name_size == 0) return ATOM_NONE;
+    return intern_lookup(name, name_size, intern_hash(name, name_size));
+}
+
+char* atom_name(Atom atom) {
+    return interner.entries[atom].name;
+}
+
+size_t atom_size(Atom atom) {
+    return interner.entries[atom].name_size;
+}
+
+uint32_t atom_hash(Atom atom) {
+    return interner.entries[atom].hash;
+}
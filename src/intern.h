@@ -0,0 +1,51 @@
+#ifndef ANCC_INTERN_H
+#define ANCC_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// An atom is the stable id of an interned identifier. Two names are equal iff
+// their atoms are equal. Atom 0 is never handed out and means "no name".
+typedef uint32_t Atom;
+
+// Names the compiler itself looks for, pre-interned with fixed ids.
+typedef enum BuiltinAtom {
+    ATOM_NONE,
+    ATOM_VOID,
+    ATOM_BOOL,
+    ATOM_BYTE,
+    ATOM_SHORT,
+    ATOM_USHORT,
+    ATOM_INT,
+    ATOM_UINT,
+    ATOM_LONG,
+    ATOM_ULONG,
+    ATOM_ISIZE,
+    ATOM_USIZE,
+    ATOM_FLOAT,
+    ATOM_DOUBLE,
+    ATOM_STRING,
+    ATOM_PTR,
+    ATOM_LEN,
+    ATOM_RELEASE,
+    ATOM_MAIN,
+    ATOM_BUILTIN_COUNT,
+} BuiltinAtom;
+
+// The table is process-wide and owns copies of the interned bytes, so atoms
+// stay valid across arena resets (the LSP re-analyzes into a reset arena).
+Atom intern(char* name, size_t name_size);
+
+// The atom of a name already interned, or ATOM_NONE. Lookups use this so a
+// miss does not grow the table.
+Atom intern_find(char* name, size_t name_size);
+
+char* atom_name(Atom atom);
+
+size_t atom_size(Atom atom);
+
+uint32_t atom_hash(Atom atom);
+
+uint32_t intern_hash(char* name, size_t name_size);
+
+#endif
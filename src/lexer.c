@@ -1,5 +1,6 @@
 #include "lexer.h"
 
+#include <stdarg.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
@@ -11,15 +12,13 @@ typedef struct Lexer {
     char* start;
     char* current;
     char* token_start;
-    size_t line;
-    size_t column;
-    size_t token_line;
-    size_t token_column;
 } Lexer;
 
 static void tokens_push(Lexer* lexer, TokenType type) {
     Tokens* tokens = lexer->tokens;
 
+    // capacity is pre-sized from the source length, so this only triggers on
+    // unusually dense input
     if (tokens->count >= tokens->capacity) {
         size_t new_capacity = tokens->capacity * 2;
         Token* new_tokens = arena_alloc(lexer->arena, new_capacity * sizeof(Token));
@@ -28,14 +27,39 @@ static void tokens_push(Lexer* lexer, TokenType type) {
         tokens->capacity = new_capacity;
     }
 
-    Token* token = &tokens->tokens[tokens->count];
-    token->type = type;
-    token->value = lexer->token_start;
-    token->size = (size_t)(lexer->current - lexer->token_start);
-    token->offset = (size_t)(lexer->token_start - lexer->start);
-    token->line = lexer->token_line;
-    token->column = lexer->token_column;
-    tokens->count++;
+    Token* token = &tokens->tokens[tokens->count++];
+    token->offset = (uint32_t)(lexer->token_start - lexer->start);
+    token->size = (uint32_t)(lexer->current - lexer->token_start);
+    token->type = (uint8_t)type;
+}
+
+// Records that a new line begins at the current position.
+static void lexer_newline(Lexer* lexer) {
+    Tokens* tokens = lexer->tokens;
+
+    if (tokens->line_count >= tokens->line_capacity) {
+        size_t new_capacity = tokens->line_capacity * 2;
+        uint32_t* new_starts = arena_alloc(lexer->arena, new_capacity * sizeof(uint32_t));
+        memcpy(new_starts, tokens->line_starts, tokens->line_count * sizeof(uint32_t));
+        tokens->line_starts = new_starts;
+        tokens->line_capacity = new_capacity;
+    }
+
+    tokens->line_starts[tokens->line_count++] = (uint32_t)(lexer->current - lexer->start);
+}
+
+static void lexer_error(Lexer* lexer, char* message, ...) {
+    size_t offset = (size_t)(lexer->token_start - lexer->start);
+    size_t line, column;
+    tokens_position(lexer->tokens, offset, &line, &column);
+
+    char buffer[256];
+    va_list args;
+    va_start(args, message);
+    vsnprintf(buffer, sizeof(buffer), message, args);
+    va_end(args);
+
+    errors_push(lexer->errors, SEVERITY_ERROR, offset, line, column, "%s", buffer);
 }
 
 static char lexer_peek(Lexer* lexer) {
@@ -43,94 +67,270 @@ static char lexer_peek(Lexer* lexer) {
 }
 
 static char lexer_advance(Lexer* lexer) {
-    char c = *lexer->current;
-    lexer->current++;
-    lexer->column++;
-    return c;
+    return *lexer->current++;
 }
 
 static bool lexer_match(Lexer* lexer, char expected) {
     if (*lexer->current == expected) {
         lexer->current++;
-        lexer->column++;
         return true;
     }
     return false;
 }
 
+// ----------------------------------------------------------------------------
+// character classes
+// ----------------------------------------------------------------------------
+
+enum {
+    CHAR_ALPHA = 1 << 0, // a-z A-Z _
+    CHAR_DIGIT = 1 << 1, // 0-9
+    CHAR_SPACE = 1 << 2, // ' ' \t
+};
+
+#define A CHAR_ALPHA
+#define D CHAR_DIGIT
+#define S CHAR_SPACE
+
+static const unsigned char char_class[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, S, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    S, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    D, D, D, D, D, D, D, D, D, D, 0, 0, 0, 0, 0, 0,
+    0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,
+    A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, A,
+    0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,
+    A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, 0,
+    // 0x80-0xff: never part of a token
+};
+
+#undef A
+#undef D
+#undef S
+
 static bool is_alpha(char c) {
-    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    return (char_class[(unsigned char)c] & CHAR_ALPHA) != 0;
 }
 
 static bool is_digit(char c) {
-    return c >= '0' && c <= '9';
+    return (char_class[(unsigned char)c] & CHAR_DIGIT) != 0;
 }
 
-static bool is_alnum(char c) {
-    return is_alpha(c) || is_digit(c);
+// ----------------------------------------------------------------------------
+// keywords
+// ----------------------------------------------------------------------------
+
+typedef struct Keyword {
+    const char* name;
+    size_t size;
+    TokenType type;
+} Keyword;
+
+// Perfect hash over the keyword set: KEYWORD_HASH(s, size) & (KEYWORD_SLOTS - 1)
+// maps each keyword to a distinct slot. The block below is generated by
+// tools/keyword_hash.c; when adding a keyword, add it to the list there and
+// paste the tool's output over the block instead of editing it by hand.
+// generated by tools/keyword_hash.c: begin
+#define KEYWORD_SLOTS 64
+#define KEYWORD_MIN_SIZE 2
+#define KEYWORD_MAX_SIZE 9
+#define KEYWORD_HASH(s, size) ((size) + 15 * (s)[0] + 2 * (s)[1] + 11 * (s)[(size) - 1])
+
+static const Keyword keyword_table[KEYWORD_SLOTS] = {
+    [0] = { "break", 5, TOKEN_BREAK },
+    [1] = { "for", 3, TOKEN_FOR },
+    [3] = { "import", 6, TOKEN_IMPORT },
+    [4] = { "null", 4, TOKEN_NULL },
+    [7] = { "with", 4, TOKEN_WITH },
+    [8] = { "as", 2, TOKEN_AS },
+    [10] = { "continue", 8, TOKEN_CONTINUE },
+    [11] = { "true", 4, TOKEN_TRUE },
+    [13] = { "or", 2, TOKEN_OR },
+    [15] = { "not", 3, TOKEN_NOT },
+    [17] = { "from", 4, TOKEN_FROM },
+    [21] = { "var", 3, TOKEN_VAR },
+    [22] = { "end", 3, TOKEN_END },
+    [23] = { "if", 2, TOKEN_IF },
+    [24] = { "false", 5, TOKEN_FALSE },
+    [26] = { "and", 3, TOKEN_AND },
+    [27] = { "extern", 6, TOKEN_EXTERN },
+    [29] = { "export", 6, TOKEN_EXPORT },
+    [30] = { "else", 4, TOKEN_ELSE },
+    [32] = { "until", 5, TOKEN_UNTIL },
+    [34] = { "match", 5, TOKEN_MATCH },
+    [35] = { "interface", 9, TOKEN_INTERFACE },
+    [37] = { "while", 5, TOKEN_WHILE },
+    [39] = { "struct", 6, TOKEN_STRUCT },
+    [41] = { "func", 4, TOKEN_FUNC },
+    [42] = { "case", 4, TOKEN_CASE },
+    [43] = { "elseif", 6, TOKEN_ELSEIF },
+    [44] = { "const", 5, TOKEN_CONST },
+    [45] = { "self", 4, TOKEN_SELF },
+    [55] = { "sizeof", 6, TOKEN_SIZEOF },
+    [56] = { "return", 6, TOKEN_RETURN },
+    [57] = { "step", 4, TOKEN_STEP },
+    [58] = { "enum", 4, TOKEN_ENUM },
+    [63] = { "in", 2, TOKEN_IN },
+};
+// generated by tools/keyword_hash.c: end
+
+static TokenType keyword_lookup(const char* start, size_t length) {
+    if (length < KEYWORD_MIN_SIZE || length > KEYWORD_MAX_SIZE) {
+        return TOKEN_IDENTIFIER;
+    }
+
+    const unsigned char* s = (const unsigned char*)start;
+    size_t slot = KEYWORD_HASH(s, length) & (KEYWORD_SLOTS - 1);
+    const Keyword* keyword = &keyword_table[slot];
+    if (keyword->size == length && memcmp(keyword->name, start, length) == 0) {
+        return keyword->type;
+    }
+    return TOKEN_IDENTIFIER;
 }
 
-static void lexer_read_identifier_or_keyword(Lexer* lexer) {
-    while (is_alnum(lexer_peek(lexer))) {
-        lexer_advance(lexer);
+// ----------------------------------------------------------------------------
+// bulk scanning
+// ----------------------------------------------------------------------------
+
+// Each scanner returns how many bytes starting at p belong to the run; none of
+// them cross a newline, so the caller never has to update the line index.
+// The SIMD variants use aligned loads, which never cross a page boundary and so
+// may safely read past the NUL terminator within the same block.
+
+typedef size_t (*ScanFunc)(const char* p);
+
+typedef struct Scanner {
+    ScanFunc identifier; // [A-Za-z0-9_]*
+    ScanFunc blanks;     // [ \t]*
+    ScanFunc line;       // up to '\n' or NUL
+    ScanFunc string;     // up to '"', '\n' or NUL
+} Scanner;
+
+static size_t scan_identifier_scalar(const char* p) {
+    const char* s = p;
+    while (char_class[(unsigned char)*s] & (CHAR_ALPHA | CHAR_DIGIT)) s++;
+    return (size_t)(s - p);
+}
+
+static size_t scan_blanks_scalar(const char* p) {
+    const char* s = p;
+    while (char_class[(unsigned char)*s] & CHAR_SPACE) s++;
+    return (size_t)(s - p);
+}
+
+static size_t scan_line_scalar(const char* p) {
+    const char* s = p;
+    while (*s != '\n' && *s != '\0') s++;
+    return (size_t)(s - p);
+}
+
+static size_t scan_string_scalar(const char* p) {
+    const char* s = p;
+    while (*s != '"' && *s != '\n' && *s != '\0') s++;
+    return (size_t)(s - p);
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define LEXER_SCAN_X86 1
+#include <immintrin.h>
+#include <stdint.h>
+
+enum { SCAN_LINE, SCAN_STRING };
+
+__attribute__((target("sse2")))
+static inline uint32_t sse2_stop_mask(__m128i v, int kind) {
+    __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+    if (kind == SCAN_STRING) hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+    return (uint32_t)_mm_movemask_epi8(hit);
+}
+
+__attribute__((target("sse2")))
+static inline size_t scan_sse2(const char* p, int kind) {
+    const char* block = (const char*)((uintptr_t)p & ~(uintptr_t)15);
+    uint32_t stop = sse2_stop_mask(_mm_load_si128((const __m128i*)block), kind) & (0xFFFFu << (p - block));
+    while (stop == 0) {
+        block += 16;
+        stop = sse2_stop_mask(_mm_load_si128((const __m128i*)block), kind);
     }
+    return (size_t)(block + __builtin_ctz(stop) - p);
+}
 
-    size_t length = (size_t)(lexer->current - lexer->token_start);
-    char* start = lexer->token_start;
-    TokenType type = TOKEN_IDENTIFIER;
-
-    switch (length) {
-    case 2:
-        if (strncmp(start, "if", 2) == 0)           type = TOKEN_IF;
-        else if (strncmp(start, "in", 2) == 0)      type = TOKEN_IN;
-        else if (strncmp(start, "or", 2) == 0)      type = TOKEN_OR;
-        else if (strncmp(start, "as", 2) == 0)      type = TOKEN_AS;
-        break;
-    case 3:
-        if (strncmp(start, "end", 3) == 0)          type = TOKEN_END;
-        else if (strncmp(start, "var", 3) == 0)     type = TOKEN_VAR;
-        else if (strncmp(start, "for", 3) == 0)     type = TOKEN_FOR;
-        else if (strncmp(start, "and", 3) == 0)     type = TOKEN_AND;
-        else if (strncmp(start, "not", 3) == 0)     type = TOKEN_NOT;
-        break;
-    case 4:
-        if (strncmp(start, "func", 4) == 0)         type = TOKEN_FUNC;
-        else if (strncmp(start, "else", 4) == 0)    type = TOKEN_ELSE;
-        else if (strncmp(start, "step", 4) == 0)    type = TOKEN_STEP;
-        else if (strncmp(start, "case", 4) == 0)    type = TOKEN_CASE;
-        else if (strncmp(start, "enum", 4) == 0)    type = TOKEN_ENUM;
-        else if (strncmp(start, "self", 4) == 0)    type = TOKEN_SELF;
-        else if (strncmp(start, "null", 4) == 0)    type = TOKEN_NULL;
-        else if (strncmp(start, "true", 4) == 0)    type = TOKEN_TRUE;
-        else if (strncmp(start, "from", 4) == 0)    type = TOKEN_FROM;
-        else if (strncmp(start, "with", 4) == 0)    type = TOKEN_WITH;
-        break;
-    case 5:
-        if (strncmp(start, "const", 5) == 0)        type = TOKEN_CONST;
-        else if (strncmp(start, "until", 5) == 0)   type = TOKEN_UNTIL;
-        else if (strncmp(start, "while", 5) == 0)   type = TOKEN_WHILE;
-        else if (strncmp(start, "break", 5) == 0)   type = TOKEN_BREAK;
-        else if (strncmp(start, "match", 5) == 0)   type = TOKEN_MATCH;
-        else if (strncmp(start, "false", 5) == 0)   type = TOKEN_FALSE;
-        break;
-    case 6:
-        if (strncmp(start, "return", 6) == 0)       type = TOKEN_RETURN;
-        else if (strncmp(start, "export", 6) == 0)  type = TOKEN_EXPORT;
-        else if (strncmp(start, "elseif", 6) == 0)  type = TOKEN_ELSEIF;
-        else if (strncmp(start, "struct", 6) == 0)  type = TOKEN_STRUCT;
-        else if (strncmp(start, "import", 6) == 0)  type = TOKEN_IMPORT;
-        else if (strncmp(start, "extern", 6) == 0)  type = TOKEN_EXTERN;
-        else if (strncmp(start, "sizeof", 6) == 0)  type = TOKEN_SIZEOF;
-        break;
-    case 8:
-        if (strncmp(start, "continue", 8) == 0)     type = TOKEN_CONTINUE;
-        break;
-    case 9:
-        if (strncmp(start, "interface", 9) == 0)    type = TOKEN_INTERFACE;
-        break;
+__attribute__((target("sse2"))) static size_t scan_line_sse2(const char* p) { return scan_sse2(p, SCAN_LINE); }
+__attribute__((target("sse2"))) static size_t scan_string_sse2(const char* p) { return scan_sse2(p, SCAN_STRING); }
+
+__attribute__((target("avx2")))
+static inline uint32_t avx2_stop_mask(__m256i v, int kind) {
+    __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                                  _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+    if (kind == SCAN_STRING) hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+    return (uint32_t)_mm256_movemask_epi8(hit);
+}
+
+__attribute__((target("avx2")))
+static inline size_t scan_avx2(const char* p, int kind) {
+    const char* block = (const char*)((uintptr_t)p & ~(uintptr_t)31);
+    uint32_t stop = avx2_stop_mask(_mm256_load_si256((const __m256i*)block), kind) & (0xFFFFFFFFu << (p - block));
+    while (stop == 0) {
+        block += 32;
+        stop = avx2_stop_mask(_mm256_load_si256((const __m256i*)block), kind);
+    }
+    return (size_t)(block + __builtin_ctz(stop) - p);
+}
+
+__attribute__((target("avx2"))) static size_t scan_line_avx2(const char* p) { return scan_avx2(p, SCAN_LINE); }
+__attribute__((target("avx2"))) static size_t scan_string_avx2(const char* p) { return scan_avx2(p, SCAN_STRING); }
+#endif
+
+static const Scanner scanner_scalar = {
+    scan_identifier_scalar, scan_blanks_scalar, scan_line_scalar, scan_string_scalar,
+};
+
+#ifdef LEXER_SCAN_X86
+// Identifiers and blank runs are a few bytes long, so the vector setup costs
+// more than it saves; only comment lines and string bodies use SIMD.
+static const Scanner scanner_sse2 = {
+    scan_identifier_scalar, scan_blanks_scalar, scan_line_sse2, scan_string_sse2,
+};
+
+static const Scanner scanner_avx2 = {
+    scan_identifier_scalar, scan_blanks_scalar, scan_line_avx2, scan_string_avx2,
+};
+#endif
+
+static const Scanner* scanner;
+
+LexerScanLevel lexer_scan_detect(void) {
+#ifdef LEXER_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return LEXER_SCAN_AVX2;
+    if (__builtin_cpu_supports("sse2")) return LEXER_SCAN_SSE2;
+#endif
+    return LEXER_SCAN_SCALAR;
+}
+
+LexerScanLevel lexer_scan_select(LexerScanLevel level) {
+    LexerScanLevel supported = lexer_scan_detect();
+    if (level > supported) level = supported;
+
+    switch (level) {
+#ifdef LEXER_SCAN_X86
+    case LEXER_SCAN_AVX2: scanner = &scanner_avx2; break;
+    case LEXER_SCAN_SSE2: scanner = &scanner_sse2; break;
+#endif
+    default: scanner = &scanner_scalar; level = LEXER_SCAN_SCALAR; break;
     }
+    return level;
+}
 
-    tokens_push(lexer, type);
+static void lexer_skip(Lexer* lexer, size_t count) {
+    lexer->current += count;
+}
+
+static void lexer_read_identifier_or_keyword(Lexer* lexer) {
+    lexer_skip(lexer, scanner->identifier(lexer->current));
+
+    size_t length = (size_t)(lexer->current - lexer->token_start);
+    tokens_push(lexer, keyword_lookup(lexer->token_start, length));
 }
 
 static void lexer_read_number(Lexer* lexer) {
@@ -157,18 +357,15 @@ static void lexer_read_number(Lexer* lexer) {
 }
 
 static void lexer_read_string(Lexer* lexer) {
-    while (lexer_peek(lexer) != '"' && lexer_peek(lexer) != '\0') {
-        if (lexer_peek(lexer) == '\n') {
-            lexer->line++;
-            lexer->column = 0;
-        }
+    lexer_skip(lexer, scanner->string(lexer->current));
+    while (lexer_peek(lexer) == '\n') {
         lexer_advance(lexer);
+        lexer_newline(lexer);
+        lexer_skip(lexer, scanner->string(lexer->current));
     }
 
     if (lexer_peek(lexer) == '\0') {
-        size_t start_offset = (size_t)(lexer->token_start - lexer->start);
-        errors_push(lexer->errors, SEVERITY_ERROR, start_offset, lexer->token_line, lexer->token_column,
-                     "Unterminated string literal.");
+        lexer_error(lexer, "Unterminated string literal.");
         tokens_push(lexer, TOKEN_ERROR);
         return;
     }
@@ -185,26 +382,47 @@ void lexer_tokenize(Arena* arena, Tokens* tokens, Errors* errors, char* buffer,
     lexer.start = buffer;
     lexer.current = buffer;
     lexer.token_start = buffer;
-    lexer.line = 1;
-    lexer.column = 1;
-    lexer.token_line = 1;
-    lexer.token_column = 1;
 
-    size_t estimated = buffer_size / 2;
+    // AVX2's 32-byte blocks overshoot the short comments and strings of real
+    // source; on lexer_bench it trails SSE2, so it is only used when selected.
+    if (!scanner) {
+        lexer_scan_select(LEXER_SCAN_SSE2);
+    }
+
+    // Offsets and lengths are 32-bit. A source too large for them is refused
+    // before anything is sized by it.
+    bool too_large = buffer_size > UINT32_MAX;
+
+    // Real code averages well over four bytes per token and one line per
+    // ~32 bytes; denser input falls back to doubling.
+    size_t estimated = too_large ? 0 : buffer_size / 4;
     tokens->capacity = estimated < 256 ? 256 : estimated;
     tokens->count = 0;
     tokens->tokens = arena_alloc(arena, tokens->capacity * sizeof(Token));
+    tokens->source = buffer;
+
+    size_t estimated_lines = too_large ? 0 : buffer_size / 32;
+    tokens->line_capacity = estimated_lines < 64 ? 64 : estimated_lines;
+    tokens->line_count = 1;
+    tokens->line_starts = arena_alloc(arena, tokens->line_capacity * sizeof(uint32_t));
+    tokens->line_starts[0] = 0;
+
+    if (too_large) {
+        lexer_error(&lexer, "Source file is too large (%zu bytes).", buffer_size);
+        tokens_push(&lexer, TOKEN_END_OF_FILE);
+        tokens->base = 0;
+        return;
+    }
 
     while (*lexer.current != '\0') {
         lexer.token_start = lexer.current;
-        lexer.token_line = lexer.line;
-        lexer.token_column = lexer.column;
 
         char c = lexer_advance(&lexer);
 
         switch (c) {
         case ' ':
         case '\t':
+            lexer_skip(&lexer, scanner->blanks(lexer.current));
             break;
 
         case '\r':
@@ -212,14 +430,12 @@ void lexer_tokenize(Arena* arena, Tokens* tokens, Errors* errors, char* buffer,
                 lexer_advance(&lexer);
             }
             tokens_push(&lexer, TOKEN_NEWLINE);
-            lexer.line++;
-            lexer.column = 1;
+            lexer_newline(&lexer);
             break;
 
         case '\n':
             tokens_push(&lexer, TOKEN_NEWLINE);
-            lexer.line++;
-            lexer.column = 1;
+            lexer_newline(&lexer);
             break;
 
         case '(': tokens_push(&lexer, TOKEN_LEFT_PAREN); break;
@@ -231,9 +447,7 @@ void lexer_tokenize(Arena* arena, Tokens* tokens, Errors* errors, char* buffer,
         case '.': tokens_push(&lexer, TOKEN_DOT); break;
 
         case '#':
-            while (lexer_peek(&lexer) != '\n' && lexer_peek(&lexer) != '\0') {
-                lexer_advance(&lexer);
-            }
+            lexer_skip(&lexer, scanner->line(lexer.current));
             break;
 
         case '+':
@@ -280,9 +494,7 @@ void lexer_tokenize(Arena* arena, Tokens* tokens, Errors* errors, char* buffer,
             if (lexer_match(&lexer, '=')) {
                 tokens_push(&lexer, TOKEN_NOT_EQUAL);
             } else {
-                size_t offset = (size_t)(lexer.token_start - lexer.start);
-                errors_push(errors, SEVERITY_ERROR, offset, lexer.token_line, lexer.token_column,
-                             "Unexpected character '!'.");
+                lexer_error(&lexer, "Unexpected character '!'.");
                 tokens_push(&lexer, TOKEN_ERROR);
             }
             break;
@@ -313,9 +525,7 @@ void lexer_tokenize(Arena* arena, Tokens* tokens, Errors* errors, char* buffer,
             } else if (is_digit(c)) {
                 lexer_read_number(&lexer);
             } else {
-                size_t offset = (size_t)(lexer.token_start - lexer.start);
-                errors_push(errors, SEVERITY_ERROR, offset, lexer.token_line, lexer.token_column,
-                             "Unexpected character '%c'.", c);
+                lexer_error(&lexer, "Unexpected character '%c'.", c);
                 tokens_push(&lexer, TOKEN_ERROR);
             }
             break;
@@ -323,9 +533,17 @@ void lexer_tokenize(Arena* arena, Tokens* tokens, Errors* errors, char* buffer,
     }
 
     lexer.token_start = lexer.current;
-    lexer.token_line = lexer.line;
-    lexer.token_column = lexer.column;
     tokens_push(&lexer, TOKEN_END_OF_FILE);
+
+    tokens->base = location_add_file(tokens->line_starts, tokens->line_count, buffer_size);
+}
+
+char* token_text(Tokens* tokens, Token* token) {
+    return tokens->source + token->offset;
+}
+
+void tokens_position(Tokens* tokens, size_t offset, size_t* line, size_t* column) {
+    line_index_lookup(tokens->line_starts, tokens->line_count, offset, line, column);
 }
 
 void lexer_print(Tokens* tokens) {
@@ -397,10 +615,12 @@ void lexer_print(Tokens* tokens) {
 
     for (size_t i = 0; i < tokens->count; i++) {
         Token* tok = &tokens->tokens[i];
+        size_t line, column;
+        tokens_position(tokens, tok->offset, &line, &column);
         if (tok->type == TOKEN_NEWLINE) {
-            printf("%s %zu:%zu\n", token_names[tok->type], tok->line, tok->column);
+            printf("%s %zu:%zu\n", token_names[tok->type], line, column);
         } else {
-            printf("%s %zu:%zu %.*s\n", token_names[tok->type], tok->line, tok->column, (int)tok->size, tok->value);
+            printf("%s %zu:%zu %.*s\n", token_names[tok->type], line, column, (int)tok->size, token_text(tokens, tok));
         }
     }
 }
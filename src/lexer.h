@@ -3,8 +3,10 @@
 
 #include "arena.h"
 #include "error.h"
+#include "location.h"
 
 #include <stddef.h>
+#include <stdint.h>
 
 typedef enum TokenType {
     // literals
@@ -91,23 +93,42 @@ typedef enum TokenType {
     TOKEN_ERROR,
 } TokenType;
 
+// 12 bytes per token: text and position are derived from the source and the
+// line-start index in Tokens.
 typedef struct Token {
-    TokenType type;
-    char* value;
-    size_t size;
-    size_t offset;
-    size_t line;
-    size_t column;
+    uint32_t offset;
+    uint32_t size;
+    uint8_t type; // TokenType
 } Token;
 
 typedef struct Tokens {
     Token* tokens;
     size_t count;
     size_t capacity;
+    char* source;
+    uint32_t* line_starts; // offset of the first byte of each line
+    size_t line_count;
+    size_t line_capacity;
+    SourceLoc base; // location of offset 0 once lexing is done
 } Tokens;
 
+// Bulk scanning implementation; SSE2 where supported is picked on first use.
+typedef enum LexerScanLevel {
+    LEXER_SCAN_SCALAR,
+    LEXER_SCAN_SSE2,
+    LEXER_SCAN_AVX2,
+} LexerScanLevel;
+
+LexerScanLevel lexer_scan_detect(void);
+LexerScanLevel lexer_scan_select(LexerScanLevel level); // clamps to what the CPU supports
+
 void lexer_tokenize(Arena* arena, Tokens* tokens, Errors* errors, char* buffer, size_t buffer_size);
 
 void lexer_print(Tokens* tokens);
 
+char* token_text(Tokens* tokens, Token* token);
+
+// 1-based line and column of a byte offset, by binary search over line_starts.
+void tokens_position(Tokens* tokens, size_t offset, size_t* line, size_t* column);
+
 #endif
@@ -0,0 +1,103 @@
+#include "location.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct LocationFile {
+    SourceLoc base;
+    size_t size;
+    uint32_t* line_starts;
+    size_t line_count;
+} LocationFile;
+
+typedef struct LocationTable {
+    LocationFile* files; // ascending base
+    size_t count;
+    size_t capacity;
+    SourceLoc next_base;
+} LocationTable;
+
+static LocationTable locations;
+
+SourceLoc location_add_file(uint32_t* line_starts, size_t line_count, size_t size) {
+    if (locations.next_base == 0) locations.next_base = 1;
+
+    // the end-of-file position is addressable too
+    if ((uint64_t)locations.next_base + size + 1 > UINT32_MAX) {
+        return 0;
+    }
+
+    if (locations.count >= locations.capacity) {
+        locations.capacity = locations.capacity ? locations.capacity * 2 : 64;
+        locations.files = realloc(locations.files, locations.capacity * sizeof(LocationFile));
+    }
+
+    LocationFile* file = &locations.files[locations.count++];
+    file->base = locations.next_base;
+    file->size = size;
+    file->line_count = line_count;
+    file->line_starts = malloc(line_count * sizeof(uint32_t));
+    memcpy(file->line_starts, line_starts, line_count * sizeof(uint32_t));
+
+    locations.next_base += (SourceLoc)(size + 1);
+    return file->base;
+}
+
+void line_index_lookup(uint32_t* line_starts, size_t line_count, size_t offset, size_t* line, size_t* column) {
+    // last line starting at or before offset
+    size_t lo = 0;
+    size_t hi = line_count;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (line_starts[mid] <= offset) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    *line = lo + 1;
+    *column = offset - line_starts[lo] + 1;
+}
+
+void location_resolve(SourceLoc loc, size_t* line, size_t* column) {
+    *line = 0;
+    *column = 0;
+    if (loc == 0 || locations.count == 0) return;
+
+    // last file whose base is at or before loc
+    size_t lo = 0;
+    size_t hi = locations.count;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (locations.files[mid].base <= loc) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    LocationFile* file = &locations.files[lo];
+    if (loc < file->base || loc - file->base > file->size) return;
+    line_index_lookup(file->line_starts, file->line_count, loc - file->base, line, column);
+}
+
+size_t location_line(SourceLoc loc) {
+    size_t line, column;
+    location_resolve(loc, &line, &column);
+    return line;
+}
+
+size_t location_column(SourceLoc loc) {
+    size_t line, column;
+    location_resolve(loc, &line, &column);
+    return column;
+}
+
+void location_reset(void) {
+    for (size_t i = 0; i < locations.count; i++) {
+        free(locations.files[i].line_starts);
+    }
+    locations.count = 0;
+    locations.next_base = 1;
+}
@@ -0,0 +1,30 @@
+#ifndef ANCC_LOCATION_H
+#define ANCC_LOCATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A source location is a 32-bit position in one address space shared by every
+// file lexed in the process: each file owns the range [base, base + size].
+// Location 0 is never handed out and means "unknown" (line 0, column 0).
+typedef uint32_t SourceLoc;
+
+// Registers a lexed file and returns its base. The registry keeps its own copy
+// of the line index, so locations stay resolvable across arena resets.
+SourceLoc location_add_file(uint32_t* line_starts, size_t line_count, size_t size);
+
+// 1-based line and column of a location.
+void location_resolve(SourceLoc loc, size_t* line, size_t* column);
+
+size_t location_line(SourceLoc loc);
+
+size_t location_column(SourceLoc loc);
+
+// Forgets every registered file; for long-lived processes that re-analyze
+// into a reset arena (the LSP server).
+void location_reset(void);
+
+// Line and column of a file-local offset, by binary search over line_starts.
+void line_index_lookup(uint32_t* line_starts, size_t line_count, size_t offset, size_t* line, size_t* column);
+
+#endif
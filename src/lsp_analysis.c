@@ -1,5 +1,9 @@
 #include "lsp_analysis.h"
 #include "sema.h"
+#include "module_cache.h"
+#include "fs.h"
+
+#include <stdio.h>
 
 LspAnalysisResult lsp_analyze(Arena* arena, char* src_dir,
                               char* override_path, char* override_source,
@@ -12,11 +16,24 @@ LspAnalysisResult lsp_analyze(Arena* arena, char* src_dir,
     result.graph.override_path = override_path;
     result.graph.override_source = override_source;
     result.graph.override_source_len = override_source_len;
+    result.graph.main_bodies_only = true;
+
+    // share the interface cache of a package that has been built; analysis
+    // never creates it, and a path that does not fit means no cache
+    char cache_dir[1024];
+    int cache_dir_len = snprintf(cache_dir, sizeof(cache_dir), "%s/../build/cache", src_dir);
+    if (cache_dir_len > 0 && (size_t)cache_dir_len < sizeof(cache_dir) && dir_exists(cache_dir)) {
+        result.graph.cache_dir = cache_dir;
+    }
 
     result.main_module = module_resolve(&result.graph, module_name, module_name_len);
     if (result.main_module) {
+        if (result.errors.count == 0) {
+            module_cache_store(&result.graph);
+        }
         sema_analyze(arena, &result.errors, &result.graph);
     }
+    result.graph.cache_dir = NULL; // points into this frame
 
     return result;
 }
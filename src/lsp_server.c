@@ -3,6 +3,7 @@
 #include "lsp_transport.h"
 #include "lsp_analysis.h"
 #include "arena.h"
+#include "location.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -194,6 +195,7 @@ static void send_notification(Arena* arena, const char* method,
 
 static void analyze_and_publish(LspServer* server, LspDocument* doc) {
     arena_reset(&server->analysis_arena);
+    location_reset();
 
     char src_dir[1024];
     char stem[256];
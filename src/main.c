@@ -2,12 +2,15 @@
 #include "lexer.h"
 #include "parser.h"
 #include "module.h"
+#include "module_cache.h"
 #include "sema.h"
+#include "opt.h"
 #include "codegen.h"
 #include "package.h"
 #include "fs.h"
 #include "compile.h"
 #include "os.h"
+#include "report.h"
 #include "error.h"
 #include "lsp_server.h"
 
@@ -23,6 +26,8 @@ int main(int argc, char** argv) {
             "Commands:\n"
             "  ancc init [name]     Create a new project.\n"
             "  ancc build [dir]     Build package.\n"
+            "    --report=<list>    Print reports after building: generics, size, devirt, opt,\n"
+            "                       loops.\n"
             "  ancc run <file>      Compile and run a file.\n"
             "  ancc lsp [dir]       Run LSP mode.\n"
             "  ancc lexer [file]    Print tokens.\n"
@@ -41,7 +46,7 @@ int main(int argc, char** argv) {
         arena_init(&arena, 16 * 1024 * 1024);
 
         size_t buffer_size;
-        char* buffer = file_read(&arena, argv[2], &buffer_size);
+        char* buffer = source_load(&arena, argv[2], &buffer_size);
         if (!buffer) {
             fprintf(stderr, "Error: File not found '%s'.\n", argv[2]);
             arena_free(&arena);
@@ -74,7 +79,7 @@ int main(int argc, char** argv) {
         arena_init(&arena, 16 * 1024 * 1024);
 
         size_t buffer_size;
-        char* buffer = file_read(&arena, argv[2], &buffer_size);
+        char* buffer = source_load(&arena, argv[2], &buffer_size);
         if (!buffer) {
             fprintf(stderr, "Error: File not found '%s'.\n", argv[2]);
             arena_free(&arena);
@@ -87,7 +92,7 @@ int main(int argc, char** argv) {
         Tokens tokens;
         lexer_tokenize(&arena, &tokens, &errors, buffer, buffer_size);
 
-        Node* ast = parser_parse(&arena, &tokens, &errors);
+        Node* ast = parser_parse(&arena, &tokens, &errors, false);
         ast_print(ast, 0);
 
         for (Error* error = errors.first; error; error = error->next) {
@@ -99,7 +104,39 @@ int main(int argc, char** argv) {
     }
 
     if (strcmp(argv[1], "build") == 0) {
-        char* dir = argc >= 3 ? argv[2] : ".";
+        char* dir = ".";
+        bool show_generics = false;
+        bool show_sizes = false;
+        bool show_devirt = false;
+        bool show_opt = false;
+        bool show_loops = false;
+        for (int i = 2; i < argc; i++) {
+            if (strncmp(argv[i], "--report=", 9) != 0) {
+                dir = argv[i];
+                continue;
+            }
+            // comma-separated report names
+            char* name = argv[i] + 9;
+            while (*name) {
+                size_t len = strcspn(name, ",");
+                if (len == 8 && strncmp(name, "generics", 8) == 0) {
+                    show_generics = true;
+                } else if (len == 4 && strncmp(name, "size", 4) == 0) {
+                    show_sizes = true;
+                } else if (len == 6 && strncmp(name, "devirt", 6) == 0) {
+                    show_devirt = true;
+                } else if (len == 3 && strncmp(name, "opt", 3) == 0) {
+                    show_opt = true;
+                } else if (len == 5 && strncmp(name, "loops", 5) == 0) {
+                    show_loops = true;
+                } else {
+                    fprintf(stderr, "error: unknown report '%.*s'\n", (int)len, name);
+                    return EXIT_FAILURE;
+                }
+                name += len;
+                if (*name == ',') name++;
+            }
+        }
 
         Arena arena;
         arena_init(&arena, 16 * 1024 * 1024);
@@ -119,8 +156,19 @@ int main(int argc, char** argv) {
         char src_dir[1024];
         snprintf(src_dir, sizeof(src_dir), "%s/src", dir);
 
+        char output_dir[1024];
+        snprintf(output_dir, sizeof(output_dir), "%s/build", dir);
+
+        char cache_dir[1024];
+        int cache_dir_len = snprintf(cache_dir, sizeof(cache_dir), "%s/cache", output_dir);
+
         ModuleGraph graph;
         module_graph_init(&graph, &arena, &errors, src_dir);
+        if (cache_dir_len > 0 && (size_t)cache_dir_len < sizeof(cache_dir)) {
+            graph.cache_dir = cache_dir;
+        } else {
+            fprintf(stderr, "warning: cache path too long, building without the interface cache\n");
+        }
 
         size_t entry_len = strlen(pkg.entry);
         Module* entry = module_resolve(&graph, pkg.entry, entry_len);
@@ -132,12 +180,30 @@ int main(int argc, char** argv) {
             return EXIT_FAILURE;
         }
 
+        // interfaces of the imported modules, for the LSP's next analysis;
+        // stored as parsed, before sema and opt_run rewrite them
+        if (errors.count == 0 && dir_ensure(output_dir)) {
+            module_cache_store(&graph);
+        }
+
         sema_analyze(&arena, &errors, &graph);
 
-        char output_dir[1024];
-        snprintf(output_dir, sizeof(output_dir), "%s/build", dir);
+        FuncSizeList func_sizes = {0};
+        if (show_generics || show_sizes) {
+            graph.func_sizes = &func_sizes;
+        }
+        DevirtStats devirt = {0};
+        if (show_devirt) {
+            graph.devirt = &devirt;
+        }
 
+        OptStats opt_stats = {0};
+        LoopList loops = {0};
+        if (show_loops) {
+            opt_stats.loops = &loops;
+        }
         if (errors.count == 0) {
+            opt_run(&arena, &graph, &opt_stats);
             codegen(&arena, &errors, &pkg, &graph, entry, output_dir);
         }
 
@@ -145,6 +211,34 @@ int main(int argc, char** argv) {
             compile(&arena, &errors, &pkg, &graph, output_dir);
         }
 
+        if (errors.count == 0 && graph.func_sizes) {
+            char bin_path[1024];
+#ifdef _WIN32
+            int bin_path_len = snprintf(bin_path, sizeof(bin_path), "%s/%s.exe", output_dir, pkg.name);
+#else
+            int bin_path_len = snprintf(bin_path, sizeof(bin_path), "%s/%s", output_dir, pkg.name);
+#endif
+            // without the symbol table the reports leave out their obj bytes columns
+            if (bin_path_len < 0 || (size_t)bin_path_len >= sizeof(bin_path)) {
+                fprintf(stderr, "warning: binary path too long, object sizes not reported\n");
+            } else if (!report_object_sizes(&arena, &func_sizes, bin_path)) {
+                fprintf(stderr, "warning: cannot read symbols of '%s', object sizes not reported\n", bin_path);
+            }
+            if (show_generics) report_generics(&arena, &graph, &func_sizes);
+            if (show_sizes) report_size(&arena, &func_sizes);
+        }
+        func_size_list_free(&func_sizes);
+        if (errors.count == 0 && graph.devirt) {
+            report_devirt(&devirt);
+        }
+        if (errors.count == 0 && show_opt) {
+            report_opt(&opt_stats);
+        }
+        if (errors.count == 0 && show_loops) {
+            report_loops(&loops);
+        }
+        loop_list_free(&loops);
+
         for (Error* error = errors.first; error; error = error->next) {
             fprintf(stderr, "%zu:%zu: %s\n", error->line, error->column, error->message);
         }
@@ -231,6 +325,7 @@ int main(int argc, char** argv) {
         dir_ensure(output_dir);
 
         if (errors.count == 0) {
+            opt_run(&arena, &graph, NULL);
             codegen(&arena, &errors, &pkg, &graph, entry, output_dir);
         }
 
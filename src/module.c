@@ -1,6 +1,7 @@
 #include "module.h"
 #include "fs.h"
 #include "lexer.h"
+#include "module_cache.h"
 #include "parser.h"
 
 #include <stdio.h>
@@ -16,6 +17,10 @@ void module_graph_init(ModuleGraph* graph, Arena* arena, Errors* errors, char* s
     graph->override_path = NULL;
     graph->override_source = NULL;
     graph->override_source_len = 0;
+    graph->main_bodies_only = false;
+    graph->cache_dir = NULL;
+    graph->func_sizes = NULL;
+    graph->devirt = NULL;
 }
 
 Module* module_find(ModuleGraph* graph, char* path) {
@@ -33,12 +38,13 @@ static Module* module_graph_add(ModuleGraph* graph) {
     m->name = NULL;
     m->path = NULL;
     m->ast = NULL;
+    m->source_hash = 0;
+    m->from_cache = false;
     m->symbols = NULL;
     m->impl_pairs.pairs = NULL;
     m->impl_pairs.count = 0;
     m->impl_pairs.capacity = 0;
-    m->generic_insts.first = NULL;
-    m->generic_insts.last = NULL;
+    memset(&m->generic_insts, 0, sizeof(GenericInstList));
     if (!graph->first) {
         graph->first = m;
     } else {
@@ -108,25 +114,41 @@ Module* module_resolve(ModuleGraph* graph, char* module_path, size_t module_path
         source = graph->override_source;
         source_size = graph->override_source_len;
     } else {
-        source = file_read(graph->arena, file_path, &source_size);
+        source = source_load(graph->arena, file_path, &source_size);
     }
     if (!source) {
         errors_push(graph->errors, SEVERITY_ERROR, 0, 0, 0, "cannot open module '%s'", file_path);
         return NULL;
     }
 
-    // lex
-    Tokens tokens;
-    lexer_tokenize(graph->arena, &tokens, graph->errors, source, source_size);
+    char* name = extract_module_name(graph->arena, module_path, module_path_size);
+    bool is_import = graph->count > 0;
+    uint64_t source_hash = module_cache_hash(source, source_size);
 
-    // parse
-    Node* ast = parser_parse(graph->arena, &tokens, graph->errors);
+    // an import that is only needed for its declarations can come from the
+    // interface cache instead of the front end
+    Node* ast = NULL;
+    if (is_import && graph->main_bodies_only && graph->cache_dir) {
+        ast = module_cache_load(graph->arena, graph->cache_dir, name, source_hash);
+    }
+    bool from_cache = ast != NULL;
+
+    if (!ast) {
+        // lex (tokens stay in the arena for deferred function bodies)
+        Tokens* tokens = arena_alloc(graph->arena, sizeof(Tokens));
+        lexer_tokenize(graph->arena, tokens, graph->errors, source, source_size);
+
+        // parse; imported modules defer function bodies until something needs them
+        ast = parser_parse(graph->arena, tokens, graph->errors, is_import);
+    }
 
     // add to graph before resolving imports (handles circular imports)
     Module* module = module_graph_add(graph);
-    module->name = extract_module_name(graph->arena, module_path, module_path_size);
+    module->name = name;
     module->path = file_path;
     module->ast = ast;
+    module->source_hash = source_hash;
+    module->from_cache = from_cache;
 
     // resolve imports recursively
     if (ast) {
@@ -6,30 +6,61 @@
 #include "ast.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef struct SymbolTable SymbolTable;
 typedef struct Type Type;
 
+// Numbering of the template nodes that instances record facts about. One
+// layout is shared by every instance of a template, so each instance keeps
+// only dense arrays indexed by ordinal.
+typedef struct InstLayout {
+    Node** keys; // open-addressed by node address
+    uint32_t* ordinals;
+    size_t capacity;
+    size_t key_count; // ordinals plus aliases (see generic_inst_alias)
+    uint32_t count;
+} InstLayout;
+
+// Instances do not copy their template: they check and emit its AST in place
+// under the type_args binding. What sema would otherwise write into a node
+// (its type; for a call, method call or struct literal naming another
+// generic, the instance it resolved to) is kept per instance by ordinal.
 typedef struct GenericInst {
     struct GenericInst* next;
     Node* template_decl;
+    Atom* param_atoms; // template type parameters, bound to type_args
     Type** type_args;
     size_t type_arg_count;
+    struct GenericInst* outer; // struct instance whose method template this is
     char* mangled_name;
     size_t mangled_name_size;
+    Atom mangled_name_atom;
     Node* mono_decl;
     Type* resolved_type;
+    uint32_t hash;
+    uint32_t depth; // instantiations between this one and non-generic code
+    InstLayout* layout;
+    Type** node_types;
+    struct GenericInst** node_targets; // NULL until the body names another instance
+    uint32_t node_capacity;
 } GenericInst;
 
+// Instances stay chained in creation order; the slot table indexes them by
+// template node + canonical type arguments.
 typedef struct GenericInstList {
     GenericInst* first;
     GenericInst* last;
+    size_t count;
+    GenericInst** slots;
+    size_t slot_capacity;
 } GenericInstList;
 
 typedef struct ImplPair {
     Type* struct_type;
     Type* interface_type;
     struct Module* struct_module;
+    Node** methods; // struct method filling each interface signature slot
 } ImplPair;
 
 typedef struct ImplPairList {
@@ -43,6 +74,8 @@ typedef struct Module {
     char* name;
     char* path;
     Node* ast;
+    uint64_t source_hash;
+    bool from_cache; // ast was loaded from the interface cache: no bodies
     SymbolTable* symbols;
     ImplPairList impl_pairs;
     GenericInstList generic_insts;
@@ -60,6 +93,20 @@ typedef struct ModuleGraph {
     char* override_path;
     char* override_source;
     size_t override_source_len;
+
+    // LSP: type-check function bodies of the main module only, so imported
+    // bodies are never parsed unless a generic instantiation needs them
+    bool main_bodies_only;
+
+    // Interface cache directory, or NULL for none (see module_cache.h)
+    char* cache_dir;
+
+    // When set, codegen records the C size of every function it defines
+    // (see report.h)
+    struct FuncSizeList* func_sizes;
+
+    // When set, codegen counts interface calls it devirtualized
+    struct DevirtStats* devirt;
 } ModuleGraph;
 
 void module_graph_init(ModuleGraph* graph, Arena* arena, Errors* errors, char* src_dir);
@@ -0,0 +1,724 @@
+#include "module_cache.h"
+#include "fs.h"
+#include "parser.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define CACHE_MAGIC   0x49434e41u // "ANCI"
+#define CACHE_VERSION 3u
+#define CACHE_NO_NODE 0xffu
+
+uint64_t module_cache_hash(char* source, size_t size) {
+    // FNV-1a, 64-bit
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)source[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// False if the path does not fit in buf.
+static bool cache_path(char* buf, size_t buf_size, char* cache_dir, char* name) {
+    int len = snprintf(buf, buf_size, "%s/%s.anci", cache_dir, name);
+    return len > 0 && (size_t)len < buf_size;
+}
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+
+static void put_u8(FILE* f, uint8_t value) {
+    fputc(value, f);
+}
+
+static void put_u32(FILE* f, uint32_t value) {
+    fwrite(&value, sizeof(value), 1, f);
+}
+
+static void put_u64(FILE* f, uint64_t value) {
+    fwrite(&value, sizeof(value), 1, f);
+}
+
+static void put_str(FILE* f, char* str, size_t size) {
+    put_u32(f, (uint32_t)size);
+    if (size > 0) fwrite(str, 1, size, f);
+}
+
+static void put_node(FILE* f, Node* node);
+
+static void put_nodes(FILE* f, NodeList* list) {
+    put_u32(f, list->count);
+    for (size_t i = 0; i < list->count; i++) {
+        put_node(f, list->nodes[i]);
+    }
+}
+
+static void put_type_params(FILE* f, TypeParamList* list) {
+    put_u32(f, list->count);
+    for (size_t i = 0; i < list->count; i++) {
+        put_str(f, list->params[i].name, list->params[i].name_size);
+        put_node(f, list->params[i].bound);
+    }
+}
+
+// Bodies are kept only where instantiation needs them: generic functions,
+// generic methods and every method of a generic struct.
+static void put_func(FILE* f, Node* node, bool keep_body) {
+    put_u8(f, node->as.func_decl.is_export);
+    put_u8(f, node->as.func_decl.is_extern);
+    put_str(f, node->as.func_decl.name, node->as.func_decl.name_size);
+    put_type_params(f, &node->as.func_decl.type_params);
+
+    ParamList* params = &node->as.func_decl.params;
+    put_u32(f, params->count);
+    for (size_t i = 0; i < params->count; i++) {
+        put_str(f, params->params[i].name, params->params[i].name_size);
+        put_node(f, params->params[i].type_node);
+    }
+    put_node(f, node->as.func_decl.return_type);
+
+    if (keep_body || node->as.func_decl.type_params.count > 0) {
+        put_nodes(f, parser_func_body(node));
+    } else {
+        put_u32(f, 0);
+    }
+}
+
+static void put_node(FILE* f, Node* node) {
+    if (!node) {
+        put_u8(f, CACHE_NO_NODE);
+        return;
+    }
+    put_u8(f, (uint8_t)node->type);
+
+    switch (node->type) {
+    case NODE_PROGRAM:
+        put_nodes(f, &node->as.program.declarations);
+        break;
+
+    // Declarations
+    case NODE_IMPORT_DECL: {
+        ImportNameList* names = &node->as.import_decl.names;
+        put_u8(f, node->as.import_decl.is_export);
+        put_str(f, node->as.import_decl.module_path, node->as.import_decl.module_path_size);
+        put_u32(f, names->count);
+        for (size_t i = 0; i < names->count; i++) {
+            put_str(f, names->names[i].name, names->names[i].name_size);
+        }
+        break;
+    }
+    case NODE_CONST_DECL:
+        put_u8(f, node->as.const_decl.is_export);
+        put_str(f, node->as.const_decl.name, node->as.const_decl.name_size);
+        put_node(f, node->as.const_decl.type_node);
+        put_node(f, node->as.const_decl.value);
+        break;
+    case NODE_VAR_DECL:
+        put_u8(f, node->as.var_decl.is_export);
+        put_str(f, node->as.var_decl.name, node->as.var_decl.name_size);
+        put_node(f, node->as.var_decl.type_node);
+        put_node(f, node->as.var_decl.value);
+        break;
+    case NODE_FUNC_DECL:
+        put_func(f, node, false);
+        break;
+    case NODE_STRUCT_DECL: {
+        FieldList* fields = &node->as.struct_decl.fields;
+        NodeList* methods = &node->as.struct_decl.methods;
+        bool is_generic = node->as.struct_decl.type_params.count > 0;
+        put_u8(f, node->as.struct_decl.is_export);
+        put_str(f, node->as.struct_decl.name, node->as.struct_decl.name_size);
+        put_type_params(f, &node->as.struct_decl.type_params);
+        put_u32(f, fields->count);
+        for (size_t i = 0; i < fields->count; i++) {
+            put_str(f, fields->fields[i].name, fields->fields[i].name_size);
+            put_node(f, fields->fields[i].type_node);
+        }
+        put_u32(f, methods->count);
+        for (size_t i = 0; i < methods->count; i++) {
+            put_u8(f, NODE_FUNC_DECL);
+            put_func(f, methods->nodes[i], is_generic);
+        }
+        break;
+    }
+    case NODE_INTERFACE_DECL:
+        put_str(f, node->as.interface_decl.name, node->as.interface_decl.name_size);
+        put_nodes(f, &node->as.interface_decl.method_sigs);
+        break;
+    case NODE_ENUM_DECL: {
+        EnumVariantList* variants = &node->as.enum_decl.variants;
+        put_u8(f, node->as.enum_decl.is_export);
+        put_str(f, node->as.enum_decl.name, node->as.enum_decl.name_size);
+        put_u32(f, variants->count);
+        for (size_t i = 0; i < variants->count; i++) {
+            put_str(f, variants->variants[i].name, variants->variants[i].name_size);
+        }
+        break;
+    }
+
+    // Statements (cleanup lists and with-release calls are rebuilt by sema)
+    case NODE_RETURN_STMT:
+        put_node(f, node->as.return_stmt.value);
+        break;
+    case NODE_IF_STMT: {
+        ElseIfList* elseifs = &node->as.if_stmt.elseifs;
+        put_node(f, node->as.if_stmt.condition);
+        put_nodes(f, &node->as.if_stmt.then_body);
+        put_u32(f, elseifs->count);
+        for (size_t i = 0; i < elseifs->count; i++) {
+            put_node(f, elseifs->branches[i].condition);
+            put_nodes(f, &elseifs->branches[i].body);
+        }
+        put_nodes(f, &node->as.if_stmt.else_body);
+        break;
+    }
+    case NODE_FOR_STMT:
+        put_str(f, node->as.for_stmt.var_name, node->as.for_stmt.var_name_size);
+        put_node(f, node->as.for_stmt.start);
+        put_node(f, node->as.for_stmt.end);
+        put_node(f, node->as.for_stmt.step);
+        put_nodes(f, &node->as.for_stmt.body);
+        break;
+    case NODE_WHILE_STMT:
+        put_node(f, node->as.while_stmt.condition);
+        put_nodes(f, &node->as.while_stmt.body);
+        break;
+    case NODE_WITH_STMT:
+        put_node(f, node->as.with_stmt.resource);
+        put_nodes(f, &node->as.with_stmt.body);
+        break;
+    case NODE_BREAK_STMT:
+    case NODE_CONTINUE_STMT:
+        break;
+    case NODE_MATCH_STMT: {
+        MatchCaseList* cases = &node->as.match_stmt.cases;
+        put_node(f, node->as.match_stmt.subject);
+        put_u32(f, cases->count);
+        for (size_t i = 0; i < cases->count; i++) {
+            put_nodes(f, &cases->cases[i].values);
+            put_nodes(f, &cases->cases[i].body);
+        }
+        put_nodes(f, &node->as.match_stmt.else_body);
+        break;
+    }
+    case NODE_ASSIGN_STMT:
+        put_node(f, node->as.assign_stmt.target);
+        put_node(f, node->as.assign_stmt.value);
+        break;
+    case NODE_COMPOUND_ASSIGN_STMT:
+        put_u8(f, (uint8_t)node->as.compound_assign_stmt.op);
+        put_node(f, node->as.compound_assign_stmt.target);
+        put_node(f, node->as.compound_assign_stmt.value);
+        break;
+    case NODE_EXPR_STMT:
+        put_node(f, node->as.expr_stmt.expr);
+        break;
+
+    // Expressions
+    case NODE_INTEGER_LITERAL:
+        put_str(f, node->as.integer_literal.value, node->as.integer_literal.value_size);
+        break;
+    case NODE_FLOAT_LITERAL:
+        put_str(f, node->as.float_literal.value, node->as.float_literal.value_size);
+        break;
+    case NODE_STRING_LITERAL:
+        put_str(f, node->as.string_literal.value, node->as.string_literal.value_size);
+        break;
+    case NODE_BOOL_LITERAL:
+        put_u8(f, node->as.bool_literal.value);
+        break;
+    case NODE_NULL_LITERAL:
+    case NODE_SELF:
+        break;
+    case NODE_IDENTIFIER:
+        put_str(f, node->as.identifier.name, node->as.identifier.name_size);
+        break;
+    case NODE_BINARY_EXPR:
+        put_u8(f, (uint8_t)node->as.binary_expr.op);
+        put_node(f, node->as.binary_expr.left);
+        put_node(f, node->as.binary_expr.right);
+        break;
+    case NODE_UNARY_EXPR:
+        put_u8(f, (uint8_t)node->as.unary_expr.op);
+        put_node(f, node->as.unary_expr.operand);
+        break;
+    case NODE_PAREN_EXPR:
+        put_node(f, node->as.paren_expr.inner);
+        break;
+    case NODE_CALL_EXPR:
+        put_node(f, node->as.call_expr.callee);
+        put_nodes(f, &node->as.call_expr.type_args);
+        put_nodes(f, &node->as.call_expr.args);
+        break;
+    case NODE_FIELD_ACCESS:
+        put_node(f, node->as.field_access.object);
+        put_str(f, node->as.field_access.field_name, node->as.field_access.field_name_size);
+        break;
+    case NODE_METHOD_CALL:
+        put_node(f, node->as.method_call.object);
+        put_str(f, node->as.method_call.method_name, node->as.method_call.method_name_size);
+        put_nodes(f, &node->as.method_call.type_args);
+        put_nodes(f, &node->as.method_call.args);
+        break;
+    case NODE_STRUCT_LITERAL: {
+        FieldInitList* inits = &node->as.struct_literal.fields;
+        put_str(f, node->as.struct_literal.struct_name, node->as.struct_literal.struct_name_size);
+        put_nodes(f, &node->as.struct_literal.type_args);
+        put_u32(f, inits->count);
+        for (size_t i = 0; i < inits->count; i++) {
+            put_str(f, inits->inits[i].name, inits->inits[i].name_size);
+            put_node(f, inits->inits[i].value);
+        }
+        break;
+    }
+    case NODE_CAST_EXPR:
+        put_node(f, node->as.cast_expr.expr);
+        put_node(f, node->as.cast_expr.target_type);
+        break;
+    case NODE_SIZEOF_EXPR:
+        put_node(f, node->as.sizeof_expr.type_node);
+        break;
+    case NODE_ARRAY_LITERAL:
+        put_nodes(f, &node->as.array_literal.elements);
+        break;
+    case NODE_INDEX_EXPR:
+        put_node(f, node->as.index_expr.object);
+        put_node(f, node->as.index_expr.index);
+        break;
+
+    // Types
+    case NODE_TYPE_SIMPLE:
+        put_str(f, node->as.type_simple.name, node->as.type_simple.name_size);
+        put_nodes(f, &node->as.type_simple.type_args);
+        break;
+    case NODE_TYPE_REFERENCE:
+        put_node(f, node->as.type_ref.inner);
+        break;
+    case NODE_TYPE_POINTER:
+        put_node(f, node->as.type_ptr.inner);
+        break;
+    case NODE_TYPE_ARRAY:
+        put_node(f, node->as.type_array.inner);
+        put_node(f, node->as.type_array.size_expr);
+        break;
+    case NODE_TYPE_SLICE:
+        put_node(f, node->as.type_slice.inner);
+        break;
+    }
+}
+
+static bool store_module(char* cache_dir, Errors* errors, Module* mod) {
+    size_t error_count = errors->count;
+
+    char path[1024];
+    char tmp_path[1040];
+    if (!cache_path(path, sizeof(path), cache_dir, mod->name)) return false;
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE* f = fopen(tmp_path, "wb");
+    if (!f) return false;
+
+    put_u32(f, CACHE_MAGIC);
+    put_u32(f, CACHE_VERSION);
+    put_u64(f, mod->source_hash);
+    put_node(f, mod->ast);
+
+    // generic bodies are parsed on the way; one that fails is not cached
+    bool ok = !ferror(f) && errors->count == error_count;
+    ok = fclose(f) == 0 && ok;
+    // rename so a concurrent reader never sees a partial entry
+    if (!ok || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+void module_cache_store(ModuleGraph* graph) {
+    if (!graph->cache_dir || !dir_ensure(graph->cache_dir)) return;
+
+    // the first module is the one being compiled or edited; nothing imports it
+    for (Module* m = graph->first ? graph->first->next : NULL; m; m = m->next) {
+        if (m->from_cache || !m->ast) continue;
+        store_module(graph->cache_dir, graph->errors, m);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------
+
+typedef struct CacheReader {
+    Arena* arena;
+    char* data;
+    size_t size;
+    size_t pos;
+    bool ok;
+} CacheReader;
+
+static bool get_bytes(CacheReader* r, void* out, size_t size) {
+    if (!r->ok || size > r->size - r->pos) {
+        r->ok = false;
+        memset(out, 0, size);
+        return false;
+    }
+    memcpy(out, r->data + r->pos, size);
+    r->pos += size;
+    return true;
+}
+
+static uint8_t get_u8(CacheReader* r) {
+    uint8_t value;
+    get_bytes(r, &value, sizeof(value));
+    return value;
+}
+
+static uint32_t get_u32(CacheReader* r) {
+    uint32_t value;
+    get_bytes(r, &value, sizeof(value));
+    return value;
+}
+
+static uint64_t get_u64(CacheReader* r) {
+    uint64_t value;
+    get_bytes(r, &value, sizeof(value));
+    return value;
+}
+
+// NUL-terminated arena copy of a stored string.
+static char* get_str(CacheReader* r, size_t* out_size) {
+    uint32_t size = get_u32(r);
+    if (!r->ok || size > r->size - r->pos) {
+        r->ok = false;
+        *out_size = 0;
+        return NULL;
+    }
+    char* str = arena_alloc(r->arena, (size_t)size + 1);
+    memcpy(str, r->data + r->pos, size);
+    str[size] = '\0';
+    r->pos += size;
+    *out_size = size;
+    return str;
+}
+
+// Names are stored once; the atom is re-interned on load.
+#define GET_NAME(r, name, name_size, name_atom) \
+    do { \
+        (name) = get_str((r), &(name_size)); \
+        (name_atom) = (name) ? intern((name), (name_size)) : ATOM_NONE; \
+    } while (0)
+
+// Element count of a list, rejecting counts the remaining bytes cannot hold.
+static uint32_t get_count(CacheReader* r) {
+    uint32_t count = get_u32(r);
+    if (count > r->size - r->pos) {
+        r->ok = false;
+        return 0;
+    }
+    return count;
+}
+
+static void* get_array(CacheReader* r, uint32_t count, size_t item_size) {
+    if (count == 0) return NULL;
+    void* items = arena_alloc(r->arena, count * item_size);
+    memset(items, 0, count * item_size);
+    return items;
+}
+
+static Node* get_node(CacheReader* r);
+
+static NodeList get_nodes(CacheReader* r) {
+    NodeList list;
+    list.count = get_count(r);
+    list.nodes = get_array(r, list.count, sizeof(Node*));
+    for (size_t i = 0; i < list.count && r->ok; i++) {
+        list.nodes[i] = get_node(r);
+    }
+    return list;
+}
+
+static TypeParamList get_type_params(CacheReader* r) {
+    TypeParamList list;
+    list.count = get_count(r);
+    list.params = get_array(r, list.count, sizeof(TypeParam));
+    for (size_t i = 0; i < list.count && r->ok; i++) {
+        TypeParam* param = &list.params[i];
+        GET_NAME(r, param->name, param->name_size, param->name_atom);
+        param->bound = get_node(r);
+    }
+    return list;
+}
+
+static void get_func(CacheReader* r, Node* node) {
+    node->as.func_decl.is_export = get_u8(r);
+    node->as.func_decl.is_extern = get_u8(r);
+    GET_NAME(r, node->as.func_decl.name, node->as.func_decl.name_size, node->as.func_decl.name_atom);
+    node->as.func_decl.type_params = get_type_params(r);
+
+    ParamList* params = &node->as.func_decl.params;
+    params->count = get_count(r);
+    params->params = get_array(r, params->count, sizeof(Param));
+    for (size_t i = 0; i < params->count && r->ok; i++) {
+        Param* param = &params->params[i];
+        GET_NAME(r, param->name, param->name_size, param->name_atom);
+        param->type_node = get_node(r);
+    }
+    node->as.func_decl.return_type = get_node(r);
+    node->as.func_decl.body = get_nodes(r);
+}
+
+static Node* get_node(CacheReader* r) {
+    uint8_t type = get_u8(r);
+    if (!r->ok || type == CACHE_NO_NODE) return NULL;
+    if (type > NODE_TYPE_SLICE) {
+        r->ok = false;
+        return NULL;
+    }
+
+    Node* node = node_new(r->arena, (NodeType)type, 0);
+    switch (node->type) {
+    case NODE_PROGRAM:
+        node->as.program.declarations = get_nodes(r);
+        break;
+
+    // Declarations
+    case NODE_IMPORT_DECL: {
+        ImportNameList* names = &node->as.import_decl.names;
+        node->as.import_decl.is_export = get_u8(r);
+        node->as.import_decl.module_path = get_str(r, &node->as.import_decl.module_path_size);
+        names->count = get_count(r);
+        names->names = get_array(r, names->count, sizeof(ImportName));
+        for (size_t i = 0; i < names->count && r->ok; i++) {
+            ImportName* name = &names->names[i];
+            GET_NAME(r, name->name, name->name_size, name->name_atom);
+        }
+        break;
+    }
+    case NODE_CONST_DECL:
+        node->as.const_decl.is_export = get_u8(r);
+        GET_NAME(r, node->as.const_decl.name, node->as.const_decl.name_size, node->as.const_decl.name_atom);
+        node->as.const_decl.type_node = get_node(r);
+        node->as.const_decl.value = get_node(r);
+        break;
+    case NODE_VAR_DECL:
+        node->as.var_decl.is_export = get_u8(r);
+        GET_NAME(r, node->as.var_decl.name, node->as.var_decl.name_size, node->as.var_decl.name_atom);
+        node->as.var_decl.type_node = get_node(r);
+        node->as.var_decl.value = get_node(r);
+        break;
+    case NODE_FUNC_DECL:
+        get_func(r, node);
+        break;
+    case NODE_STRUCT_DECL: {
+        FieldList* fields = &node->as.struct_decl.fields;
+        node->as.struct_decl.is_export = get_u8(r);
+        GET_NAME(r, node->as.struct_decl.name, node->as.struct_decl.name_size, node->as.struct_decl.name_atom);
+        node->as.struct_decl.type_params = get_type_params(r);
+        fields->count = get_count(r);
+        fields->fields = get_array(r, fields->count, sizeof(Field));
+        for (size_t i = 0; i < fields->count && r->ok; i++) {
+            Field* field = &fields->fields[i];
+            GET_NAME(r, field->name, field->name_size, field->name_atom);
+            field->type_node = get_node(r);
+        }
+        node->as.struct_decl.methods = get_nodes(r);
+        break;
+    }
+    case NODE_INTERFACE_DECL:
+        GET_NAME(r, node->as.interface_decl.name, node->as.interface_decl.name_size,
+                 node->as.interface_decl.name_atom);
+        node->as.interface_decl.method_sigs = get_nodes(r);
+        break;
+    case NODE_ENUM_DECL: {
+        EnumVariantList* variants = &node->as.enum_decl.variants;
+        node->as.enum_decl.is_export = get_u8(r);
+        GET_NAME(r, node->as.enum_decl.name, node->as.enum_decl.name_size, node->as.enum_decl.name_atom);
+        variants->count = get_count(r);
+        variants->variants = get_array(r, variants->count, sizeof(EnumVariant));
+        for (size_t i = 0; i < variants->count && r->ok; i++) {
+            EnumVariant* variant = &variants->variants[i];
+            GET_NAME(r, variant->name, variant->name_size, variant->name_atom);
+        }
+        break;
+    }
+
+    // Statements
+    case NODE_RETURN_STMT:
+        node->as.return_stmt.value = get_node(r);
+        break;
+    case NODE_IF_STMT: {
+        ElseIfList* elseifs = &node->as.if_stmt.elseifs;
+        node->as.if_stmt.condition = get_node(r);
+        node->as.if_stmt.then_body = get_nodes(r);
+        elseifs->count = get_count(r);
+        elseifs->branches = get_array(r, elseifs->count, sizeof(ElseIfBranch));
+        for (size_t i = 0; i < elseifs->count && r->ok; i++) {
+            elseifs->branches[i].condition = get_node(r);
+            elseifs->branches[i].body = get_nodes(r);
+        }
+        node->as.if_stmt.else_body = get_nodes(r);
+        break;
+    }
+    case NODE_FOR_STMT:
+        GET_NAME(r, node->as.for_stmt.var_name, node->as.for_stmt.var_name_size,
+                 node->as.for_stmt.var_name_atom);
+        node->as.for_stmt.start = get_node(r);
+        node->as.for_stmt.end = get_node(r);
+        node->as.for_stmt.step = get_node(r);
+        node->as.for_stmt.body = get_nodes(r);
+        break;
+    case NODE_WHILE_STMT:
+        node->as.while_stmt.condition = get_node(r);
+        node->as.while_stmt.body = get_nodes(r);
+        break;
+    case NODE_WITH_STMT:
+        node->as.with_stmt.resource = get_node(r);
+        node->as.with_stmt.body = get_nodes(r);
+        break;
+    case NODE_BREAK_STMT:
+    case NODE_CONTINUE_STMT:
+        break;
+    case NODE_MATCH_STMT: {
+        MatchCaseList* cases = &node->as.match_stmt.cases;
+        node->as.match_stmt.subject = get_node(r);
+        cases->count = get_count(r);
+        cases->cases = get_array(r, cases->count, sizeof(MatchCase));
+        for (size_t i = 0; i < cases->count && r->ok; i++) {
+            cases->cases[i].values = get_nodes(r);
+            cases->cases[i].body = get_nodes(r);
+        }
+        node->as.match_stmt.else_body = get_nodes(r);
+        break;
+    }
+    case NODE_ASSIGN_STMT:
+        node->as.assign_stmt.target = get_node(r);
+        node->as.assign_stmt.value = get_node(r);
+        break;
+    case NODE_COMPOUND_ASSIGN_STMT:
+        node->as.compound_assign_stmt.op = (TokenType)get_u8(r);
+        node->as.compound_assign_stmt.target = get_node(r);
+        node->as.compound_assign_stmt.value = get_node(r);
+        break;
+    case NODE_EXPR_STMT:
+        node->as.expr_stmt.expr = get_node(r);
+        break;
+
+    // Expressions
+    case NODE_INTEGER_LITERAL:
+        node->as.integer_literal.value = get_str(r, &node->as.integer_literal.value_size);
+        break;
+    case NODE_FLOAT_LITERAL:
+        node->as.float_literal.value = get_str(r, &node->as.float_literal.value_size);
+        break;
+    case NODE_STRING_LITERAL:
+        node->as.string_literal.value = get_str(r, &node->as.string_literal.value_size);
+        break;
+    case NODE_BOOL_LITERAL:
+        node->as.bool_literal.value = get_u8(r);
+        break;
+    case NODE_NULL_LITERAL:
+    case NODE_SELF:
+        break;
+    case NODE_IDENTIFIER:
+        GET_NAME(r, node->as.identifier.name, node->as.identifier.name_size, node->as.identifier.name_atom);
+        break;
+    case NODE_BINARY_EXPR:
+        node->as.binary_expr.op = (TokenType)get_u8(r);
+        node->as.binary_expr.left = get_node(r);
+        node->as.binary_expr.right = get_node(r);
+        break;
+    case NODE_UNARY_EXPR:
+        node->as.unary_expr.op = (TokenType)get_u8(r);
+        node->as.unary_expr.operand = get_node(r);
+        break;
+    case NODE_PAREN_EXPR:
+        node->as.paren_expr.inner = get_node(r);
+        break;
+    case NODE_CALL_EXPR:
+        node->as.call_expr.callee = get_node(r);
+        node->as.call_expr.type_args = get_nodes(r);
+        node->as.call_expr.args = get_nodes(r);
+        break;
+    case NODE_FIELD_ACCESS:
+        node->as.field_access.object = get_node(r);
+        GET_NAME(r, node->as.field_access.field_name, node->as.field_access.field_name_size,
+                 node->as.field_access.field_name_atom);
+        break;
+    case NODE_METHOD_CALL:
+        node->as.method_call.object = get_node(r);
+        GET_NAME(r, node->as.method_call.method_name, node->as.method_call.method_name_size,
+                 node->as.method_call.method_name_atom);
+        node->as.method_call.type_args = get_nodes(r);
+        node->as.method_call.args = get_nodes(r);
+        break;
+    case NODE_STRUCT_LITERAL: {
+        FieldInitList* inits = &node->as.struct_literal.fields;
+        GET_NAME(r, node->as.struct_literal.struct_name, node->as.struct_literal.struct_name_size,
+                 node->as.struct_literal.struct_name_atom);
+        node->as.struct_literal.type_args = get_nodes(r);
+        inits->count = get_count(r);
+        inits->inits = get_array(r, inits->count, sizeof(FieldInit));
+        for (size_t i = 0; i < inits->count && r->ok; i++) {
+            FieldInit* init = &inits->inits[i];
+            GET_NAME(r, init->name, init->name_size, init->name_atom);
+            init->value = get_node(r);
+        }
+        break;
+    }
+    case NODE_CAST_EXPR:
+        node->as.cast_expr.expr = get_node(r);
+        node->as.cast_expr.target_type = get_node(r);
+        break;
+    case NODE_SIZEOF_EXPR:
+        node->as.sizeof_expr.type_node = get_node(r);
+        break;
+    case NODE_ARRAY_LITERAL:
+        node->as.array_literal.elements = get_nodes(r);
+        break;
+    case NODE_INDEX_EXPR:
+        node->as.index_expr.object = get_node(r);
+        node->as.index_expr.index = get_node(r);
+        break;
+
+    // Types
+    case NODE_TYPE_SIMPLE:
+        GET_NAME(r, node->as.type_simple.name, node->as.type_simple.name_size, node->as.type_simple.name_atom);
+        node->as.type_simple.type_args = get_nodes(r);
+        break;
+    case NODE_TYPE_REFERENCE:
+        node->as.type_ref.inner = get_node(r);
+        break;
+    case NODE_TYPE_POINTER:
+        node->as.type_ptr.inner = get_node(r);
+        break;
+    case NODE_TYPE_ARRAY:
+        node->as.type_array.inner = get_node(r);
+        node->as.type_array.size_expr = get_node(r);
+        break;
+    case NODE_TYPE_SLICE:
+        node->as.type_slice.inner = get_node(r);
+        break;
+    }
+    return node;
+}
+
+Node* module_cache_load(Arena* arena, char* cache_dir, char* name, uint64_t source_hash) {
+    char file_path[1024];
+    if (!cache_path(file_path, sizeof(file_path), cache_dir, name)) return NULL;
+
+    CacheReader r;
+    r.arena = arena;
+    r.data = file_read(arena, file_path, &r.size);
+    r.pos = 0;
+    r.ok = r.data != NULL;
+    if (!r.ok) return NULL;
+
+    if (get_u32(&r) != CACHE_MAGIC || get_u32(&r) != CACHE_VERSION) return NULL;
+    if (get_u64(&r) != source_hash) return NULL;
+
+    Node* ast = get_node(&r);
+    if (!r.ok || !ast || ast->type != NODE_PROGRAM || r.pos != r.size) return NULL;
+    return ast;
+}
@@ -0,0 +1,29 @@
+#ifndef ANCC_MODULE_CACHE_H
+#define ANCC_MODULE_CACHE_H
+
+#include "arena.h"
+#include "ast.h"
+#include "module.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Module interface cache: a module's declarations, without the bodies of
+// non-generic functions and without source positions, stored in
+// <cache_dir>/<module>.anci and keyed by a hash of the source text. Loading
+// one stands in for lexing and parsing the module when only its declarations
+// are needed (the LSP analyzes imported modules this way).
+
+uint64_t module_cache_hash(char* source, size_t size);
+
+// Declarations of the named module, or NULL if there is no entry for this
+// exact source text.
+Node* module_cache_load(Arena* arena, char* cache_dir, char* name, uint64_t source_hash);
+
+// Writes an entry for every imported module parsed from source. Must run
+// before sema, which folds values from other modules into the AST; an entry
+// may only depend on its own module's source.
+void module_cache_store(ModuleGraph* graph);
+
+#endif
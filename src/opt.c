@@ -0,0 +1,1502 @@
+#include "opt.h"
+#include "consteval.h"
+#include "location.h"
+#include "parser.h"
+#include "sema.h"
+#include "type.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Passes run in order over a body, repeated while any of them changes it
+// (folding can expose a dead branch, which can leave a store unread).
+#define OPT_MAX_ROUNDS 4
+
+// ---------------------------------------------------------------------------
+// Context
+// ---------------------------------------------------------------------------
+
+// A name in scope in the body being rewritten. Reads of it are replaced by
+// value when it holds a constant, or by copy_of when it copies another local.
+typedef struct OptBinding {
+    Atom atom;
+    void* decl;      // declaring node or param; identifies the binding
+    Node* value;     // constant standing in for every read, or NULL
+    Node* copy_of;   // identifier read instead, or NULL
+    void* copy_decl; // binding copy_of must still resolve to
+} OptBinding;
+
+// How a name is used across the whole body, over all bindings of that name.
+typedef struct OptUse {
+    Atom atom;
+    uint32_t reads;
+    uint32_t writes;    // assigned, address taken, method receiver, loop variable
+    bool is_local;      // declared by the body or a parameter
+    bool impure_store;  // some store to it must stay (side effects, loop variable)
+} OptUse;
+
+typedef struct OptContext {
+    Arena* arena;
+    Module* mod;
+    char* struct_name; // of the method being rewritten, NULL in free functions
+    size_t struct_name_size;
+    OptStats* stats;
+    bool changed;
+    GenericInst* inst; // instance whose body is being rewritten, NULL elsewhere
+
+    OptBinding* bindings;
+    size_t binding_count;
+    size_t binding_capacity;
+
+    OptUse* uses;
+    size_t use_count;
+    size_t use_capacity;
+} OptContext;
+
+static void opt_changed(OptContext* ctx, size_t* counter) {
+    (*counter)++;
+    ctx->changed = true;
+}
+
+// Type sema recorded for a node: inside an instance body it lives in the
+// instance's side table, since the template node is shared.
+static Type* opt_type(OptContext* ctx, Node* node) {
+    if (ctx->inst) {
+        Type* t = generic_inst_type(ctx->inst, node);
+        if (t) return t;
+    }
+    return (Type*)node->resolved_type;
+}
+
+// ---------------------------------------------------------------------------
+// Scope bindings
+// ---------------------------------------------------------------------------
+
+static OptBinding* binding_add(OptContext* ctx, Atom atom, void* decl) {
+    if (ctx->binding_count >= ctx->binding_capacity) {
+        ctx->binding_capacity = ctx->binding_capacity ? ctx->binding_capacity * 2 : 64;
+        ctx->bindings = realloc(ctx->bindings, ctx->binding_capacity * sizeof(OptBinding));
+    }
+    OptBinding* b = &ctx->bindings[ctx->binding_count++];
+    memset(b, 0, sizeof(OptBinding));
+    b->atom = atom;
+    b->decl = decl;
+    return b;
+}
+
+static OptBinding* binding_find(OptContext* ctx, Atom atom) {
+    for (size_t i = ctx->binding_count; i > 0; i--) {
+        if (ctx->bindings[i - 1].atom == atom) return &ctx->bindings[i - 1];
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Use counts
+// ---------------------------------------------------------------------------
+
+static OptUse* use_find(OptContext* ctx, Atom atom) {
+    for (size_t i = 0; i < ctx->use_count; i++) {
+        if (ctx->uses[i].atom == atom) return &ctx->uses[i];
+    }
+    return NULL;
+}
+
+static OptUse* use_of(OptContext* ctx, Atom atom) {
+    OptUse* use = use_find(ctx, atom);
+    if (use) return use;
+    if (ctx->use_count >= ctx->use_capacity) {
+        ctx->use_capacity = ctx->use_capacity ? ctx->use_capacity * 2 : 64;
+        ctx->uses = realloc(ctx->uses, ctx->use_capacity * sizeof(OptUse));
+    }
+    use = &ctx->uses[ctx->use_count++];
+    memset(use, 0, sizeof(OptUse));
+    use->atom = atom;
+    return use;
+}
+
+static bool int_value(OptContext* ctx, Node* node, int64_t* out);
+
+// Evaluating the expression has no effect beyond its value and cannot trap.
+static bool expr_is_pure(OptContext* ctx, Node* node) {
+    if (!node) return true;
+    switch (node->type) {
+    case NODE_INTEGER_LITERAL:
+    case NODE_FLOAT_LITERAL:
+    case NODE_STRING_LITERAL:
+    case NODE_BOOL_LITERAL:
+    case NODE_NULL_LITERAL:
+    case NODE_IDENTIFIER:
+    case NODE_SELF:
+    case NODE_SIZEOF_EXPR:
+        return true;
+    case NODE_PAREN_EXPR:
+        return expr_is_pure(ctx, node->as.paren_expr.inner);
+    case NODE_CAST_EXPR:
+        return expr_is_pure(ctx, node->as.cast_expr.expr);
+    case NODE_UNARY_EXPR:
+        // *p may fault
+        return node->as.unary_expr.op != TOKEN_STAR && expr_is_pure(ctx, node->as.unary_expr.operand);
+    case NODE_BINARY_EXPR: {
+        Node* right = node->as.binary_expr.right;
+        // x / 0 and INT_MIN / -1 trap: only a known divisor that is neither
+        // is safe (the language has no remainder operator)
+        int64_t divisor;
+        if (node->as.binary_expr.op == TOKEN_SLASH &&
+            (!int_value(ctx, right, &divisor) || divisor == 0 || divisor == -1)) {
+            return false;
+        }
+        return expr_is_pure(ctx, node->as.binary_expr.left) && expr_is_pure(ctx, right);
+    }
+    case NODE_FIELD_ACCESS: {
+        // through a pointer the read may fault
+        Type* object_type = opt_type(ctx, node->as.field_access.object);
+        if (!object_type || object_type->kind != TYPE_STRUCT) return false;
+        return expr_is_pure(ctx, node->as.field_access.object);
+    }
+    case NODE_STRUCT_LITERAL: {
+        FieldInitList* inits = &node->as.struct_literal.fields;
+        for (size_t i = 0; i < inits->count; i++) {
+            if (!expr_is_pure(ctx, inits->inits[i].value)) return false;
+        }
+        return true;
+    }
+    case NODE_ARRAY_LITERAL: {
+        NodeList* elements = &node->as.array_literal.elements;
+        for (size_t i = 0; i < elements->count; i++) {
+            if (!expr_is_pure(ctx, elements->nodes[i])) return false;
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+static void count_expr(OptContext* ctx, Node* node);
+static void count_body(OptContext* ctx, NodeList* body);
+
+// The storage an lvalue or method receiver names may change.
+static void count_write(OptContext* ctx, Node* target) {
+    while (target) {
+        switch (target->type) {
+        case NODE_IDENTIFIER:
+            use_of(ctx, target->as.identifier.name_atom)->writes++;
+            return;
+        case NODE_FIELD_ACCESS:
+            target = target->as.field_access.object;
+            break;
+        case NODE_INDEX_EXPR:
+            target = target->as.index_expr.object;
+            break;
+        case NODE_PAREN_EXPR:
+            target = target->as.paren_expr.inner;
+            break;
+        default:
+            return;
+        }
+    }
+}
+
+static void count_exprs(OptContext* ctx, NodeList* list) {
+    for (size_t i = 0; i < list->count; i++) count_expr(ctx, list->nodes[i]);
+}
+
+static void count_expr(OptContext* ctx, Node* node) {
+    if (!node) return;
+    switch (node->type) {
+    case NODE_IDENTIFIER:
+        use_of(ctx, node->as.identifier.name_atom)->reads++;
+        break;
+    case NODE_BINARY_EXPR:
+        count_expr(ctx, node->as.binary_expr.left);
+        count_expr(ctx, node->as.binary_expr.right);
+        break;
+    case NODE_UNARY_EXPR:
+        if (node->as.unary_expr.op == TOKEN_AMPERSAND) count_write(ctx, node->as.unary_expr.operand);
+        count_expr(ctx, node->as.unary_expr.operand);
+        break;
+    case NODE_PAREN_EXPR:
+        count_expr(ctx, node->as.paren_expr.inner);
+        break;
+    case NODE_CALL_EXPR:
+        count_expr(ctx, node->as.call_expr.callee);
+        count_exprs(ctx, &node->as.call_expr.args);
+        break;
+    case NODE_FIELD_ACCESS:
+        count_expr(ctx, node->as.field_access.object);
+        break;
+    case NODE_METHOD_CALL:
+        count_write(ctx, node->as.method_call.object);
+        count_expr(ctx, node->as.method_call.object);
+        count_exprs(ctx, &node->as.method_call.args);
+        break;
+    case NODE_STRUCT_LITERAL: {
+        FieldInitList* inits = &node->as.struct_literal.fields;
+        for (size_t i = 0; i < inits->count; i++) count_expr(ctx, inits->inits[i].value);
+        break;
+    }
+    case NODE_CAST_EXPR:
+        count_expr(ctx, node->as.cast_expr.expr);
+        break;
+    case NODE_ARRAY_LITERAL:
+        count_exprs(ctx, &node->as.array_literal.elements);
+        break;
+    case NODE_INDEX_EXPR:
+        count_expr(ctx, node->as.index_expr.object);
+        count_expr(ctx, node->as.index_expr.index);
+        break;
+    default:
+        break;
+    }
+}
+
+static void count_store(OptContext* ctx, Atom atom, Node* value) {
+    OptUse* use = use_of(ctx, atom);
+    if (!expr_is_pure(ctx, value)) use->impure_store = true;
+}
+
+static void count_stmt(OptContext* ctx, Node* node) {
+    switch (node->type) {
+    case NODE_VAR_DECL:
+        use_of(ctx, node->as.var_decl.name_atom)->is_local = true;
+        count_store(ctx, node->as.var_decl.name_atom, node->as.var_decl.value);
+        count_expr(ctx, node->as.var_decl.value);
+        break;
+    case NODE_CONST_DECL:
+        use_of(ctx, node->as.const_decl.name_atom)->is_local = true;
+        count_store(ctx, node->as.const_decl.name_atom, node->as.const_decl.value);
+        count_expr(ctx, node->as.const_decl.value);
+        break;
+    case NODE_RETURN_STMT:
+        count_expr(ctx, node->as.return_stmt.value);
+        count_exprs(ctx, &node->as.return_stmt.cleanup);
+        break;
+    case NODE_BREAK_STMT:
+        count_exprs(ctx, &node->as.break_stmt.cleanup);
+        break;
+    case NODE_CONTINUE_STMT:
+        count_exprs(ctx, &node->as.continue_stmt.cleanup);
+        break;
+    case NODE_IF_STMT: {
+        count_expr(ctx, node->as.if_stmt.condition);
+        count_body(ctx, &node->as.if_stmt.then_body);
+        ElseIfList* elseifs = &node->as.if_stmt.elseifs;
+        for (size_t i = 0; i < elseifs->count; i++) {
+            count_expr(ctx, elseifs->branches[i].condition);
+            count_body(ctx, &elseifs->branches[i].body);
+        }
+        count_body(ctx, &node->as.if_stmt.else_body);
+        break;
+    }
+    case NODE_FOR_STMT: {
+        // the loop itself reads and steps the variable
+        OptUse* use = use_of(ctx, node->as.for_stmt.var_name_atom);
+        use->is_local = true;
+        use->reads++;
+        use->writes++;
+        use->impure_store = true;
+        count_expr(ctx, node->as.for_stmt.start);
+        count_expr(ctx, node->as.for_stmt.end);
+        count_expr(ctx, node->as.for_stmt.step);
+        count_body(ctx, &node->as.for_stmt.body);
+        break;
+    }
+    case NODE_WHILE_STMT:
+        count_expr(ctx, node->as.while_stmt.condition);
+        count_body(ctx, &node->as.while_stmt.body);
+        break;
+    case NODE_WITH_STMT: {
+        Node* resource = node->as.with_stmt.resource;
+        if (resource->type == NODE_VAR_DECL) {
+            count_stmt(ctx, resource);
+            OptUse* use = use_of(ctx, resource->as.var_decl.name_atom);
+            use->writes++;
+            use->impure_store = true;
+        } else {
+            count_write(ctx, resource);
+            count_expr(ctx, resource);
+        }
+        count_expr(ctx, node->as.with_stmt.release);
+        count_body(ctx, &node->as.with_stmt.body);
+        break;
+    }
+    case NODE_MATCH_STMT: {
+        count_expr(ctx, node->as.match_stmt.subject);
+        MatchCaseList* cases = &node->as.match_stmt.cases;
+        for (size_t i = 0; i < cases->count; i++) {
+            count_exprs(ctx, &cases->cases[i].values);
+            count_body(ctx, &cases->cases[i].body);
+        }
+        count_body(ctx, &node->as.match_stmt.else_body);
+        break;
+    }
+    case NODE_ASSIGN_STMT: {
+        Node* target = node->as.assign_stmt.target;
+        if (target->type == NODE_IDENTIFIER) {
+            use_of(ctx, target->as.identifier.name_atom)->writes++;
+            count_store(ctx, target->as.identifier.name_atom, node->as.assign_stmt.value);
+        } else {
+            count_write(ctx, target);
+            count_expr(ctx, target);
+        }
+        count_expr(ctx, node->as.assign_stmt.value);
+        break;
+    }
+    case NODE_COMPOUND_ASSIGN_STMT:
+        count_write(ctx, node->as.compound_assign_stmt.target);
+        count_expr(ctx, node->as.compound_assign_stmt.target);
+        count_expr(ctx, node->as.compound_assign_stmt.value);
+        break;
+    case NODE_EXPR_STMT:
+        count_expr(ctx, node->as.expr_stmt.expr);
+        break;
+    default:
+        break;
+    }
+}
+
+static void count_body(OptContext* ctx, NodeList* body) {
+    for (size_t i = 0; i < body->count; i++) count_stmt(ctx, body->nodes[i]);
+}
+
+static void count_func(OptContext* ctx, Node* func) {
+    ctx->use_count = 0;
+    ParamList* params = &func->as.func_decl.params;
+    for (size_t i = 0; i < params->count; i++) {
+        use_of(ctx, params->params[i].name_atom)->is_local = true;
+    }
+    count_body(ctx, parser_func_body(func));
+}
+
+// ---------------------------------------------------------------------------
+// Constant values
+// ---------------------------------------------------------------------------
+
+// Value of an integer constant: a literal, possibly negative inside the
+// parentheses folding wraps it in, or a cast of one to a type it fits.
+static bool int_value(OptContext* ctx, Node* node, int64_t* out) {
+    if (!node) return false;
+    if (node->type == NODE_PAREN_EXPR) return int_value(ctx, node->as.paren_expr.inner, out);
+    if (node->type == NODE_CAST_EXPR) {
+        Type* target = opt_type(ctx, node->as.cast_expr.target_type);
+        return int_value(ctx, node->as.cast_expr.expr, out) && const_int_fits(target, *out);
+    }
+    if (node->type != NODE_INTEGER_LITERAL) return false;
+
+    char* s = node->as.integer_literal.value;
+    size_t n = node->as.integer_literal.value_size;
+    size_t i = 0;
+    bool negative = n > 0 && s[0] == '-';
+    if (negative) i++;
+    if (i == n) return false;
+    int64_t value = 0;
+    for (; i < n; i++) {
+        if (s[i] < '0' || s[i] > '9') return false;
+        int digit = s[i] - '0';
+        if (value > (INT64_MAX - digit) / 10) return false;
+        value = value * 10 + digit;
+    }
+    *out = negative ? -value : value;
+    return true;
+}
+
+static bool bool_value(Node* node, bool* out) {
+    if (!node) return false;
+    if (node->type == NODE_PAREN_EXPR) return bool_value(node->as.paren_expr.inner, out);
+    if (node->type != NODE_BOOL_LITERAL) return false;
+    *out = node->as.bool_literal.value;
+    return true;
+}
+
+static bool is_const_value(OptContext* ctx, Node* node) {
+    int64_t i;
+    bool b;
+    if (int_value(ctx, node, &i) || bool_value(node, &b)) return true;
+    if (node->type == NODE_FLOAT_LITERAL) return true;
+    return node->type == NODE_CAST_EXPR && node->as.cast_expr.expr->type == NODE_FLOAT_LITERAL;
+}
+
+// Types whose constants are propagated into reads.
+static bool type_is_scalar(Type* type) {
+    return type && (type_is_numeric(type) || type->kind == TYPE_BOOL);
+}
+
+// Types whose copies are propagated: scalars and non-interface pointers.
+static bool type_is_copyable(Type* type) {
+    if (type_is_scalar(type)) return true;
+    if (!type) return false;
+    if (type->kind == TYPE_PTR) return type->as.ptr_type.inner->kind != TYPE_INTERFACE;
+    if (type->kind == TYPE_REF) return type->as.ref_type.inner->kind != TYPE_INTERFACE;
+    return false;
+}
+
+// A bare C literal only has the C type of int, bool and double; every other
+// type gets a cast so arithmetic around the constant keeps its C type.
+static Node* typed_const(OptContext* ctx, Node* literal, Type* type) {
+    bool bare = type->kind == TYPE_INT || type->kind == TYPE_BOOL ||
+                (type->kind == TYPE_DOUBLE && literal->type == NODE_FLOAT_LITERAL);
+    if (bare) return literal;
+    Node* type_node = node_new(ctx->arena, NODE_TYPE_SIMPLE, literal->loc);
+    type_node->resolved_type = type;
+    Node* cast = node_new(ctx->arena, NODE_CAST_EXPR, literal->loc);
+    cast->as.cast_expr.expr = literal;
+    cast->as.cast_expr.target_type = type_node;
+    cast->resolved_type = type;
+    return cast;
+}
+
+// Strip the casts and parentheses around a constant, for re-typing it.
+static Node* const_literal(Node* node) {
+    while (node->type == NODE_PAREN_EXPR || node->type == NODE_CAST_EXPR) {
+        node = node->type == NODE_PAREN_EXPR ? node->as.paren_expr.inner : node->as.cast_expr.expr;
+    }
+    return node;
+}
+
+static Node* make_int(OptContext* ctx, Node* like, int64_t value, Type* type) {
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%lld", (long long)value);
+    char* text = arena_alloc(ctx->arena, (size_t)len + 1);
+    memcpy(text, buf, (size_t)len + 1);
+
+    Node* literal = node_new(ctx->arena, NODE_INTEGER_LITERAL, like->loc);
+    literal->as.integer_literal.value = text;
+    literal->as.integer_literal.value_size = (size_t)len;
+    literal->resolved_type = type;
+    if (type->kind != TYPE_INT) return typed_const(ctx, literal, type);
+    if (value >= 0) return literal;
+
+    // keep "-5" from merging with a preceding '-'
+    Node* paren = node_new(ctx->arena, NODE_PAREN_EXPR, like->loc);
+    paren->as.paren_expr.inner = literal;
+    paren->resolved_type = type;
+    return paren;
+}
+
+// The constant value as a constant of the given type.
+static Node* const_retype(OptContext* ctx, Node* value, Type* type) {
+    int64_t i;
+    if (type_is_integer(type) && int_value(ctx, value, &i)) return make_int(ctx, value, i, type);
+    return typed_const(ctx, const_literal(value), type);
+}
+
+static Node* make_bool(OptContext* ctx, Node* like, bool value) {
+    Node* literal = node_new(ctx->arena, NODE_BOOL_LITERAL, like->loc);
+    literal->as.bool_literal.value = value;
+    literal->resolved_type = opt_type(ctx, like);
+    return literal;
+}
+
+// ---------------------------------------------------------------------------
+// Folding
+// ---------------------------------------------------------------------------
+
+static void fold_binary(OptContext* ctx, Node** slot) {
+    Node* node = *slot;
+    Type* type = opt_type(ctx, node);
+    TokenType op = node->as.binary_expr.op;
+    Node* left = node->as.binary_expr.left;
+    Node* right = node->as.binary_expr.right;
+    if (!type) return;
+
+    int64_t a, b;
+    if (int_value(ctx, left, &a) && int_value(ctx, right, &b)) {
+        if (type_is_integer(type)) {
+            // only results C computes the same way: no wrap, no overflow
+            int64_t result;
+            if (!const_int_signed(type) && (a < 0 || b < 0)) return;
+            if (!const_int_arith(op, a, b, &result) || !const_int_fits(type, result)) return;
+            *slot = make_int(ctx, node, result, type);
+            opt_changed(ctx, &ctx->stats->folded);
+        } else if (type->kind == TYPE_BOOL) {
+            // a negative value meets an unsigned one as a huge number in C
+            bool both_signed = const_int_signed(opt_type(ctx, left)) &&
+                               const_int_signed(opt_type(ctx, right));
+            bool result;
+            if ((a < 0 || b < 0) && !both_signed) return;
+            if (!const_int_compare(op, a, b, &result)) return;
+            *slot = make_bool(ctx, node, result);
+            opt_changed(ctx, &ctx->stats->folded);
+        }
+        return;
+    }
+
+    bool x, y;
+    bool left_known = bool_value(left, &x);
+    bool right_known = bool_value(right, &y);
+    if (left_known && right_known && (op == TOKEN_EQUAL || op == TOKEN_NOT_EQUAL)) {
+        *slot = make_bool(ctx, node, op == TOKEN_EQUAL ? x == y : x != y);
+        opt_changed(ctx, &ctx->stats->folded);
+        return;
+    }
+    // a known left operand decides or passes through, as short-circuiting would
+    if (left_known && (op == TOKEN_AND || op == TOKEN_OR)) {
+        bool decides = op == TOKEN_AND ? !x : x;
+        *slot = decides ? make_bool(ctx, node, x) : right;
+        opt_changed(ctx, &ctx->stats->folded);
+        return;
+    }
+    // a known right operand that does not decide leaves the left one
+    if (right_known && (op == TOKEN_AND ? y : !y) && (op == TOKEN_AND || op == TOKEN_OR)) {
+        *slot = left;
+        opt_changed(ctx, &ctx->stats->folded);
+    }
+}
+
+static void fold_unary(OptContext* ctx, Node** slot) {
+    Node* node = *slot;
+    Type* type = opt_type(ctx, node);
+    Node* operand = node->as.unary_expr.operand;
+    if (!type) return;
+
+    int64_t a;
+    bool x;
+    if (node->as.unary_expr.op == TOKEN_MINUS && int_value(ctx, operand, &a)) {
+        if (!const_int_signed(type) || !const_int_fits(type, -a)) return;
+        *slot = make_int(ctx, node, -a, type);
+        opt_changed(ctx, &ctx->stats->folded);
+    } else if (node->as.unary_expr.op == TOKEN_NOT && bool_value(operand, &x)) {
+        *slot = make_bool(ctx, node, !x);
+        opt_changed(ctx, &ctx->stats->folded);
+    }
+}
+
+// `5 as byte`: the constant retyped, when it fits.
+static void fold_cast(OptContext* ctx, Node** slot) {
+    Node* node = *slot;
+    Type* target = opt_type(ctx, node->as.cast_expr.target_type);
+    Node* expr = node->as.cast_expr.expr;
+    int64_t a;
+    if (!type_is_integer(target) || !int_value(ctx, expr, &a) || !const_int_fits(target, a)) return;
+    // already in canonical form
+    if (expr->type == NODE_INTEGER_LITERAL && target->kind != TYPE_INT && a >= 0) return;
+    *slot = make_int(ctx, node, a, target);
+    opt_changed(ctx, &ctx->stats->folded);
+}
+
+// ---------------------------------------------------------------------------
+// Pass: constant and copy propagation, with folding
+// ---------------------------------------------------------------------------
+
+static void prop_expr(OptContext* ctx, Node** slot);
+static void prop_body(OptContext* ctx, NodeList* body);
+
+// Replacement for a read of an identifier, or NULL.
+static Node* prop_read(OptContext* ctx, Node* ident) {
+    Atom atom = ident->as.identifier.name_atom;
+    OptBinding* b = binding_find(ctx, atom);
+    if (b) {
+        if (b->value) {
+            opt_changed(ctx, &ctx->stats->propagated);
+            return b->value;
+        }
+        if (b->copy_of) {
+            OptBinding* source = binding_find(ctx, b->copy_of->as.identifier.name_atom);
+            if (source && source->decl == b->copy_decl) {
+                opt_changed(ctx, &ctx->stats->copies);
+                return b->copy_of;
+            }
+        }
+        return NULL;
+    }
+
+    // module-level constant, possibly imported
+    Symbol* sym = symbol_find_atom(ctx->mod->symbols, atom);
+    if (sym && sym->kind == SYMBOL_IMPORT && sym->source) {
+        sym = symbol_find_atom(sym->source->symbols, atom);
+    }
+    if (!sym || sym->kind != SYMBOL_CONST || !sym->node) return NULL;
+    Node* value = sym->node->as.const_decl.value;
+    Type* type = opt_type(ctx, ident);
+    if (!value || !is_const_value(ctx, value) || !type_is_scalar(type)) return NULL;
+    opt_changed(ctx, &ctx->stats->propagated);
+    return const_retype(ctx, value, type);
+}
+
+// An lvalue or method receiver names storage: only the expressions inside it
+// (indices, dereferenced pointers) are rewritten.
+static void prop_place(OptContext* ctx, Node** slot) {
+    Node* node = *slot;
+    if (!node) return;
+    switch (node->type) {
+    case NODE_IDENTIFIER:
+    case NODE_SELF:
+        break;
+    case NODE_FIELD_ACCESS:
+        prop_place(ctx, &node->as.field_access.object);
+        break;
+    case NODE_INDEX_EXPR:
+        prop_place(ctx, &node->as.index_expr.object);
+        prop_expr(ctx, &node->as.index_expr.index);
+        break;
+    case NODE_PAREN_EXPR:
+        prop_place(ctx, &node->as.paren_expr.inner);
+        break;
+    default:
+        prop_expr(ctx, slot);
+        break;
+    }
+}
+
+static void prop_exprs(OptContext* ctx, NodeList* list) {
+    for (size_t i = 0; i < list->count; i++) prop_expr(ctx, &list->nodes[i]);
+}
+
+static void prop_expr(OptContext* ctx, Node** slot) {
+    Node* node = *slot;
+    if (!node) return;
+    switch (node->type) {
+    case NODE_IDENTIFIER: {
+        Node* replacement = prop_read(ctx, node);
+        if (replacement) *slot = replacement;
+        break;
+    }
+    case NODE_BINARY_EXPR:
+        prop_expr(ctx, &node->as.binary_expr.left);
+        prop_expr(ctx, &node->as.binary_expr.right);
+        fold_binary(ctx, slot);
+        break;
+    case NODE_UNARY_EXPR:
+        if (node->as.unary_expr.op == TOKEN_AMPERSAND) {
+            prop_place(ctx, &node->as.unary_expr.operand);
+            break;
+        }
+        prop_expr(ctx, &node->as.unary_expr.operand);
+        fold_unary(ctx, slot);
+        break;
+    case NODE_PAREN_EXPR: {
+        prop_expr(ctx, &node->as.paren_expr.inner);
+        // a constant needs no parentheses, except a negative literal's own
+        Node* inner = node->as.paren_expr.inner;
+        bool negative = inner->type == NODE_INTEGER_LITERAL && inner->as.integer_literal.value[0] == '-';
+        if (is_const_value(ctx, inner) && !negative) *slot = inner;
+        break;
+    }
+    case NODE_CALL_EXPR:
+        prop_exprs(ctx, &node->as.call_expr.args);
+        break;
+    case NODE_FIELD_ACCESS:
+        prop_place(ctx, &node->as.field_access.object);
+        break;
+    case NODE_METHOD_CALL:
+        prop_place(ctx, &node->as.method_call.object);
+        prop_exprs(ctx, &node->as.method_call.args);
+        break;
+    case NODE_STRUCT_LITERAL: {
+        FieldInitList* inits = &node->as.struct_literal.fields;
+        for (size_t i = 0; i < inits->count; i++) prop_expr(ctx, &inits->inits[i].value);
+        break;
+    }
+    case NODE_CAST_EXPR:
+        prop_expr(ctx, &node->as.cast_expr.expr);
+        fold_cast(ctx, slot);
+        break;
+    case NODE_ARRAY_LITERAL:
+        prop_exprs(ctx, &node->as.array_literal.elements);
+        break;
+    case NODE_INDEX_EXPR:
+        prop_place(ctx, &node->as.index_expr.object);
+        prop_expr(ctx, &node->as.index_expr.index);
+        break;
+    default:
+        break;
+    }
+}
+
+// Bind a declared local; a never-written one initialized with a constant or
+// a copy of another never-written local is read through its initializer.
+static void prop_declare(OptContext* ctx, Node* decl, Atom atom, Node* value) {
+    OptBinding* b = binding_add(ctx, atom, decl);
+    Type* type = opt_type(ctx, decl);
+    OptUse* use = use_find(ctx, atom);
+    if (!value || !use || use->writes > 0) return;
+
+    if (type_is_scalar(type) && is_const_value(ctx, value)) {
+        b->value = const_retype(ctx, value, type);
+        return;
+    }
+    if (value->type == NODE_IDENTIFIER && type_is_copyable(type) &&
+        type_equals(type, opt_type(ctx, value))) {
+        Atom source_atom = value->as.identifier.name_atom;
+        OptBinding* source = binding_find(ctx, source_atom);
+        OptUse* source_use = use_find(ctx, source_atom);
+        if (source && source_use && source_use->writes == 0) {
+            b->copy_of = value;
+            b->copy_decl = source->decl;
+        }
+    }
+}
+
+static void prop_stmt(OptContext* ctx, Node* node) {
+    switch (node->type) {
+    case NODE_VAR_DECL:
+        prop_expr(ctx, &node->as.var_decl.value);
+        prop_declare(ctx, node, node->as.var_decl.name_atom, node->as.var_decl.value);
+        break;
+    case NODE_CONST_DECL:
+        prop_expr(ctx, &node->as.const_decl.value);
+        prop_declare(ctx, node, node->as.const_decl.name_atom, node->as.const_decl.value);
+        break;
+    case NODE_RETURN_STMT:
+        prop_expr(ctx, &node->as.return_stmt.value);
+        break;
+    case NODE_IF_STMT: {
+        prop_expr(ctx, &node->as.if_stmt.condition);
+        prop_body(ctx, &node->as.if_stmt.then_body);
+        ElseIfList* elseifs = &node->as.if_stmt.elseifs;
+        for (size_t i = 0; i < elseifs->count; i++) {
+            prop_expr(ctx, &elseifs->branches[i].condition);
+            prop_body(ctx, &elseifs->branches[i].body);
+        }
+        prop_body(ctx, &node->as.if_stmt.else_body);
+        break;
+    }
+    case NODE_FOR_STMT: {
+        prop_expr(ctx, &node->as.for_stmt.start);
+        prop_expr(ctx, &node->as.for_stmt.end);
+        prop_expr(ctx, &node->as.for_stmt.step);
+        size_t mark = ctx->binding_count;
+        binding_add(ctx, node->as.for_stmt.var_name_atom, node);
+        prop_body(ctx, &node->as.for_stmt.body);
+        ctx->binding_count = mark;
+        break;
+    }
+    case NODE_WHILE_STMT:
+        prop_expr(ctx, &node->as.while_stmt.condition);
+        prop_body(ctx, &node->as.while_stmt.body);
+        break;
+    case NODE_WITH_STMT: {
+        size_t mark = ctx->binding_count;
+        Node* resource = node->as.with_stmt.resource;
+        if (resource->type == NODE_VAR_DECL) {
+            prop_expr(ctx, &resource->as.var_decl.value);
+            binding_add(ctx, resource->as.var_decl.name_atom, resource);
+        } else {
+            prop_place(ctx, &node->as.with_stmt.resource);
+        }
+        prop_body(ctx, &node->as.with_stmt.body);
+        ctx->binding_count = mark;
+        break;
+    }
+    case NODE_MATCH_STMT: {
+        prop_expr(ctx, &node->as.match_stmt.subject);
+        MatchCaseList* cases = &node->as.match_stmt.cases;
+        for (size_t i = 0; i < cases->count; i++) {
+            prop_exprs(ctx, &cases->cases[i].values);
+            prop_body(ctx, &cases->cases[i].body);
+        }
+        prop_body(ctx, &node->as.match_stmt.else_body);
+        break;
+    }
+    case NODE_ASSIGN_STMT:
+        prop_place(ctx, &node->as.assign_stmt.target);
+        prop_expr(ctx, &node->as.assign_stmt.value);
+        break;
+    case NODE_COMPOUND_ASSIGN_STMT:
+        prop_place(ctx, &node->as.compound_assign_stmt.target);
+        prop_expr(ctx, &node->as.compound_assign_stmt.value);
+        break;
+    case NODE_EXPR_STMT:
+        prop_expr(ctx, &node->as.expr_stmt.expr);
+        break;
+    default:
+        break;
+    }
+}
+
+static void prop_body(OptContext* ctx, NodeList* body) {
+    size_t mark = ctx->binding_count;
+    for (size_t i = 0; i < body->count; i++) prop_stmt(ctx, body->nodes[i]);
+    ctx->binding_count = mark;
+}
+
+static void pass_propagate(OptContext* ctx, Node* func) {
+    ctx->binding_count = 0;
+    ParamList* params = &func->as.func_decl.params;
+    for (size_t i = 0; i < params->count; i++) {
+        binding_add(ctx, params->params[i].name_atom, &params->params[i]);
+    }
+    prop_body(ctx, parser_func_body(func));
+}
+
+// ---------------------------------------------------------------------------
+// Statement list rebuilding
+// ---------------------------------------------------------------------------
+
+typedef struct StmtList {
+    Node** nodes;
+    size_t count;
+    size_t capacity;
+} StmtList;
+
+static void stmt_push(OptContext* ctx, StmtList* list, Node* node) {
+    if (list->count >= list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 8;
+        Node** nodes = arena_alloc(ctx->arena, sizeof(Node*) * capacity);
+        if (list->count) memcpy(nodes, list->nodes, sizeof(Node*) * list->count);
+        list->nodes = nodes;
+        list->capacity = capacity;
+    }
+    list->nodes[list->count++] = node;
+}
+
+static void stmt_list_store(StmtList* list, NodeList* body) {
+    body->nodes = list->nodes;
+    body->count = (uint32_t)list->count;
+}
+
+static bool stmt_exits(Node* node);
+
+static bool body_exits(NodeList* body) {
+    return body->count > 0 && stmt_exits(body->nodes[body->count - 1]);
+}
+
+// Control never reaches the statement after this one.
+static bool stmt_exits(Node* node) {
+    switch (node->type) {
+    case NODE_RETURN_STMT:
+    case NODE_BREAK_STMT:
+    case NODE_CONTINUE_STMT:
+        return true;
+    case NODE_WITH_STMT:
+        return body_exits(&node->as.with_stmt.body);
+    case NODE_IF_STMT: {
+        if (!body_exits(&node->as.if_stmt.then_body) || !body_exits(&node->as.if_stmt.else_body)) return false;
+        ElseIfList* elseifs = &node->as.if_stmt.elseifs;
+        for (size_t i = 0; i < elseifs->count; i++) {
+            if (!body_exits(&elseifs->branches[i].body)) return false;
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// A body can be spliced into its parent when it declares no names of its own.
+static bool body_declares(NodeList* body) {
+    for (size_t i = 0; i < body->count; i++) {
+        NodeType t = body->nodes[i]->type;
+        if (t == NODE_VAR_DECL || t == NODE_CONST_DECL) return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// Pass: dead branches and unreachable statements
+// ---------------------------------------------------------------------------
+
+static void prune_body(OptContext* ctx, NodeList* body);
+
+// Drop arms with a false condition and everything after a true one. Returns
+// the body that always runs when no conditional arm is left, via *always.
+static bool prune_if(OptContext* ctx, Node* node, NodeList** always) {
+    ElseIfList* elseifs = &node->as.if_stmt.elseifs;
+    size_t arm_count = 1 + elseifs->count;
+    ElseIfBranch* arms = arena_alloc(ctx->arena, sizeof(ElseIfBranch) * arm_count);
+    size_t kept = 0;
+    NodeList* else_body = &node->as.if_stmt.else_body;
+    bool dropped = false;
+
+    for (size_t i = 0; i < arm_count; i++) {
+        Node* cond = i == 0 ? node->as.if_stmt.condition : elseifs->branches[i - 1].condition;
+        NodeList* arm_body = i == 0 ? &node->as.if_stmt.then_body : &elseifs->branches[i - 1].body;
+        bool value;
+        if (bool_value(cond, &value)) {
+            dropped = true;
+            if (!value) continue;
+            // a true arm becomes the else; later arms never run
+            else_body = arm_body;
+            break;
+        }
+        arms[kept].condition = cond;
+        arms[kept].body = *arm_body;
+        arms[kept].loc = node->loc;
+        kept++;
+    }
+    if (!dropped) return false;
+
+    opt_changed(ctx, &ctx->stats->dead_branches);
+    if (kept == 0) {
+        *always = else_body;
+        return true;
+    }
+    node->as.if_stmt.condition = arms[0].condition;
+    node->as.if_stmt.then_body = arms[0].body;
+    node->as.if_stmt.elseifs.branches = arms + 1;
+    node->as.if_stmt.elseifs.count = (uint32_t)(kept - 1);
+    node->as.if_stmt.else_body = *else_body;
+    *always = NULL;
+    return true;
+}
+
+static void prune_stmt(OptContext* ctx, Node* node) {
+    switch (node->type) {
+    case NODE_IF_STMT: {
+        prune_body(ctx, &node->as.if_stmt.then_body);
+        ElseIfList* elseifs = &node->as.if_stmt.elseifs;
+        for (size_t i = 0; i < elseifs->count; i++) prune_body(ctx, &elseifs->branches[i].body);
+        prune_body(ctx, &node->as.if_stmt.else_body);
+        break;
+    }
+    case NODE_FOR_STMT:
+        prune_body(ctx, &node->as.for_stmt.body);
+        break;
+    case NODE_WHILE_STMT:
+        prune_body(ctx, &node->as.while_stmt.body);
+        break;
+    case NODE_WITH_STMT:
+        prune_body(ctx, &node->as.with_stmt.body);
+        break;
+    case NODE_MATCH_STMT: {
+        MatchCaseList* cases = &node->as.match_stmt.cases;
+        for (size_t i = 0; i < cases->count; i++) prune_body(ctx, &cases->cases[i].body);
+        prune_body(ctx, &node->as.match_stmt.else_body);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static void prune_body(OptContext* ctx, NodeList* body) {
+    StmtList out = {0};
+    bool changed = false;
+
+    for (size_t i = 0; i < body->count; i++) {
+        Node* node = body->nodes[i];
+        prune_stmt(ctx, node);
+
+        bool value;
+        if (node->type == NODE_WHILE_STMT && bool_value(node->as.while_stmt.condition, &value) && !value) {
+            opt_changed(ctx, &ctx->stats->dead_branches);
+            changed = true;
+            continue;
+        }
+
+        NodeList* always = NULL;
+        if (node->type == NODE_IF_STMT && prune_if(ctx, node, &always)) {
+            changed = true;
+            if (always && body_declares(always)) {
+                // keep the block for its scope
+                node->as.if_stmt.condition = make_bool(ctx, node->as.if_stmt.condition, true);
+                node->as.if_stmt.then_body = *always;
+                node->as.if_stmt.elseifs.count = 0;
+                node->as.if_stmt.else_body.count = 0;
+            } else if (always) {
+                for (size_t j = 0; j < always->count; j++) stmt_push(ctx, &out, always->nodes[j]);
+                continue;
+            }
+        }
+
+        stmt_push(ctx, &out, node);
+        if (stmt_exits(node) && i + 1 < body->count) {
+            ctx->stats->unreachable += body->count - (i + 1);
+            ctx->changed = true;
+            changed = true;
+            break;
+        }
+    }
+
+    if (changed) stmt_list_store(&out, body);
+}
+
+static void pass_prune(OptContext* ctx, Node* func) {
+    prune_body(ctx, parser_func_body(func));
+}
+
+// ---------------------------------------------------------------------------
+// Pass: dead stores
+// ---------------------------------------------------------------------------
+
+// A local that nothing reads: its declaration and every store to it can go,
+// provided none of the stores has side effects.
+static bool store_is_dead(OptContext* ctx, Atom atom) {
+    OptUse* use = use_find(ctx, atom);
+    if (!use || !use->is_local || use->reads > 0 || use->impure_store) return false;
+    // codegen resolves a name shadowing a module symbol to the symbol
+    return symbol_find_atom(ctx->mod->symbols, atom) == NULL;
+}
+
+static void dead_store_body(OptContext* ctx, NodeList* body);
+
+static void dead_store_stmt(OptContext* ctx, Node* node) {
+    switch (node->type) {
+    case NODE_IF_STMT: {
+        dead_store_body(ctx, &node->as.if_stmt.then_body);
+        ElseIfList* elseifs = &node->as.if_stmt.elseifs;
+        for (size_t i = 0; i < elseifs->count; i++) dead_store_body(ctx, &elseifs->branches[i].body);
+        dead_store_body(ctx, &node->as.if_stmt.else_body);
+        break;
+    }
+    case NODE_FOR_STMT:
+        dead_store_body(ctx, &node->as.for_stmt.body);
+        break;
+    case NODE_WHILE_STMT:
+        dead_store_body(ctx, &node->as.while_stmt.body);
+        break;
+    case NODE_WITH_STMT:
+        dead_store_body(ctx, &node->as.with_stmt.body);
+        break;
+    case NODE_MATCH_STMT: {
+        MatchCaseList* cases = &node->as.match_stmt.cases;
+        for (size_t i = 0; i < cases->count; i++) dead_store_body(ctx, &cases->cases[i].body);
+        dead_store_body(ctx, &node->as.match_stmt.else_body);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static void dead_store_body(OptContext* ctx, NodeList* body) {
+    size_t out = 0;
+    for (size_t i = 0; i < body->count; i++) {
+        Node* node = body->nodes[i];
+        dead_store_stmt(ctx, node);
+
+        Atom atom = 0;
+        bool is_store = true;
+        if (node->type == NODE_VAR_DECL) {
+            atom = node->as.var_decl.name_atom;
+        } else if (node->type == NODE_CONST_DECL) {
+            atom = node->as.const_decl.name_atom;
+        } else if (node->type == NODE_ASSIGN_STMT && node->as.assign_stmt.target->type == NODE_IDENTIFIER) {
+            atom = node->as.assign_stmt.target->as.identifier.name_atom;
+        } else {
+            is_store = false;
+        }
+        if (is_store && store_is_dead(ctx, atom)) {
+            opt_changed(ctx, &ctx->stats->dead_stores);
+            continue;
+        }
+        body->nodes[out++] = node;
+    }
+    body->count = (uint32_t)out;
+}
+
+static void pass_dead_store(OptContext* ctx, Node* func) {
+    dead_store_body(ctx, parser_func_body(func));
+}
+
+// ---------------------------------------------------------------------------
+// Pass: with-cleanup deduplication
+// ---------------------------------------------------------------------------
+
+// A with body that ends by leaving runs the release on its way out (sema put
+// it in the exit's cleanup list), so the release after the body never runs.
+static void with_cleanup_body(OptContext* ctx, NodeList* body) {
+    for (size_t i = 0; i < body->count; i++) {
+        Node* node = body->nodes[i];
+        switch (node->type) {
+        case NODE_IF_STMT: {
+            with_cleanup_body(ctx, &node->as.if_stmt.then_body);
+            ElseIfList* elseifs = &node->as.if_stmt.elseifs;
+            for (size_t j = 0; j < elseifs->count; j++) with_cleanup_body(ctx, &elseifs->branches[j].body);
+            with_cleanup_body(ctx, &node->as.if_stmt.else_body);
+            break;
+        }
+        case NODE_FOR_STMT:
+            with_cleanup_body(ctx, &node->as.for_stmt.body);
+            break;
+        case NODE_WHILE_STMT:
+            with_cleanup_body(ctx, &node->as.while_stmt.body);
+            break;
+        case NODE_MATCH_STMT: {
+            MatchCaseList* cases = &node->as.match_stmt.cases;
+            for (size_t j = 0; j < cases->count; j++) with_cleanup_body(ctx, &cases->cases[j].body);
+            with_cleanup_body(ctx, &node->as.match_stmt.else_body);
+            break;
+        }
+        case NODE_WITH_STMT: {
+            NodeList* inner = &node->as.with_stmt.body;
+            with_cleanup_body(ctx, inner);
+            if (node->as.with_stmt.release && body_exits(inner)) {
+                node->as.with_stmt.release = NULL;
+                opt_changed(ctx, &ctx->stats->cleanups);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+static void pass_with_cleanup(OptContext* ctx, Node* func) {
+    with_cleanup_body(ctx, parser_func_body(func));
+}
+
+// ---------------------------------------------------------------------------
+// Loop bounds
+// ---------------------------------------------------------------------------
+
+// A for loop evaluates end and step once, before the first iteration. A
+// bound whose value cannot change while the loop runs is read in place;
+// codegen evaluates any other bound into a temporary.
+
+void loop_list_free(LoopList* list) {
+    free(list->items);
+    memset(list, 0, sizeof(LoopList));
+}
+
+static LoopInfo* loop_add(LoopList* list) {
+    if (list->count >= list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 32;
+        list->items = realloc(list->items, list->capacity * sizeof(LoopInfo));
+    }
+    LoopInfo* info = &list->items[list->count++];
+    memset(info, 0, sizeof(LoopInfo));
+    return info;
+}
+
+// Only constants and locals the function never writes; uses are counted over
+// the whole body, so a write anywhere (or a taken address) disqualifies.
+static bool loop_invariant(OptContext* ctx, Node* node, Atom var_atom) {
+    switch (node->type) {
+    case NODE_INTEGER_LITERAL:
+    case NODE_SIZEOF_EXPR:
+        return true;
+    case NODE_PAREN_EXPR:
+        return loop_invariant(ctx, node->as.paren_expr.inner, var_atom);
+    case NODE_CAST_EXPR:
+        return loop_invariant(ctx, node->as.cast_expr.expr, var_atom);
+    case NODE_UNARY_EXPR:
+        return node->as.unary_expr.op == TOKEN_MINUS &&
+               loop_invariant(ctx, node->as.unary_expr.operand, var_atom);
+    case NODE_BINARY_EXPR:
+        return loop_invariant(ctx, node->as.binary_expr.left, var_atom) &&
+               loop_invariant(ctx, node->as.binary_expr.right, var_atom);
+    case NODE_FIELD_ACCESS: {
+        // a field of a slice or struct held by value, such as s.len
+        Type* object_type = opt_type(ctx, node->as.field_access.object);
+        if (!object_type || (object_type->kind != TYPE_SLICE && object_type->kind != TYPE_STRUCT)) {
+            return false;
+        }
+        return loop_invariant(ctx, node->as.field_access.object, var_atom);
+    }
+    case NODE_IDENTIFIER: {
+        Atom atom = node->as.identifier.name_atom;
+        // in C the loop variable is already in scope in the condition
+        if (atom == var_atom) return false;
+        // codegen resolves a name shadowing a module symbol to the symbol
+        Symbol* sym = symbol_find_atom(ctx->mod->symbols, atom);
+        if (sym && sym->kind == SYMBOL_IMPORT && sym->source) {
+            sym = symbol_find_atom(sym->source->symbols, atom);
+        }
+        if (sym) return sym->kind == SYMBOL_CONST;
+        OptUse* use = use_find(ctx, atom);
+        return use && use->is_local && use->writes == 0;
+    }
+    default:
+        return false;
+    }
+}
+
+// Whether the loop body may change the loop variable.
+static bool loop_var_written(Node* loop) {
+    OptContext body_ctx;
+    memset(&body_ctx, 0, sizeof(body_ctx));
+    count_body(&body_ctx, &loop->as.for_stmt.body);
+    OptUse* use = use_find(&body_ctx, loop->as.for_stmt.var_name_atom);
+    bool written = use && use->writes > 0;
+    free(body_ctx.uses);
+    return written;
+}
+
+static void loops_body(OptContext* ctx, Node* func, NodeList* body);
+
+static void loops_for(OptContext* ctx, Node* func, Node* node) {
+    Atom var_atom = node->as.for_stmt.var_name_atom;
+    Node* step = node->as.for_stmt.step;
+    node->as.for_stmt.end_invariant = loop_invariant(ctx, node->as.for_stmt.end, var_atom);
+    node->as.for_stmt.step_invariant = !step || loop_invariant(ctx, step, var_atom);
+
+    LoopList* loops = ctx->stats->loops;
+    if (loops) {
+        int64_t step_value = 1;
+        LoopInfo* info = loop_add(loops);
+        info->mod = ctx->mod;
+        info->struct_name = ctx->struct_name;
+        info->struct_name_size = ctx->struct_name_size;
+        info->func_name = func->as.func_decl.name;
+        info->func_name_size = func->as.func_decl.name_size;
+        info->line = location_line(node->loc);
+        info->end_hoisted = !node->as.for_stmt.end_invariant;
+        info->step_hoisted = !node->as.for_stmt.step_invariant;
+        info->step_constant = (!step || int_value(ctx, step, &step_value)) && step_value > 0;
+        info->var_written = loop_var_written(node);
+    }
+    loops_body(ctx, func, &node->as.for_stmt.body);
+}
+
+static void loops_body(OptContext* ctx, Node* func, NodeList* body) {
+    for (size_t i = 0; i < body->count; i++) {
+        Node* node = body->nodes[i];
+        switch (node->type) {
+        case NODE_IF_STMT: {
+            loops_body(ctx, func, &node->as.if_stmt.then_body);
+            ElseIfList* elseifs = &node->as.if_stmt.elseifs;
+            for (size_t j = 0; j < elseifs->count; j++) loops_body(ctx, func, &elseifs->branches[j].body);
+            loops_body(ctx, func, &node->as.if_stmt.else_body);
+            break;
+        }
+        case NODE_FOR_STMT:
+            loops_for(ctx, func, node);
+            break;
+        case NODE_WHILE_STMT:
+            loops_body(ctx, func, &node->as.while_stmt.body);
+            break;
+        case NODE_WITH_STMT:
+            loops_body(ctx, func, &node->as.with_stmt.body);
+            break;
+        case NODE_MATCH_STMT: {
+            MatchCaseList* cases = &node->as.match_stmt.cases;
+            for (size_t j = 0; j < cases->count; j++) loops_body(ctx, func, &cases->cases[j].body);
+            loops_body(ctx, func, &node->as.match_stmt.else_body);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+// Runs once, after the rewriting passes have settled.
+static void pass_loops(OptContext* ctx, Node* func) {
+    count_func(ctx, func);
+    loops_body(ctx, func, parser_func_body(func));
+}
+
+// ---------------------------------------------------------------------------
+// Instance bodies
+// ---------------------------------------------------------------------------
+
+// Instances share their template's body, so an instance's passes rewrite a
+// private copy of its statements and expressions. Each copy stands for its
+// original in the instance's side tables. Type nodes, release calls and
+// cleanup lists are never rewritten and stay shared.
+
+static Node* clone_node(OptContext* ctx, Node* node);
+
+static NodeList clone_list(OptContext* ctx, NodeList list) {
+    NodeList copy = list;
+    if (list.count == 0) return copy;
+    copy.nodes = arena_alloc(ctx->arena, sizeof(Node*) * list.count);
+    for (uint32_t i = 0; i < list.count; i++) copy.nodes[i] = clone_node(ctx, list.nodes[i]);
+    return copy;
+}
+
+static Node* clone_node(OptContext* ctx, Node* node) {
+    if (!node) return NULL;
+    size_t size = node_size(node->type);
+    Node* copy = arena_alloc(ctx->arena, size);
+    memcpy(copy, node, size);
+    generic_inst_alias(ctx->arena, ctx->inst, copy, node);
+
+    switch (node->type) {
+    case NODE_CONST_DECL:
+        copy->as.const_decl.value = clone_node(ctx, node->as.const_decl.value);
+        break;
+    case NODE_VAR_DECL:
+        copy->as.var_decl.value = clone_node(ctx, node->as.var_decl.value);
+        break;
+    case NODE_RETURN_STMT:
+        copy->as.return_stmt.value = clone_node(ctx, node->as.return_stmt.value);
+        break;
+    case NODE_IF_STMT: {
+        copy->as.if_stmt.condition = clone_node(ctx, node->as.if_stmt.condition);
+        copy->as.if_stmt.then_body = clone_list(ctx, node->as.if_stmt.then_body);
+        ElseIfList* elseifs = &copy->as.if_stmt.elseifs;
+        if (elseifs->count > 0) {
+            ElseIfBranch* branches = arena_alloc(ctx->arena, sizeof(ElseIfBranch) * elseifs->count);
+            for (uint32_t i = 0; i < elseifs->count; i++) {
+                branches[i] = elseifs->branches[i];
+                branches[i].condition = clone_node(ctx, branches[i].condition);
+                branches[i].body = clone_list(ctx, branches[i].body);
+            }
+            elseifs->branches = branches;
+        }
+        copy->as.if_stmt.else_body = clone_list(ctx, node->as.if_stmt.else_body);
+        break;
+    }
+    case NODE_FOR_STMT:
+        copy->as.for_stmt.start = clone_node(ctx, node->as.for_stmt.start);
+        copy->as.for_stmt.end = clone_node(ctx, node->as.for_stmt.end);
+        copy->as.for_stmt.step = clone_node(ctx, node->as.for_stmt.step);
+        copy->as.for_stmt.body = clone_list(ctx, node->as.for_stmt.body);
+        break;
+    case NODE_WHILE_STMT:
+        copy->as.while_stmt.condition = clone_node(ctx, node->as.while_stmt.condition);
+        copy->as.while_stmt.body = clone_list(ctx, node->as.while_stmt.body);
+        break;
+    case NODE_WITH_STMT:
+        copy->as.with_stmt.resource = clone_node(ctx, node->as.with_stmt.resource);
+        copy->as.with_stmt.body = clone_list(ctx, node->as.with_stmt.body);
+        break;
+    case NODE_MATCH_STMT: {
+        copy->as.match_stmt.subject = clone_node(ctx, node->as.match_stmt.subject);
+        MatchCaseList* cases = &copy->as.match_stmt.cases;
+        if (cases->count > 0) {
+            MatchCase* items = arena_alloc(ctx->arena, sizeof(MatchCase) * cases->count);
+            for (uint32_t i = 0; i < cases->count; i++) {
+                items[i] = cases->cases[i];
+                items[i].values = clone_list(ctx, items[i].values);
+                items[i].body = clone_list(ctx, items[i].body);
+            }
+            cases->cases = items;
+        }
+        copy->as.match_stmt.else_body = clone_list(ctx, node->as.match_stmt.else_body);
+        break;
+    }
+    case NODE_ASSIGN_STMT:
+        copy->as.assign_stmt.target = clone_node(ctx, node->as.assign_stmt.target);
+        copy->as.assign_stmt.value = clone_node(ctx, node->as.assign_stmt.value);
+        break;
+    case NODE_COMPOUND_ASSIGN_STMT:
+        copy->as.compound_assign_stmt.target = clone_node(ctx, node->as.compound_assign_stmt.target);
+        copy->as.compound_assign_stmt.value = clone_node(ctx, node->as.compound_assign_stmt.value);
+        break;
+    case NODE_EXPR_STMT:
+        copy->as.expr_stmt.expr = clone_node(ctx, node->as.expr_stmt.expr);
+        break;
+    case NODE_BINARY_EXPR:
+        copy->as.binary_expr.left = clone_node(ctx, node->as.binary_expr.left);
+        copy->as.binary_expr.right = clone_node(ctx, node->as.binary_expr.right);
+        break;
+    case NODE_UNARY_EXPR:
+        copy->as.unary_expr.operand = clone_node(ctx, node->as.unary_expr.operand);
+        break;
+    case NODE_PAREN_EXPR:
+        copy->as.paren_expr.inner = clone_node(ctx, node->as.paren_expr.inner);
+        break;
+    case NODE_CALL_EXPR:
+        copy->as.call_expr.callee = clone_node(ctx, node->as.call_expr.callee);
+        copy->as.call_expr.args = clone_list(ctx, node->as.call_expr.args);
+        break;
+    case NODE_FIELD_ACCESS:
+        copy->as.field_access.object = clone_node(ctx, node->as.field_access.object);
+        break;
+    case NODE_METHOD_CALL:
+        copy->as.method_call.object = clone_node(ctx, node->as.method_call.object);
+        copy->as.method_call.args = clone_list(ctx, node->as.method_call.args);
+        break;
+    case NODE_STRUCT_LITERAL: {
+        FieldInitList* inits = &copy->as.struct_literal.fields;
+        if (inits->count > 0) {
+            FieldInit* items = arena_alloc(ctx->arena, sizeof(FieldInit) * inits->count);
+            for (uint32_t i = 0; i < inits->count; i++) {
+                items[i] = inits->inits[i];
+                items[i].value = clone_node(ctx, items[i].value);
+            }
+            inits->inits = items;
+        }
+        break;
+    }
+    case NODE_CAST_EXPR:
+        copy->as.cast_expr.expr = clone_node(ctx, node->as.cast_expr.expr);
+        break;
+    case NODE_ARRAY_LITERAL:
+        copy->as.array_literal.elements = clone_list(ctx, node->as.array_literal.elements);
+        break;
+    case NODE_INDEX_EXPR:
+        copy->as.index_expr.object = clone_node(ctx, node->as.index_expr.object);
+        copy->as.index_expr.index = clone_node(ctx, node->as.index_expr.index);
+        break;
+    default:
+        break;
+    }
+    return copy;
+}
+
+// ---------------------------------------------------------------------------
+// Pass manager
+// ---------------------------------------------------------------------------
+
+typedef struct OptPass {
+    char* name;
+    bool needs_uses; // runs on use counts taken just before it
+    void (*run)(OptContext* ctx, Node* func);
+} OptPass;
+
+static const OptPass OPT_PASSES[] = {
+    { "propagate",    true,  pass_propagate },
+    { "dead-branch",  false, pass_prune },
+    { "dead-store",   true,  pass_dead_store },
+    { "with-cleanup", false, pass_with_cleanup },
+};
+
+static void opt_func(OptContext* ctx, Node* func) {
+    if (!func || func->type != NODE_FUNC_DECL) return;
+    if (func->as.func_decl.is_extern) return;
+    // a template's nodes stand for a different type in every instance
+    if (func->as.func_decl.type_params.count > 0) return;
+    // unreached struct-instance methods are never checked or emitted
+    GenericInst* inst = func->as.func_decl.inst;
+    if (inst && !func->as.func_decl.is_reached) return;
+    ctx->inst = inst;
+    if (inst) func->as.func_decl.body = clone_list(ctx, *parser_func_body(func));
+
+    for (int round = 0; round < OPT_MAX_ROUNDS; round++) {
+        ctx->changed = false;
+        for (size_t i = 0; i < sizeof(OPT_PASSES) / sizeof(OPT_PASSES[0]); i++) {
+            if (OPT_PASSES[i].needs_uses) count_func(ctx, func);
+            OPT_PASSES[i].run(ctx, func);
+        }
+        if (!ctx->changed) break;
+    }
+    pass_loops(ctx, func);
+    ctx->inst = NULL;
+}
+
+// Module-level constant and variable initializers fold with module
+// constants only, in declaration order.
+static void opt_module_values(OptContext* ctx) {
+    ctx->binding_count = 0;
+    for (Symbol* sym = ctx->mod->symbols->first; sym; sym = sym->next) {
+        if (!sym->node) continue;
+        if (sym->kind == SYMBOL_CONST && sym->node->type == NODE_CONST_DECL) {
+            prop_expr(ctx, &sym->node->as.const_decl.value);
+        } else if (sym->kind == SYMBOL_VAR && sym->node->type == NODE_VAR_DECL) {
+            prop_expr(ctx, &sym->node->as.var_decl.value);
+        }
+    }
+}
+
+void opt_run(Arena* arena, ModuleGraph* graph, OptStats* stats) {
+    OptStats unused = {0};
+    OptContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.arena = arena;
+    ctx.stats = stats ? stats : &unused;
+
+    for (Module* mod = graph->first; mod; mod = mod->next) {
+        if (!mod->symbols) continue;
+        ctx.mod = mod;
+        opt_module_values(&ctx);
+    }
+
+    for (Module* mod = graph->first; mod; mod = mod->next) {
+        if (!mod->symbols) continue;
+        ctx.mod = mod;
+        for (Symbol* sym = mod->symbols->first; sym; sym = sym->next) {
+            if (!sym->node) continue;
+            if (sym->kind == SYMBOL_FUNC) {
+                opt_func(&ctx, sym->node);
+            } else if (sym->kind == SYMBOL_STRUCT) {
+                if (sym->node->as.struct_decl.type_params.count > 0) continue;
+                ctx.struct_name = sym->node->as.struct_decl.name;
+                ctx.struct_name_size = sym->node->as.struct_decl.name_size;
+                NodeList* methods = &sym->node->as.struct_decl.methods;
+                for (size_t i = 0; i < methods->count; i++) opt_func(&ctx, methods->nodes[i]);
+                ctx.struct_name = NULL;
+            }
+        }
+    }
+
+    free(ctx.bindings);
+    free(ctx.uses);
+}
@@ -0,0 +1,56 @@
+#ifndef ANCC_OPT_H
+#define ANCC_OPT_H
+
+#include "arena.h"
+#include "module.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Optimization passes over the checked AST, run between sema and codegen.
+// Passes rewrite function bodies in place. These are AST passes, not an IR:
+// codegen prints the rewritten tree. Generic templates are left alone; each
+// reached instance rewrites a private copy of the body it shares with the
+// template, whose nodes the instance's side tables also cover.
+
+// One for loop of a checked body, for `ancc build --report=loops`. The loop
+// is canonical when codegen emits it as a counted C loop: bounds fixed before
+// the first iteration, a positive constant step, and a loop variable only the
+// loop itself advances.
+typedef struct LoopInfo {
+    Module* mod;
+    char* struct_name; // NULL for free functions
+    size_t struct_name_size;
+    char* func_name;
+    size_t func_name_size;
+    size_t line;
+    bool end_hoisted;   // end evaluated into a temporary before the loop
+    bool step_hoisted;
+    bool step_constant; // positive compile-time step
+    bool var_written;   // the body assigns the loop variable or takes its address
+} LoopInfo;
+
+typedef struct LoopList {
+    LoopInfo* items;
+    size_t count;
+    size_t capacity;
+} LoopList;
+
+void loop_list_free(LoopList* list);
+
+// Changes made by each pass, for `ancc build --report=opt`.
+typedef struct OptStats {
+    size_t folded;        // constant expressions replaced by their value
+    size_t propagated;    // reads of constants replaced by the constant
+    size_t copies;        // reads of a copy replaced by the original
+    size_t dead_branches; // if/while branches dropped for a constant condition
+    size_t unreachable;   // statements dropped after return, break or continue
+    size_t dead_stores;   // declarations and assignments of locals never read
+    size_t cleanups;      // with-releases dropped after a body that always exits
+    LoopList* loops;      // when set, every for loop is recorded here
+} OptStats;
+
+// Run every pass over every function body of the graph. stats may be NULL.
+void opt_run(Arena* arena, ModuleGraph* graph, OptStats* stats);
+
+#endif
@@ -18,7 +18,7 @@ bool package_load(Arena* arena, Errors* errors, Package* pkg, char* dir) {
     snprintf(path, sizeof(path), "%s/anchor", dir);
 
     size_t size;
-    char* buf = file_read(arena, path, &size);
+    char* buf = source_load(arena, path, &size);
     if (!buf) {
         errors_push(errors, SEVERITY_ERROR, 0, 0, 0, "cannot open '%s'", path);
         return false;
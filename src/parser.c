@@ -1,7 +1,9 @@
 #include "parser.h"
+#include "macro.h"
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 // ---------------------------------------------------------------------------
@@ -15,6 +17,12 @@ typedef struct Parser {
     size_t pos;
     bool had_error;
     bool panic_mode;
+    bool lazy_bodies;
+
+    // Scratch stack shared by every open list; reused across the whole parse.
+    char* scratch;
+    size_t scratch_top;
+    size_t scratch_capacity;
 } Parser;
 
 // ---------------------------------------------------------------------------
@@ -33,6 +41,18 @@ static Token* advance(Parser* p) {
     return tok;
 }
 
+static char* tok_text(Parser* p, Token* tok) {
+    return token_text(p->tokens, tok);
+}
+
+static Atom tok_atom(Parser* p, Token* tok) {
+    return intern(token_text(p->tokens, tok), tok->size);
+}
+
+static SourceLoc tok_loc(Parser* p, Token* tok) {
+    return p->tokens->base + tok->offset;
+}
+
 static bool check(Parser* p, TokenType type) {
     return peek(p)->type == type;
 }
@@ -50,7 +70,7 @@ static Token* expect(Parser* p, TokenType expected, const char* message) {
         return advance(p);
     }
     Token* tok = peek(p);
-    errors_push(p->errors, SEVERITY_ERROR, tok->offset, tok->line, tok->column, "%s", message);
+    errors_push_at(p->errors, SEVERITY_ERROR, tok_loc(p, tok), "%s", message);
     p->had_error = true;
     p->panic_mode = true;
     return NULL;
@@ -68,8 +88,8 @@ static bool expect_newline(Parser* p) {
         return true;
     }
     Token* tok = peek(p);
-    errors_push(p->errors, SEVERITY_ERROR, tok->offset, tok->line, tok->column,
-                "Expected newline.");
+    errors_push_at(p->errors, SEVERITY_ERROR, tok_loc(p, tok),
+                   "Expected newline.");
     p->had_error = true;
     return false;
 }
@@ -79,136 +99,58 @@ static bool expect_newline(Parser* p) {
 // ---------------------------------------------------------------------------
 
 static Node* make_node(Parser* p, NodeType type, Token* tok) {
-    Node* node = arena_alloc(p->arena, sizeof(Node));
-    memset(node, 0, sizeof(Node));
-    node->type = type;
-    if (tok) {
-        node->offset = tok->offset;
-        node->line = tok->line;
-        node->column = tok->column;
-    }
-    return node;
+    return node_new(p->arena, type, tok ? tok_loc(p, tok) : 0);
 }
 
 // ---------------------------------------------------------------------------
-// List helpers (arena-allocated, 2x doubling)
+// List helpers
 // ---------------------------------------------------------------------------
 
-static void node_list_push(Arena* arena, NodeList* list, Node* node) {
-    if (list->count >= list->capacity) {
-        size_t new_cap = list->capacity < 8 ? 8 : list->capacity * 2;
-        Node** new_nodes = arena_alloc(arena, new_cap * sizeof(Node*));
-        if (list->nodes) {
-            memcpy(new_nodes, list->nodes, list->count * sizeof(Node*));
-        }
-        list->nodes = new_nodes;
-        list->capacity = new_cap;
-    }
-    list->nodes[list->count++] = node;
+// Open lists collect their items on the parser's scratch stack and are copied
+// into an exact-size arena array when they close, so list growth leaves no
+// dead copies in the arena. Lists nest: a child opens above its parent's items
+// and its close pops back to where it started. A child abandoned on an error
+// path is overwritten by the parent's next push.
+typedef struct ListBuilder {
+    size_t start;
+    size_t count;
+} ListBuilder;
+
+static ListBuilder list_open(Parser* p) {
+    ListBuilder list = { ALIGN_UP(p->scratch_top, sizeof(void*)), 0 };
+    return list;
 }
 
-static void param_list_push(Arena* arena, ParamList* list, Param param) {
-    if (list->count >= list->capacity) {
-        size_t new_cap = list->capacity < 8 ? 8 : list->capacity * 2;
-        Param* new_params = arena_alloc(arena, new_cap * sizeof(Param));
-        if (list->params) {
-            memcpy(new_params, list->params, list->count * sizeof(Param));
-        }
-        list->params = new_params;
-        list->capacity = new_cap;
-    }
-    list->params[list->count++] = param;
+static void list_push(Parser* p, ListBuilder* list, void* item, size_t item_size) {
+    size_t offset = list->start + list->count * item_size;
+    if (offset + item_size > p->scratch_capacity) {
+        size_t new_cap = p->scratch_capacity < 4096 ? 4096 : p->scratch_capacity * 2;
+        while (new_cap < offset + item_size) new_cap *= 2;
+        p->scratch = realloc(p->scratch, new_cap);
+        p->scratch_capacity = new_cap;
+    }
+    memcpy(p->scratch + offset, item, item_size);
+    p->scratch_top = offset + item_size;
+    list->count++;
 }
 
-static void field_list_push(Arena* arena, FieldList* list, Field field) {
-    if (list->count >= list->capacity) {
-        size_t new_cap = list->capacity < 8 ? 8 : list->capacity * 2;
-        Field* new_fields = arena_alloc(arena, new_cap * sizeof(Field));
-        if (list->fields) {
-            memcpy(new_fields, list->fields, list->count * sizeof(Field));
-        }
-        list->fields = new_fields;
-        list->capacity = new_cap;
-    }
-    list->fields[list->count++] = field;
+static void* list_close(Parser* p, ListBuilder* list, size_t item_size) {
+    p->scratch_top = list->start;
+    if (list->count == 0) return NULL;
+    void* items = arena_alloc(p->arena, list->count * item_size);
+    memcpy(items, p->scratch + list->start, list->count * item_size);
+    return items;
 }
 
-static void enum_variant_list_push(Arena* arena, EnumVariantList* list, EnumVariant variant) {
-    if (list->count >= list->capacity) {
-        size_t new_cap = list->capacity < 8 ? 8 : list->capacity * 2;
-        EnumVariant* new_variants = arena_alloc(arena, new_cap * sizeof(EnumVariant));
-        if (list->variants) {
-            memcpy(new_variants, list->variants, list->count * sizeof(EnumVariant));
-        }
-        list->variants = new_variants;
-        list->capacity = new_cap;
-    }
-    list->variants[list->count++] = variant;
-}
-
-static void field_init_list_push(Arena* arena, FieldInitList* list, FieldInit init) {
-    if (list->count >= list->capacity) {
-        size_t new_cap = list->capacity < 8 ? 8 : list->capacity * 2;
-        FieldInit* new_inits = arena_alloc(arena, new_cap * sizeof(FieldInit));
-        if (list->inits) {
-            memcpy(new_inits, list->inits, list->count * sizeof(FieldInit));
-        }
-        list->inits = new_inits;
-        list->capacity = new_cap;
-    }
-    list->inits[list->count++] = init;
-}
-
-static void elseif_list_push(Arena* arena, ElseIfList* list, ElseIfBranch branch) {
-    if (list->count >= list->capacity) {
-        size_t new_cap = list->capacity < 8 ? 8 : list->capacity * 2;
-        ElseIfBranch* new_branches = arena_alloc(arena, new_cap * sizeof(ElseIfBranch));
-        if (list->branches) {
-            memcpy(new_branches, list->branches, list->count * sizeof(ElseIfBranch));
-        }
-        list->branches = new_branches;
-        list->capacity = new_cap;
-    }
-    list->branches[list->count++] = branch;
-}
-
-static void type_param_list_push(Arena* arena, TypeParamList* list, TypeParam param) {
-    if (list->count >= list->capacity) {
-        size_t new_cap = list->capacity < 8 ? 8 : list->capacity * 2;
-        TypeParam* new_params = arena_alloc(arena, new_cap * sizeof(TypeParam));
-        if (list->params) {
-            memcpy(new_params, list->params, list->count * sizeof(TypeParam));
-        }
-        list->params = new_params;
-        list->capacity = new_cap;
-    }
-    list->params[list->count++] = param;
-}
+// A struct body entry: a method when `method` is set, otherwise a field.
+typedef struct StructMember {
+    Field field;
+    Node* method;
+} StructMember;
 
-static void import_name_list_push(Arena* arena, ImportNameList* list, ImportName name) {
-    if (list->count >= list->capacity) {
-        size_t new_cap = list->capacity < 8 ? 8 : list->capacity * 2;
-        ImportName* new_names = arena_alloc(arena, new_cap * sizeof(ImportName));
-        if (list->names) {
-            memcpy(new_names, list->names, list->count * sizeof(ImportName));
-        }
-        list->names = new_names;
-        list->capacity = new_cap;
-    }
-    list->names[list->count++] = name;
-}
-
-static void match_case_list_push(Arena* arena, MatchCaseList* list, MatchCase mc) {
-    if (list->count >= list->capacity) {
-        size_t new_cap = list->capacity < 8 ? 8 : list->capacity * 2;
-        MatchCase* new_cases = arena_alloc(arena, new_cap * sizeof(MatchCase));
-        if (list->cases) {
-            memcpy(new_cases, list->cases, list->count * sizeof(MatchCase));
-        }
-        list->cases = new_cases;
-        list->capacity = new_cap;
-    }
-    list->cases[list->count++] = mc;
+static NodeList node_list_close(Parser* p, ListBuilder* list) {
+    NodeList result = { list_close(p, list, sizeof(Node*)), (uint32_t)list->count };
+    return result;
 }
 
 // ---------------------------------------------------------------------------
@@ -247,42 +189,40 @@ static Node* parse_func_decl(Parser* p, bool is_export);
 // Generic parameter/argument parsers
 // ---------------------------------------------------------------------------
 
-// Parses [T, K, V] at declaration sites (type parameter names)
+// Parses [T, K: Hashable, V] at declaration sites (type parameter names,
+// each with an optional interface bound)
 static TypeParamList parse_type_params(Parser* p) {
-    TypeParamList params = {0};
+    ListBuilder params = list_open(p);
     advance(p); // consume '['
-    Token* name_tok = expect(p, TOKEN_IDENTIFIER, "Expected type parameter name.");
-    if (name_tok) {
+    do {
+        Token* name_tok = expect(p, TOKEN_IDENTIFIER, "Expected type parameter name.");
+        if (!name_tok) break;
         TypeParam param = {0};
-        param.name = name_tok->value;
+        param.name = tok_text(p, name_tok);
         param.name_size = name_tok->size;
-        type_param_list_push(p->arena, &params, param);
-
-        while (match(p, TOKEN_COMMA)) {
-            name_tok = expect(p, TOKEN_IDENTIFIER, "Expected type parameter name.");
-            if (!name_tok) break;
-            TypeParam next = {0};
-            next.name = name_tok->value;
-            next.name_size = name_tok->size;
-            type_param_list_push(p->arena, &params, next);
+        param.name_atom = tok_atom(p, name_tok);
+        if (match(p, TOKEN_COLON)) {
+            param.bound = parse_type(p);
         }
-    }
+        list_push(p, &params, &param, sizeof(param));
+    } while (match(p, TOKEN_COMMA));
     expect(p, TOKEN_RIGHT_BRACKET, "Expected ']' after type parameters.");
-    return params;
+    TypeParamList result = { list_close(p, &params, sizeof(TypeParam)), (uint32_t)params.count };
+    return result;
 }
 
 // Parses [int, float] at usage sites (type arguments as type nodes)
 static NodeList parse_type_args(Parser* p) {
-    NodeList args = {0};
+    ListBuilder args = list_open(p);
     advance(p); // consume '['
     Node* type_node = parse_type(p);
-    if (type_node) node_list_push(p->arena, &args, type_node);
+    if (type_node) list_push(p, &args, &type_node, sizeof(type_node));
     while (match(p, TOKEN_COMMA)) {
         type_node = parse_type(p);
-        if (type_node) node_list_push(p->arena, &args, type_node);
+        if (type_node) list_push(p, &args, &type_node, sizeof(type_node));
     }
     expect(p, TOKEN_RIGHT_BRACKET, "Expected ']' after type arguments.");
-    return args;
+    return node_list_close(p, &args);
 }
 
 // ---------------------------------------------------------------------------
@@ -307,18 +247,31 @@ static Node* parse_type(Parser* p) {
     if (check(p, TOKEN_IDENTIFIER)) {
         Token* tok = advance(p);
         Node* node = make_node(p, NODE_TYPE_SIMPLE, tok);
-        node->as.type_simple.name = tok->value;
+        node->as.type_simple.name = tok_text(p, tok);
         node->as.type_simple.name_size = tok->size;
+        node->as.type_simple.name_atom = tok_atom(p, tok);
         memset(&node->as.type_simple.type_args, 0, sizeof(NodeList));
 
         // check for array/slice/generic suffix
         if (check(p, TOKEN_LEFT_BRACKET)) {
             // Peek inside the bracket to disambiguate:
             //   T[]      -> slice
-            //   T[N]     -> array (N is integer literal)
+            //   T[N]     -> array (N is a constant expression)
             //   T[U,...] -> generic type args
+            // A lone name is a type argument unless T is a built-in type,
+            // which takes none.
             size_t saved = p->pos;
             Token* after = &p->tokens->tokens[saved + 1];
+            Token* next = after->type == TOKEN_END_OF_FILE ? after : &p->tokens->tokens[saved + 2];
+            Atom name_atom = node->as.type_simple.name_atom;
+            bool is_builtin = name_atom >= ATOM_VOID && name_atom <= ATOM_STRING;
+            bool starts_type = after->type == TOKEN_IDENTIFIER || after->type == TOKEN_AMPERSAND ||
+                               after->type == TOKEN_STAR;
+            bool lone_name = after->type == TOKEN_IDENTIFIER &&
+                             (next->type == TOKEN_COMMA || next->type == TOKEN_RIGHT_BRACKET ||
+                              next->type == TOKEN_LEFT_BRACKET);
+            bool is_size = after->type != TOKEN_RIGHT_BRACKET &&
+                           (is_builtin || !starts_type || (after->type == TOKEN_IDENTIFIER && !lone_name));
             if (after->type == TOKEN_RIGHT_BRACKET) {
                 // T[] -> slice
                 Token* bracket_tok = advance(p); // consume '['
@@ -326,7 +279,7 @@ static Node* parse_type(Parser* p) {
                 Node* slice_node = make_node(p, NODE_TYPE_SLICE, bracket_tok);
                 slice_node->as.type_slice.inner = node;
                 return slice_node;
-            } else if (after->type == TOKEN_INTEGER_LITERAL) {
+            } else if (is_size) {
                 // T[N] -> array
                 Token* bracket_tok = advance(p); // consume '['
                 Node* size_expr = parse_expression(p);
@@ -344,8 +297,8 @@ static Node* parse_type(Parser* p) {
         return node;
     }
     Token* tok = peek(p);
-    errors_push(p->errors, SEVERITY_ERROR, tok->offset, tok->line, tok->column,
-                "Expected type.");
+    errors_push_at(p->errors, SEVERITY_ERROR, tok_loc(p, tok),
+                   "Expected type.");
     p->had_error = true;
     p->panic_mode = true;
     return NULL;
@@ -355,27 +308,27 @@ static Node* parse_type(Parser* p) {
 // Expression parser — precedence climbing
 // ---------------------------------------------------------------------------
 
-// Level 7: primary
+// Primary expressions: literals, names, calls, parentheses
 static Node* parse_struct_literal(Parser* p, Token* name_tok) {
     advance(p); // consume '('
     Node* node = make_node(p, NODE_STRUCT_LITERAL, name_tok);
-    node->as.struct_literal.struct_name = name_tok->value;
+    node->as.struct_literal.struct_name = tok_text(p, name_tok);
     node->as.struct_literal.struct_name_size = name_tok->size;
-    memset(&node->as.struct_literal.fields, 0, sizeof(FieldInitList));
+    node->as.struct_literal.struct_name_atom = tok_atom(p, name_tok);
 
+    ListBuilder fields = list_open(p);
     if (!check(p, TOKEN_RIGHT_PAREN)) {
         Token* field_tok = expect(p, TOKEN_IDENTIFIER, "Expected field name in struct literal.");
         if (!field_tok) return node;
         expect(p, TOKEN_ASSIGN, "Expected '=' after field name.");
         Node* value = parse_expression(p);
         FieldInit init = {0};
-        init.name = field_tok->value;
+        init.name = tok_text(p, field_tok);
         init.name_size = field_tok->size;
+        init.name_atom = tok_atom(p, field_tok);
         init.value = value;
-        init.offset = field_tok->offset;
-        init.line = field_tok->line;
-        init.column = field_tok->column;
-        field_init_list_push(p->arena, &node->as.struct_literal.fields, init);
+        init.loc = tok_loc(p, field_tok);
+        list_push(p, &fields, &init, sizeof(init));
 
         while (match(p, TOKEN_COMMA)) {
             field_tok = expect(p, TOKEN_IDENTIFIER, "Expected field name.");
@@ -383,28 +336,31 @@ static Node* parse_struct_literal(Parser* p, Token* name_tok) {
             expect(p, TOKEN_ASSIGN, "Expected '=' after field name.");
             value = parse_expression(p);
             FieldInit next = {0};
-            next.name = field_tok->value;
+            next.name = tok_text(p, field_tok);
             next.name_size = field_tok->size;
+            next.name_atom = tok_atom(p, field_tok);
             next.value = value;
-            next.offset = field_tok->offset;
-            next.line = field_tok->line;
-            next.column = field_tok->column;
-            field_init_list_push(p->arena, &node->as.struct_literal.fields, next);
+            next.loc = tok_loc(p, field_tok);
+            list_push(p, &fields, &next, sizeof(next));
         }
     }
+    node->as.struct_literal.fields.inits = list_close(p, &fields, sizeof(FieldInit));
+    node->as.struct_literal.fields.count = (uint32_t)fields.count;
     expect(p, TOKEN_RIGHT_PAREN, "Expected ')' after struct literal.");
     return node;
 }
 
-static void parse_args_into(Parser* p, NodeList* args) {
+static NodeList parse_args(Parser* p) {
+    ListBuilder args = list_open(p);
     if (!check(p, TOKEN_RIGHT_PAREN)) {
         Node* arg = parse_expression(p);
-        if (arg) node_list_push(p->arena, args, arg);
+        if (arg) list_push(p, &args, &arg, sizeof(arg));
         while (match(p, TOKEN_COMMA)) {
             arg = parse_expression(p);
-            if (arg) node_list_push(p->arena, args, arg);
+            if (arg) list_push(p, &args, &arg, sizeof(arg));
         }
     }
+    return node_list_close(p, &args);
 }
 
 static bool is_struct_literal_lookahead(Parser* p) {
@@ -430,21 +386,21 @@ static Node* parse_primary(Parser* p) {
     case TOKEN_INTEGER_LITERAL: {
         advance(p);
         Node* node = make_node(p, NODE_INTEGER_LITERAL, tok);
-        node->as.integer_literal.value = tok->value;
+        node->as.integer_literal.value = tok_text(p, tok);
         node->as.integer_literal.value_size = tok->size;
         return node;
     }
     case TOKEN_FLOAT_LITERAL: {
         advance(p);
         Node* node = make_node(p, NODE_FLOAT_LITERAL, tok);
-        node->as.float_literal.value = tok->value;
+        node->as.float_literal.value = tok_text(p, tok);
         node->as.float_literal.value_size = tok->size;
         return node;
     }
     case TOKEN_STRING_LITERAL: {
         advance(p);
         Node* node = make_node(p, NODE_STRING_LITERAL, tok);
-        node->as.string_literal.value = tok->value;
+        node->as.string_literal.value = tok_text(p, tok);
         node->as.string_literal.value_size = tok->size;
         return node;
     }
@@ -515,19 +471,20 @@ static Node* parse_primary(Parser* p) {
             // function call
             advance(p); // consume '('
             Node* callee = make_node(p, NODE_IDENTIFIER, name_tok);
-            callee->as.identifier.name = name_tok->value;
+            callee->as.identifier.name = tok_text(p, name_tok);
             callee->as.identifier.name_size = name_tok->size;
+            callee->as.identifier.name_atom = tok_atom(p, name_tok);
             Node* node = make_node(p, NODE_CALL_EXPR, name_tok);
             node->as.call_expr.callee = callee;
             node->as.call_expr.type_args = type_args;
-            memset(&node->as.call_expr.args, 0, sizeof(NodeList));
-            parse_args_into(p, &node->as.call_expr.args);
+            node->as.call_expr.args = parse_args(p);
             expect(p, TOKEN_RIGHT_PAREN, "Expected ')' after arguments.");
             return node;
         }
         Node* node = make_node(p, NODE_IDENTIFIER, name_tok);
-        node->as.identifier.name = name_tok->value;
+        node->as.identifier.name = tok_text(p, name_tok);
         node->as.identifier.name_size = name_tok->size;
+        node->as.identifier.name_atom = tok_atom(p, name_tok);
         return node;
     }
     case TOKEN_LEFT_PAREN: {
@@ -541,28 +498,29 @@ static Node* parse_primary(Parser* p) {
     case TOKEN_LEFT_BRACKET: {
         Token* bracket_tok = advance(p);
         Node* node = make_node(p, NODE_ARRAY_LITERAL, bracket_tok);
-        memset(&node->as.array_literal.elements, 0, sizeof(NodeList));
+        ListBuilder elements = list_open(p);
         if (!check(p, TOKEN_RIGHT_BRACKET)) {
             Node* elem = parse_expression(p);
-            if (elem) node_list_push(p->arena, &node->as.array_literal.elements, elem);
+            if (elem) list_push(p, &elements, &elem, sizeof(elem));
             while (match(p, TOKEN_COMMA)) {
                 elem = parse_expression(p);
-                if (elem) node_list_push(p->arena, &node->as.array_literal.elements, elem);
+                if (elem) list_push(p, &elements, &elem, sizeof(elem));
             }
         }
+        node->as.array_literal.elements = node_list_close(p, &elements);
         expect(p, TOKEN_RIGHT_BRACKET, "Expected ']' after array literal.");
         return node;
     }
     default:
-        errors_push(p->errors, SEVERITY_ERROR, tok->offset, tok->line, tok->column,
-                     "Unexpected token in expression.");
+        errors_push_at(p->errors, SEVERITY_ERROR, tok_loc(p, tok),
+                       "Unexpected token in expression.");
         p->had_error = true;
         p->panic_mode = true;
         return NULL;
     }
 }
 
-// Level 6: postfix (field access, method call)
+// Postfix: field access, method call, indexing
 static Node* parse_postfix(Parser* p) {
     Node* node = parse_primary(p);
     if (!node) return NULL;
@@ -594,26 +552,27 @@ static Node* parse_postfix(Parser* p) {
             if (check(p, TOKEN_LEFT_PAREN)) advance(p); // consume '('
             Node* call = make_node(p, NODE_METHOD_CALL, dot_tok);
             call->as.method_call.object = node;
-            call->as.method_call.method_name = name_tok->value;
+            call->as.method_call.method_name = tok_text(p, name_tok);
             call->as.method_call.method_name_size = name_tok->size;
+            call->as.method_call.method_name_atom = tok_atom(p, name_tok);
             call->as.method_call.type_args = method_type_args;
-            memset(&call->as.method_call.args, 0, sizeof(NodeList));
-            parse_args_into(p, &call->as.method_call.args);
+            call->as.method_call.args = parse_args(p);
             expect(p, TOKEN_RIGHT_PAREN, "Expected ')' after method arguments.");
             node = call;
         } else {
             // field access
             Node* access = make_node(p, NODE_FIELD_ACCESS, dot_tok);
             access->as.field_access.object = node;
-            access->as.field_access.field_name = name_tok->value;
+            access->as.field_access.field_name = tok_text(p, name_tok);
             access->as.field_access.field_name_size = name_tok->size;
+            access->as.field_access.field_name_atom = tok_atom(p, name_tok);
             node = access;
         }
     }
     return node;
 }
 
-// Level 5: unary (-, &)
+// Prefix unary: -, &, *, not
 static Node* parse_unary(Parser* p) {
     if (check(p, TOKEN_MINUS)) {
         Token* tok = advance(p);
@@ -650,103 +609,56 @@ static Node* parse_unary(Parser* p) {
     return parse_postfix(p);
 }
 
-// Level 4.5: cast (as)
-static Node* parse_cast(Parser* p) {
-    Node* node = parse_unary(p);
-    while (check(p, TOKEN_AS)) {
-        Token* tok = advance(p);
-        Node* type_node = parse_type(p);
-        Node* cast = make_node(p, NODE_CAST_EXPR, tok);
-        cast->as.cast_expr.expr = node;
-        cast->as.cast_expr.target_type = type_node;
-        node = cast;
-    }
-    return node;
-}
-
-// Level 4: bitwise (^)
-static Node* parse_bitwise(Parser* p) {
-    Node* left = parse_cast(p);
-    while (check(p, TOKEN_CARET)) {
-        Token* op_tok = advance(p);
-        Node* right = parse_cast(p);
-        Node* node = make_node(p, NODE_BINARY_EXPR, op_tok);
-        node->as.binary_expr.op = op_tok->type;
-        node->as.binary_expr.left = left;
-        node->as.binary_expr.right = right;
-        left = node;
-    }
-    return left;
-}
-
-// Level 3: multiplication (*, /)
-static Node* parse_multiplication(Parser* p) {
-    Node* left = parse_bitwise(p);
-    while (check(p, TOKEN_STAR) || check(p, TOKEN_SLASH)) {
-        Token* op_tok = advance(p);
-        Node* right = parse_bitwise(p);
-        Node* node = make_node(p, NODE_BINARY_EXPR, op_tok);
-        node->as.binary_expr.op = op_tok->type;
-        node->as.binary_expr.left = left;
-        node->as.binary_expr.right = right;
-        left = node;
-    }
-    return left;
-}
-
-// Level 2: addition (+, -)
-static Node* parse_addition(Parser* p) {
-    Node* left = parse_multiplication(p);
-    while (check(p, TOKEN_PLUS) || check(p, TOKEN_MINUS)) {
-        Token* op_tok = advance(p);
-        Node* right = parse_multiplication(p);
-        Node* node = make_node(p, NODE_BINARY_EXPR, op_tok);
-        node->as.binary_expr.op = op_tok->type;
-        node->as.binary_expr.left = left;
-        node->as.binary_expr.right = right;
-        left = node;
-    }
-    return left;
-}
-
-// Level 1: comparison (==, !=, <, >, <=, >=)
-static Node* parse_comparison(Parser* p) {
-    Node* left = parse_addition(p);
-    while (check(p, TOKEN_EQUAL) || check(p, TOKEN_NOT_EQUAL) ||
-           check(p, TOKEN_LESS_THAN) || check(p, TOKEN_GREATER_THAN) ||
-           check(p, TOKEN_LESS_THAN_OR_EQUAL) || check(p, TOKEN_GREATER_THAN_OR_EQUAL)) {
-        Token* op_tok = advance(p);
-        Node* right = parse_addition(p);
-        Node* node = make_node(p, NODE_BINARY_EXPR, op_tok);
-        node->as.binary_expr.op = op_tok->type;
-        node->as.binary_expr.left = left;
-        node->as.binary_expr.right = right;
-        left = node;
-    }
-    return left;
-}
+// Binary operators are parsed by precedence climbing: one loop driven by the
+// binding power of the next token instead of a function per precedence level.
+// Higher binds tighter; every binary operator is left-associative, and `as`
+// is a postfix cast that binds tighter than any of them.
+typedef enum Precedence {
+    PREC_NONE,
+    PREC_OR,         // or
+    PREC_AND,        // and
+    PREC_COMPARISON, // == != < > <= >=
+    PREC_ADDITION,   // + -
+    PREC_MULTIPLY,   // * /
+    PREC_BITWISE,    // ^
+    PREC_CAST,       // as
+} Precedence;
+
+static const uint8_t binding_power[TOKEN_ERROR + 1] = {
+    [TOKEN_OR] = PREC_OR,
+    [TOKEN_AND] = PREC_AND,
+    [TOKEN_EQUAL] = PREC_COMPARISON,
+    [TOKEN_NOT_EQUAL] = PREC_COMPARISON,
+    [TOKEN_LESS_THAN] = PREC_COMPARISON,
+    [TOKEN_GREATER_THAN] = PREC_COMPARISON,
+    [TOKEN_LESS_THAN_OR_EQUAL] = PREC_COMPARISON,
+    [TOKEN_GREATER_THAN_OR_EQUAL] = PREC_COMPARISON,
+    [TOKEN_PLUS] = PREC_ADDITION,
+    [TOKEN_MINUS] = PREC_ADDITION,
+    [TOKEN_STAR] = PREC_MULTIPLY,
+    [TOKEN_SLASH] = PREC_MULTIPLY,
+    [TOKEN_CARET] = PREC_BITWISE,
+    [TOKEN_AS] = PREC_CAST,
+};
+
+// Parses an expression whose operators all bind tighter than min_power.
+static Node* parse_binary(Parser* p, Precedence min_power) {
+    Node* left = parse_unary(p);
+    for (;;) {
+        Token* op_tok = peek(p);
+        Precedence power = binding_power[op_tok->type];
+        if (power <= min_power) break;
+        advance(p);
 
-// Level 0b: logical and
-static Node* parse_and(Parser* p) {
-    Node* left = parse_comparison(p);
-    while (check(p, TOKEN_AND)) {
-        Token* op_tok = advance(p);
-        Node* right = parse_comparison(p);
-        Node* node = make_node(p, NODE_BINARY_EXPR, op_tok);
-        node->as.binary_expr.op = op_tok->type;
-        node->as.binary_expr.left = left;
-        node->as.binary_expr.right = right;
-        left = node;
-    }
-    return left;
-}
+        if (op_tok->type == TOKEN_AS) {
+            Node* cast = make_node(p, NODE_CAST_EXPR, op_tok);
+            cast->as.cast_expr.expr = left;
+            cast->as.cast_expr.target_type = parse_type(p);
+            left = cast;
+            continue;
+        }
 
-// Level 0a: logical or (lowest precedence)
-static Node* parse_or(Parser* p) {
-    Node* left = parse_and(p);
-    while (check(p, TOKEN_OR)) {
-        Token* op_tok = advance(p);
-        Node* right = parse_and(p);
+        Node* right = parse_binary(p, power);
         Node* node = make_node(p, NODE_BINARY_EXPR, op_tok);
         node->as.binary_expr.op = op_tok->type;
         node->as.binary_expr.left = left;
@@ -757,7 +669,7 @@ static Node* parse_or(Parser* p) {
 }
 
 static Node* parse_expression(Parser* p) {
-    return parse_or(p);
+    return parse_binary(p, PREC_NONE);
 }
 
 // ---------------------------------------------------------------------------
@@ -785,9 +697,8 @@ static Node* parse_if_stmt(Parser* p) {
     Node* node = make_node(p, NODE_IF_STMT, tok);
     node->as.if_stmt.condition = condition;
     node->as.if_stmt.then_body = then_body;
-    memset(&node->as.if_stmt.elseifs, 0, sizeof(ElseIfList));
-    memset(&node->as.if_stmt.else_body, 0, sizeof(NodeList));
 
+    ListBuilder elseifs = list_open(p);
     while (check(p, TOKEN_ELSEIF)) {
         Token* ei_tok = advance(p);
         Node* ei_cond = parse_expression(p);
@@ -796,11 +707,11 @@ static Node* parse_if_stmt(Parser* p) {
         ElseIfBranch branch = {0};
         branch.condition = ei_cond;
         branch.body = ei_body;
-        branch.offset = ei_tok->offset;
-        branch.line = ei_tok->line;
-        branch.column = ei_tok->column;
-        elseif_list_push(p->arena, &node->as.if_stmt.elseifs, branch);
+        branch.loc = tok_loc(p, ei_tok);
+        list_push(p, &elseifs, &branch, sizeof(branch));
     }
+    node->as.if_stmt.elseifs.branches = list_close(p, &elseifs, sizeof(ElseIfBranch));
+    node->as.if_stmt.elseifs.count = (uint32_t)elseifs.count;
 
     if (match(p, TOKEN_ELSE)) {
         expect_newline(p);
@@ -831,8 +742,9 @@ static Node* parse_for_stmt(Parser* p) {
     expect(p, TOKEN_END, "Expected 'end' to close for loop.");
 
     Node* node = make_node(p, NODE_FOR_STMT, tok);
-    node->as.for_stmt.var_name = var_tok->value;
+    node->as.for_stmt.var_name = tok_text(p, var_tok);
     node->as.for_stmt.var_name_size = var_tok->size;
+    node->as.for_stmt.var_name_atom = tok_atom(p, var_tok);
     node->as.for_stmt.start = start;
     node->as.for_stmt.end = end_expr;
     node->as.for_stmt.step = step;
@@ -894,38 +806,39 @@ static Node* parse_match_stmt(Parser* p) {
 
     Node* node = make_node(p, NODE_MATCH_STMT, tok);
     node->as.match_stmt.subject = subject;
-    memset(&node->as.match_stmt.cases, 0, sizeof(MatchCaseList));
-    memset(&node->as.match_stmt.else_body, 0, sizeof(NodeList));
 
+    ListBuilder cases = list_open(p);
     while (!check(p, TOKEN_END) && !check(p, TOKEN_ELSE) && !check(p, TOKEN_END_OF_FILE)) {
         skip_newlines(p);
         if (check(p, TOKEN_CASE)) {
             Token* case_tok = advance(p);
             MatchCase mc = {0};
-            mc.offset = case_tok->offset;
-            mc.line = case_tok->line;
-            mc.column = case_tok->column;
+            mc.loc = tok_loc(p, case_tok);
 
             // parse comma-separated values
+            ListBuilder values = list_open(p);
             Node* val = parse_expression(p);
-            if (val) node_list_push(p->arena, &mc.values, val);
+            if (val) list_push(p, &values, &val, sizeof(val));
             while (match(p, TOKEN_COMMA)) {
                 val = parse_expression(p);
-                if (val) node_list_push(p->arena, &mc.values, val);
+                if (val) list_push(p, &values, &val, sizeof(val));
             }
+            mc.values = node_list_close(p, &values);
             expect_newline(p);
             mc.body = parse_body(p);
-            match_case_list_push(p->arena, &node->as.match_stmt.cases, mc);
+            list_push(p, &cases, &mc, sizeof(mc));
         } else if (check(p, TOKEN_END) || check(p, TOKEN_ELSE)) {
             break;
         } else {
-            errors_push(p->errors, SEVERITY_ERROR, peek(p)->offset, peek(p)->line, peek(p)->column,
-                         "Expected 'case', 'else', or 'end' in match statement.");
+            errors_push_at(p->errors, SEVERITY_ERROR, tok_loc(p, peek(p)),
+                           "Expected 'case', 'else', or 'end' in match statement.");
             p->had_error = true;
             advance(p); // skip the bad token to guarantee progress
             synchronize(p);
         }
     }
+    node->as.match_stmt.cases.cases = list_close(p, &cases, sizeof(MatchCase));
+    node->as.match_stmt.cases.count = (uint32_t)cases.count;
 
     if (match(p, TOKEN_ELSE)) {
         expect_newline(p);
@@ -960,10 +873,7 @@ static Node* parse_assignment_or_expr_stmt(Parser* p) {
         return node;
     }
 
-    Node* node = make_node(p, NODE_EXPR_STMT, NULL);
-    node->offset = expr->offset;
-    node->line = expr->line;
-    node->column = expr->column;
+    Node* node = node_new(p->arena, NODE_EXPR_STMT, expr->loc);
     node->as.expr_stmt.expr = expr;
     return node;
 }
@@ -985,7 +895,7 @@ static Node* parse_statement(Parser* p) {
 }
 
 static NodeList parse_body(Parser* p) {
-    NodeList stmts = {0};
+    ListBuilder stmts = list_open(p);
     skip_newlines(p);
 
     while (!check(p, TOKEN_END) && !check(p, TOKEN_ELSE) &&
@@ -993,7 +903,7 @@ static NodeList parse_body(Parser* p) {
            !check(p, TOKEN_END_OF_FILE)) {
         Node* stmt = parse_statement(p);
         if (stmt) {
-            node_list_push(p->arena, &stmts, stmt);
+            list_push(p, &stmts, &stmt, sizeof(stmt));
         }
         if (p->panic_mode) {
             synchronize(p);
@@ -1002,7 +912,7 @@ static NodeList parse_body(Parser* p) {
         expect_newline(p);
         skip_newlines(p);
     }
-    return stmts;
+    return node_list_close(p, &stmts);
 }
 
 // ---------------------------------------------------------------------------
@@ -1024,8 +934,9 @@ static Node* parse_const_decl(Parser* p, bool is_export) {
 
     Node* node = make_node(p, NODE_CONST_DECL, tok);
     node->as.const_decl.is_export = is_export;
-    node->as.const_decl.name = name_tok->value;
+    node->as.const_decl.name = tok_text(p, name_tok);
     node->as.const_decl.name_size = name_tok->size;
+    node->as.const_decl.name_atom = tok_atom(p, name_tok);
     node->as.const_decl.type_node = type_node;
     node->as.const_decl.value = value;
     return node;
@@ -1046,30 +957,31 @@ static Node* parse_var_decl(Parser* p, bool is_export) {
 
     Node* node = make_node(p, NODE_VAR_DECL, tok);
     node->as.var_decl.is_export = is_export;
-    node->as.var_decl.name = name_tok->value;
+    node->as.var_decl.name = tok_text(p, name_tok);
     node->as.var_decl.name_size = name_tok->size;
+    node->as.var_decl.name_atom = tok_atom(p, name_tok);
     node->as.var_decl.type_node = type_node;
     node->as.var_decl.value = value;
     return node;
 }
 
 static ParamList parse_param_list(Parser* p) {
-    ParamList params = {0};
-    if (check(p, TOKEN_RIGHT_PAREN)) return params;
+    ParamList result = {0};
+    if (check(p, TOKEN_RIGHT_PAREN)) return result;
 
     Token* name_tok = expect(p, TOKEN_IDENTIFIER, "Expected parameter name.");
-    if (!name_tok) return params;
+    if (!name_tok) return result;
     expect(p, TOKEN_COLON, "Expected ':' after parameter name.");
     Node* type_node = parse_type(p);
 
     Param param = {0};
-    param.name = name_tok->value;
+    param.name = tok_text(p, name_tok);
     param.name_size = name_tok->size;
+    param.name_atom = tok_atom(p, name_tok);
     param.type_node = type_node;
-    param.offset = name_tok->offset;
-    param.line = name_tok->line;
-    param.column = name_tok->column;
-    param_list_push(p->arena, &params, param);
+    param.loc = tok_loc(p, name_tok);
+    ListBuilder params = list_open(p);
+    list_push(p, &params, &param, sizeof(param));
 
     while (match(p, TOKEN_COMMA)) {
         name_tok = expect(p, TOKEN_IDENTIFIER, "Expected parameter name.");
@@ -1078,15 +990,16 @@ static ParamList parse_param_list(Parser* p) {
         type_node = parse_type(p);
 
         Param next = {0};
-        next.name = name_tok->value;
+        next.name = tok_text(p, name_tok);
         next.name_size = name_tok->size;
+        next.name_atom = tok_atom(p, name_tok);
         next.type_node = type_node;
-        next.offset = name_tok->offset;
-        next.line = name_tok->line;
-        next.column = name_tok->column;
-        param_list_push(p->arena, &params, next);
+        next.loc = tok_loc(p, name_tok);
+        list_push(p, &params, &next, sizeof(next));
     }
-    return params;
+    result.params = list_close(p, &params, sizeof(Param));
+    result.count = (uint32_t)params.count;
+    return result;
 }
 
 static Node* parse_func_signature(Parser* p) {
@@ -1110,22 +1023,69 @@ static Node* parse_func_signature(Parser* p) {
 
     Node* node = make_node(p, NODE_FUNC_DECL, tok);
     node->as.func_decl.is_export = false;
-    node->as.func_decl.name = name_tok->value;
+    node->as.func_decl.name = tok_text(p, name_tok);
     node->as.func_decl.name_size = name_tok->size;
+    node->as.func_decl.name_atom = tok_atom(p, name_tok);
     node->as.func_decl.type_params = type_params;
     node->as.func_decl.params = params;
     node->as.func_decl.return_type = return_type;
     memset(&node->as.func_decl.body, 0, sizeof(NodeList));
+    node->as.func_decl.lazy_body = NULL;
     return node;
 }
 
+// A deferred function body: where its tokens start and what to parse it with.
+typedef struct LazyBody {
+    Arena* arena;
+    Errors* errors;
+    Tokens* tokens;
+    size_t start;
+} LazyBody;
+
+// Advances to the 'end' closing the current body by counting the statements
+// that open a block. The parser consumes at most one 'end' per opener, so a
+// deferred parse never runs past the 'end' found here.
+static void skip_body(Parser* p) {
+    size_t depth = 0;
+    for (;;) {
+        switch (peek(p)->type) {
+        case TOKEN_IF:
+        case TOKEN_FOR:
+        case TOKEN_WHILE:
+        case TOKEN_WITH:
+        case TOKEN_MATCH:
+            depth++;
+            break;
+        case TOKEN_END:
+            if (depth == 0) return;
+            depth--;
+            break;
+        case TOKEN_END_OF_FILE:
+            return;
+        default:
+            break;
+        }
+        advance(p);
+    }
+}
+
 static Node* parse_func_decl(Parser* p, bool is_export) {
     Node* node = parse_func_signature(p);
     if (!node) return NULL;
     node->as.func_decl.is_export = is_export;
 
     expect_newline(p);
-    node->as.func_decl.body = parse_body(p);
+    if (p->lazy_bodies) {
+        LazyBody* lazy = arena_alloc(p->arena, sizeof(LazyBody));
+        lazy->arena = p->arena;
+        lazy->errors = p->errors;
+        lazy->tokens = p->tokens;
+        lazy->start = p->pos;
+        node->as.func_decl.lazy_body = lazy;
+        skip_body(p);
+    } else {
+        node->as.func_decl.body = parse_body(p);
+    }
     expect(p, TOKEN_END, "Expected 'end' to close function.");
     return node;
 }
@@ -1145,12 +1105,14 @@ static Node* parse_struct_decl(Parser* p, bool is_export) {
 
     Node* node = make_node(p, NODE_STRUCT_DECL, tok);
     node->as.struct_decl.is_export = is_export;
-    node->as.struct_decl.name = name_tok->value;
+    node->as.struct_decl.name = tok_text(p, name_tok);
     node->as.struct_decl.name_size = name_tok->size;
+    node->as.struct_decl.name_atom = tok_atom(p, name_tok);
     node->as.struct_decl.type_params = type_params;
-    memset(&node->as.struct_decl.fields, 0, sizeof(FieldList));
-    memset(&node->as.struct_decl.methods, 0, sizeof(NodeList));
 
+    // Fields and methods interleave in the source, so both go on one list and
+    // are split apart when it closes.
+    ListBuilder members = list_open(p);
     while (!check(p, TOKEN_END) && !check(p, TOKEN_END_OF_FILE)) {
         skip_newlines(p);
         if (check(p, TOKEN_END)) break;
@@ -1158,7 +1120,8 @@ static Node* parse_struct_decl(Parser* p, bool is_export) {
         if (check(p, TOKEN_FUNC)) {
             Node* method = parse_func_decl(p, false);
             if (method) {
-                node_list_push(p->arena, &node->as.struct_decl.methods, method);
+                StructMember member = { .method = method };
+                list_push(p, &members, &member, sizeof(member));
             }
         } else if (check(p, TOKEN_IDENTIFIER)) {
             Token* field_tok = advance(p);
@@ -1166,17 +1129,17 @@ static Node* parse_struct_decl(Parser* p, bool is_export) {
             Node* type_node = parse_type(p);
 
             Field field = {0};
-            field.name = field_tok->value;
+            field.name = tok_text(p, field_tok);
             field.name_size = field_tok->size;
+            field.name_atom = tok_atom(p, field_tok);
             field.type_node = type_node;
-            field.offset = field_tok->offset;
-            field.line = field_tok->line;
-            field.column = field_tok->column;
-            field_list_push(p->arena, &node->as.struct_decl.fields, field);
+            field.loc = tok_loc(p, field_tok);
+            StructMember member = { .field = field };
+            list_push(p, &members, &member, sizeof(member));
             expect_newline(p);
         } else {
-            errors_push(p->errors, SEVERITY_ERROR, peek(p)->offset, peek(p)->line, peek(p)->column,
-                         "Expected field or method in struct.");
+            errors_push_at(p->errors, SEVERITY_ERROR, tok_loc(p, peek(p)),
+                           "Expected field or method in struct.");
             p->had_error = true;
             advance(p); // skip the bad token to guarantee progress
             synchronize(p);
@@ -1184,6 +1147,28 @@ static Node* parse_struct_decl(Parser* p, bool is_export) {
         skip_newlines(p);
     }
 
+    StructMember* items = (StructMember*)(p->scratch + members.start);
+    size_t method_count = 0;
+    for (size_t i = 0; i < members.count; i++) {
+        if (items[i].method) method_count++;
+    }
+    size_t field_count = members.count - method_count;
+    FieldList fields = { NULL, (uint32_t)field_count };
+    NodeList methods = { NULL, (uint32_t)method_count };
+    if (field_count > 0) fields.fields = arena_alloc(p->arena, field_count * sizeof(Field));
+    if (method_count > 0) methods.nodes = arena_alloc(p->arena, method_count * sizeof(Node*));
+    field_count = method_count = 0;
+    for (size_t i = 0; i < members.count; i++) {
+        if (items[i].method) {
+            methods.nodes[method_count++] = items[i].method;
+        } else {
+            fields.fields[field_count++] = items[i].field;
+        }
+    }
+    p->scratch_top = members.start;
+    node->as.struct_decl.fields = fields;
+    node->as.struct_decl.methods = methods;
+
     expect(p, TOKEN_END, "Expected 'end' to close struct.");
     return node;
 }
@@ -1197,10 +1182,11 @@ static Node* parse_interface_decl(Parser* p) {
     skip_newlines(p);
 
     Node* node = make_node(p, NODE_INTERFACE_DECL, tok);
-    node->as.interface_decl.name = name_tok->value;
+    node->as.interface_decl.name = tok_text(p, name_tok);
     node->as.interface_decl.name_size = name_tok->size;
-    memset(&node->as.interface_decl.method_sigs, 0, sizeof(NodeList));
+    node->as.interface_decl.name_atom = tok_atom(p, name_tok);
 
+    ListBuilder sigs = list_open(p);
     while (!check(p, TOKEN_END) && !check(p, TOKEN_END_OF_FILE)) {
         skip_newlines(p);
         if (check(p, TOKEN_END)) break;
@@ -1208,12 +1194,12 @@ static Node* parse_interface_decl(Parser* p) {
         if (check(p, TOKEN_FUNC)) {
             Node* sig = parse_func_signature(p);
             if (sig) {
-                node_list_push(p->arena, &node->as.interface_decl.method_sigs, sig);
+                list_push(p, &sigs, &sig, sizeof(sig));
             }
             expect_newline(p);
         } else {
-            errors_push(p->errors, SEVERITY_ERROR, peek(p)->offset, peek(p)->line, peek(p)->column,
-                         "Expected method signature in interface.");
+            errors_push_at(p->errors, SEVERITY_ERROR, tok_loc(p, peek(p)),
+                           "Expected method signature in interface.");
             p->had_error = true;
             advance(p); // skip the bad token to guarantee progress
             synchronize(p);
@@ -1221,6 +1207,8 @@ static Node* parse_interface_decl(Parser* p) {
         skip_newlines(p);
     }
 
+    node->as.interface_decl.method_sigs = node_list_close(p, &sigs);
+
     expect(p, TOKEN_END, "Expected 'end' to close interface.");
     return node;
 }
@@ -1233,14 +1221,14 @@ static Node* parse_import_decl(Parser* p) {
     if (!path_tok) return NULL;
 
     // Track start and end of the full path for dot-separated modules
-    char* path_start = path_tok->value;
-    char* path_end = path_tok->value + path_tok->size;
+    char* path_start = tok_text(p, path_tok);
+    char* path_end = tok_text(p, path_tok) + path_tok->size;
 
     while (check(p, TOKEN_DOT)) {
         advance(p); // consume '.'
         Token* next = expect(p, TOKEN_IDENTIFIER, "Expected module name after '.'.");
         if (!next) break;
-        path_end = next->value + next->size;
+        path_end = tok_text(p, next) + next->size;
     }
 
     size_t path_size = (size_t)(path_end - path_start);
@@ -1257,31 +1245,31 @@ static Node* parse_import_decl(Parser* p) {
     node->as.import_decl.is_export = is_export;
     node->as.import_decl.module_path = path_start;
     node->as.import_decl.module_path_size = path_size;
-    memset(&node->as.import_decl.names, 0, sizeof(ImportNameList));
 
     // Parse comma-separated import names
+    ListBuilder names = list_open(p);
     Token* name_tok = expect(p, TOKEN_IDENTIFIER, "Expected name to import.");
     if (name_tok) {
         ImportName name = {0};
-        name.name = name_tok->value;
+        name.name = tok_text(p, name_tok);
         name.name_size = name_tok->size;
-        name.offset = name_tok->offset;
-        name.line = name_tok->line;
-        name.column = name_tok->column;
-        import_name_list_push(p->arena, &node->as.import_decl.names, name);
+        name.name_atom = tok_atom(p, name_tok);
+        name.loc = tok_loc(p, name_tok);
+        list_push(p, &names, &name, sizeof(name));
 
         while (match(p, TOKEN_COMMA)) {
             name_tok = expect(p, TOKEN_IDENTIFIER, "Expected name to import.");
             if (!name_tok) break;
             ImportName next = {0};
-            next.name = name_tok->value;
+            next.name = tok_text(p, name_tok);
             next.name_size = name_tok->size;
-            next.offset = name_tok->offset;
-            next.line = name_tok->line;
-            next.column = name_tok->column;
-            import_name_list_push(p->arena, &node->as.import_decl.names, next);
+            next.name_atom = tok_atom(p, name_tok);
+            next.loc = tok_loc(p, name_tok);
+            list_push(p, &names, &next, sizeof(next));
         }
     }
+    node->as.import_decl.names.names = list_close(p, &names, sizeof(ImportName));
+    node->as.import_decl.names.count = (uint32_t)names.count;
 
     return node;
 }
@@ -1296,10 +1284,11 @@ static Node* parse_enum_decl(Parser* p, bool is_export) {
 
     Node* node = make_node(p, NODE_ENUM_DECL, tok);
     node->as.enum_decl.is_export = is_export;
-    node->as.enum_decl.name = name_tok->value;
+    node->as.enum_decl.name = tok_text(p, name_tok);
     node->as.enum_decl.name_size = name_tok->size;
-    memset(&node->as.enum_decl.variants, 0, sizeof(EnumVariantList));
+    node->as.enum_decl.name_atom = tok_atom(p, name_tok);
 
+    ListBuilder variants = list_open(p);
     while (!check(p, TOKEN_END) && !check(p, TOKEN_END_OF_FILE)) {
         skip_newlines(p);
         if (check(p, TOKEN_END)) break;
@@ -1307,16 +1296,15 @@ static Node* parse_enum_decl(Parser* p, bool is_export) {
         if (check(p, TOKEN_IDENTIFIER)) {
             Token* var_tok = advance(p);
             EnumVariant variant = {0};
-            variant.name = var_tok->value;
+            variant.name = tok_text(p, var_tok);
             variant.name_size = var_tok->size;
-            variant.offset = var_tok->offset;
-            variant.line = var_tok->line;
-            variant.column = var_tok->column;
-            enum_variant_list_push(p->arena, &node->as.enum_decl.variants, variant);
+            variant.name_atom = tok_atom(p, var_tok);
+            variant.loc = tok_loc(p, var_tok);
+            list_push(p, &variants, &variant, sizeof(variant));
             expect_newline(p);
         } else {
-            errors_push(p->errors, SEVERITY_ERROR, peek(p)->offset, peek(p)->line, peek(p)->column,
-                         "Expected variant name in enum.");
+            errors_push_at(p->errors, SEVERITY_ERROR, tok_loc(p, peek(p)),
+                           "Expected variant name in enum.");
             p->had_error = true;
             advance(p); // skip the bad token to guarantee progress
             synchronize(p);
@@ -1324,6 +1312,9 @@ static Node* parse_enum_decl(Parser* p, bool is_export) {
         skip_newlines(p);
     }
 
+    node->as.enum_decl.variants.variants = list_close(p, &variants, sizeof(EnumVariant));
+    node->as.enum_decl.variants.count = (uint32_t)variants.count;
+
     expect(p, TOKEN_END, "Expected 'end' to close enum.");
     return node;
 }
@@ -1340,8 +1331,8 @@ static Node* parse_extern_declaration(Parser* p) {
     }
 
     Token* tok = peek(p);
-    errors_push(p->errors, SEVERITY_ERROR, tok->offset, tok->line, tok->column,
-                "Expected 'func' after 'extern'.");
+    errors_push_at(p->errors, SEVERITY_ERROR, tok_loc(p, tok),
+                   "Expected 'func' after 'extern'.");
     p->had_error = true;
     p->panic_mode = true;
     return NULL;
@@ -1361,8 +1352,8 @@ static Node* parse_export_declaration(Parser* p) {
     if (check(p, TOKEN_ENUM))   return parse_enum_decl(p, true);
 
     Token* tok = peek(p);
-    errors_push(p->errors, SEVERITY_ERROR, tok->offset, tok->line, tok->column,
-                "Expected declaration after 'export'.");
+    errors_push_at(p->errors, SEVERITY_ERROR, tok_loc(p, tok),
+                   "Expected declaration after 'export'.");
     p->had_error = true;
     p->panic_mode = true;
     return NULL;
@@ -1371,7 +1362,7 @@ static Node* parse_export_declaration(Parser* p) {
 static Node* parse_program(Parser* p) {
     Token* tok = peek(p);
     Node* program = make_node(p, NODE_PROGRAM, tok);
-    memset(&program->as.program.declarations, 0, sizeof(NodeList));
+    ListBuilder decls = list_open(p);
 
     skip_newlines(p);
 
@@ -1402,8 +1393,8 @@ static Node* parse_program(Parser* p) {
             decl = parse_enum_decl(p, false);
         } else {
             Token* t = peek(p);
-            errors_push(p->errors, SEVERITY_ERROR, t->offset, t->line, t->column,
-                         "Unexpected top-level token.");
+            errors_push_at(p->errors, SEVERITY_ERROR, tok_loc(p, t),
+                           "Unexpected top-level token.");
             p->had_error = true;
             p->panic_mode = true;
             advance(p); // skip the bad token to guarantee progress
@@ -1413,12 +1404,13 @@ static Node* parse_program(Parser* p) {
         }
 
         if (decl) {
-            node_list_push(p->arena, &program->as.program.declarations, decl);
+            list_push(p, &decls, &decl, sizeof(decl));
         }
 
         skip_newlines(p);
     }
 
+    program->as.program.declarations = node_list_close(p, &decls);
     return program;
 }
 
@@ -1426,15 +1418,41 @@ static Node* parse_program(Parser* p) {
 // Public API
 // ---------------------------------------------------------------------------
 
-Node* parser_parse(Arena* arena, Tokens* tokens, Errors* errors) {
+static void parser_init(Parser* p, Arena* arena, Tokens* tokens, Errors* errors, bool lazy_bodies) {
+    p->arena = arena;
+    p->errors = errors;
+    p->tokens = tokens;
+    p->pos = 0;
+    p->had_error = false;
+    p->panic_mode = false;
+    p->lazy_bodies = lazy_bodies;
+    p->scratch = NULL;
+    p->scratch_top = 0;
+    p->scratch_capacity = 0;
+}
+
+Node* parser_parse(Arena* arena, Tokens* tokens, Errors* errors, bool lazy_bodies) {
     Parser parser;
-    parser.arena = arena;
-    parser.errors = errors;
-    parser.tokens = tokens;
-    parser.pos = 0;
-    parser.had_error = false;
-    parser.panic_mode = false;
-    return parse_program(&parser);
+    parser_init(&parser, arena, tokens, errors, lazy_bodies);
+    Node* program = parse_program(&parser);
+    free(parser.scratch);
+    return program;
+}
+
+NodeList* parser_func_body(Node* func) {
+    LazyBody* lazy = func->as.func_decl.lazy_body;
+    if (lazy) {
+        func->as.func_decl.lazy_body = NULL;
+
+        Parser parser;
+        parser_init(&parser, lazy->arena, lazy->tokens, lazy->errors, false);
+        parser.pos = lazy->start;
+        func->as.func_decl.body = parse_body(&parser);
+        // skip_body stopped at an 'end' the body parse may not reach
+        expect(&parser, TOKEN_END, "Expected 'end' to close function.");
+        free(parser.scratch);
+    }
+    return &func->as.func_decl.body;
 }
 
 // ---------------------------------------------------------------------------
@@ -1522,7 +1540,7 @@ void ast_print(Node* node, int indent) {
 
     case NODE_IMPORT_DECL:
         printf("ImportDecl [%zu:%zu] from %.*s %s",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.import_decl.module_path_size, node->as.import_decl.module_path,
                node->as.import_decl.is_export ? "export" : "import");
         for (size_t i = 0; i < node->as.import_decl.names.count; i++) {
@@ -1534,7 +1552,7 @@ void ast_print(Node* node, int indent) {
 
     case NODE_CONST_DECL:
         printf("ConstDecl [%zu:%zu] %.*s%s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.const_decl.name_size, node->as.const_decl.name,
                node->as.const_decl.is_export ? " (export)" : "");
         if (node->as.const_decl.type_node) {
@@ -1549,7 +1567,7 @@ void ast_print(Node* node, int indent) {
 
     case NODE_VAR_DECL:
         printf("VarDecl [%zu:%zu] %.*s%s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.var_decl.name_size, node->as.var_decl.name,
                node->as.var_decl.is_export ? " (export)" : "");
         if (node->as.var_decl.type_node) {
@@ -1564,7 +1582,7 @@ void ast_print(Node* node, int indent) {
 
     case NODE_FUNC_DECL:
         printf("FuncDecl [%zu:%zu] %.*s%s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.func_decl.name_size, node->as.func_decl.name,
                node->as.func_decl.is_export ? " (export)" : "");
         if (node->as.func_decl.params.count > 0) {
@@ -1582,6 +1600,7 @@ void ast_print(Node* node, int indent) {
             printf("return_type:\n");
             ast_print_type(node->as.func_decl.return_type, indent + 2);
         }
+        parser_func_body(node);
         if (node->as.func_decl.body.count > 0) {
             print_indent(indent + 1);
             printf("body:\n");
@@ -1593,7 +1612,7 @@ void ast_print(Node* node, int indent) {
 
     case NODE_STRUCT_DECL:
         printf("StructDecl [%zu:%zu] %.*s%s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.struct_decl.name_size, node->as.struct_decl.name,
                node->as.struct_decl.is_export ? " (export)" : "");
         if (node->as.struct_decl.fields.count > 0) {
@@ -1617,7 +1636,7 @@ void ast_print(Node* node, int indent) {
 
     case NODE_INTERFACE_DECL:
         printf("InterfaceDecl [%zu:%zu] %.*s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.interface_decl.name_size, node->as.interface_decl.name);
         if (node->as.interface_decl.method_sigs.count > 0) {
             print_indent(indent + 1);
@@ -1629,14 +1648,14 @@ void ast_print(Node* node, int indent) {
         break;
 
     case NODE_RETURN_STMT:
-        printf("ReturnStmt [%zu:%zu]\n", node->line, node->column);
+        printf("ReturnStmt [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         if (node->as.return_stmt.value) {
             ast_print(node->as.return_stmt.value, indent + 1);
         }
         break;
 
     case NODE_IF_STMT:
-        printf("IfStmt [%zu:%zu]\n", node->line, node->column);
+        printf("IfStmt [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         print_indent(indent + 1);
         printf("condition:\n");
         ast_print(node->as.if_stmt.condition, indent + 2);
@@ -1648,7 +1667,7 @@ void ast_print(Node* node, int indent) {
         for (size_t i = 0; i < node->as.if_stmt.elseifs.count; i++) {
             ElseIfBranch* ei = &node->as.if_stmt.elseifs.branches[i];
             print_indent(indent + 1);
-            printf("elseif [%zu:%zu]:\n", ei->line, ei->column);
+            printf("elseif [%zu:%zu]:\n", location_line(ei->loc), location_column(ei->loc));
             print_indent(indent + 2);
             printf("condition:\n");
             ast_print(ei->condition, indent + 3);
@@ -1669,7 +1688,7 @@ void ast_print(Node* node, int indent) {
 
     case NODE_FOR_STMT:
         printf("ForStmt [%zu:%zu] %.*s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.for_stmt.var_name_size, node->as.for_stmt.var_name);
         print_indent(indent + 1);
         printf("start:\n");
@@ -1690,7 +1709,7 @@ void ast_print(Node* node, int indent) {
         break;
 
     case NODE_WHILE_STMT:
-        printf("WhileStmt [%zu:%zu]\n", node->line, node->column);
+        printf("WhileStmt [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         print_indent(indent + 1);
         printf("condition:\n");
         ast_print(node->as.while_stmt.condition, indent + 2);
@@ -1702,7 +1721,7 @@ void ast_print(Node* node, int indent) {
         break;
 
     case NODE_WITH_STMT:
-        printf("WithStmt [%zu:%zu]\n", node->line, node->column);
+        printf("WithStmt [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         print_indent(indent + 1);
         printf("resource:\n");
         ast_print(node->as.with_stmt.resource, indent + 2);
@@ -1714,22 +1733,22 @@ void ast_print(Node* node, int indent) {
         break;
 
     case NODE_BREAK_STMT:
-        printf("BreakStmt [%zu:%zu]\n", node->line, node->column);
+        printf("BreakStmt [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         break;
 
     case NODE_CONTINUE_STMT:
-        printf("ContinueStmt [%zu:%zu]\n", node->line, node->column);
+        printf("ContinueStmt [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         break;
 
     case NODE_MATCH_STMT:
-        printf("MatchStmt [%zu:%zu]\n", node->line, node->column);
+        printf("MatchStmt [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         print_indent(indent + 1);
         printf("subject:\n");
         ast_print(node->as.match_stmt.subject, indent + 2);
         for (size_t i = 0; i < node->as.match_stmt.cases.count; i++) {
             MatchCase* mc = &node->as.match_stmt.cases.cases[i];
             print_indent(indent + 1);
-            printf("case [%zu:%zu]:\n", mc->line, mc->column);
+            printf("case [%zu:%zu]:\n", location_line(mc->loc), location_column(mc->loc));
             print_indent(indent + 2);
             printf("values:\n");
             for (size_t j = 0; j < mc->values.count; j++) {
@@ -1751,7 +1770,7 @@ void ast_print(Node* node, int indent) {
         break;
 
     case NODE_ASSIGN_STMT:
-        printf("AssignStmt [%zu:%zu]\n", node->line, node->column);
+        printf("AssignStmt [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         print_indent(indent + 1);
         printf("target:\n");
         ast_print(node->as.assign_stmt.target, indent + 2);
@@ -1762,7 +1781,7 @@ void ast_print(Node* node, int indent) {
 
     case NODE_COMPOUND_ASSIGN_STMT:
         printf("CompoundAssignStmt [%zu:%zu] %s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                op_to_string(node->as.compound_assign_stmt.op));
         print_indent(indent + 1);
         printf("target:\n");
@@ -1773,51 +1792,51 @@ void ast_print(Node* node, int indent) {
         break;
 
     case NODE_EXPR_STMT:
-        printf("ExprStmt [%zu:%zu]\n", node->line, node->column);
+        printf("ExprStmt [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         ast_print(node->as.expr_stmt.expr, indent + 1);
         break;
 
     case NODE_INTEGER_LITERAL:
         printf("IntegerLiteral [%zu:%zu] %.*s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.integer_literal.value_size, node->as.integer_literal.value);
         break;
 
     case NODE_FLOAT_LITERAL:
         printf("FloatLiteral [%zu:%zu] %.*s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.float_literal.value_size, node->as.float_literal.value);
         break;
 
     case NODE_STRING_LITERAL:
         printf("StringLiteral [%zu:%zu] %.*s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.string_literal.value_size, node->as.string_literal.value);
         break;
 
     case NODE_BOOL_LITERAL:
         printf("BoolLiteral [%zu:%zu] %s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                node->as.bool_literal.value ? "true" : "false");
         break;
 
     case NODE_NULL_LITERAL:
-        printf("NullLiteral [%zu:%zu]\n", node->line, node->column);
+        printf("NullLiteral [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         break;
 
     case NODE_IDENTIFIER:
         printf("Identifier [%zu:%zu] %.*s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.identifier.name_size, node->as.identifier.name);
         break;
 
     case NODE_SELF:
-        printf("Self [%zu:%zu]\n", node->line, node->column);
+        printf("Self [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         break;
 
     case NODE_BINARY_EXPR:
         printf("BinaryExpr [%zu:%zu] %s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                op_to_string(node->as.binary_expr.op));
         ast_print(node->as.binary_expr.left, indent + 1);
         ast_print(node->as.binary_expr.right, indent + 1);
@@ -1825,18 +1844,18 @@ void ast_print(Node* node, int indent) {
 
     case NODE_UNARY_EXPR:
         printf("UnaryExpr [%zu:%zu] %s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                op_to_string(node->as.unary_expr.op));
         ast_print(node->as.unary_expr.operand, indent + 1);
         break;
 
     case NODE_PAREN_EXPR:
-        printf("ParenExpr [%zu:%zu]\n", node->line, node->column);
+        printf("ParenExpr [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         ast_print(node->as.paren_expr.inner, indent + 1);
         break;
 
     case NODE_CALL_EXPR:
-        printf("CallExpr [%zu:%zu]\n", node->line, node->column);
+        printf("CallExpr [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         print_indent(indent + 1);
         printf("callee:\n");
         ast_print(node->as.call_expr.callee, indent + 2);
@@ -1851,14 +1870,14 @@ void ast_print(Node* node, int indent) {
 
     case NODE_FIELD_ACCESS:
         printf("FieldAccess [%zu:%zu] .%.*s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.field_access.field_name_size, node->as.field_access.field_name);
         ast_print(node->as.field_access.object, indent + 1);
         break;
 
     case NODE_METHOD_CALL:
         printf("MethodCall [%zu:%zu] .%.*s()\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.method_call.method_name_size, node->as.method_call.method_name);
         print_indent(indent + 1);
         printf("object:\n");
@@ -1874,7 +1893,7 @@ void ast_print(Node* node, int indent) {
 
     case NODE_STRUCT_LITERAL:
         printf("StructLiteral [%zu:%zu] %.*s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.struct_literal.struct_name_size, node->as.struct_literal.struct_name);
         for (size_t i = 0; i < node->as.struct_literal.fields.count; i++) {
             FieldInit* fi = &node->as.struct_literal.fields.inits[i];
@@ -1885,7 +1904,7 @@ void ast_print(Node* node, int indent) {
         break;
 
     case NODE_CAST_EXPR:
-        printf("CastExpr [%zu:%zu]\n", node->line, node->column);
+        printf("CastExpr [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         print_indent(indent + 1);
         printf("expr:\n");
         ast_print(node->as.cast_expr.expr, indent + 2);
@@ -1895,21 +1914,21 @@ void ast_print(Node* node, int indent) {
         break;
 
     case NODE_SIZEOF_EXPR:
-        printf("SizeofExpr [%zu:%zu]\n", node->line, node->column);
+        printf("SizeofExpr [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         print_indent(indent + 1);
         printf("type:\n");
         ast_print_type(node->as.sizeof_expr.type_node, indent + 2);
         break;
 
     case NODE_ARRAY_LITERAL:
-        printf("ArrayLiteral [%zu:%zu]\n", node->line, node->column);
+        printf("ArrayLiteral [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         for (size_t i = 0; i < node->as.array_literal.elements.count; i++) {
             ast_print(node->as.array_literal.elements.nodes[i], indent + 1);
         }
         break;
 
     case NODE_INDEX_EXPR:
-        printf("IndexExpr [%zu:%zu]\n", node->line, node->column);
+        printf("IndexExpr [%zu:%zu]\n", location_line(node->loc), location_column(node->loc));
         print_indent(indent + 1);
         printf("object:\n");
         ast_print(node->as.index_expr.object, indent + 2);
@@ -1920,7 +1939,7 @@ void ast_print(Node* node, int indent) {
 
     case NODE_ENUM_DECL:
         printf("EnumDecl [%zu:%zu] %.*s%s\n",
-               node->line, node->column,
+               location_line(node->loc), location_column(node->loc),
                (int)node->as.enum_decl.name_size, node->as.enum_decl.name,
                node->as.enum_decl.is_export ? " (export)" : "");
         for (size_t i = 0; i < node->as.enum_decl.variants.count; i++) {
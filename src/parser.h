@@ -6,7 +6,14 @@
 #include "error.h"
 #include "lexer.h"
 
-Node* parser_parse(Arena* arena, Tokens* tokens, Errors* errors);
+#include <stdbool.h>
+
+// With lazy_bodies, function bodies are skipped up to their matching 'end' and
+// parsed on first use through parser_func_body; tokens must outlive the AST.
+Node* parser_parse(Arena* arena, Tokens* tokens, Errors* errors, bool lazy_bodies);
+
+// Body of a function declaration, parsing it first if it was deferred.
+NodeList* parser_func_body(Node* func);
 
 void ast_print(Node* node, int indent);
 
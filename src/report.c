@@ -0,0 +1,380 @@
+#include "report.h"
+#include "ast.h"
+#include "os.h"
+#include "type.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIZE_RANKING_LIMIT 20
+#define NM_OUTPUT_CAP (4 * 1024 * 1024)
+
+// ---------------------------------------------------------------------------
+// Function sizes
+// ---------------------------------------------------------------------------
+
+void func_size_add(FuncSizeList* list, char* c_name, Module* mod, GenericInst* inst, size_t c_bytes) {
+    if (list->count >= list->capacity) {
+        size_t new_cap = list->capacity == 0 ? 64 : list->capacity * 2;
+        FuncSize* new_items = realloc(list->items, new_cap * sizeof(FuncSize));
+        list->items = new_items;
+        list->capacity = new_cap;
+    }
+
+    FuncSize* item = &list->items[list->count++];
+    item->c_name = c_name;
+    item->mod = mod;
+    item->inst = inst;
+    item->c_bytes = c_bytes;
+    item->object_bytes = 0;
+}
+
+void func_size_list_free(FuncSizeList* list) {
+    free(list->items);
+    memset(list, 0, sizeof(FuncSizeList));
+}
+
+static int func_size_name_cmp(const void* a, const void* b) {
+    FuncSize* x = *(FuncSize**)a;
+    FuncSize* y = *(FuncSize**)b;
+    return strcmp(x->c_name, y->c_name);
+}
+
+static FuncSize* func_size_find(FuncSize** by_name, size_t count, char* name) {
+    FuncSize key;
+    key.c_name = name;
+    FuncSize* key_ptr = &key;
+    FuncSize** hit = bsearch(&key_ptr, by_name, count, sizeof(FuncSize*), func_size_name_cmp);
+    return hit ? *hit : NULL;
+}
+
+bool report_object_sizes(Arena* arena, FuncSizeList* sizes, char* binary_path) {
+    if (sizes->count == 0) return true;
+
+    FuncSize** by_name = arena_alloc(arena, sizeof(FuncSize*) * sizes->count);
+    for (size_t i = 0; i < sizes->count; i++) {
+        by_name[i] = &sizes->items[i];
+    }
+    qsort(by_name, sizes->count, sizeof(FuncSize*), func_size_name_cmp);
+
+    char cmd[1200];
+    snprintf(cmd, sizeof(cmd), "nm -S --defined-only \"%s\" 2>&1", binary_path);
+    char* output = arena_alloc(arena, NM_OUTPUT_CAP);
+    if (os_cmd_run(cmd, output, NM_OUTPUT_CAP) != 0) return false;
+
+    char* line = output;
+    while (*line) {
+        char* end = strchr(line, '\n');
+        if (end) *end = '\0';
+
+        // "<address> <size> <kind> <name>"; symbols without a size have no size field
+        char size_hex[32];
+        char kind[8];
+        char name[512];
+        if (sscanf(line, "%*s %31s %7s %511s", size_hex, kind, name) == 3) {
+            FuncSize* hit = func_size_find(by_name, sizes->count, name);
+            // Mach-O symbols carry a leading underscore
+            if (!hit && name[0] == '_') hit = func_size_find(by_name, sizes->count, name + 1);
+            if (hit) hit->object_bytes = (size_t)strtoull(size_hex, NULL, 16);
+        }
+
+        if (!end) break;
+        line = end + 1;
+    }
+    sizes->has_object_bytes = true;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Pointer index
+// ---------------------------------------------------------------------------
+
+// Fixed-size open-addressed map from a pointer to a dense index.
+typedef struct PtrIndex {
+    void** keys;
+    size_t* values;
+    size_t capacity;
+} PtrIndex;
+
+static void ptr_index_init(Arena* arena, PtrIndex* index, size_t count) {
+    size_t capacity = 16;
+    while (capacity < count * 2) capacity *= 2;
+    index->keys = arena_alloc(arena, sizeof(void*) * capacity);
+    index->values = arena_alloc(arena, sizeof(size_t) * capacity);
+    memset(index->keys, 0, sizeof(void*) * capacity);
+    index->capacity = capacity;
+}
+
+static size_t ptr_hash(void* key) {
+    uint64_t h = (uint64_t)(uintptr_t)key * 0x9e3779b97f4a7c15ull;
+    return (size_t)(h ^ (h >> 29));
+}
+
+// Value stored for key; stores value first if key is new.
+static size_t ptr_index_get_or_add(PtrIndex* index, void* key, size_t value) {
+    size_t mask = index->capacity - 1;
+    size_t i = ptr_hash(key) & mask;
+    while (index->keys[i]) {
+        if (index->keys[i] == key) return index->values[i];
+        i = (i + 1) & mask;
+    }
+    index->keys[i] = key;
+    index->values[i] = value;
+    return value;
+}
+
+static bool ptr_index_get(PtrIndex* index, void* key, size_t* out_value) {
+    size_t mask = index->capacity - 1;
+    for (size_t i = ptr_hash(key) & mask; index->keys[i]; i = (i + 1) & mask) {
+        if (index->keys[i] == key) {
+            *out_value = index->values[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// Generics report
+// ---------------------------------------------------------------------------
+
+typedef struct InstBytes {
+    size_t c_bytes;
+    size_t object_bytes;
+} InstBytes;
+
+typedef struct TemplateGroup {
+    GenericInst* first; // in creation order through group_next
+    GenericInst* last;
+    size_t count;
+    InstBytes bytes;
+} TemplateGroup;
+
+static void print_object_bytes(FuncSizeList* sizes, size_t object_bytes, int width) {
+    if (!sizes || !sizes->has_object_bytes) return;
+    if (object_bytes > 0) {
+        printf(" %*zu", width, object_bytes);
+    } else {
+        printf(" %*s", width, "-");
+    }
+}
+
+static void template_label(GenericInst* inst, char* buf, size_t size) {
+    Node* decl = inst->template_decl;
+    if (decl->type == NODE_STRUCT_DECL) {
+        snprintf(buf, size, "%.*s", (int)decl->as.struct_decl.name_size, decl->as.struct_decl.name);
+        return;
+    }
+    Type* method_of = (Type*)inst->mono_decl->as.func_decl.method_of;
+    if (method_of) {
+        snprintf(buf, size, "%s.%.*s", type_name(method_of),
+                 (int)decl->as.func_decl.name_size, decl->as.func_decl.name);
+    } else {
+        snprintf(buf, size, "%.*s", (int)decl->as.func_decl.name_size, decl->as.func_decl.name);
+    }
+}
+
+static void inst_label(GenericInst* inst, char* buf, size_t size) {
+    Node* decl = inst->template_decl;
+    int pos = decl->type == NODE_STRUCT_DECL
+        ? snprintf(buf, size, "%.*s[", (int)decl->as.struct_decl.name_size, decl->as.struct_decl.name)
+        : snprintf(buf, size, "%.*s[", (int)decl->as.func_decl.name_size, decl->as.func_decl.name);
+    for (size_t i = 0; i < inst->type_arg_count && pos < (int)size; i++) {
+        pos += snprintf(buf + pos, size - pos, "%s%s", i > 0 ? ", " : "", type_name(inst->type_args[i]));
+    }
+    if (pos < (int)size) snprintf(buf + pos, size - pos, "]");
+}
+
+void report_generics(Arena* arena, ModuleGraph* graph, FuncSizeList* sizes) {
+    for (Module* m = graph->first; m; m = m->next) {
+        GenericInstList* list = &m->generic_insts;
+        if (list->count == 0) continue;
+
+        // number instances in creation order
+        PtrIndex by_inst;
+        ptr_index_init(arena, &by_inst, list->count);
+        GenericInst** insts = arena_alloc(arena, sizeof(GenericInst*) * list->count);
+        size_t n = 0;
+        for (GenericInst* inst = list->first; inst; inst = inst->next) {
+            ptr_index_get_or_add(&by_inst, inst, n);
+            insts[n++] = inst;
+        }
+
+        // emitted bytes per instance: its own body, or a struct instance's methods
+        InstBytes* bytes = arena_alloc(arena, sizeof(InstBytes) * n);
+        memset(bytes, 0, sizeof(InstBytes) * n);
+        for (size_t i = 0; sizes && i < sizes->count; i++) {
+            FuncSize* fs = &sizes->items[i];
+            size_t idx;
+            if (fs->mod != m || !fs->inst || !ptr_index_get(&by_inst, fs->inst, &idx)) continue;
+            bytes[idx].c_bytes += fs->c_bytes;
+            bytes[idx].object_bytes += fs->object_bytes;
+        }
+
+        // group by template, in order of first instantiation
+        PtrIndex by_template;
+        ptr_index_init(arena, &by_template, n);
+        TemplateGroup* groups = arena_alloc(arena, sizeof(TemplateGroup) * n);
+        GenericInst** group_next = arena_alloc(arena, sizeof(GenericInst*) * n);
+        size_t group_count = 0;
+
+        size_t structs = 0, funcs = 0, methods = 0;
+        size_t reached = 0, skipped = 0;
+        for (size_t i = 0; i < n; i++) {
+            GenericInst* inst = insts[i];
+            Node* mono = inst->mono_decl;
+            if (mono->type == NODE_STRUCT_DECL) {
+                structs++;
+                NodeList* struct_methods = &mono->as.struct_decl.methods;
+                for (size_t j = 0; j < struct_methods->count; j++) {
+                    Node* method = struct_methods->nodes[j];
+                    if (method->type != NODE_FUNC_DECL) continue;
+                    if (method->as.func_decl.type_params.count > 0) continue;
+                    if (method->as.func_decl.is_reached) {
+                        reached++;
+                    } else {
+                        skipped++;
+                    }
+                }
+            } else if (mono->as.func_decl.method_of) {
+                methods++;
+            } else {
+                funcs++;
+            }
+
+            size_t g = ptr_index_get_or_add(&by_template, inst->template_decl, group_count);
+            if (g == group_count) {
+                memset(&groups[g], 0, sizeof(TemplateGroup));
+                groups[g].first = inst;
+                group_count++;
+            } else {
+                size_t last = 0;
+                ptr_index_get(&by_inst, groups[g].last, &last);
+                group_next[last] = inst;
+            }
+            group_next[i] = NULL;
+            groups[g].last = inst;
+            groups[g].count++;
+            groups[g].bytes.c_bytes += bytes[i].c_bytes;
+            groups[g].bytes.object_bytes += bytes[i].object_bytes;
+        }
+
+        printf("%s: %zu generic instances (%zu structs, %zu functions, %zu methods), "
+               "%zu bodies checked, %zu unreached methods skipped\n",
+               m->name, list->count, structs, funcs, methods,
+               funcs + methods + reached, skipped);
+        printf("  %-40s %9s %9s", "template / instance", "instances", "C bytes");
+        if (sizes && sizes->has_object_bytes) printf(" %9s", "obj bytes");
+        printf("\n");
+
+        char label[256];
+        for (size_t g = 0; g < group_count; g++) {
+            template_label(groups[g].first, label, sizeof(label));
+            printf("  %-40s %9zu %9zu", label, groups[g].count, groups[g].bytes.c_bytes);
+            print_object_bytes(sizes, groups[g].bytes.object_bytes, 9);
+            printf("\n");
+
+            for (GenericInst* inst = groups[g].first; inst;) {
+                size_t idx = 0;
+                ptr_index_get(&by_inst, inst, &idx);
+                inst_label(inst, label, sizeof(label));
+                printf("    %-38s %9s %9zu", label, "", bytes[idx].c_bytes);
+                print_object_bytes(sizes, bytes[idx].object_bytes, 9);
+                printf("\n");
+                inst = group_next[idx];
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Size report
+// ---------------------------------------------------------------------------
+
+static int func_size_bytes_cmp(const void* a, const void* b) {
+    FuncSize* x = *(FuncSize**)a;
+    FuncSize* y = *(FuncSize**)b;
+    if (x->c_bytes != y->c_bytes) return x->c_bytes > y->c_bytes ? -1 : 1;
+    return strcmp(x->c_name, y->c_name);
+}
+
+void report_size(Arena* arena, FuncSizeList* sizes) {
+    size_t c_total = 0;
+    size_t object_total = 0;
+    FuncSize** ranked = arena_alloc(arena, sizeof(FuncSize*) * (sizes->count + 1));
+    for (size_t i = 0; i < sizes->count; i++) {
+        ranked[i] = &sizes->items[i];
+        c_total += sizes->items[i].c_bytes;
+        object_total += sizes->items[i].object_bytes;
+    }
+    qsort(ranked, sizes->count, sizeof(FuncSize*), func_size_bytes_cmp);
+
+    printf("size: %zu functions, %zu C bytes", sizes->count, c_total);
+    if (sizes->has_object_bytes) printf(", %zu obj bytes", object_total);
+    printf("\n");
+    printf("  %9s", "C bytes");
+    if (sizes->has_object_bytes) printf(" %9s", "obj bytes");
+    printf("  %s\n", "function");
+    size_t limit = sizes->count < SIZE_RANKING_LIMIT ? sizes->count : SIZE_RANKING_LIMIT;
+    for (size_t i = 0; i < limit; i++) {
+        printf("  %9zu", ranked[i]->c_bytes);
+        print_object_bytes(sizes, ranked[i]->object_bytes, 9);
+        printf("  %s\n", ranked[i]->c_name);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Devirtualization report
+// ---------------------------------------------------------------------------
+
+void report_devirt(DevirtStats* stats) {
+    printf("devirt: %zu of %zu interface call sites call the method directly "
+           "(%zu sole implementation, %zu known receiver)\n",
+           stats->sole_impl + stats->known_receiver, stats->interface_calls,
+           stats->sole_impl, stats->known_receiver);
+}
+
+void report_opt(OptStats* stats) {
+    printf("opt: %zu folded, %zu constants propagated, %zu copies propagated\n",
+           stats->folded, stats->propagated, stats->copies);
+    printf("opt: %zu dead branches, %zu unreachable statements, %zu dead stores, "
+           "%zu with-releases dropped\n",
+           stats->dead_branches, stats->unreachable, stats->dead_stores, stats->cleanups);
+}
+
+// ---------------------------------------------------------------------------
+// Loop report
+// ---------------------------------------------------------------------------
+
+void report_loops(LoopList* loops) {
+    size_t canonical = 0;
+    size_t hoisted = 0;
+    for (size_t i = 0; i < loops->count; i++) {
+        LoopInfo* loop = &loops->items[i];
+        if (loop->step_constant && !loop->var_written) canonical++;
+        if (loop->end_hoisted || loop->step_hoisted) hoisted++;
+    }
+    printf("loops: %zu of %zu for loops canonical, %zu with bounds hoisted\n",
+           canonical, loops->count, hoisted);
+
+    for (size_t i = 0; i < loops->count; i++) {
+        LoopInfo* loop = &loops->items[i];
+        printf("  %s:%zu  ", loop->mod->name, loop->line);
+        if (loop->struct_name) {
+            printf("%.*s.", (int)loop->struct_name_size, loop->struct_name);
+        }
+        printf("%.*s  ", (int)loop->func_name_size, loop->func_name);
+        if (loop->var_written) {
+            printf("not canonical: body writes the loop variable");
+        } else if (!loop->step_constant) {
+            printf("not canonical: step is not a positive constant");
+        } else {
+            printf("canonical");
+        }
+        if (loop->end_hoisted) printf(", end hoisted");
+        if (loop->step_hoisted) printf(", step hoisted");
+        printf("\n");
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef ANCC_REPORT_H
+#define ANCC_REPORT_H
+
+#include "arena.h"
+#include "module.h"
+#include "opt.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Build reports requested with `ancc build --report=<name>[,<name>...]`.
+// They print to stdout after the C compiler has run.
+
+// One C function definition written by codegen.
+typedef struct FuncSize {
+    char* c_name;
+    Module* mod;
+    GenericInst* inst; // instance the body was emitted for, or NULL
+    size_t c_bytes;
+    size_t object_bytes; // from the built binary's symbol table, 0 if unknown
+} FuncSize;
+
+// Codegen appends to this when ModuleGraph.func_sizes is set.
+typedef struct FuncSizeList {
+    FuncSize* items;
+    size_t count;
+    size_t capacity;
+    bool has_object_bytes; // set by report_object_sizes; the reports omit obj columns otherwise
+} FuncSizeList;
+
+void func_size_add(FuncSizeList* list, char* c_name, Module* mod, GenericInst* inst, size_t c_bytes);
+void func_size_list_free(FuncSizeList* list);
+
+// Fills object_bytes by running nm over the built binary. Returns false if
+// the symbol table could not be read; sizes then stay unknown and the
+// reports leave out their obj bytes columns.
+bool report_object_sizes(Arena* arena, FuncSizeList* sizes, char* binary_path);
+
+// Per module: instance counts and checked/skipped bodies. Per template: its
+// instances with their emitted C and object bytes.
+void report_generics(Arena* arena, ModuleGraph* graph, FuncSizeList* sizes);
+
+// Functions ranked by emitted C bytes.
+void report_size(Arena* arena, FuncSizeList* sizes);
+
+// Interface method call sites codegen emitted, and how many of them call the
+// struct method directly instead of going through the vtable.
+typedef struct DevirtStats {
+    size_t interface_calls;
+    size_t sole_impl;      // the interface has a single implementing struct
+    size_t known_receiver; // sema proved which struct the receiver points at
+} DevirtStats;
+
+void report_devirt(DevirtStats* stats);
+
+// What the AST optimization passes changed.
+void report_opt(OptStats* stats);
+
+// Every for loop opt saw, whether codegen emitted it as a canonical counted
+// loop, and which bounds it evaluated into temporaries.
+void report_loops(LoopList* loops);
+
+#endif
@@ -1,42 +1,96 @@
 #include "sema.h"
+#include "consteval.h"
 #include "module.h"
 #include "type.h"
 #include "lexer.h"
+#include "parser.h"
 
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+// tables at or below this size are searched linearly and carry no index
+#define SYMBOL_TABLE_LINEAR_MAX 8
+
+static void symbol_index_put(Symbol** slots, size_t capacity, Symbol* sym) {
+    size_t mask = capacity - 1;
+    size_t i = atom_hash(sym->name_atom) & mask;
+    while (slots[i]) {
+        // first insertion wins, matching the old linear scan
+        if (slots[i]->name_atom == sym->name_atom) return;
+        i = (i + 1) & mask;
+    }
+    slots[i] = sym;
+}
+
+static void symbol_index_grow(Arena* arena, SymbolTable* table) {
+    size_t capacity = table->slot_capacity ? table->slot_capacity * 2 : 32;
+    Symbol** slots = arena_alloc(arena, sizeof(Symbol*) * capacity);
+    memset(slots, 0, sizeof(Symbol*) * capacity);
+    for (Symbol* s = table->first; s; s = s->next) {
+        symbol_index_put(slots, capacity, s);
+    }
+    table->slots = slots;
+    table->slot_capacity = capacity;
+}
+
+static void symbol_table_append(Arena* arena, SymbolTable* table, Symbol* sym) {
+    if (!table->first) {
+        table->first = sym;
+    } else {
+        table->last->next = sym;
+    }
+    table->last = sym;
+    table->count++;
+
+    if (table->count <= SYMBOL_TABLE_LINEAR_MAX) return;
+    // keep the load factor under 1/2
+    if ((size_t)table->count * 2 > table->slot_capacity) {
+        symbol_index_grow(arena, table);
+    } else {
+        symbol_index_put(table->slots, table->slot_capacity, sym);
+    }
+}
+
 static Symbol* symbol_add(Arena* arena, SymbolTable* table, SymbolKind kind,
-                           char* name, size_t name_size, bool is_export, Node* node) {
+                           char* name, size_t name_size, Atom name_atom,
+                           bool is_export, Node* node) {
     Symbol* sym = arena_alloc(arena, sizeof(Symbol));
     sym->next = NULL;
     sym->kind = kind;
     sym->name = name;
     sym->name_size = name_size;
+    sym->name_atom = name_atom;
     sym->is_export = is_export;
     sym->node = node;
     sym->source = NULL;
     sym->resolved_type = NULL;
-    if (!table->first) {
-        table->first = sym;
-    } else {
-        table->last->next = sym;
-    }
-    table->last = sym;
-    table->count++;
+    symbol_table_append(arena, table, sym);
     return sym;
 }
 
-Symbol* symbol_find(SymbolTable* table, char* name, size_t name_size) {
-    for (Symbol* s = table->first; s; s = s->next) {
-        if (s->name_size == name_size && memcmp(s->name, name, name_size) == 0) {
-            return s;
+Symbol* symbol_find_atom(SymbolTable* table, Atom name_atom) {
+    if (!table->slots) {
+        for (Symbol* s = table->first; s; s = s->next) {
+            if (s->name_atom == name_atom) return s;
         }
+        return NULL;
+    }
+
+    size_t mask = table->slot_capacity - 1;
+    for (size_t i = atom_hash(name_atom) & mask; table->slots[i]; i = (i + 1) & mask) {
+        if (table->slots[i]->name_atom == name_atom) return table->slots[i];
     }
     return NULL;
 }
 
+Symbol* symbol_find(SymbolTable* table, char* name, size_t name_size) {
+    // a name never interned names no symbol
+    Atom atom = intern_find(name, name_size);
+    if (atom == ATOM_NONE) return NULL;
+    return symbol_find_atom(table, atom);
+}
+
 static char* build_import_file_path(Arena* arena, char* src_dir, char* module_path, size_t module_path_size) {
     size_t src_dir_len = strlen(src_dir);
     size_t max_len = src_dir_len + 1 + module_path_size + 4 + 1;
@@ -59,9 +113,7 @@ static char* build_import_file_path(Arena* arena, char* src_dir, char* module_pa
 
 static void collect_module_symbols(Arena* arena, Errors* errors, Module* mod) {
     SymbolTable* table = arena_alloc(arena, sizeof(SymbolTable));
-    table->first = NULL;
-    table->last = NULL;
-    table->count = 0;
+    memset(table, 0, sizeof(SymbolTable));
     mod->symbols = table;
 
     if (!mod->ast || mod->ast->type != NODE_PROGRAM) return;
@@ -71,6 +123,7 @@ static void collect_module_symbols(Arena* arena, Errors* errors, Module* mod) {
         Node* node = decls->nodes[i];
         char* name = NULL;
         size_t name_size = 0;
+        Atom name_atom = ATOM_NONE;
         bool is_export = false;
         SymbolKind kind;
 
@@ -79,36 +132,42 @@ static void collect_module_symbols(Arena* arena, Errors* errors, Module* mod) {
             kind = SYMBOL_FUNC;
             name = node->as.func_decl.name;
             name_size = node->as.func_decl.name_size;
+            name_atom = node->as.func_decl.name_atom;
             is_export = node->as.func_decl.is_export;
             break;
         case NODE_STRUCT_DECL:
             kind = SYMBOL_STRUCT;
             name = node->as.struct_decl.name;
             name_size = node->as.struct_decl.name_size;
+            name_atom = node->as.struct_decl.name_atom;
             is_export = node->as.struct_decl.is_export;
             break;
         case NODE_INTERFACE_DECL:
             kind = SYMBOL_INTERFACE;
             name = node->as.interface_decl.name;
             name_size = node->as.interface_decl.name_size;
+            name_atom = node->as.interface_decl.name_atom;
             is_export = false;
             break;
         case NODE_ENUM_DECL:
             kind = SYMBOL_ENUM;
             name = node->as.enum_decl.name;
             name_size = node->as.enum_decl.name_size;
+            name_atom = node->as.enum_decl.name_atom;
             is_export = node->as.enum_decl.is_export;
             break;
         case NODE_CONST_DECL:
             kind = SYMBOL_CONST;
             name = node->as.const_decl.name;
             name_size = node->as.const_decl.name_size;
+            name_atom = node->as.const_decl.name_atom;
             is_export = node->as.const_decl.is_export;
             break;
         case NODE_VAR_DECL:
             kind = SYMBOL_VAR;
             name = node->as.var_decl.name;
             name_size = node->as.var_decl.name_size;
+            name_atom = node->as.var_decl.name_atom;
             is_export = node->as.var_decl.is_export;
             break;
         default:
@@ -116,14 +175,14 @@ static void collect_module_symbols(Arena* arena, Errors* errors, Module* mod) {
         }
 
         // duplicate check
-        Symbol* existing = symbol_find(table, name, name_size);
+        Symbol* existing = symbol_find_atom(table, name_atom);
         if (existing) {
-            errors_push(errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "duplicate symbol '%.*s' in module '%s'", (int)name_size, name, mod->name);
+            errors_push_at(errors, SEVERITY_ERROR, node->loc,
+                           "duplicate symbol '%.*s' in module '%s'", (int)name_size, name, mod->name);
             continue;
         }
 
-        symbol_add(arena, table, kind, name, name_size, is_export, node);
+        symbol_add(arena, table, kind, name, name_size, name_atom, is_export, node);
     }
 }
 
@@ -143,8 +202,8 @@ static void resolve_module_imports(Arena* arena, Errors* errors, ModuleGraph* gr
         char* file_path = build_import_file_path(arena, graph->src_dir, module_path, module_path_size);
         Module* source = module_find(graph, file_path);
         if (!source) {
-            errors_push(errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "module '%.*s' not found", (int)module_path_size, module_path);
+            errors_push_at(errors, SEVERITY_ERROR, node->loc,
+                           "module '%.*s' not found", (int)module_path_size, module_path);
             continue;
         }
 
@@ -154,109 +213,251 @@ static void resolve_module_imports(Arena* arena, Errors* errors, ModuleGraph* gr
             ImportName* imp = &names->names[j];
 
             // check for duplicate in current module
-            Symbol* dup = symbol_find(mod->symbols, imp->name, imp->name_size);
+            Symbol* dup = symbol_find_atom(mod->symbols, imp->name_atom);
             if (dup) {
-                errors_push(errors, SEVERITY_ERROR, imp->offset, imp->line, imp->column,
-                            "duplicate symbol '%.*s' in module '%s'",
-                            (int)imp->name_size, imp->name, mod->name);
+                errors_push_at(errors, SEVERITY_ERROR, imp->loc,
+                               "duplicate symbol '%.*s' in module '%s'",
+                               (int)imp->name_size, imp->name, mod->name);
                 continue;
             }
 
             // find in source module
-            Symbol* src_sym = symbol_find(source->symbols, imp->name, imp->name_size);
+            Symbol* src_sym = symbol_find_atom(source->symbols, imp->name_atom);
             if (!src_sym) {
-                errors_push(errors, SEVERITY_ERROR, imp->offset, imp->line, imp->column,
-                            "'%.*s' not found in module '%s'",
-                            (int)imp->name_size, imp->name, source->name);
+                errors_push_at(errors, SEVERITY_ERROR, imp->loc,
+                               "'%.*s' not found in module '%s'",
+                               (int)imp->name_size, imp->name, source->name);
                 continue;
             }
 
             if (!src_sym->is_export) {
-                errors_push(errors, SEVERITY_ERROR, imp->offset, imp->line, imp->column,
-                            "'%.*s' is not exported from module '%s'",
-                            (int)imp->name_size, imp->name, source->name);
+                errors_push_at(errors, SEVERITY_ERROR, imp->loc,
+                               "'%.*s' is not exported from module '%s'",
+                               (int)imp->name_size, imp->name, source->name);
                 continue;
             }
 
             Symbol* sym = symbol_add(arena, mod->symbols, SYMBOL_IMPORT,
-                                      imp->name, imp->name_size, is_export, src_sym->node);
+                                      imp->name, imp->name_size, imp->name_atom,
+                                      is_export, src_sym->node);
             sym->source = source;
         }
     }
 }
 
+// ---------------------------------------------------------------------------
+// Generic instance side tables
+// ---------------------------------------------------------------------------
+
+#define INST_NO_ORDINAL UINT32_MAX
+
+static size_t inst_node_hash(Node* node) {
+    uint64_t h = (uint64_t)(uintptr_t)node * 0x9e3779b97f4a7c15ull;
+    return (size_t)(h ^ (h >> 29));
+}
+
+static uint32_t inst_layout_find(InstLayout* layout, Node* node) {
+    if (!layout->capacity) return INST_NO_ORDINAL;
+    size_t mask = layout->capacity - 1;
+    for (size_t i = inst_node_hash(node) & mask; layout->keys[i]; i = (i + 1) & mask) {
+        if (layout->keys[i] == node) return layout->ordinals[i];
+    }
+    return INST_NO_ORDINAL;
+}
+
+static void inst_layout_put(InstLayout* layout, Node* node, uint32_t ordinal) {
+    size_t mask = layout->capacity - 1;
+    size_t i = inst_node_hash(node) & mask;
+    while (layout->keys[i]) i = (i + 1) & mask;
+    layout->keys[i] = node;
+    layout->ordinals[i] = ordinal;
+}
+
+// Room for one more key, keeping the load factor under 1/2.
+static void inst_layout_reserve(Arena* arena, InstLayout* layout) {
+    if ((layout->key_count + 1) * 2 > layout->capacity) {
+        Node** keys = layout->keys;
+        uint32_t* ordinals = layout->ordinals;
+        size_t old_capacity = layout->capacity;
+        layout->capacity = old_capacity ? old_capacity * 2 : 32;
+        layout->keys = arena_alloc(arena, sizeof(Node*) * layout->capacity);
+        layout->ordinals = arena_alloc(arena, sizeof(uint32_t) * layout->capacity);
+        memset(layout->keys, 0, sizeof(Node*) * layout->capacity);
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (keys[i]) inst_layout_put(layout, keys[i], ordinals[i]);
+        }
+    }
+    layout->key_count++;
+}
+
+// Ordinal of node, numbering it on first use.
+static uint32_t inst_layout_add(Arena* arena, InstLayout* layout, Node* node) {
+    uint32_t ordinal = inst_layout_find(layout, node);
+    if (ordinal != INST_NO_ORDINAL) return ordinal;
+
+    inst_layout_reserve(arena, layout);
+    inst_layout_put(layout, node, layout->count);
+    return layout->count++;
+}
+
+// The node numbering shared by all instances of a template.
+static InstLayout* template_layout(Arena* arena, Node* template_decl) {
+    InstLayout** layout = template_decl->type == NODE_FUNC_DECL
+        ? &template_decl->as.func_decl.layout
+        : &template_decl->as.struct_decl.layout;
+    if (!*layout) {
+        *layout = arena_alloc(arena, sizeof(InstLayout));
+        memset(*layout, 0, sizeof(InstLayout));
+    }
+    return *layout;
+}
+
+static void inst_arrays_grow(Arena* arena, GenericInst* inst, uint32_t capacity) {
+    Type** types = arena_alloc(arena, sizeof(Type*) * capacity);
+    memset(types, 0, sizeof(Type*) * capacity);
+    if (inst->node_capacity) memcpy(types, inst->node_types, sizeof(Type*) * inst->node_capacity);
+    inst->node_types = types;
+    if (inst->node_targets) {
+        GenericInst** targets = arena_alloc(arena, sizeof(GenericInst*) * capacity);
+        memset(targets, 0, sizeof(GenericInst*) * capacity);
+        memcpy(targets, inst->node_targets, sizeof(GenericInst*) * inst->node_capacity);
+        inst->node_targets = targets;
+    }
+    inst->node_capacity = capacity;
+}
+
+// Ordinal of node with inst's arrays grown to cover it.
+static uint32_t generic_inst_slot(Arena* arena, GenericInst* inst, Node* node) {
+    uint32_t ordinal = inst_layout_add(arena, inst->layout, node);
+    if (ordinal >= inst->node_capacity) {
+        uint32_t capacity = inst->node_capacity ? inst->node_capacity * 2 : 16;
+        while (capacity <= ordinal) capacity *= 2;
+        inst_arrays_grow(arena, inst, capacity);
+    }
+    return ordinal;
+}
+
+Type* generic_inst_type(GenericInst* inst, Node* node) {
+    uint32_t ordinal = inst_layout_find(inst->layout, node);
+    if (ordinal == INST_NO_ORDINAL || ordinal >= inst->node_capacity) return NULL;
+    return inst->node_types[ordinal];
+}
+
+void generic_inst_alias(Arena* arena, GenericInst* inst, Node* copy, Node* original) {
+    uint32_t ordinal = inst_layout_find(inst->layout, original);
+    if (ordinal == INST_NO_ORDINAL) return;
+    inst_layout_reserve(arena, inst->layout);
+    inst_layout_put(inst->layout, copy, ordinal);
+}
+
+GenericInst* generic_inst_target(GenericInst* inst, Node* node) {
+    if (!inst->node_targets) return NULL;
+    uint32_t ordinal = inst_layout_find(inst->layout, node);
+    if (ordinal == INST_NO_ORDINAL || ordinal >= inst->node_capacity) return NULL;
+    return inst->node_targets[ordinal];
+}
+
+static void generic_inst_set_target(Arena* arena, GenericInst* inst, Node* node, GenericInst* target) {
+    uint32_t ordinal = generic_inst_slot(arena, inst, node);
+    if (!inst->node_targets) {
+        inst->node_targets = arena_alloc(arena, sizeof(GenericInst*) * inst->node_capacity);
+        memset(inst->node_targets, 0, sizeof(GenericInst*) * inst->node_capacity);
+    }
+    inst->node_targets[ordinal] = target;
+}
+
+// Concrete type bound to a type parameter by inst or the struct instance
+// enclosing it.
+static Type* inst_param_type(GenericInst* inst, Atom name_atom) {
+    for (; inst; inst = inst->outer) {
+        for (size_t i = 0; i < inst->type_arg_count; i++) {
+            if (inst->param_atoms[i] == name_atom) return inst->type_args[i];
+        }
+    }
+    return NULL;
+}
+
+// Length of an array type. A size expression is folded to a literal in
+// place, so codegen and the module cache see the number.
+static int array_type_size(ConstEval* ev, Errors* errors, Node* node) {
+    Node* size_node = node->as.type_array.size_expr;
+    ConstValue size;
+    if (!size_node || !const_eval(ev, size_node, &size) || (size.type && !type_is_integer(size.type))) {
+        errors_push_at(errors, SEVERITY_ERROR, node->loc,
+                       "array size must be a compile-time constant");
+        return 0;
+    }
+    if (size.value <= 0 || size.value > INT32_MAX) {
+        errors_push_at(errors, SEVERITY_ERROR, node->loc,
+                       "array size must be positive");
+        return 0;
+    }
+    if (size_node->type != NODE_INTEGER_LITERAL) {
+        Type* type = size.type ? size.type : type_int(ev->reg);
+        node->as.type_array.size_expr = const_value_node(ev->reg->arena, &size, type, size_node->loc);
+    }
+    return (int)size.value;
+}
+
+// Resolve a type node. inst, when set, is the generic instance the node is
+// read under: its bindings name the type parameters and its table holds
+// what was resolved earlier for that instance.
 static Type* resolve_type_node(TypeRegistry* reg, Errors* errors,
-                                SymbolTable* table, Node* node) {
+                                SymbolTable* table, GenericInst* inst, Node* node) {
     if (!node) return type_void(reg);
+    if (inst) {
+        Type* t = generic_inst_type(inst, node);
+        if (t) return t;
+    }
     if (node->resolved_type) return (Type*)node->resolved_type;
 
     switch (node->type) {
     case NODE_TYPE_SIMPLE: {
         char* name = node->as.type_simple.name;
         size_t size = node->as.type_simple.name_size;
-        if (size == 4 && memcmp(name, "void", 4) == 0) return type_void(reg);
-        if (size == 4 && memcmp(name, "bool", 4) == 0) return type_bool(reg);
-        if (size == 4 && memcmp(name, "byte", 4) == 0) return type_byte(reg);
-        if (size == 5 && memcmp(name, "short", 5) == 0) return type_short(reg);
-        if (size == 6 && memcmp(name, "ushort", 6) == 0) return type_ushort(reg);
-        if (size == 3 && memcmp(name, "int", 3) == 0) return type_int(reg);
-        if (size == 4 && memcmp(name, "uint", 4) == 0) return type_uint(reg);
-        if (size == 4 && memcmp(name, "long", 4) == 0) return type_long(reg);
-        if (size == 5 && memcmp(name, "ulong", 5) == 0) return type_ulong(reg);
-        if (size == 5 && memcmp(name, "isize", 5) == 0) return type_isize(reg);
-        if (size == 5 && memcmp(name, "usize", 5) == 0) return type_usize(reg);
-        if (size == 5 && memcmp(name, "float", 5) == 0) return type_float(reg);
-        if (size == 6 && memcmp(name, "double", 6) == 0) return type_double(reg);
-        if (size == 6 && memcmp(name, "string", 6) == 0) return type_string(reg);
+        Type* bound = inst_param_type(inst, node->as.type_simple.name_atom);
+        if (bound) return bound;
+        Type* prim = type_primitive(reg, node->as.type_simple.name_atom);
+        if (prim) return prim;
 
         // look up struct/interface in symbol table
-        Symbol* sym = symbol_find(table, name, size);
+        Symbol* sym = symbol_find_atom(table, node->as.type_simple.name_atom);
         if (sym && sym->node && sym->node->resolved_type) {
             return (Type*)sym->node->resolved_type;
         }
         // check if it's an import
         if (sym && sym->kind == SYMBOL_IMPORT && sym->source) {
-            Symbol* src_sym = symbol_find(sym->source->symbols, name, size);
+            Symbol* src_sym = symbol_find_atom(sym->source->symbols, node->as.type_simple.name_atom);
             if (src_sym && src_sym->node && src_sym->node->resolved_type) {
                 return (Type*)src_sym->node->resolved_type;
             }
         }
-        errors_push(errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                    "unknown type '%.*s'", (int)size, name);
+        errors_push_at(errors, SEVERITY_ERROR, node->loc,
+                       "unknown type '%.*s'", (int)size, name);
         return NULL;
     }
     case NODE_TYPE_REFERENCE: {
-        Type* inner = resolve_type_node(reg, errors, table, node->as.type_ref.inner);
+        Type* inner = resolve_type_node(reg, errors, table, inst, node->as.type_ref.inner);
         if (!inner) return NULL;
         return type_ref(reg, inner);
     }
     case NODE_TYPE_POINTER: {
-        Type* inner = resolve_type_node(reg, errors, table, node->as.type_ptr.inner);
+        Type* inner = resolve_type_node(reg, errors, table, inst, node->as.type_ptr.inner);
         if (!inner) return NULL;
         return type_ptr(reg, inner);
     }
     case NODE_TYPE_ARRAY: {
-        Type* element = resolve_type_node(reg, errors, table, node->as.type_array.inner);
+        Type* element = resolve_type_node(reg, errors, table, inst, node->as.type_array.inner);
         if (!element) return NULL;
-        Node* size_node = node->as.type_array.size_expr;
-        if (!size_node || size_node->type != NODE_INTEGER_LITERAL) {
-            errors_push(errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "array size must be an integer literal");
-            return NULL;
-        }
-        int arr_size = 0;
-        for (size_t i = 0; i < size_node->as.integer_literal.value_size; i++) {
-            arr_size = arr_size * 10 + (size_node->as.integer_literal.value[i] - '0');
-        }
-        if (arr_size <= 0) {
-            errors_push(errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "array size must be positive");
-            return NULL;
-        }
+        ConstEval ev;
+        const_eval_init(&ev, reg, table);
+        int arr_size = array_type_size(&ev, errors, node);
+        const_eval_free(&ev);
+        if (arr_size <= 0) return NULL;
         return type_array(reg, element, arr_size);
     }
     case NODE_TYPE_SLICE: {
-        Type* element = resolve_type_node(reg, errors, table, node->as.type_slice.inner);
+        Type* element = resolve_type_node(reg, errors, table, inst, node->as.type_slice.inner);
         if (!element) return NULL;
         return type_slice(reg, element);
     }
@@ -265,6 +466,39 @@ static Type* resolve_type_node(TypeRegistry* reg, Errors* errors,
     }
 }
 
+// Index a struct type's methods by name. First declaration wins on duplicates.
+static void struct_method_index_build(Arena* arena, Type* st) {
+    NodeList* methods = st->as.struct_type.methods;
+    if (!methods || methods->count == 0) return;
+
+    size_t capacity = 8;
+    while (capacity < methods->count * 2) capacity *= 2;
+    Node** slots = arena_alloc(arena, sizeof(Node*) * capacity);
+    memset(slots, 0, sizeof(Node*) * capacity);
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < methods->count; i++) {
+        Node* m = methods->nodes[i];
+        if (m->type != NODE_FUNC_DECL) continue;
+        size_t j = atom_hash(m->as.func_decl.name_atom) & mask;
+        while (slots[j] && slots[j]->as.func_decl.name_atom != m->as.func_decl.name_atom) {
+            j = (j + 1) & mask;
+        }
+        if (!slots[j]) slots[j] = m;
+    }
+    st->as.struct_type.method_slots = slots;
+    st->as.struct_type.method_slot_capacity = capacity;
+}
+
+static Node* struct_find_method(Type* st, Atom name_atom) {
+    Node** slots = st->as.struct_type.method_slots;
+    if (!slots) return NULL;
+    size_t mask = st->as.struct_type.method_slot_capacity - 1;
+    for (size_t j = atom_hash(name_atom) & mask; slots[j]; j = (j + 1) & mask) {
+        if (slots[j]->as.func_decl.name_atom == name_atom) return slots[j];
+    }
+    return NULL;
+}
+
 static void resolve_module_types(Arena* arena, Errors* errors,
                                   TypeRegistry* reg, Module* mod) {
     if (!mod->symbols) return;
@@ -284,13 +518,14 @@ static void resolve_module_types(Arena* arena, Errors* errors,
                 &sym->node->as.struct_decl.fields,
                 &sym->node->as.struct_decl.methods);
             sym->node->resolved_type = t;
+            struct_method_index_build(arena, t);
 
             // resolve field type nodes
             FieldList* fields = &sym->node->as.struct_decl.fields;
             for (size_t i = 0; i < fields->count; i++) {
                 if (fields->fields[i].type_node) {
                     fields->fields[i].type_node->resolved_type =
-                        resolve_type_node(reg, errors, mod->symbols, fields->fields[i].type_node);
+                        resolve_type_node(reg, errors, mod->symbols, NULL, fields->fields[i].type_node);
                 }
             }
             break;
@@ -323,11 +558,11 @@ static void resolve_module_types(Arena* arena, Errors* errors,
                 if (param_count > 0) {
                     param_types = arena_alloc(arena, sizeof(Type*) * param_count);
                     for (int j = 0; j < param_count; j++) {
-                        param_types[j] = resolve_type_node(reg, errors, mod->symbols,
+                        param_types[j] = resolve_type_node(reg, errors, mod->symbols, NULL,
                                                             params->params[j].type_node);
                     }
                 }
-                Type* ret = resolve_type_node(reg, errors, mod->symbols,
+                Type* ret = resolve_type_node(reg, errors, mod->symbols, NULL,
                                                sig->as.func_decl.return_type);
                 sig->resolved_type = type_func(reg, param_types, param_count, ret);
             }
@@ -341,19 +576,98 @@ static void resolve_module_types(Arena* arena, Errors* errors,
 
 // forward declarations for CheckContext and resolve_generic_type
 // (needed by resolve_func_types to handle generic types in function signatures)
-typedef struct Scope {
-    struct Scope* parent;
-    SymbolTable locals;
-} Scope;
+// Local bindings live on one flat stack shared by every function body in a
+// sema run. innermost maps an atom to its most recent binding, and each
+// binding remembers the one it shadows, so popping a block restores names in
+// bulk without walking parent scopes.
+typedef struct ScopeBinding {
+    Symbol* sym;
+    int prev; // binding of the same name this one shadows, or -1
+} ScopeBinding;
+
+typedef struct ScopeStack {
+    ScopeBinding* bindings;
+    size_t count;
+    size_t capacity;
+    int* innermost; // indexed by atom, -1 if unbound
+    size_t innermost_capacity;
+    size_t scope_start; // first binding of the innermost block
+    size_t frame_start; // first binding of the function being checked
+} ScopeStack;
+
+// Interface satisfaction results for every (struct, interface) pair seen in
+// a sema run, shared across modules.
+typedef struct ImplUse {
+    struct ImplUse* next;
+    Module* mod;
+} ImplUse;
+
+typedef struct ImplEntry {
+    Type* struct_type;
+    Type* interface_type;
+    bool satisfied;
+    Node** methods;  // struct method per interface signature (the vtable slots)
+    ImplUse* uses;   // modules that recorded an ImplPair for this entry
+} ImplEntry;
+
+typedef struct ImplCache {
+    ImplEntry** slots;
+    size_t capacity;
+    size_t count;
+} ImplCache;
+
+// Instance bodies waiting to be checked. Instantiating records the request
+// and queues the body; the queue is drained at the end of pass 4, so a body is
+// only ever checked because checked code needed it.
+typedef struct PendingBody {
+    Node* func;
+    Module* mod; // module owning the instance
+    Type* self_type; // struct the body is a method of, or NULL
+} PendingBody;
+
+typedef struct PendingList {
+    PendingBody* items;
+    size_t count;
+    size_t capacity;
+} PendingList;
+
+// Interface-typed locals initialized from a struct reference, and the calls
+// made through them, collected over one function body. A local that is never
+// reassigned and never has its address taken keeps pointing at that struct,
+// so its calls can skip the vtable (see known_struct on method_call).
+typedef struct KnownReceiver {
+    Node* decl;
+    Type* struct_type;
+    bool reassigned;
+} KnownReceiver;
+
+typedef struct ReceiverCall {
+    Node* call;
+    size_t receiver;
+} ReceiverCall;
+
+typedef struct ReceiverList {
+    KnownReceiver* receivers;
+    size_t receiver_count;
+    size_t receiver_capacity;
+    ReceiverCall* calls;
+    size_t call_count;
+    size_t call_capacity;
+} ReceiverList;
 
 #define MAX_WITH_DEPTH 16
+#define MAX_INST_DEPTH 64
 
 typedef struct CheckContext {
     Arena* arena;
     Errors* errors;
     TypeRegistry* reg;
     Module* mod;
-    Scope* scope;
+    ScopeStack* scopes;
+    ImplCache* impls;
+    PendingList* pending;
+    ReceiverList* receivers;
+    GenericInst* inst; // instance whose template body is being checked, or NULL
     Type* return_type;
     Type* self_type;
     int loop_depth;
@@ -365,6 +679,43 @@ typedef struct CheckContext {
 
 static Type* resolve_generic_type(CheckContext* ctx, Node* type_node);
 
+// Type sema recorded for a node: inside a generic instance the template
+// node is shared, so the type lives in the instance's table.
+static Type* node_type(CheckContext* ctx, Node* node) {
+    if (ctx->inst) {
+        Type* t = generic_inst_type(ctx->inst, node);
+        if (t) return t;
+    }
+    return (Type*)node->resolved_type;
+}
+
+static void node_type_set(CheckContext* ctx, Node* node, Type* type) {
+    if (ctx->inst) {
+        uint32_t ordinal = generic_inst_slot(ctx->arena, ctx->inst, node);
+        ctx->inst->node_types[ordinal] = type;
+    } else {
+        node->resolved_type = type;
+    }
+}
+
+// A bound names an interface of the template's module; its type stays on the
+// bound node for the check at each instantiation.
+static void resolve_type_param_bounds(CheckContext* ctx, TypeParamList* params) {
+    for (size_t i = 0; i < params->count; i++) {
+        Node* bound = params->params[i].bound;
+        if (!bound || bound->resolved_type) continue;
+        Type* t = resolve_type_node(ctx->reg, ctx->errors, ctx->mod->symbols, NULL, bound);
+        if (!t) continue;
+        if (t->kind != TYPE_INTERFACE) {
+            errors_push_at(ctx->errors, SEVERITY_ERROR, bound->loc,
+                           "bound of type parameter '%.*s' must be an interface, got '%s'",
+                           (int)params->params[i].name_size, params->params[i].name, type_name(t));
+            continue;
+        }
+        bound->resolved_type = t;
+    }
+}
+
 static void resolve_func_types(Arena* arena, Errors* errors,
                                 TypeRegistry* reg, Module* mod) {
     if (!mod->symbols) return;
@@ -377,10 +728,24 @@ static void resolve_func_types(Arena* arena, Errors* errors,
     func_ctx.mod = mod;
 
     for (Symbol* sym = mod->symbols->first; sym; sym = sym->next) {
-        if (sym->kind != SYMBOL_FUNC || !sym->node) continue;
+        if (!sym->node) continue;
+
+        if (sym->kind == SYMBOL_STRUCT) {
+            resolve_type_param_bounds(&func_ctx, &sym->node->as.struct_decl.type_params);
+            NodeList* methods = &sym->node->as.struct_decl.methods;
+            for (size_t i = 0; i < methods->count; i++) {
+                if (methods->nodes[i]->type != NODE_FUNC_DECL) continue;
+                resolve_type_param_bounds(&func_ctx, &methods->nodes[i]->as.func_decl.type_params);
+            }
+            continue;
+        }
+        if (sym->kind != SYMBOL_FUNC) continue;
 
         // skip generic templates — they are instantiated on demand
-        if (sym->node->as.func_decl.type_params.count > 0) continue;
+        if (sym->node->as.func_decl.type_params.count > 0) {
+            resolve_type_param_bounds(&func_ctx, &sym->node->as.func_decl.type_params);
+            continue;
+        }
 
         ParamList* params = &sym->node->as.func_decl.params;
         int param_count = (int)params->count;
@@ -403,49 +768,95 @@ static void resolve_func_types(Arena* arena, Errors* errors,
 // Pass 4: Expression & statement type checking
 // ---------------------------------------------------------------------------
 
-static Scope* scope_push(CheckContext* ctx) {
-    Scope* s = arena_alloc(ctx->arena, sizeof(Scope));
-    s->parent = ctx->scope;
-    s->locals.first = NULL;
-    s->locals.last = NULL;
-    s->locals.count = 0;
-    ctx->scope = s;
-    return s;
+static void scope_stack_free(ScopeStack* ss) {
+    free(ss->bindings);
+    free(ss->innermost);
+    memset(ss, 0, sizeof(ScopeStack));
 }
 
-static void scope_pop(CheckContext* ctx, Scope* prev) {
-    ctx->scope = prev;
+// Open a block scope. Returns the previous block start for scope_pop.
+static size_t scope_push(CheckContext* ctx) {
+    ScopeStack* ss = ctx->scopes;
+    size_t prev = ss->scope_start;
+    ss->scope_start = ss->count;
+    return prev;
+}
+
+static void scope_pop(CheckContext* ctx, size_t prev) {
+    ScopeStack* ss = ctx->scopes;
+    while (ss->count > ss->scope_start) {
+        ScopeBinding* b = &ss->bindings[--ss->count];
+        ss->innermost[b->sym->name_atom] = b->prev;
+    }
+    ss->scope_start = prev;
 }
 
-static void scope_add(CheckContext* ctx, SymbolKind kind, char* name, size_t name_size, Type* type, Node* node) {
+static void scope_add(CheckContext* ctx, SymbolKind kind, char* name, size_t name_size, Atom name_atom,
+                      Type* type, Node* node) {
     Symbol* sym = arena_alloc(ctx->arena, sizeof(Symbol));
     sym->next = NULL;
     sym->kind = kind;
     sym->name = name;
     sym->name_size = name_size;
+    sym->name_atom = name_atom;
     sym->is_export = false;
     sym->node = node;
     sym->source = NULL;
     sym->resolved_type = type;
-    if (node) node->resolved_type = type;
+    if (node) node_type_set(ctx, node, type);
+
+    ScopeStack* ss = ctx->scopes;
+    if (name_atom >= ss->innermost_capacity) {
+        size_t capacity = ss->innermost_capacity ? ss->innermost_capacity : 1024;
+        while (capacity <= name_atom) capacity *= 2;
+        ss->innermost = realloc(ss->innermost, capacity * sizeof(int));
+        for (size_t i = ss->innermost_capacity; i < capacity; i++) ss->innermost[i] = -1;
+        ss->innermost_capacity = capacity;
+    }
+    if (ss->count >= ss->capacity) {
+        ss->capacity = ss->capacity ? ss->capacity * 2 : 256;
+        ss->bindings = realloc(ss->bindings, ss->capacity * sizeof(ScopeBinding));
+    }
+    ScopeBinding* b = &ss->bindings[ss->count];
+    b->sym = sym;
+    b->prev = ss->innermost[name_atom];
+    ss->innermost[name_atom] = (int)ss->count;
+    ss->count++;
+}
 
-    SymbolTable* t = &ctx->scope->locals;
-    if (!t->first) {
-        t->first = sym;
-    } else {
-        t->last->next = sym;
-    }
-    t->last = sym;
-    t->count++;
+// Innermost binding of name_atom in the current function, or -1.
+static int scope_binding(CheckContext* ctx, Atom name_atom) {
+    ScopeStack* ss = ctx->scopes;
+    if (!ss || name_atom >= ss->innermost_capacity) return -1;
+    int idx = ss->innermost[name_atom];
+    // bindings below frame_start belong to a caller whose body is still being checked
+    if (idx < 0 || (size_t)idx < ss->frame_start) return -1;
+    return idx;
 }
 
-static Symbol* scope_lookup(CheckContext* ctx, char* name, size_t name_size) {
-    for (Scope* s = ctx->scope; s; s = s->parent) {
-        Symbol* sym = symbol_find(&s->locals, name, name_size);
-        if (sym) return sym;
-    }
+// Binding of name_atom declared directly in the innermost block, if any.
+// ConstEval lookup hook: names bound in the body being checked.
+static bool scope_const_decl(void* data, Atom name_atom, Node** decl) {
+    CheckContext* ctx = data;
+    int idx = scope_binding(ctx, name_atom);
+    if (idx < 0) return false;
+    Symbol* sym = ctx->scopes->bindings[idx].sym;
+    bool is_const = sym->kind == SYMBOL_CONST && sym->node && sym->node->type == NODE_CONST_DECL;
+    *decl = is_const ? sym->node : NULL;
+    return true;
+}
+
+static Symbol* scope_find_local(CheckContext* ctx, Atom name_atom) {
+    int idx = scope_binding(ctx, name_atom);
+    if (idx < 0 || (size_t)idx < ctx->scopes->scope_start) return NULL;
+    return ctx->scopes->bindings[idx].sym;
+}
+
+static Symbol* scope_lookup(CheckContext* ctx, Atom name_atom) {
+    int idx = scope_binding(ctx, name_atom);
+    if (idx >= 0) return ctx->scopes->bindings[idx].sym;
     // fall back to module symbols
-    return symbol_find(ctx->mod->symbols, name, name_size);
+    return symbol_find_atom(ctx->mod->symbols, name_atom);
 }
 
 static Type* get_symbol_type(Symbol* sym) {
@@ -474,56 +885,190 @@ static Type* unwrap_to_interface(Type* type) {
 }
 
 // check if a struct satisfies an interface (has all required methods with matching signatures)
-static bool check_interface_satisfaction(CheckContext* ctx, Type* struct_type, Type* iface_type) {
-    if (!struct_type || !iface_type) return false;
-    if (struct_type->kind != TYPE_STRUCT || iface_type->kind != TYPE_INTERFACE) return false;
-
-    NodeList* iface_sigs = iface_type->as.interface_type.method_sigs;
-    NodeList* struct_methods = struct_type->as.struct_type.methods;
+// and fill in the vtable slot mapping
+static bool check_interface_satisfaction(CheckContext* ctx, ImplEntry* entry) {
+    Type* struct_type = entry->struct_type;
+    NodeList* iface_sigs = entry->interface_type->as.interface_type.method_sigs;
 
+    entry->methods = arena_alloc(ctx->arena, sizeof(Node*) * (iface_sigs->count + 1));
     for (size_t i = 0; i < iface_sigs->count; i++) {
         Node* sig = iface_sigs->nodes[i];
+        entry->methods[i] = NULL;
         if (sig->type != NODE_FUNC_DECL) continue;
 
-        char* sig_name = sig->as.func_decl.name;
-        size_t sig_name_size = sig->as.func_decl.name_size;
-
         // find matching method on struct
-        bool found = false;
-        for (size_t j = 0; j < struct_methods->count; j++) {
-            Node* m = struct_methods->nodes[j];
-            if (m->type != NODE_FUNC_DECL) continue;
-            if (m->as.func_decl.name_size == sig_name_size &&
-                memcmp(m->as.func_decl.name, sig_name, sig_name_size) == 0) {
-                // check param count matches
-                if (m->as.func_decl.params.count != sig->as.func_decl.params.count) {
-                    return false;
-                }
-                // check type param count matches (generic methods)
-                if (m->as.func_decl.type_params.count != sig->as.func_decl.type_params.count) {
-                    return false;
-                }
-                found = true;
-                break;
-            }
+        Node* m = struct_find_method(struct_type, sig->as.func_decl.name_atom);
+        if (!m) return false;
+        // check param count matches
+        if (m->as.func_decl.params.count != sig->as.func_decl.params.count) {
+            return false;
+        }
+        // check type param count matches (generic methods)
+        if (m->as.func_decl.type_params.count != sig->as.func_decl.type_params.count) {
+            return false;
         }
-        if (!found) return false;
+        entry->methods[i] = m;
     }
     return true;
 }
 
+static size_t impl_hash(Type* struct_type, Type* iface_type) {
+    uint64_t h = (uint64_t)(uintptr_t)struct_type * 0x9e3779b97f4a7c15ull;
+    h ^= (uint64_t)(uintptr_t)iface_type + (h << 6) + (h >> 2);
+    return (size_t)(h ^ (h >> 29));
+}
+
+static void impl_cache_put(ImplEntry** slots, size_t capacity, ImplEntry* entry) {
+    size_t mask = capacity - 1;
+    size_t i = impl_hash(entry->struct_type, entry->interface_type) & mask;
+    while (slots[i]) i = (i + 1) & mask;
+    slots[i] = entry;
+}
+
+// Memoized satisfaction check. Each (struct, interface) pair is checked once
+// per sema run no matter how many coercion sites mention it.
+static ImplEntry* impl_lookup(CheckContext* ctx, Type* struct_type, Type* iface_type) {
+    ImplCache* cache = ctx->impls;
+    if (cache->capacity) {
+        size_t mask = cache->capacity - 1;
+        for (size_t i = impl_hash(struct_type, iface_type) & mask; cache->slots[i]; i = (i + 1) & mask) {
+            ImplEntry* e = cache->slots[i];
+            if (e->struct_type == struct_type && e->interface_type == iface_type) return e;
+        }
+    }
+
+    ImplEntry* entry = arena_alloc(ctx->arena, sizeof(ImplEntry));
+    entry->struct_type = struct_type;
+    entry->interface_type = iface_type;
+    entry->uses = NULL;
+    entry->satisfied = check_interface_satisfaction(ctx, entry);
+
+    // keep the load factor under 1/2
+    if ((cache->count + 1) * 2 > cache->capacity) {
+        size_t capacity = cache->capacity ? cache->capacity * 2 : 64;
+        ImplEntry** slots = arena_alloc(ctx->arena, sizeof(ImplEntry*) * capacity);
+        memset(slots, 0, sizeof(ImplEntry*) * capacity);
+        for (size_t i = 0; i < cache->capacity; i++) {
+            if (cache->slots[i]) impl_cache_put(slots, capacity, cache->slots[i]);
+        }
+        cache->slots = slots;
+        cache->capacity = capacity;
+    }
+    impl_cache_put(cache->slots, cache->capacity, entry);
+    cache->count++;
+    return entry;
+}
+
+static void body_queue(CheckContext* ctx, Node* func, Module* mod, Type* self_type) {
+    func->as.func_decl.is_reached = true;
+
+    PendingList* list = ctx->pending;
+    if (list->count >= list->capacity) {
+        size_t new_cap = list->capacity == 0 ? 16 : list->capacity * 2;
+        PendingBody* new_items = realloc(list->items, new_cap * sizeof(PendingBody));
+        list->items = new_items;
+        list->capacity = new_cap;
+    }
+
+    PendingBody* item = &list->items[list->count++];
+    item->func = func;
+    item->mod = mod;
+    item->self_type = self_type;
+}
+
+// Methods of a generic struct instance are checked and emitted only once
+// checked code calls them or puts them in a vtable.
+static void method_reached(CheckContext* ctx, Node* method, Type* struct_type) {
+    if (!method || method->type != NODE_FUNC_DECL) return;
+    if (!method->as.func_decl.inst || method->as.func_decl.is_reached) return;
+    if (method->as.func_decl.type_params.count > 0) return;
+    body_queue(ctx, method, struct_type->as.struct_type.module, struct_type);
+}
+
+// Index of the tracked receiver `ident` names in the current body, or -1.
+static int receiver_find(CheckContext* ctx, Node* ident) {
+    if (!ident || ident->type != NODE_IDENTIFIER) return -1;
+    int idx = scope_binding(ctx, ident->as.identifier.name_atom);
+    if (idx < 0) return -1;
+    Node* decl = ctx->scopes->bindings[idx].sym->node;
+
+    ReceiverList* list = ctx->receivers;
+    for (size_t i = list->receiver_count; i > 0; i--) {
+        if (list->receivers[i - 1].decl == decl) return (int)(i - 1);
+    }
+    return -1;
+}
+
+// `var h: &Iface = <&Struct>` inside a non-instance body.
+static void receiver_add(CheckContext* ctx, Node* decl, Type* declared_type, Type* init_type) {
+    if (ctx->inst || !ctx->return_type) return;
+    if (!declared_type || declared_type->kind != TYPE_REF) return;
+    if (declared_type->as.ref_type.inner->kind != TYPE_INTERFACE) return;
+    if (!init_type || init_type->kind != TYPE_REF) return;
+    if (init_type->as.ref_type.inner->kind != TYPE_STRUCT) return;
+
+    ReceiverList* list = ctx->receivers;
+    if (list->receiver_count >= list->receiver_capacity) {
+        size_t new_cap = list->receiver_capacity == 0 ? 16 : list->receiver_capacity * 2;
+        list->receivers = realloc(list->receivers, new_cap * sizeof(KnownReceiver));
+        list->receiver_capacity = new_cap;
+    }
+    KnownReceiver* r = &list->receivers[list->receiver_count++];
+    r->decl = decl;
+    r->struct_type = init_type->as.ref_type.inner;
+    r->reassigned = false;
+}
+
+static void receiver_invalidate(CheckContext* ctx, Node* ident) {
+    int idx = receiver_find(ctx, ident);
+    if (idx >= 0) ctx->receivers->receivers[idx].reassigned = true;
+}
+
+static void receiver_call_add(CheckContext* ctx, Node* call) {
+    int idx = receiver_find(ctx, call->as.method_call.object);
+    if (idx < 0) return;
+
+    ReceiverList* list = ctx->receivers;
+    if (list->call_count >= list->call_capacity) {
+        size_t new_cap = list->call_capacity == 0 ? 16 : list->call_capacity * 2;
+        list->calls = realloc(list->calls, new_cap * sizeof(ReceiverCall));
+        list->call_capacity = new_cap;
+    }
+    ReceiverCall* c = &list->calls[list->call_count++];
+    c->call = call;
+    c->receiver = (size_t)idx;
+}
+
+// Once a body is checked, calls through receivers that were never reassigned
+// get their struct; the body's entries are then dropped.
+static void receivers_resolve(CheckContext* ctx, size_t receiver_start, size_t call_start) {
+    ReceiverList* list = ctx->receivers;
+    for (size_t i = call_start; i < list->call_count; i++) {
+        KnownReceiver* r = &list->receivers[list->calls[i].receiver];
+        if (!r->reassigned) list->calls[i].call->as.method_call.known_struct = r->struct_type;
+    }
+    list->receiver_count = receiver_start;
+    list->call_count = call_start;
+}
+
 // record a (struct, interface) implementation pair on the module
-static void impl_pair_add(Module* mod, Type* struct_type, Type* iface_type, Module* struct_mod) {
-    ImplPairList* list = &mod->impl_pairs;
+static void impl_pair_add(CheckContext* ctx, ImplEntry* entry) {
+    Module* mod = ctx->mod;
+    for (ImplUse* u = entry->uses; u; u = u->next) {
+        if (u->mod == mod) return;
+    }
 
-    // check for duplicate
-    for (size_t i = 0; i < list->count; i++) {
-        if (list->pairs[i].struct_type == struct_type &&
-            list->pairs[i].interface_type == iface_type) {
-            return;
-        }
+    // the vtable needs every method filling a slot
+    size_t slot_count = entry->interface_type->as.interface_type.method_sigs->count;
+    for (size_t i = 0; i < slot_count; i++) {
+        method_reached(ctx, entry->methods[i], entry->struct_type);
     }
+    ImplUse* use = arena_alloc(ctx->arena, sizeof(ImplUse));
+    use->mod = mod;
+    use->next = entry->uses;
+    entry->uses = use;
 
+    ImplPairList* list = &mod->impl_pairs;
     if (list->count >= list->capacity) {
         size_t new_cap = list->capacity == 0 ? 4 : list->capacity * 2;
         ImplPair* new_pairs = realloc(list->pairs, new_cap * sizeof(ImplPair));
@@ -531,10 +1076,17 @@ static void impl_pair_add(Module* mod, Type* struct_type, Type* iface_type, Modu
         list->capacity = new_cap;
     }
 
-    list->pairs[list->count].struct_type = struct_type;
-    list->pairs[list->count].interface_type = iface_type;
-    list->pairs[list->count].struct_module = struct_mod;
-    list->count++;
+    ImplPair* pair = &list->pairs[list->count++];
+    pair->struct_type = entry->struct_type;
+    pair->interface_type = entry->interface_type;
+    pair->struct_module = entry->struct_type->as.struct_type.module;
+    pair->methods = entry->methods;
+}
+
+// release() for `with`: zero params, no generic type params
+static bool struct_has_release(Type* struct_type) {
+    Node* m = struct_find_method(struct_type, ATOM_RELEASE);
+    return m && m->as.func_decl.params.count == 0 && m->as.func_decl.type_params.count == 0;
 }
 
 static bool is_lvalue(Node* node) {
@@ -591,14 +1143,14 @@ static bool check_iface_compat(CheckContext* ctx, Type* to, Type* from, Node* er
     Type* iface = unwrap_to_interface(to);
     Type* struc = unwrap_to_struct(from);
     if (iface && struc) {
-        if (check_interface_satisfaction(ctx, struc, iface)) {
-            impl_pair_add(ctx->mod, struc, iface, struc->as.struct_type.module);
+        ImplEntry* entry = impl_lookup(ctx, struc, iface);
+        if (entry->satisfied) {
+            impl_pair_add(ctx, entry);
             return true;
         }
-        errors_push(ctx->errors, SEVERITY_ERROR, error_node->offset,
-                    error_node->line, error_node->column,
-                    "struct '%s' does not satisfy interface '%s'",
-                    type_name(struc), type_name(iface));
+        errors_push_at(ctx->errors, SEVERITY_ERROR, error_node->loc,
+                       "struct '%s' does not satisfy interface '%s'",
+                       type_name(struc), type_name(iface));
         return true; // already reported
     }
     return false;
@@ -613,30 +1165,14 @@ static void check_func_body(CheckContext* ctx, Node* func_node);
 // Monomorphization engine for generics
 // ---------------------------------------------------------------------------
 
-typedef struct TypeSubst {
-    char** param_names;
-    size_t* param_name_sizes;
-    Type** concrete_types;
-    size_t count;
-} TypeSubst;
-
-static Type* subst_lookup(TypeSubst* subst, char* name, size_t name_size) {
-    for (size_t i = 0; i < subst->count; i++) {
-        if (subst->param_name_sizes[i] == name_size &&
-            memcmp(subst->param_names[i], name, name_size) == 0) {
-            return subst->concrete_types[i];
-        }
-    }
-    return NULL;
-}
-
 // Build mangled name: "max" + [int] -> "max__int", "Pair" + [int, float] -> "Pair__int__float"
 static char* build_mangled_name(Arena* arena, char* base, size_t base_size,
                                  Type** type_args, size_t type_arg_count, size_t* out_size) {
-    // estimate size
     size_t total = base_size;
     for (size_t i = 0; i < type_arg_count; i++) {
-        total += 2 + strlen(type_name(type_args[i])); // "__" + type name
+        size_t tlen;
+        type_mangle_name(arena, type_args[i], &tlen);
+        total += 2 + tlen; // "__" + type name
     }
     char* buf = arena_alloc(arena, total + 1);
     size_t pos = 0;
@@ -645,8 +1181,8 @@ static char* build_mangled_name(Arena* arena, char* base, size_t base_size,
     for (size_t i = 0; i < type_arg_count; i++) {
         buf[pos++] = '_';
         buf[pos++] = '_';
-        const char* tname = type_name(type_args[i]);
-        size_t tlen = strlen(tname);
+        size_t tlen;
+        char* tname = type_mangle_name(arena, type_args[i], &tlen);
         memcpy(buf + pos, tname, tlen);
         pos += tlen;
     }
@@ -655,15 +1191,40 @@ static char* build_mangled_name(Arena* arena, char* base, size_t base_size,
     return buf;
 }
 
+// Instances are keyed by template node + type arguments. Types are canonical,
+// so the key hashes and compares addresses only.
+static uint32_t generic_inst_hash(Node* template_decl, Type** type_args, size_t type_arg_count) {
+    uint64_t h = 1469598103934665603ull;
+    h = (h ^ (uint64_t)(uintptr_t)template_decl) * 1099511628211ull;
+    for (size_t i = 0; i < type_arg_count; i++) {
+        h = (h ^ (uint64_t)(uintptr_t)type_args[i]) * 1099511628211ull;
+    }
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+static void generic_inst_index_put(GenericInst** slots, size_t capacity, GenericInst* inst) {
+    size_t mask = capacity - 1;
+    size_t i = inst->hash & mask;
+    while (slots[i]) i = (i + 1) & mask;
+    slots[i] = inst;
+}
+
 // Find an existing generic instantiation for the same template + type args
 static GenericInst* find_generic_inst(Module* mod, Node* template_decl,
                                        Type** type_args, size_t type_arg_count) {
-    for (GenericInst* inst = mod->generic_insts.first; inst; inst = inst->next) {
+    GenericInstList* list = &mod->generic_insts;
+    if (!list->slots) return NULL;
+
+    uint32_t hash = generic_inst_hash(template_decl, type_args, type_arg_count);
+    size_t mask = list->slot_capacity - 1;
+    for (size_t i = hash & mask; list->slots[i]; i = (i + 1) & mask) {
+        GenericInst* inst = list->slots[i];
+        if (inst->hash != hash) continue;
         if (inst->template_decl != template_decl) continue;
         if (inst->type_arg_count != type_arg_count) continue;
         bool match = true;
-        for (size_t i = 0; i < type_arg_count; i++) {
-            if (!type_equals(inst->type_args[i], type_args[i])) {
+        for (size_t j = 0; j < type_arg_count; j++) {
+            if (inst->type_args[j] != type_args[j]) {
                 match = false;
                 break;
             }
@@ -674,370 +1235,238 @@ static GenericInst* find_generic_inst(Module* mod, Node* template_decl,
 }
 
 static void generic_inst_add(Arena* arena, Module* mod, GenericInst* inst) {
+    GenericInstList* list = &mod->generic_insts;
     inst->next = NULL;
-    if (!mod->generic_insts.first) {
-        mod->generic_insts.first = inst;
+    inst->hash = generic_inst_hash(inst->template_decl, inst->type_args, inst->type_arg_count);
+    if (!list->first) {
+        list->first = inst;
     } else {
-        mod->generic_insts.last->next = inst;
+        list->last->next = inst;
     }
-    mod->generic_insts.last = inst;
-}
-
-// Deep-copy an AST node, substituting type parameter names with concrete types
-static Node* deep_copy_node(Arena* arena, Node* src, TypeSubst* subst);
+    list->last = inst;
+    list->count++;
 
-static NodeList deep_copy_node_list(Arena* arena, NodeList* src, TypeSubst* subst) {
-    NodeList dst = {0};
-    for (size_t i = 0; i < src->count; i++) {
-        Node* copy = deep_copy_node(arena, src->nodes[i], subst);
-        if (copy) {
-            if (dst.count >= dst.capacity) {
-                size_t new_cap = dst.capacity < 8 ? 8 : dst.capacity * 2;
-                Node** new_nodes = arena_alloc(arena, new_cap * sizeof(Node*));
-                if (dst.nodes) memcpy(new_nodes, dst.nodes, dst.count * sizeof(Node*));
-                dst.nodes = new_nodes;
-                dst.capacity = new_cap;
-            }
-            dst.nodes[dst.count++] = copy;
+    // keep the load factor under 1/2
+    if (list->count * 2 > list->slot_capacity) {
+        size_t capacity = list->slot_capacity ? list->slot_capacity * 2 : 16;
+        GenericInst** slots = arena_alloc(arena, sizeof(GenericInst*) * capacity);
+        memset(slots, 0, sizeof(GenericInst*) * capacity);
+        for (GenericInst* g = list->first; g; g = g->next) {
+            generic_inst_index_put(slots, capacity, g);
         }
+        list->slots = slots;
+        list->slot_capacity = capacity;
+    } else {
+        generic_inst_index_put(list->slots, list->slot_capacity, inst);
     }
-    return dst;
-}
-
-static FieldList deep_copy_field_list(Arena* arena, FieldList* src, TypeSubst* subst) {
-    FieldList dst = {0};
-    if (src->count == 0) return dst;
-    dst.fields = arena_alloc(arena, src->count * sizeof(Field));
-    dst.count = src->count;
-    dst.capacity = src->count;
-    for (size_t i = 0; i < src->count; i++) {
-        dst.fields[i] = src->fields[i];
-        dst.fields[i].type_node = deep_copy_node(arena, src->fields[i].type_node, subst);
-    }
-    return dst;
-}
-
-static ParamList deep_copy_param_list(Arena* arena, ParamList* src, TypeSubst* subst) {
-    ParamList dst = {0};
-    if (src->count == 0) return dst;
-    dst.params = arena_alloc(arena, src->count * sizeof(Param));
-    dst.count = src->count;
-    dst.capacity = src->count;
-    for (size_t i = 0; i < src->count; i++) {
-        dst.params[i] = src->params[i];
-        dst.params[i].type_node = deep_copy_node(arena, src->params[i].type_node, subst);
-    }
-    return dst;
-}
-
-static FieldInitList deep_copy_field_init_list(Arena* arena, FieldInitList* src, TypeSubst* subst) {
-    FieldInitList dst = {0};
-    if (src->count == 0) return dst;
-    dst.inits = arena_alloc(arena, src->count * sizeof(FieldInit));
-    dst.count = src->count;
-    dst.capacity = src->count;
-    for (size_t i = 0; i < src->count; i++) {
-        dst.inits[i] = src->inits[i];
-        dst.inits[i].value = deep_copy_node(arena, src->inits[i].value, subst);
-    }
-    return dst;
 }
 
-static ElseIfList deep_copy_elseif_list(Arena* arena, ElseIfList* src, TypeSubst* subst) {
-    ElseIfList dst = {0};
-    if (src->count == 0) return dst;
-    dst.branches = arena_alloc(arena, src->count * sizeof(ElseIfBranch));
-    dst.count = src->count;
-    dst.capacity = src->count;
-    for (size_t i = 0; i < src->count; i++) {
-        dst.branches[i] = src->branches[i];
-        dst.branches[i].condition = deep_copy_node(arena, src->branches[i].condition, subst);
-        dst.branches[i].body = deep_copy_node_list(arena, &src->branches[i].body, subst);
-    }
-    return dst;
-}
+// forward declaration — needed because instantiate_generic_struct and resolve_generic_type are mutually recursive
+static Type* resolve_generic_type(CheckContext* ctx, Node* type_node);
 
-static MatchCaseList deep_copy_match_case_list(Arena* arena, MatchCaseList* src, TypeSubst* subst) {
-    MatchCaseList dst = {0};
-    if (src->count == 0) return dst;
-    dst.cases = arena_alloc(arena, src->count * sizeof(MatchCase));
-    dst.count = src->count;
-    dst.capacity = src->count;
-    for (size_t i = 0; i < src->count; i++) {
-        dst.cases[i] = src->cases[i];
-        dst.cases[i].values = deep_copy_node_list(arena, &src->cases[i].values, subst);
-        dst.cases[i].body = deep_copy_node_list(arena, &src->cases[i].body, subst);
+// A type argument that failed to resolve has already been reported.
+static bool type_args_resolved(Type** type_args, size_t type_arg_count) {
+    for (size_t i = 0; i < type_arg_count; i++) {
+        if (!type_args[i]) return false;
     }
-    return dst;
+    return true;
 }
 
-static Node* deep_copy_node(Arena* arena, Node* src, TypeSubst* subst) {
-    if (!src) return NULL;
-    Node* dst = arena_alloc(arena, sizeof(Node));
-    *dst = *src; // shallow copy first
-    dst->resolved_type = NULL; // clear — will be re-resolved
-
-    switch (src->type) {
-    // Type nodes — this is where substitution happens
-    case NODE_TYPE_SIMPLE: {
-        // Check if this type name is a type parameter
-        Type* concrete = subst_lookup(subst, src->as.type_simple.name, src->as.type_simple.name_size);
-        if (concrete) {
-            // Replace with a concrete type node
-            // We keep it as NODE_TYPE_SIMPLE but change the name to the concrete type's name
-            const char* cname = type_name(concrete);
-            size_t clen = strlen(cname);
-            char* name_copy = arena_alloc(arena, clen);
-            memcpy(name_copy, cname, clen);
-            dst->as.type_simple.name = name_copy;
-            dst->as.type_simple.name_size = clen;
-            // Pre-resolve it so resolve_type_node finds it
-            dst->resolved_type = concrete;
-        }
-        // Deep-copy type_args so e.g. Node[T] becomes Node[int]
-        dst->as.type_simple.type_args = deep_copy_node_list(arena, &src->as.type_simple.type_args, subst);
-        break;
-    }
-    case NODE_TYPE_REFERENCE:
-        dst->as.type_ref.inner = deep_copy_node(arena, src->as.type_ref.inner, subst);
-        break;
-    case NODE_TYPE_POINTER:
-        dst->as.type_ptr.inner = deep_copy_node(arena, src->as.type_ptr.inner, subst);
-        break;
-    case NODE_TYPE_ARRAY:
-        dst->as.type_array.inner = deep_copy_node(arena, src->as.type_array.inner, subst);
-        dst->as.type_array.size_expr = deep_copy_node(arena, src->as.type_array.size_expr, subst);
-        break;
-    case NODE_TYPE_SLICE:
-        dst->as.type_slice.inner = deep_copy_node(arena, src->as.type_slice.inner, subst);
-        break;
-
-    // Declaration nodes
-    case NODE_FUNC_DECL:
-        dst->as.func_decl.type_params.count = 0; // no longer generic
-        dst->as.func_decl.type_params.params = NULL;
-        dst->as.func_decl.params = deep_copy_param_list(arena, &src->as.func_decl.params, subst);
-        dst->as.func_decl.return_type = deep_copy_node(arena, src->as.func_decl.return_type, subst);
-        dst->as.func_decl.body = deep_copy_node_list(arena, &src->as.func_decl.body, subst);
-        break;
-    case NODE_STRUCT_DECL:
-        dst->as.struct_decl.type_params.count = 0; // no longer generic
-        dst->as.struct_decl.type_params.params = NULL;
-        dst->as.struct_decl.fields = deep_copy_field_list(arena, &src->as.struct_decl.fields, subst);
-        dst->as.struct_decl.methods = deep_copy_node_list(arena, &src->as.struct_decl.methods, subst);
-        break;
-
-    // Statement nodes
-    case NODE_RETURN_STMT:
-        dst->as.return_stmt.value = deep_copy_node(arena, src->as.return_stmt.value, subst);
-        dst->as.return_stmt.cleanup = deep_copy_node_list(arena, &src->as.return_stmt.cleanup, subst);
-        break;
-    case NODE_IF_STMT:
-        dst->as.if_stmt.condition = deep_copy_node(arena, src->as.if_stmt.condition, subst);
-        dst->as.if_stmt.then_body = deep_copy_node_list(arena, &src->as.if_stmt.then_body, subst);
-        dst->as.if_stmt.elseifs = deep_copy_elseif_list(arena, &src->as.if_stmt.elseifs, subst);
-        dst->as.if_stmt.else_body = deep_copy_node_list(arena, &src->as.if_stmt.else_body, subst);
-        break;
-    case NODE_FOR_STMT:
-        dst->as.for_stmt.start = deep_copy_node(arena, src->as.for_stmt.start, subst);
-        dst->as.for_stmt.end = deep_copy_node(arena, src->as.for_stmt.end, subst);
-        dst->as.for_stmt.step = deep_copy_node(arena, src->as.for_stmt.step, subst);
-        dst->as.for_stmt.body = deep_copy_node_list(arena, &src->as.for_stmt.body, subst);
-        break;
-    case NODE_WHILE_STMT:
-        dst->as.while_stmt.condition = deep_copy_node(arena, src->as.while_stmt.condition, subst);
-        dst->as.while_stmt.body = deep_copy_node_list(arena, &src->as.while_stmt.body, subst);
-        break;
-    case NODE_WITH_STMT:
-        dst->as.with_stmt.resource = deep_copy_node(arena, src->as.with_stmt.resource, subst);
-        dst->as.with_stmt.release = deep_copy_node(arena, src->as.with_stmt.release, subst);
-        dst->as.with_stmt.body = deep_copy_node_list(arena, &src->as.with_stmt.body, subst);
-        break;
-    case NODE_MATCH_STMT:
-        dst->as.match_stmt.subject = deep_copy_node(arena, src->as.match_stmt.subject, subst);
-        dst->as.match_stmt.cases = deep_copy_match_case_list(arena, &src->as.match_stmt.cases, subst);
-        dst->as.match_stmt.else_body = deep_copy_node_list(arena, &src->as.match_stmt.else_body, subst);
-        break;
-    case NODE_ASSIGN_STMT:
-        dst->as.assign_stmt.target = deep_copy_node(arena, src->as.assign_stmt.target, subst);
-        dst->as.assign_stmt.value = deep_copy_node(arena, src->as.assign_stmt.value, subst);
-        break;
-    case NODE_COMPOUND_ASSIGN_STMT:
-        dst->as.compound_assign_stmt.target = deep_copy_node(arena, src->as.compound_assign_stmt.target, subst);
-        dst->as.compound_assign_stmt.value = deep_copy_node(arena, src->as.compound_assign_stmt.value, subst);
-        break;
-    case NODE_EXPR_STMT:
-        dst->as.expr_stmt.expr = deep_copy_node(arena, src->as.expr_stmt.expr, subst);
-        break;
-    case NODE_VAR_DECL:
-        dst->as.var_decl.type_node = deep_copy_node(arena, src->as.var_decl.type_node, subst);
-        dst->as.var_decl.value = deep_copy_node(arena, src->as.var_decl.value, subst);
-        break;
-    case NODE_CONST_DECL:
-        dst->as.const_decl.type_node = deep_copy_node(arena, src->as.const_decl.type_node, subst);
-        dst->as.const_decl.value = deep_copy_node(arena, src->as.const_decl.value, subst);
-        break;
-
-    // Expression nodes
-    case NODE_BINARY_EXPR:
-        dst->as.binary_expr.left = deep_copy_node(arena, src->as.binary_expr.left, subst);
-        dst->as.binary_expr.right = deep_copy_node(arena, src->as.binary_expr.right, subst);
-        break;
-    case NODE_UNARY_EXPR:
-        dst->as.unary_expr.operand = deep_copy_node(arena, src->as.unary_expr.operand, subst);
-        break;
-    case NODE_PAREN_EXPR:
-        dst->as.paren_expr.inner = deep_copy_node(arena, src->as.paren_expr.inner, subst);
-        break;
-    case NODE_CALL_EXPR:
-        dst->as.call_expr.callee = deep_copy_node(arena, src->as.call_expr.callee, subst);
-        dst->as.call_expr.args = deep_copy_node_list(arena, &src->as.call_expr.args, subst);
-        dst->as.call_expr.type_args = deep_copy_node_list(arena, &src->as.call_expr.type_args, subst);
-        break;
-    case NODE_FIELD_ACCESS:
-        dst->as.field_access.object = deep_copy_node(arena, src->as.field_access.object, subst);
-        break;
-    case NODE_METHOD_CALL:
-        dst->as.method_call.object = deep_copy_node(arena, src->as.method_call.object, subst);
-        dst->as.method_call.args = deep_copy_node_list(arena, &src->as.method_call.args, subst);
-        dst->as.method_call.type_args = deep_copy_node_list(arena, &src->as.method_call.type_args, subst);
-        break;
-    case NODE_STRUCT_LITERAL:
-        dst->as.struct_literal.fields = deep_copy_field_init_list(arena, &src->as.struct_literal.fields, subst);
-        dst->as.struct_literal.type_args = deep_copy_node_list(arena, &src->as.struct_literal.type_args, subst);
-        break;
-    case NODE_CAST_EXPR:
-        dst->as.cast_expr.expr = deep_copy_node(arena, src->as.cast_expr.expr, subst);
-        dst->as.cast_expr.target_type = deep_copy_node(arena, src->as.cast_expr.target_type, subst);
-        break;
-    case NODE_SIZEOF_EXPR:
-        dst->as.sizeof_expr.type_node = deep_copy_node(arena, src->as.sizeof_expr.type_node, subst);
-        break;
-    case NODE_ARRAY_LITERAL:
-        dst->as.array_literal.elements = deep_copy_node_list(arena, &src->as.array_literal.elements, subst);
-        break;
-    case NODE_INDEX_EXPR:
-        dst->as.index_expr.object = deep_copy_node(arena, src->as.index_expr.object, subst);
-        dst->as.index_expr.index = deep_copy_node(arena, src->as.index_expr.index, subst);
-        break;
-
-    // Leaf nodes — no children to copy
-    case NODE_INTEGER_LITERAL:
-    case NODE_FLOAT_LITERAL:
-    case NODE_STRING_LITERAL:
-    case NODE_BOOL_LITERAL:
-    case NODE_NULL_LITERAL:
-    case NODE_IDENTIFIER:
-    case NODE_SELF:
-        break;
-    case NODE_BREAK_STMT:
-        dst->as.break_stmt.cleanup = deep_copy_node_list(arena, &src->as.break_stmt.cleanup, subst);
-        break;
-    case NODE_CONTINUE_STMT:
-        dst->as.continue_stmt.cleanup = deep_copy_node_list(arena, &src->as.continue_stmt.cleanup, subst);
-        break;
-
-    default:
-        break;
-    }
-
-    return dst;
+// Instantiations requested from instance bodies nest; without a bound a
+// template instantiating itself with a larger type (f[T] calling f[Box[T]])
+// would never run out of new instances.
+static bool inst_depth_ok(CheckContext* ctx, Node* template_decl, char* name, size_t name_size) {
+    if (!ctx->inst || ctx->inst->depth < MAX_INST_DEPTH) return true;
+    errors_push_at(ctx->errors, SEVERITY_ERROR, template_decl->loc,
+                   "generic '%.*s' is instantiated more than %d levels deep",
+                   (int)name_size, name, MAX_INST_DEPTH);
+    return false;
 }
 
-// Build a TypeSubst from template type params and concrete type args
-static TypeSubst build_subst(Arena* arena, TypeParamList* params, Type** type_args, size_t type_arg_count) {
-    TypeSubst subst;
-    subst.count = params->count;
-    subst.param_names = arena_alloc(arena, sizeof(char*) * subst.count);
-    subst.param_name_sizes = arena_alloc(arena, sizeof(size_t) * subst.count);
-    subst.concrete_types = arena_alloc(arena, sizeof(Type*) * subst.count);
-    for (size_t i = 0; i < subst.count; i++) {
-        subst.param_names[i] = params->params[i].name;
-        subst.param_name_sizes[i] = params->params[i].name_size;
-        subst.concrete_types[i] = (i < type_arg_count) ? type_args[i] : NULL;
-    }
-    return subst;
+// A bounded type param takes a struct satisfying its interface (called
+// directly in the instance body), or the interface itself.
+static bool type_args_satisfy_bounds(CheckContext* ctx, TypeParamList* params,
+                                     Type** type_args, Node* site, char* name, size_t name_size) {
+    bool ok = true;
+    for (size_t i = 0; i < params->count; i++) {
+        Node* bound = params->params[i].bound;
+        if (!bound || !bound->resolved_type) continue;
+        Type* iface = (Type*)bound->resolved_type;
+        Type* st = unwrap_to_struct(type_args[i]);
+        if (st && impl_lookup(ctx, st, iface)->satisfied) continue;
+        if (unwrap_to_interface(type_args[i]) == iface) continue;
+        errors_push_at(ctx->errors, SEVERITY_ERROR, site->loc,
+                       "type '%s' does not satisfy bound '%s' of type parameter '%.*s' of '%.*s'",
+                       type_name(type_args[i]), type_name(iface),
+                       (int)params->params[i].name_size, params->params[i].name,
+                       (int)name_size, name);
+        ok = false;
+    }
+    return ok;
 }
 
-// forward declaration — needed because instantiate_generic_struct and resolve_generic_type are mutually recursive
-static Type* resolve_generic_type(CheckContext* ctx, Node* type_node);
-
-// Register a generic instantiation and add it to the module's inst list.
-static GenericInst* register_generic_inst(CheckContext* ctx, Node* template_decl,
+// A new instantiation binding the template's type params to type_args.
+static GenericInst* generic_inst_new(CheckContext* ctx, Node* template_decl, TypeParamList* params,
     Type** type_args, size_t type_arg_count,
-    char* mangled, size_t mangled_size,
-    Node* mono, Type* resolved_type) {
+    char* mangled, size_t mangled_size, Atom mangled_atom) {
     GenericInst* inst = arena_alloc(ctx->arena, sizeof(GenericInst));
-    inst->next = NULL;
+    memset(inst, 0, sizeof(GenericInst));
     inst->template_decl = template_decl;
+    inst->param_atoms = arena_alloc(ctx->arena, sizeof(Atom) * type_arg_count);
+    for (size_t i = 0; i < type_arg_count; i++) {
+        inst->param_atoms[i] = params->params[i].name_atom;
+    }
     inst->type_args = arena_alloc(ctx->arena, sizeof(Type*) * type_arg_count);
     memcpy(inst->type_args, type_args, sizeof(Type*) * type_arg_count);
     inst->type_arg_count = type_arg_count;
     inst->mangled_name = mangled;
     inst->mangled_name_size = mangled_size;
+    inst->mangled_name_atom = mangled_atom;
+    inst->depth = ctx->inst ? ctx->inst->depth + 1 : 0;
+
+    // instances after the first know how many nodes their template numbers
+    inst->layout = template_layout(ctx->arena, template_decl);
+    if (inst->layout->count > 0) inst_arrays_grow(ctx->arena, inst, inst->layout->count);
+    return inst;
+}
+
+// Register a generic instantiation and add it to the module's inst list.
+static void register_generic_inst(CheckContext* ctx, GenericInst* inst,
+                                  Node* mono, Type* resolved_type) {
     inst->mono_decl = mono;
     inst->resolved_type = resolved_type;
     generic_inst_add(ctx->arena, ctx->mod, inst);
-    return inst;
+}
+
+// Declaration node for an instance: a copy of the template's node alone,
+// sharing params, body and all other children with the template.
+static Node* instance_header(Arena* arena, Node* template_decl) {
+    if (template_decl->type == NODE_FUNC_DECL) parser_func_body(template_decl);
+    size_t size = node_size(template_decl->type);
+    Node* header = arena_alloc(arena, size);
+    memcpy(header, template_decl, size);
+    header->resolved_type = NULL;
+    return header;
+}
+
+// Function type of an instance's signature, resolved under its bindings.
+static Type* resolve_instance_signature(CheckContext* ctx, GenericInst* inst, Node* mono) {
+    GenericInst* prev_inst = ctx->inst;
+    ctx->inst = inst;
+
+    ParamList* params = &mono->as.func_decl.params;
+    int param_count = (int)params->count;
+    Type** param_types = NULL;
+    if (param_count > 0) {
+        param_types = arena_alloc(ctx->arena, sizeof(Type*) * param_count);
+        for (int i = 0; i < param_count; i++) {
+            param_types[i] = resolve_generic_type(ctx, params->params[i].type_node);
+        }
+    }
+    Type* ret = NULL;
+    if (mono->as.func_decl.return_type) {
+        ret = resolve_generic_type(ctx, mono->as.func_decl.return_type);
+    } else {
+        ret = type_void(ctx->reg);
+    }
+
+    ctx->inst = prev_inst;
+    return type_func(ctx->reg, param_types, param_count, ret);
 }
 
 // Instantiate a generic struct with concrete type arguments.
 // Returns the resolved Type* for the instantiation.
 static Type* instantiate_generic_struct(CheckContext* ctx, Node* template_decl,
-                                         Type** type_args, size_t type_arg_count) {
+                                         Type** type_args, size_t type_arg_count, Node* site) {
     TypeParamList* params = &template_decl->as.struct_decl.type_params;
     if (type_arg_count != params->count) {
-        errors_push(ctx->errors, SEVERITY_ERROR, template_decl->offset,
-                    template_decl->line, template_decl->column,
-                    "generic struct '%.*s' expects %d type arguments, got %d",
-                    (int)template_decl->as.struct_decl.name_size,
-                    template_decl->as.struct_decl.name,
-                    (int)params->count, (int)type_arg_count);
+        errors_push_at(ctx->errors, SEVERITY_ERROR, template_decl->loc,
+                       "generic struct '%.*s' expects %d type arguments, got %d",
+                       (int)template_decl->as.struct_decl.name_size,
+                       template_decl->as.struct_decl.name,
+                       (int)params->count, (int)type_arg_count);
         return NULL;
     }
 
+    if (!type_args_resolved(type_args, type_arg_count)) return NULL;
+
     // dedup
     GenericInst* existing = find_generic_inst(ctx->mod, template_decl, type_args, type_arg_count);
     if (existing) return existing->resolved_type;
+    if (!type_args_satisfy_bounds(ctx, params, type_args, site, template_decl->as.struct_decl.name,
+                                  template_decl->as.struct_decl.name_size)) return NULL;
+    if (!inst_depth_ok(ctx, template_decl, template_decl->as.struct_decl.name,
+                       template_decl->as.struct_decl.name_size)) return NULL;
 
-    // build substitution and mangled name
-    TypeSubst subst = build_subst(ctx->arena, params, type_args, type_arg_count);
     size_t mangled_size;
     char* mangled = build_mangled_name(ctx->arena,
         template_decl->as.struct_decl.name,
         template_decl->as.struct_decl.name_size,
         type_args, type_arg_count, &mangled_size);
+    Atom mangled_atom = intern(mangled, mangled_size);
+    GenericInst* inst = generic_inst_new(ctx, template_decl, params, type_args, type_arg_count,
+                                         mangled, mangled_size, mangled_atom);
 
-    // deep-copy the template
-    Node* mono = deep_copy_node(ctx->arena, template_decl, &subst);
+    Node* mono = instance_header(ctx->arena, template_decl);
     mono->as.struct_decl.name = mangled;
     mono->as.struct_decl.name_size = mangled_size;
+    mono->as.struct_decl.name_atom = mangled_atom;
+    mono->as.struct_decl.type_params.count = 0; // no longer generic
+    mono->as.struct_decl.type_params.params = NULL;
+
+    // each field gets its own type node to carry the instance's field type
+    FieldList* template_fields = &template_decl->as.struct_decl.fields;
+    FieldList* fields = &mono->as.struct_decl.fields;
+    if (fields->count > 0) {
+        fields->fields = arena_alloc(ctx->arena, sizeof(Field) * fields->count);
+        for (size_t i = 0; i < fields->count; i++) {
+            fields->fields[i] = template_fields->fields[i];
+            if (fields->fields[i].type_node) {
+                fields->fields[i].type_node = instance_header(ctx->arena, fields->fields[i].type_node);
+            }
+        }
+    }
+
+    // each method gets a header bound to this instance
+    NodeList* methods = &mono->as.struct_decl.methods;
+    if (methods->count > 0) {
+        Node** template_methods = methods->nodes;
+        methods->nodes = arena_alloc(ctx->arena, sizeof(Node*) * methods->count);
+        for (size_t i = 0; i < methods->count; i++) {
+            Node* method = template_methods[i];
+            if (method->type == NODE_FUNC_DECL) {
+                // headers of a generic method share one numbering across struct instances
+                if (method->as.func_decl.type_params.count > 0) template_layout(ctx->arena, method);
+                method = instance_header(ctx->arena, method);
+                method->as.func_decl.inst = inst;
+            }
+            methods->nodes[i] = method;
+        }
+    }
 
     // create the struct type
-    Type* t = type_struct(ctx->reg, mangled, mangled_size, ctx->mod,
-                           &mono->as.struct_decl.fields, &mono->as.struct_decl.methods);
+    Type* t = type_struct(ctx->reg, mangled, mangled_size, ctx->mod, fields, methods);
     mono->resolved_type = t;
+    struct_method_index_build(ctx->arena, t);
 
     // register the instantiation BEFORE resolving fields to break self-referential cycles
     // (e.g. struct Node[T] { next: *Node[T] } — resolving *Node[int] re-enters instantiate_generic_struct)
-    register_generic_inst(ctx, template_decl, type_args, type_arg_count,
-                          mangled, mangled_size, mono, t);
+    register_generic_inst(ctx, inst, mono, t);
 
     // add a symbol for the monomorphized struct so codegen can find it
-    symbol_add(ctx->arena, ctx->mod->symbols, SYMBOL_STRUCT, mangled, mangled_size,
+    symbol_add(ctx->arena, ctx->mod->symbols, SYMBOL_STRUCT, mangled, mangled_size, mangled_atom,
                template_decl->as.struct_decl.is_export, mono);
 
     // resolve field types (use resolve_generic_type for fields like *Node[int])
-    FieldList* fields = &mono->as.struct_decl.fields;
+    GenericInst* prev_inst = ctx->inst;
+    ctx->inst = inst;
     for (size_t i = 0; i < fields->count; i++) {
         if (fields->fields[i].type_node) {
-            Type* ft = (Type*)fields->fields[i].type_node->resolved_type;
-            if (!ft) {
-                ft = resolve_generic_type(ctx, fields->fields[i].type_node);
-                fields->fields[i].type_node->resolved_type = ft;
-            }
+            fields->fields[i].type_node->resolved_type =
+                resolve_generic_type(ctx, template_fields->fields[i].type_node);
         }
     }
+    ctx->inst = prev_inst;
 
     return t;
 }
@@ -1045,72 +1474,56 @@ static Type* instantiate_generic_struct(CheckContext* ctx, Node* template_decl,
 // Instantiate a generic function with concrete type arguments.
 // Returns the resolved Type* for the instantiation.
 static Type* instantiate_generic_func(CheckContext* ctx, Node* template_decl,
-                                       Type** type_args, size_t type_arg_count) {
+                                       Type** type_args, size_t type_arg_count, Node* site) {
     TypeParamList* params = &template_decl->as.func_decl.type_params;
     if (type_arg_count != params->count) {
-        errors_push(ctx->errors, SEVERITY_ERROR, template_decl->offset,
-                    template_decl->line, template_decl->column,
-                    "generic function '%.*s' expects %d type arguments, got %d",
-                    (int)template_decl->as.func_decl.name_size,
-                    template_decl->as.func_decl.name,
-                    (int)params->count, (int)type_arg_count);
+        errors_push_at(ctx->errors, SEVERITY_ERROR, template_decl->loc,
+                       "generic function '%.*s' expects %d type arguments, got %d",
+                       (int)template_decl->as.func_decl.name_size,
+                       template_decl->as.func_decl.name,
+                       (int)params->count, (int)type_arg_count);
         return NULL;
     }
 
+    if (!type_args_resolved(type_args, type_arg_count)) return NULL;
+
     // dedup
     GenericInst* existing = find_generic_inst(ctx->mod, template_decl, type_args, type_arg_count);
     if (existing) return existing->resolved_type;
+    if (!type_args_satisfy_bounds(ctx, params, type_args, site, template_decl->as.func_decl.name,
+                                  template_decl->as.func_decl.name_size)) return NULL;
+    if (!inst_depth_ok(ctx, template_decl, template_decl->as.func_decl.name,
+                       template_decl->as.func_decl.name_size)) return NULL;
 
-    // build substitution and mangled name
-    TypeSubst subst = build_subst(ctx->arena, params, type_args, type_arg_count);
     size_t mangled_size;
     char* mangled = build_mangled_name(ctx->arena,
         template_decl->as.func_decl.name,
         template_decl->as.func_decl.name_size,
         type_args, type_arg_count, &mangled_size);
+    Atom mangled_atom = intern(mangled, mangled_size);
+    GenericInst* inst = generic_inst_new(ctx, template_decl, params, type_args, type_arg_count,
+                                         mangled, mangled_size, mangled_atom);
 
-    // deep-copy the template
-    Node* mono = deep_copy_node(ctx->arena, template_decl, &subst);
+    Node* mono = instance_header(ctx->arena, template_decl);
     mono->as.func_decl.name = mangled;
     mono->as.func_decl.name_size = mangled_size;
+    mono->as.func_decl.name_atom = mangled_atom;
+    mono->as.func_decl.type_params.count = 0; // no longer generic
+    mono->as.func_decl.type_params.params = NULL;
+    mono->as.func_decl.inst = inst;
 
-    // resolve function type
-    ParamList* mono_params = &mono->as.func_decl.params;
-    int param_count = (int)mono_params->count;
-    Type** param_types = NULL;
-    if (param_count > 0) {
-        param_types = arena_alloc(ctx->arena, sizeof(Type*) * param_count);
-        for (int i = 0; i < param_count; i++) {
-            Type* pt = (Type*)mono_params->params[i].type_node->resolved_type;
-            if (!pt) {
-                pt = resolve_generic_type(ctx, mono_params->params[i].type_node);
-            }
-            param_types[i] = pt;
-        }
-    }
-    Type* ret = NULL;
-    if (mono->as.func_decl.return_type) {
-        ret = (Type*)mono->as.func_decl.return_type->resolved_type;
-        if (!ret) {
-            ret = resolve_generic_type(ctx, mono->as.func_decl.return_type);
-        }
-    } else {
-        ret = type_void(ctx->reg);
-    }
-
-    Type* func_t = type_func(ctx->reg, param_types, param_count, ret);
+    Type* func_t = resolve_instance_signature(ctx, inst, mono);
     mono->resolved_type = func_t;
 
     // register the instantiation
-    register_generic_inst(ctx, template_decl, type_args, type_arg_count,
-                          mangled, mangled_size, mono, func_t);
+    register_generic_inst(ctx, inst, mono, func_t);
 
     // add a symbol for the monomorphized function
-    symbol_add(ctx->arena, ctx->mod->symbols, SYMBOL_FUNC, mangled, mangled_size,
+    symbol_add(ctx->arena, ctx->mod->symbols, SYMBOL_FUNC, mangled, mangled_size, mangled_atom,
                template_decl->as.func_decl.is_export, mono);
 
-    // type-check the monomorphized body
-    check_func_body(ctx, mono);
+    // the body is checked from the queue, under this instance
+    body_queue(ctx, mono, ctx->mod, NULL);
 
     return func_t;
 }
@@ -1121,24 +1534,26 @@ static Type* instantiate_generic_func(CheckContext* ctx, Node* template_decl,
 // standalone function (SYMBOL_FUNC) with mangled name struct__method__TypeArgs.
 static Type* instantiate_generic_method(CheckContext* ctx, Node* template_decl,
                                          Type* struct_type, Type** type_args,
-                                         size_t type_arg_count) {
+                                         size_t type_arg_count, Node* site) {
     TypeParamList* params = &template_decl->as.func_decl.type_params;
     if (type_arg_count != params->count) {
-        errors_push(ctx->errors, SEVERITY_ERROR, template_decl->offset,
-                    template_decl->line, template_decl->column,
-                    "generic method '%.*s' expects %d type arguments, got %d",
-                    (int)template_decl->as.func_decl.name_size,
-                    template_decl->as.func_decl.name,
-                    (int)params->count, (int)type_arg_count);
+        errors_push_at(ctx->errors, SEVERITY_ERROR, template_decl->loc,
+                       "generic method '%.*s' expects %d type arguments, got %d",
+                       (int)template_decl->as.func_decl.name_size,
+                       template_decl->as.func_decl.name,
+                       (int)params->count, (int)type_arg_count);
         return NULL;
     }
 
+    if (!type_args_resolved(type_args, type_arg_count)) return NULL;
+
     // dedup
     GenericInst* existing = find_generic_inst(ctx->mod, template_decl, type_args, type_arg_count);
     if (existing) return existing->resolved_type;
-
-    // build substitution map
-    TypeSubst subst = build_subst(ctx->arena, params, type_args, type_arg_count);
+    if (!type_args_satisfy_bounds(ctx, params, type_args, site, template_decl->as.func_decl.name,
+                                  template_decl->as.func_decl.name_size)) return NULL;
+    if (!inst_depth_ok(ctx, template_decl, template_decl->as.func_decl.name,
+                       template_decl->as.func_decl.name_size)) return NULL;
 
     // build mangled name: struct_name__method_name__TypeArgs
     // First build "struct__method" base name
@@ -1157,57 +1572,35 @@ static Type* instantiate_generic_method(CheckContext* ctx, Node* template_decl,
     size_t mangled_size;
     char* mangled = build_mangled_name(ctx->arena, base, base_size,
                                         type_args, type_arg_count, &mangled_size);
+    Atom mangled_atom = intern(mangled, mangled_size);
+    GenericInst* inst = generic_inst_new(ctx, template_decl, params, type_args, type_arg_count,
+                                         mangled, mangled_size, mangled_atom);
+    // a method of a generic struct instance also sees the struct's bindings
+    inst->outer = template_decl->as.func_decl.inst;
 
-    // deep-copy the template with type substitutions
-    Node* mono = deep_copy_node(ctx->arena, template_decl, &subst);
+    Node* mono = instance_header(ctx->arena, template_decl);
     mono->as.func_decl.name = mangled;
     mono->as.func_decl.name_size = mangled_size;
+    mono->as.func_decl.name_atom = mangled_atom;
+    mono->as.func_decl.type_params.count = 0; // no longer generic
+    mono->as.func_decl.type_params.params = NULL;
     mono->as.func_decl.method_of = struct_type; // mark as monomorphized method
+    mono->as.func_decl.inst = inst;
 
-    // Build function type: (params...) -> return_type
     // The type matches the method's declared params (no self).
     // Codegen will add self to the C signature separately.
-    ParamList* mono_params = &mono->as.func_decl.params;
-    int param_count = (int)mono_params->count;
-    Type** param_types = NULL;
-    if (param_count > 0) {
-        param_types = arena_alloc(ctx->arena, sizeof(Type*) * param_count);
-        for (int i = 0; i < param_count; i++) {
-            Type* pt = (Type*)mono_params->params[i].type_node->resolved_type;
-            if (!pt) {
-                pt = resolve_generic_type(ctx, mono_params->params[i].type_node);
-            }
-            param_types[i] = pt;
-        }
-    }
-
-    Type* ret = NULL;
-    if (mono->as.func_decl.return_type) {
-        ret = (Type*)mono->as.func_decl.return_type->resolved_type;
-        if (!ret) {
-            ret = resolve_generic_type(ctx, mono->as.func_decl.return_type);
-        }
-    } else {
-        ret = type_void(ctx->reg);
-    }
-
-    Type* func_t = type_func(ctx->reg, param_types, param_count, ret);
+    Type* func_t = resolve_instance_signature(ctx, inst, mono);
     mono->resolved_type = func_t;
 
     // register the instantiation
-    register_generic_inst(ctx, template_decl, type_args, type_arg_count,
-                          mangled, mangled_size, mono, func_t);
+    register_generic_inst(ctx, inst, mono, func_t);
 
     // add a symbol for the monomorphized function
-    symbol_add(ctx->arena, ctx->mod->symbols, SYMBOL_FUNC, mangled, mangled_size,
+    symbol_add(ctx->arena, ctx->mod->symbols, SYMBOL_FUNC, mangled, mangled_size, mangled_atom,
                false, mono);
 
-    // type-check the monomorphized body with self_type set
-    Type* self_ref = type_ref(ctx->reg, struct_type);
-    Type* prev_self = ctx->self_type;
-    ctx->self_type = self_ref;
-    check_func_body(ctx, mono);
-    ctx->self_type = prev_self;
+    // the body is checked from the queue, under this instance with self_type set
+    body_queue(ctx, mono, ctx->mod, struct_type);
 
     return func_t;
 }
@@ -1226,7 +1619,7 @@ static Type** infer_type_args(CheckContext* ctx, Node* template_decl,
     // match each function param's type node against the argument's resolved type
     ParamList* func_params = &template_decl->as.func_decl.params;
     for (size_t i = 0; i < func_params->count && i < call_args->count; i++) {
-        Type* arg_type = (Type*)call_args->nodes[i]->resolved_type;
+        Type* arg_type = node_type(ctx, call_args->nodes[i]);
         if (!arg_type) continue;
         Node* param_type_node = func_params->params[i].type_node;
         if (!param_type_node) continue;
@@ -1234,9 +1627,7 @@ static Type** infer_type_args(CheckContext* ctx, Node* template_decl,
         // if param type is a simple name matching a type param, bind it
         if (param_type_node->type == NODE_TYPE_SIMPLE) {
             for (size_t j = 0; j < param_count; j++) {
-                if (type_params->params[j].name_size == param_type_node->as.type_simple.name_size &&
-                    memcmp(type_params->params[j].name, param_type_node->as.type_simple.name,
-                           param_type_node->as.type_simple.name_size) == 0) {
+                if (type_params->params[j].name_atom == param_type_node->as.type_simple.name_atom) {
                     if (!inferred[j]) {
                         inferred[j] = arg_type;
                     }
@@ -1249,9 +1640,7 @@ static Type** infer_type_args(CheckContext* ctx, Node* template_decl,
             Node* inner = param_type_node->as.type_ptr.inner;
             if (inner && inner->type == NODE_TYPE_SIMPLE) {
                 for (size_t j = 0; j < param_count; j++) {
-                    if (type_params->params[j].name_size == inner->as.type_simple.name_size &&
-                        memcmp(type_params->params[j].name, inner->as.type_simple.name,
-                               inner->as.type_simple.name_size) == 0) {
+                    if (type_params->params[j].name_atom == inner->as.type_simple.name_atom) {
                         if (!inferred[j]) inferred[j] = arg_type->as.ptr_type.inner;
                         break;
                     }
@@ -1263,9 +1652,7 @@ static Type** infer_type_args(CheckContext* ctx, Node* template_decl,
             Node* inner = param_type_node->as.type_ref.inner;
             if (inner && inner->type == NODE_TYPE_SIMPLE) {
                 for (size_t j = 0; j < param_count; j++) {
-                    if (type_params->params[j].name_size == inner->as.type_simple.name_size &&
-                        memcmp(type_params->params[j].name, inner->as.type_simple.name,
-                               inner->as.type_simple.name_size) == 0) {
+                    if (type_params->params[j].name_atom == inner->as.type_simple.name_atom) {
                         if (!inferred[j]) inferred[j] = arg_type->as.ref_type.inner;
                         break;
                     }
@@ -1277,10 +1664,9 @@ static Type** infer_type_args(CheckContext* ctx, Node* template_decl,
     // check all params were inferred
     for (size_t i = 0; i < param_count; i++) {
         if (!inferred[i]) {
-            errors_push(ctx->errors, SEVERITY_ERROR,
-                        template_decl->offset, template_decl->line, template_decl->column,
-                        "cannot infer type parameter '%.*s'",
-                        (int)type_params->params[i].name_size, type_params->params[i].name);
+            errors_push_at(ctx->errors, SEVERITY_ERROR, template_decl->loc,
+                           "cannot infer type parameter '%.*s'",
+                           (int)type_params->params[i].name_size, type_params->params[i].name);
             return NULL;
         }
     }
@@ -1296,12 +1682,11 @@ static Type* resolve_generic_type(CheckContext* ctx, Node* type_node) {
         if (type_node->as.type_simple.type_args.count > 0) {
             char* name = type_node->as.type_simple.name;
             size_t name_size = type_node->as.type_simple.name_size;
-            Symbol* sym = symbol_find(ctx->mod->symbols, name, name_size);
+            Symbol* sym = symbol_find_atom(ctx->mod->symbols, type_node->as.type_simple.name_atom);
             if (!sym || sym->kind != SYMBOL_STRUCT || !sym->node ||
                 sym->node->as.struct_decl.type_params.count == 0) {
-                errors_push(ctx->errors, SEVERITY_ERROR, type_node->offset,
-                            type_node->line, type_node->column,
-                            "'%.*s' is not a generic struct", (int)name_size, name);
+                errors_push_at(ctx->errors, SEVERITY_ERROR, type_node->loc,
+                               "'%.*s' is not a generic struct", (int)name_size, name);
                 return NULL;
             }
             NodeList* targs = &type_node->as.type_simple.type_args;
@@ -1311,8 +1696,8 @@ static Type* resolve_generic_type(CheckContext* ctx, Node* type_node) {
                 type_args[i] = resolve_generic_type(ctx, targs->nodes[i]);
                 if (!type_args[i]) return NULL;
             }
-            Type* t = instantiate_generic_struct(ctx, sym->node, type_args, type_arg_count);
-            type_node->resolved_type = t;
+            Type* t = instantiate_generic_struct(ctx, sym->node, type_args, type_arg_count, type_node);
+            node_type_set(ctx, type_node, t);
             return t;
         }
         break;
@@ -1329,17 +1714,13 @@ static Type* resolve_generic_type(CheckContext* ctx, Node* type_node) {
     case NODE_TYPE_ARRAY: {
         Type* element = resolve_generic_type(ctx, type_node->as.type_array.inner);
         if (!element) return NULL;
-        Node* size_node = type_node->as.type_array.size_expr;
-        if (!size_node || size_node->type != NODE_INTEGER_LITERAL) {
-            errors_push(ctx->errors, SEVERITY_ERROR, type_node->offset,
-                        type_node->line, type_node->column,
-                        "array size must be an integer literal");
-            return NULL;
-        }
-        int arr_size = 0;
-        for (size_t i = 0; i < size_node->as.integer_literal.value_size; i++) {
-            arr_size = arr_size * 10 + (size_node->as.integer_literal.value[i] - '0');
-        }
+        ConstEval ev;
+        const_eval_init(&ev, ctx->reg, ctx->mod->symbols);
+        ev.lookup = scope_const_decl;
+        ev.lookup_data = ctx;
+        int arr_size = array_type_size(&ev, ctx->errors, type_node);
+        const_eval_free(&ev);
+        if (arr_size <= 0) return NULL;
         return type_array(ctx->reg, element, arr_size);
     }
     case NODE_TYPE_SLICE: {
@@ -1350,7 +1731,7 @@ static Type* resolve_generic_type(CheckContext* ctx, Node* type_node) {
     default:
         break;
     }
-    return resolve_type_node(ctx->reg, ctx->errors, ctx->mod->symbols, type_node);
+    return resolve_type_node(ctx->reg, ctx->errors, ctx->mod->symbols, ctx->inst, type_node);
 }
 
 static Type* check_expr(CheckContext* ctx, Node* node) {
@@ -1391,10 +1772,10 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
     case NODE_IDENTIFIER: {
         char* name = node->as.identifier.name;
         size_t name_size = node->as.identifier.name_size;
-        Symbol* sym = scope_lookup(ctx, name, name_size);
+        Symbol* sym = scope_lookup(ctx, node->as.identifier.name_atom);
         if (!sym) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "undefined variable '%.*s'", (int)name_size, name);
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "undefined variable '%.*s'", (int)name_size, name);
             break;
         }
         result = get_symbol_type(sym);
@@ -1403,8 +1784,8 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
 
     case NODE_SELF: {
         if (!ctx->self_type) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "'self' used outside of struct method");
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "'self' used outside of struct method");
             break;
         }
         result = ctx->self_type;
@@ -1420,15 +1801,15 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
 
         if (op == TOKEN_AND || op == TOKEN_OR) {
             if (left->kind != TYPE_BOOL) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "left operand of '%s' must be bool, got '%s'",
-                            op == TOKEN_AND ? "and" : "or", type_name(left));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "left operand of '%s' must be bool, got '%s'",
+                               op == TOKEN_AND ? "and" : "or", type_name(left));
                 break;
             }
             if (right->kind != TYPE_BOOL) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "right operand of '%s' must be bool, got '%s'",
-                            op == TOKEN_AND ? "and" : "or", type_name(right));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "right operand of '%s' must be bool, got '%s'",
+                               op == TOKEN_AND ? "and" : "or", type_name(right));
                 break;
             }
             result = type_bool(ctx->reg);
@@ -1453,30 +1834,30 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
             }
             // regular numeric arithmetic
             if (!type_is_numeric(left)) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "left operand of arithmetic must be numeric, got '%s'", type_name(left));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "left operand of arithmetic must be numeric, got '%s'", type_name(left));
                 break;
             }
             if (!type_is_numeric(right)) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "right operand of arithmetic must be numeric, got '%s'", type_name(right));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "right operand of arithmetic must be numeric, got '%s'", type_name(right));
                 break;
             }
             if (!type_equals(left, right)) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "type mismatch in arithmetic: '%s' vs '%s'", type_name(left), type_name(right));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "type mismatch in arithmetic: '%s' vs '%s'", type_name(left), type_name(right));
                 break;
             }
             result = left;
         } else if (op == TOKEN_CARET) {
             if (!type_is_integer(left) || !type_is_integer(right)) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "bitwise '^' requires integer operands");
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "bitwise '^' requires integer operands");
                 break;
             }
             if (!type_equals(left, right)) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "type mismatch in bitwise: '%s' vs '%s'", type_name(left), type_name(right));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "type mismatch in bitwise: '%s' vs '%s'", type_name(left), type_name(right));
                 break;
             }
             result = left;
@@ -1484,8 +1865,8 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
                    op == TOKEN_LESS_THAN || op == TOKEN_GREATER_THAN ||
                    op == TOKEN_LESS_THAN_OR_EQUAL || op == TOKEN_GREATER_THAN_OR_EQUAL) {
             if (!type_equals(left, right)) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "type mismatch in comparison: '%s' vs '%s'", type_name(left), type_name(right));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "type mismatch in comparison: '%s' vs '%s'", type_name(left), type_name(right));
                 break;
             }
             result = type_bool(ctx->reg);
@@ -1500,28 +1881,29 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
         TokenType op = node->as.unary_expr.op;
         if (op == TOKEN_MINUS) {
             if (!type_is_numeric(operand)) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "unary '-' requires numeric operand, got '%s'", type_name(operand));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "unary '-' requires numeric operand, got '%s'", type_name(operand));
                 break;
             }
             result = operand;
         } else if (op == TOKEN_NOT) {
             if (operand->kind != TYPE_BOOL) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "'not' requires bool operand, got '%s'", type_name(operand));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "'not' requires bool operand, got '%s'", type_name(operand));
                 break;
             }
             result = type_bool(ctx->reg);
         } else if (op == TOKEN_AMPERSAND) {
             result = type_ref(ctx->reg, operand);
+            receiver_invalidate(ctx, node->as.unary_expr.operand);
         } else if (op == TOKEN_STAR) {
             if (operand->kind == TYPE_PTR) {
                 result = operand->as.ptr_type.inner;
             } else if (operand->kind == TYPE_REF) {
                 result = operand->as.ref_type.inner;
             } else {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "cannot dereference type '%s' (expected pointer or reference)", type_name(operand));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "cannot dereference type '%s' (expected pointer or reference)", type_name(operand));
             }
         }
         break;
@@ -1537,12 +1919,11 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
         Type* callee_type = NULL;
 
         if (callee && callee->type == NODE_IDENTIFIER) {
-            Symbol* sym = scope_lookup(ctx, callee->as.identifier.name,
-                                        callee->as.identifier.name_size);
+            Symbol* sym = scope_lookup(ctx, callee->as.identifier.name_atom);
             if (!sym) {
-                errors_push(ctx->errors, SEVERITY_ERROR, callee->offset, callee->line, callee->column,
-                            "undefined function '%.*s'",
-                            (int)callee->as.identifier.name_size, callee->as.identifier.name);
+                errors_push_at(ctx->errors, SEVERITY_ERROR, callee->loc,
+                               "undefined function '%.*s'",
+                               (int)callee->as.identifier.name_size, callee->as.identifier.name);
                 break;
             }
 
@@ -1555,6 +1936,7 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
                     node->type = NODE_STRUCT_LITERAL;
                     node->as.struct_literal.struct_name = callee->as.identifier.name;
                     node->as.struct_literal.struct_name_size = callee->as.identifier.name_size;
+                    node->as.struct_literal.struct_name_atom = callee->as.identifier.name_atom;
                     memset(&node->as.struct_literal.fields, 0, sizeof(FieldInitList));
                     memset(&node->as.struct_literal.type_args, 0, sizeof(NodeList));
                     break;
@@ -1581,7 +1963,7 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
                     type_args = arena_alloc(ctx->arena, sizeof(Type*) * type_arg_count);
                     for (size_t i = 0; i < type_arg_count; i++) {
                         type_args[i] = resolve_type_node(ctx->reg, ctx->errors,
-                                                          ctx->mod->symbols,
+                                                          ctx->mod->symbols, ctx->inst,
                                                           explicit_type_args->nodes[i]);
                     }
                 } else {
@@ -1591,20 +1973,23 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
 
                 if (!type_args) break;
 
-                callee_type = instantiate_generic_func(ctx, sym->node, type_args, type_arg_count);
+                callee_type = instantiate_generic_func(ctx, sym->node, type_args, type_arg_count, node);
                 if (!callee_type) break;
 
                 // Update callee to point to the monomorphized function
                 GenericInst* inst = find_generic_inst(ctx->mod, sym->node, type_args, type_arg_count);
-                if (inst) {
+                if (inst && ctx->inst) {
+                    generic_inst_set_target(ctx->arena, ctx->inst, callee, inst);
+                } else if (inst) {
                     callee->as.identifier.name = inst->mangled_name;
                     callee->as.identifier.name_size = inst->mangled_name_size;
+                    callee->as.identifier.name_atom = inst->mangled_name_atom;
                 }
-                callee->resolved_type = callee_type;
+                node_type_set(ctx, callee, callee_type);
                 // fall through to arg type-checking (for interface satisfaction, etc.)
             } else {
                 callee_type = get_symbol_type(sym);
-                callee->resolved_type = callee_type;
+                node_type_set(ctx, callee, callee_type);
             }
         } else {
             callee_type = check_expr(ctx, callee);
@@ -1613,17 +1998,17 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
         if (!callee_type) break;
 
         if (callee_type->kind != TYPE_FUNC) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "cannot call non-function type '%s'", type_name(callee_type));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "cannot call non-function type '%s'", type_name(callee_type));
             break;
         }
 
         // check arg count
         NodeList* args = &node->as.call_expr.args;
         if ((int)args->count != callee_type->as.func_type.param_count) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "expected %d arguments, got %d",
-                        callee_type->as.func_type.param_count, (int)args->count);
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "expected %d arguments, got %d",
+                           callee_type->as.func_type.param_count, (int)args->count);
             break;
         }
 
@@ -1634,10 +2019,9 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
             Type* param_type = callee_type->as.func_type.param_types[i];
             if (param_type && !types_compatible(ctx, param_type, arg_type, args->nodes[i])) {
                 if (!check_iface_compat(ctx, param_type, arg_type, args->nodes[i])) {
-                    errors_push(ctx->errors, SEVERITY_ERROR, args->nodes[i]->offset,
-                                args->nodes[i]->line, args->nodes[i]->column,
-                                "argument %d: expected '%s', got '%s'",
-                                i + 1, type_name(param_type), type_name(arg_type));
+                    errors_push_at(ctx->errors, SEVERITY_ERROR, args->nodes[i]->loc,
+                                   "argument %d: expected '%s', got '%s'",
+                                   i + 1, type_name(param_type), type_name(arg_type));
                 }
             }
         }
@@ -1650,8 +2034,7 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
         // check for enum variant access: EnumName.Variant
         Node* fa_obj = node->as.field_access.object;
         if (fa_obj && fa_obj->type == NODE_IDENTIFIER) {
-            Symbol* sym = scope_lookup(ctx, fa_obj->as.identifier.name,
-                                        fa_obj->as.identifier.name_size);
+            Symbol* sym = scope_lookup(ctx, fa_obj->as.identifier.name_atom);
             if (sym && sym->kind == SYMBOL_ENUM) {
                 Type* enum_type = get_symbol_type(sym);
                 if (enum_type && enum_type->kind == TYPE_ENUM) {
@@ -1660,19 +2043,18 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
                     EnumVariantList* variants = enum_type->as.enum_type.variants;
                     bool found = false;
                     for (size_t i = 0; i < variants->count; i++) {
-                        if (variants->variants[i].name_size == vname_size &&
-                            memcmp(variants->variants[i].name, vname, vname_size) == 0) {
+                        if (variants->variants[i].name_atom == node->as.field_access.field_name_atom) {
                             found = true;
                             break;
                         }
                     }
                     if (!found) {
-                        errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                                    "no variant '%.*s' on enum '%.*s'",
-                                    (int)vname_size, vname,
-                                    (int)enum_type->as.enum_type.name_size, enum_type->as.enum_type.name);
+                        errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                                       "no variant '%.*s' on enum '%.*s'",
+                                       (int)vname_size, vname,
+                                       (int)enum_type->as.enum_type.name_size, enum_type->as.enum_type.name);
                     }
-                    fa_obj->resolved_type = enum_type;
+                    node_type_set(ctx, fa_obj, enum_type);
                     result = enum_type;
                     break;
                 }
@@ -1684,53 +2066,54 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
 
         char* field_name = node->as.field_access.field_name;
         size_t field_name_size = node->as.field_access.field_name_size;
+        Atom field_atom = node->as.field_access.field_name_atom;
 
         // string fat pointer fields: .ptr and .len
         if (obj_type->kind == TYPE_STRING) {
-            if (field_name_size == 3 && memcmp(field_name, "ptr", 3) == 0) {
+            if (field_atom == ATOM_PTR) {
                 result = type_ptr(ctx->reg, type_byte(ctx->reg));
-            } else if (field_name_size == 3 && memcmp(field_name, "len", 3) == 0) {
+            } else if (field_atom == ATOM_LEN) {
                 result = type_usize(ctx->reg);
             } else {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "no field '%.*s' on type 'string'",
-                            (int)field_name_size, field_name);
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "no field '%.*s' on type 'string'",
+                               (int)field_name_size, field_name);
             }
             break;
         }
 
         // array fields: .len and .ptr
         if (obj_type->kind == TYPE_ARRAY) {
-            if (field_name_size == 3 && memcmp(field_name, "len", 3) == 0) {
+            if (field_atom == ATOM_LEN) {
                 result = type_usize(ctx->reg);
-            } else if (field_name_size == 3 && memcmp(field_name, "ptr", 3) == 0) {
+            } else if (field_atom == ATOM_PTR) {
                 result = type_ptr(ctx->reg, obj_type->as.array_type.element);
             } else {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "no field '%.*s' on array type",
-                            (int)field_name_size, field_name);
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "no field '%.*s' on array type",
+                               (int)field_name_size, field_name);
             }
             break;
         }
 
         // slice fields: .len and .ptr
         if (obj_type->kind == TYPE_SLICE) {
-            if (field_name_size == 3 && memcmp(field_name, "len", 3) == 0) {
+            if (field_atom == ATOM_LEN) {
                 result = type_usize(ctx->reg);
-            } else if (field_name_size == 3 && memcmp(field_name, "ptr", 3) == 0) {
+            } else if (field_atom == ATOM_PTR) {
                 result = type_ptr(ctx->reg, obj_type->as.slice_type.element);
             } else {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "no field '%.*s' on slice type",
-                            (int)field_name_size, field_name);
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "no field '%.*s' on slice type",
+                               (int)field_name_size, field_name);
             }
             break;
         }
 
         Type* struct_type = unwrap_to_struct(obj_type);
         if (!struct_type) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "cannot access field on type '%s'", type_name(obj_type));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "cannot access field on type '%s'", type_name(obj_type));
             break;
         }
 
@@ -1738,16 +2121,16 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
 
         for (size_t i = 0; i < fields->count; i++) {
             Field* f = &fields->fields[i];
-            if (f->name_size == field_name_size && memcmp(f->name, field_name, field_name_size) == 0) {
-                result = resolve_type_node(ctx->reg, ctx->errors, ctx->mod->symbols, f->type_node);
+            if (f->name_atom == field_atom) {
+                result = resolve_type_node(ctx->reg, ctx->errors, ctx->mod->symbols, NULL, f->type_node);
                 break;
             }
         }
 
         if (!result) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "no field '%.*s' on struct '%s'",
-                        (int)field_name_size, field_name, type_name(struct_type));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "no field '%.*s' on struct '%s'",
+                           (int)field_name_size, field_name, type_name(struct_type));
         }
         break;
     }
@@ -1758,6 +2141,7 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
 
         char* method_name = node->as.method_call.method_name;
         size_t method_name_size = node->as.method_call.method_name_size;
+        Atom method_atom = node->as.method_call.method_name_atom;
 
         // try struct first, then interface
         Type* struct_type = unwrap_to_struct(obj_type);
@@ -1766,42 +2150,32 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
         Node* method_node = NULL;
 
         if (struct_type) {
-            NodeList* methods = struct_type->as.struct_type.methods;
-            for (size_t i = 0; i < methods->count; i++) {
-                Node* m = methods->nodes[i];
-                if (m->type == NODE_FUNC_DECL &&
-                    m->as.func_decl.name_size == method_name_size &&
-                    memcmp(m->as.func_decl.name, method_name, method_name_size) == 0) {
-                    method_node = m;
-                    break;
-                }
-            }
+            method_node = struct_find_method(struct_type, method_atom);
             if (!method_node) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "no method '%.*s' on struct '%s'",
-                            (int)method_name_size, method_name, type_name(struct_type));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "no method '%.*s' on struct '%s'",
+                               (int)method_name_size, method_name, type_name(struct_type));
                 break;
             }
         } else if (iface_type) {
             NodeList* sigs = iface_type->as.interface_type.method_sigs;
             for (size_t i = 0; i < sigs->count; i++) {
                 Node* m = sigs->nodes[i];
-                if (m->type == NODE_FUNC_DECL &&
-                    m->as.func_decl.name_size == method_name_size &&
-                    memcmp(m->as.func_decl.name, method_name, method_name_size) == 0) {
+                if (m->type == NODE_FUNC_DECL && m->as.func_decl.name_atom == method_atom) {
                     method_node = m;
                     break;
                 }
             }
             if (!method_node) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "no method '%.*s' on interface '%s'",
-                            (int)method_name_size, method_name, type_name(iface_type));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "no method '%.*s' on interface '%s'",
+                               (int)method_name_size, method_name, type_name(iface_type));
                 break;
             }
+            receiver_call_add(ctx, node);
         } else {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "cannot call method on type '%s'", type_name(obj_type));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "cannot call method on type '%s'", type_name(obj_type));
             break;
         }
 
@@ -1823,7 +2197,7 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
                 type_args = arena_alloc(ctx->arena, sizeof(Type*) * type_arg_count);
                 for (size_t i = 0; i < type_arg_count; i++) {
                     type_args[i] = resolve_type_node(ctx->reg, ctx->errors,
-                                                      ctx->mod->symbols,
+                                                      ctx->mod->symbols, ctx->inst,
                                                       explicit_type_args->nodes[i]);
                 }
             } else {
@@ -1835,24 +2209,30 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
             // Check arg count against method params
             ParamList* params = &method_node->as.func_decl.params;
             if (call_args->count != params->count) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "method '%.*s' expects %d arguments, got %d",
-                            (int)method_name_size, method_name,
-                            (int)params->count, (int)call_args->count);
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "method '%.*s' expects %d arguments, got %d",
+                               (int)method_name_size, method_name,
+                               (int)params->count, (int)call_args->count);
                 break;
             }
 
             Type* mono_type = instantiate_generic_method(ctx, method_node,
-                                                          struct_type, type_args, type_arg_count);
+                                                          struct_type, type_args, type_arg_count, node);
             if (!mono_type) break;
 
             // Find the instantiation to get the mangled name
             GenericInst* inst = find_generic_inst(ctx->mod, method_node, type_args, type_arg_count);
-            if (inst) {
-                node->as.method_call.method_name = inst->mangled_name;
-                node->as.method_call.method_name_size = inst->mangled_name_size;
+            if (ctx->inst) {
+                // a target marks the call monomorphized for this instance only
+                generic_inst_set_target(ctx->arena, ctx->inst, node, inst);
+            } else {
+                if (inst) {
+                    node->as.method_call.method_name = inst->mangled_name;
+                    node->as.method_call.method_name_size = inst->mangled_name_size;
+                    node->as.method_call.method_name_atom = inst->mangled_name_atom;
+                }
+                node->as.method_call.is_mono = true;
             }
-            node->as.method_call.is_mono = true;
 
             result = mono_type->as.func_type.return_type;
             break;
@@ -1862,19 +2242,21 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
         NodeList* args = &node->as.method_call.args;
         ParamList* params = &method_node->as.func_decl.params;
         if (args->count != params->count) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "method '%.*s' expects %d arguments, got %d",
-                        (int)method_name_size, method_name,
-                        (int)params->count, (int)args->count);
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "method '%.*s' expects %d arguments, got %d",
+                           (int)method_name_size, method_name,
+                           (int)params->count, (int)args->count);
             break;
         }
 
         for (size_t i = 0; i < args->count; i++) {
             check_expr(ctx, args->nodes[i]);
         }
+        if (struct_type) method_reached(ctx, method_node, struct_type);
 
         // return type
         Type* ret = resolve_type_node(ctx->reg, ctx->errors, ctx->mod->symbols,
+                                       method_node->as.func_decl.inst,
                                        method_node->as.func_decl.return_type);
         result = ret;
         break;
@@ -1883,10 +2265,10 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
     case NODE_STRUCT_LITERAL: {
         char* name = node->as.struct_literal.struct_name;
         size_t name_size = node->as.struct_literal.struct_name_size;
-        Symbol* sym = scope_lookup(ctx, name, name_size);
+        Symbol* sym = scope_lookup(ctx, node->as.struct_literal.struct_name_atom);
         if (!sym) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "undefined struct '%.*s'", (int)name_size, name);
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "undefined struct '%.*s'", (int)name_size, name);
             break;
         }
 
@@ -1899,27 +2281,30 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
             Type** type_args = arena_alloc(ctx->arena, sizeof(Type*) * type_arg_count);
             for (size_t i = 0; i < type_arg_count; i++) {
                 type_args[i] = resolve_type_node(ctx->reg, ctx->errors,
-                                                  ctx->mod->symbols,
+                                                  ctx->mod->symbols, ctx->inst,
                                                   type_args_list->nodes[i]);
                 if (!type_args[i]) { st = NULL; break; }
             }
             if (type_args[0]) {
-                st = instantiate_generic_struct(ctx, sym->node, type_args, type_arg_count);
+                st = instantiate_generic_struct(ctx, sym->node, type_args, type_arg_count, node);
             }
             if (!st) break;
             // Update the node's struct_name to the mangled name so codegen works
             GenericInst* inst = find_generic_inst(ctx->mod, sym->node, type_args, type_arg_count);
-            if (inst) {
+            if (inst && ctx->inst) {
+                generic_inst_set_target(ctx->arena, ctx->inst, node, inst);
+            } else if (inst) {
                 node->as.struct_literal.struct_name = inst->mangled_name;
                 node->as.struct_literal.struct_name_size = inst->mangled_name_size;
+                node->as.struct_literal.struct_name_atom = inst->mangled_name_atom;
             }
         } else {
             st = get_symbol_type(sym);
         }
 
         if (!st || st->kind != TYPE_STRUCT) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "'%.*s' is not a struct", (int)name_size, name);
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "'%.*s' is not a struct", (int)name_size, name);
             break;
         }
 
@@ -1932,18 +2317,18 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
             bool found = false;
             for (size_t j = 0; j < fields->count; j++) {
                 Field* f = &fields->fields[j];
-                if (f->name_size == fi->name_size && memcmp(f->name, fi->name, fi->name_size) == 0) {
+                if (f->name_atom == fi->name_atom) {
                     found = true;
                     Type* val_type = check_expr(ctx, fi->value);
                     if (val_type) {
                         Type* field_type = resolve_type_node(ctx->reg, ctx->errors,
-                                                              ctx->mod->symbols, f->type_node);
+                                                              ctx->mod->symbols, NULL, f->type_node);
                         if (field_type && !types_compatible(ctx, field_type, val_type, fi->value)) {
                             if (!check_iface_compat(ctx, field_type, val_type, fi->value)) {
-                                errors_push(ctx->errors, SEVERITY_ERROR, fi->offset, fi->line, fi->column,
-                                            "field '%.*s': expected '%s', got '%s'",
-                                            (int)fi->name_size, fi->name,
-                                            type_name(field_type), type_name(val_type));
+                                errors_push_at(ctx->errors, SEVERITY_ERROR, fi->loc,
+                                               "field '%.*s': expected '%s', got '%s'",
+                                               (int)fi->name_size, fi->name,
+                                               type_name(field_type), type_name(val_type));
                             }
                         }
                     }
@@ -1951,9 +2336,9 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
                 }
             }
             if (!found) {
-                errors_push(ctx->errors, SEVERITY_ERROR, fi->offset, fi->line, fi->column,
-                            "no field '%.*s' on struct '%.*s'",
-                            (int)fi->name_size, fi->name, (int)name_size, name);
+                errors_push_at(ctx->errors, SEVERITY_ERROR, fi->loc,
+                               "no field '%.*s' on struct '%.*s'",
+                               (int)fi->name_size, fi->name, (int)name_size, name);
             }
         }
 
@@ -1964,9 +2349,9 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
     case NODE_CAST_EXPR: {
         Type* from = check_expr(ctx, node->as.cast_expr.expr);
         Type* to = resolve_type_node(ctx->reg, ctx->errors,
-                                      ctx->mod->symbols,
+                                      ctx->mod->symbols, ctx->inst,
                                       node->as.cast_expr.target_type);
-        node->as.cast_expr.target_type->resolved_type = to;
+        node_type_set(ctx, node->as.cast_expr.target_type, to);
         if (from && to) {
             bool allowed = false;
             if (type_is_numeric(from) && type_is_numeric(to)) allowed = true;
@@ -1975,8 +2360,8 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
             if (from->kind == TYPE_ENUM && type_is_integer(to)) allowed = true;
             if (type_is_integer(from) && to->kind == TYPE_ENUM) allowed = true;
             if (!allowed) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "cannot cast '%s' to '%s'", type_name(from), type_name(to));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "cannot cast '%s' to '%s'", type_name(from), type_name(to));
             }
         }
         result = to;
@@ -1986,10 +2371,10 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
     case NODE_SIZEOF_EXPR: {
         Type* t = resolve_generic_type(ctx, node->as.sizeof_expr.type_node);
         if (!t) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "unknown type in sizeof");
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "unknown type in sizeof");
         } else {
-            node->as.sizeof_expr.type_node->resolved_type = t;
+            node_type_set(ctx, node->as.sizeof_expr.type_node, t);
         }
         result = type_usize(ctx->reg);
         break;
@@ -1998,8 +2383,8 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
     case NODE_ARRAY_LITERAL: {
         NodeList* elems = &node->as.array_literal.elements;
         if (elems->count == 0) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "array literal cannot be empty");
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "array literal cannot be empty");
             break;
         }
         Type* elem_type = check_expr(ctx, elems->nodes[0]);
@@ -2007,10 +2392,9 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
         for (size_t i = 1; i < elems->count; i++) {
             Type* t = check_expr(ctx, elems->nodes[i]);
             if (t && !type_equals(t, elem_type)) {
-                errors_push(ctx->errors, SEVERITY_ERROR, elems->nodes[i]->offset,
-                            elems->nodes[i]->line, elems->nodes[i]->column,
-                            "array element type mismatch: expected '%s', got '%s'",
-                            type_name(elem_type), type_name(t));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, elems->nodes[i]->loc,
+                               "array element type mismatch: expected '%s', got '%s'",
+                               type_name(elem_type), type_name(t));
             }
         }
         result = type_array(ctx->reg, elem_type, (int)elems->count);
@@ -2022,17 +2406,16 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
         Type* idx_type = check_expr(ctx, node->as.index_expr.index);
         if (!obj_type) break;
         if (idx_type && !type_is_integer(idx_type)) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->as.index_expr.index->offset,
-                        node->as.index_expr.index->line, node->as.index_expr.index->column,
-                        "index must be an integer type, got '%s'", type_name(idx_type));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->as.index_expr.index->loc,
+                           "index must be an integer type, got '%s'", type_name(idx_type));
         }
         if (obj_type->kind == TYPE_ARRAY) {
             result = obj_type->as.array_type.element;
         } else if (obj_type->kind == TYPE_SLICE) {
             result = obj_type->as.slice_type.element;
         } else {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "cannot index type '%s'", type_name(obj_type));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "cannot index type '%s'", type_name(obj_type));
         }
         break;
     }
@@ -2041,10 +2424,37 @@ static Type* check_expr(CheckContext* ctx, Node* node) {
         break;
     }
 
-    if (result) node->resolved_type = result;
+    if (result) node_type_set(ctx, node, result);
     return result;
 }
 
+// Case labels of a match on an integer become C case labels, which must be
+// constants: each one is evaluated and replaced by its value.
+static void fold_case_labels(CheckContext* ctx, MatchCaseList* cases, Type* subject) {
+    ConstEval ev;
+    const_eval_init(&ev, ctx->reg, ctx->mod->symbols);
+    ev.lookup = scope_const_decl;
+    ev.lookup_data = ctx;
+    for (size_t i = 0; i < cases->count; i++) {
+        NodeList* vals = &cases->cases[i].values;
+        for (size_t j = 0; j < vals->count; j++) {
+            Node* value = vals->nodes[j];
+            if (value->type == NODE_INTEGER_LITERAL) continue;
+            ConstValue v;
+            if (!const_eval(&ev, value, &v)) {
+                errors_push_at(ctx->errors, SEVERITY_ERROR, value->loc,
+                               "match case value must be a compile-time constant");
+                continue;
+            }
+            Node* folded = const_value_node(ctx->arena, &v, subject, value->loc);
+            // "case -5:" needs no parentheses, and duplicates compare by text
+            if (folded->type == NODE_PAREN_EXPR) folded = folded->as.paren_expr.inner;
+            vals->nodes[j] = folded;
+        }
+    }
+    const_eval_free(&ev);
+}
+
 static void check_stmt(CheckContext* ctx, Node* node) {
     if (!node) return;
 
@@ -2062,32 +2472,31 @@ static void check_stmt(CheckContext* ctx, Node* node) {
 
         Type* var_type = declared_type ? declared_type : init_type;
         if (!var_type) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "cannot determine type of variable '%.*s'",
-                        (int)node->as.var_decl.name_size, node->as.var_decl.name);
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "cannot determine type of variable '%.*s'",
+                           (int)node->as.var_decl.name_size, node->as.var_decl.name);
             break;
         }
 
         if (declared_type && init_type &&
             !types_compatible(ctx, declared_type, init_type, node->as.var_decl.value)) {
             if (!check_iface_compat(ctx, declared_type, init_type, node)) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "variable '%.*s': declared as '%s' but initialized with '%s'",
-                            (int)node->as.var_decl.name_size, node->as.var_decl.name,
-                            type_name(declared_type), type_name(init_type));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "variable '%.*s': declared as '%s' but initialized with '%s'",
+                               (int)node->as.var_decl.name_size, node->as.var_decl.name,
+                               type_name(declared_type), type_name(init_type));
             }
         }
 
-        if (ctx->scope) {
-            Symbol* dup = symbol_find(&ctx->scope->locals, node->as.var_decl.name, node->as.var_decl.name_size);
-            if (dup) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "duplicate variable '%.*s' in this scope",
-                            (int)node->as.var_decl.name_size, node->as.var_decl.name);
-                break;
-            }
+        if (scope_find_local(ctx, node->as.var_decl.name_atom)) {
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "duplicate variable '%.*s' in this scope",
+                           (int)node->as.var_decl.name_size, node->as.var_decl.name);
+            break;
         }
-        scope_add(ctx, SYMBOL_VAR, node->as.var_decl.name, node->as.var_decl.name_size, var_type, node);
+        scope_add(ctx, SYMBOL_VAR, node->as.var_decl.name, node->as.var_decl.name_size,
+                  node->as.var_decl.name_atom, var_type, node);
+        receiver_add(ctx, node, declared_type, init_type);
         break;
     }
 
@@ -2103,22 +2512,20 @@ static void check_stmt(CheckContext* ctx, Node* node) {
 
         Type* const_type = declared_type ? declared_type : init_type;
         if (!const_type) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "cannot determine type of constant '%.*s'",
-                        (int)node->as.const_decl.name_size, node->as.const_decl.name);
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "cannot determine type of constant '%.*s'",
+                           (int)node->as.const_decl.name_size, node->as.const_decl.name);
             break;
         }
 
-        if (ctx->scope) {
-            Symbol* dup = symbol_find(&ctx->scope->locals, node->as.const_decl.name, node->as.const_decl.name_size);
-            if (dup) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "duplicate variable '%.*s' in this scope",
-                            (int)node->as.const_decl.name_size, node->as.const_decl.name);
-                break;
-            }
+        if (scope_find_local(ctx, node->as.const_decl.name_atom)) {
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "duplicate variable '%.*s' in this scope",
+                           (int)node->as.const_decl.name_size, node->as.const_decl.name);
+            break;
         }
-        scope_add(ctx, SYMBOL_CONST, node->as.const_decl.name, node->as.const_decl.name_size, const_type, node);
+        scope_add(ctx, SYMBOL_CONST, node->as.const_decl.name, node->as.const_decl.name_size,
+                  node->as.const_decl.name_atom, const_type, node);
         break;
     }
 
@@ -2126,22 +2533,22 @@ static void check_stmt(CheckContext* ctx, Node* node) {
         if (node->as.return_stmt.value) {
             Type* val = check_expr(ctx, node->as.return_stmt.value);
             if (ctx->return_type && ctx->return_type->kind == TYPE_VOID) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "return with value in void function");
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "return with value in void function");
             } else if (val && ctx->return_type) {
                 if (!types_compatible(ctx, ctx->return_type, val, node->as.return_stmt.value)) {
                     if (!check_iface_compat(ctx, ctx->return_type, val, node)) {
-                        errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                                    "return type mismatch: expected '%s', got '%s'",
-                                    type_name(ctx->return_type), type_name(val));
+                        errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                                       "return type mismatch: expected '%s', got '%s'",
+                                       type_name(ctx->return_type), type_name(val));
                     }
                 }
             }
         } else {
             if (ctx->return_type && ctx->return_type->kind != TYPE_VOID) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "return without value in function returning '%s'",
-                            type_name(ctx->return_type));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "return without value in function returning '%s'",
+                               type_name(ctx->return_type));
             }
         }
         // Attach cleanup calls from enclosing with statements
@@ -2151,7 +2558,7 @@ static void check_stmt(CheckContext* ctx, Node* node) {
             for (int i = 0; i < ctx->with_depth; i++) {
                 node->as.return_stmt.cleanup.nodes[i] = ctx->with_releases[ctx->with_depth - 1 - i];
             }
-            node->resolved_type = ctx->return_type;
+            node_type_set(ctx, node, ctx->return_type);
         }
         break;
     }
@@ -2159,8 +2566,8 @@ static void check_stmt(CheckContext* ctx, Node* node) {
     case NODE_IF_STMT: {
         Type* cond = check_expr(ctx, node->as.if_stmt.condition);
         if (cond && cond->kind != TYPE_BOOL && cond->kind != TYPE_PTR) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "if condition must be bool or pointer, got '%s'", type_name(cond));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "if condition must be bool or pointer, got '%s'", type_name(cond));
         }
         check_body(ctx, &node->as.if_stmt.then_body);
 
@@ -2168,10 +2575,8 @@ static void check_stmt(CheckContext* ctx, Node* node) {
         for (size_t i = 0; i < elseifs->count; i++) {
             Type* ei_cond = check_expr(ctx, elseifs->branches[i].condition);
             if (ei_cond && ei_cond->kind != TYPE_BOOL && ei_cond->kind != TYPE_PTR) {
-                errors_push(ctx->errors, SEVERITY_ERROR,
-                            elseifs->branches[i].offset, elseifs->branches[i].line,
-                            elseifs->branches[i].column,
-                            "elseif condition must be bool or pointer, got '%s'", type_name(ei_cond));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, elseifs->branches[i].loc,
+                               "elseif condition must be bool or pointer, got '%s'", type_name(ei_cond));
             }
             check_body(ctx, &elseifs->branches[i].body);
         }
@@ -2191,28 +2596,24 @@ static void check_stmt(CheckContext* ctx, Node* node) {
         }
 
         if (start_type && !type_is_integer(start_type)) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->as.for_stmt.start->offset,
-                        node->as.for_stmt.start->line, node->as.for_stmt.start->column,
-                        "for-loop start must be an integer type, got '%s'", type_name(start_type));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->as.for_stmt.start->loc,
+                           "for-loop start must be an integer type, got '%s'", type_name(start_type));
         }
         if (end_type && !type_is_integer(end_type)) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->as.for_stmt.end->offset,
-                        node->as.for_stmt.end->line, node->as.for_stmt.end->column,
-                        "for-loop end must be an integer type, got '%s'", type_name(end_type));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->as.for_stmt.end->loc,
+                           "for-loop end must be an integer type, got '%s'", type_name(end_type));
         }
         if (step_type && !type_is_integer(step_type)) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->as.for_stmt.step->offset,
-                        node->as.for_stmt.step->line, node->as.for_stmt.step->column,
-                        "for-loop step must be an integer type, got '%s'", type_name(step_type));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->as.for_stmt.step->loc,
+                           "for-loop step must be an integer type, got '%s'", type_name(step_type));
         }
 
         // determine iterator type from start expression
         Type* iter_type = start_type ? start_type : type_int(ctx->reg);
 
-        Scope* prev = ctx->scope;
-        scope_push(ctx);
+        size_t prev = scope_push(ctx);
         scope_add(ctx, SYMBOL_VAR, node->as.for_stmt.var_name, node->as.for_stmt.var_name_size,
-                  iter_type, NULL);
+                  node->as.for_stmt.var_name_atom, iter_type, NULL);
         ctx->with_depth_at_loop[ctx->real_loop_depth] = ctx->with_depth;
         ctx->loop_depth++;
         ctx->real_loop_depth++;
@@ -2226,8 +2627,8 @@ static void check_stmt(CheckContext* ctx, Node* node) {
     case NODE_WHILE_STMT: {
         Type* cond = check_expr(ctx, node->as.while_stmt.condition);
         if (cond && cond->kind != TYPE_BOOL && cond->kind != TYPE_PTR) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "while condition must be bool or pointer, got '%s'", type_name(cond));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "while condition must be bool or pointer, got '%s'", type_name(cond));
         }
         ctx->with_depth_at_loop[ctx->real_loop_depth] = ctx->with_depth;
         ctx->loop_depth++;
@@ -2244,11 +2645,10 @@ static void check_stmt(CheckContext* ctx, Node* node) {
 
         if (res->type == NODE_VAR_DECL) {
             // "with var x = ..." — push scope so variable is visible in body
-            Scope* prev = ctx->scope;
-            scope_push(ctx);
+            size_t prev = scope_push(ctx);
             check_stmt(ctx, res);  // registers variable in scope
             resource_type = get_symbol_type(
-                scope_lookup(ctx, res->as.var_decl.name, res->as.var_decl.name_size));
+                scope_lookup(ctx, res->as.var_decl.name_atom));
 
             if (!resource_type) {
                 check_body(ctx, &node->as.with_stmt.body);
@@ -2259,57 +2659,47 @@ static void check_stmt(CheckContext* ctx, Node* node) {
             // Must be a struct (or &struct / *struct) with release() method
             Type* struct_type = unwrap_to_struct(resource_type);
             if (!struct_type) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "'with' requires a struct type, got '%s'", type_name(resource_type));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "'with' requires a struct type, got '%s'", type_name(resource_type));
                 check_body(ctx, &node->as.with_stmt.body);
                 scope_pop(ctx, prev);
                 break;
             }
 
             // Find release() method: zero params, no generic type params
-            bool has_release = false;
-            NodeList* methods = struct_type->as.struct_type.methods;
-            for (size_t i = 0; i < methods->count; i++) {
-                Node* m = methods->nodes[i];
-                if (m->type == NODE_FUNC_DECL &&
-                    m->as.func_decl.name_size == 7 &&
-                    memcmp(m->as.func_decl.name, "release", 7) == 0 &&
-                    m->as.func_decl.params.count == 0 &&
-                    m->as.func_decl.type_params.count == 0) {
-                    has_release = true;
-                    break;
-                }
-            }
+            bool has_release = struct_has_release(struct_type);
 
             if (!has_release) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "struct '%s' has no release() method", type_name(struct_type));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "struct '%s' has no release() method", type_name(struct_type));
                 check_body(ctx, &node->as.with_stmt.body);
                 scope_pop(ctx, prev);
                 break;
             }
 
-            // Synthesize NODE_METHOD_CALL for release()
-            Node* release_call = arena_alloc(ctx->arena, sizeof(Node));
-            memset(release_call, 0, sizeof(Node));
-            release_call->type = NODE_METHOD_CALL;
-            release_call->offset = node->offset;
-            release_call->line = node->line;
-            release_call->column = node->column;
-
-            // Build an identifier node referencing the variable
-            Node* ident = arena_alloc(ctx->arena, sizeof(Node));
-            memset(ident, 0, sizeof(Node));
-            ident->type = NODE_IDENTIFIER;
-            ident->as.identifier.name = res->as.var_decl.name;
-            ident->as.identifier.name_size = res->as.var_decl.name_size;
-            ident->resolved_type = resource_type;
-
-            release_call->as.method_call.object = ident;
-            release_call->as.method_call.method_name = "release";
-            release_call->as.method_call.method_name_size = 7;
-
-            node->as.with_stmt.release = release_call;
+            // release() is called without going through check_expr
+            method_reached(ctx, struct_find_method(struct_type, ATOM_RELEASE), struct_type);
+
+            // Synthesize NODE_METHOD_CALL for release() (once: every
+            // instance of a generic body shares it)
+            Node* release_call = node->as.with_stmt.release;
+            if (!release_call) {
+                release_call = node_new(ctx->arena, NODE_METHOD_CALL, node->loc);
+
+                // Build an identifier node referencing the variable
+                Node* ident = node_new(ctx->arena, NODE_IDENTIFIER, 0);
+                ident->as.identifier.name = res->as.var_decl.name;
+                ident->as.identifier.name_size = res->as.var_decl.name_size;
+                ident->as.identifier.name_atom = res->as.var_decl.name_atom;
+
+                release_call->as.method_call.object = ident;
+                release_call->as.method_call.method_name = "release";
+                release_call->as.method_call.method_name_size = 7;
+                release_call->as.method_call.method_name_atom = ATOM_RELEASE;
+
+                node->as.with_stmt.release = release_call;
+            }
+            node_type_set(ctx, release_call->as.method_call.object, resource_type);
 
             ctx->with_releases[ctx->with_depth++] = release_call;
             check_body(ctx, &node->as.with_stmt.body);
@@ -2326,45 +2716,34 @@ static void check_stmt(CheckContext* ctx, Node* node) {
 
             Type* struct_type = unwrap_to_struct(resource_type);
             if (!struct_type) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "'with' requires a struct type, got '%s'", type_name(resource_type));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "'with' requires a struct type, got '%s'", type_name(resource_type));
                 check_body(ctx, &node->as.with_stmt.body);
                 break;
             }
 
-            bool has_release = false;
-            NodeList* methods = struct_type->as.struct_type.methods;
-            for (size_t i = 0; i < methods->count; i++) {
-                Node* m = methods->nodes[i];
-                if (m->type == NODE_FUNC_DECL &&
-                    m->as.func_decl.name_size == 7 &&
-                    memcmp(m->as.func_decl.name, "release", 7) == 0 &&
-                    m->as.func_decl.params.count == 0 &&
-                    m->as.func_decl.type_params.count == 0) {
-                    has_release = true;
-                    break;
-                }
-            }
+            bool has_release = struct_has_release(struct_type);
 
             if (!has_release) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "struct '%s' has no release() method", type_name(struct_type));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "struct '%s' has no release() method", type_name(struct_type));
                 check_body(ctx, &node->as.with_stmt.body);
                 break;
             }
 
+            method_reached(ctx, struct_find_method(struct_type, ATOM_RELEASE), struct_type);
+
             // Synthesize NODE_METHOD_CALL for release()
-            Node* release_call = arena_alloc(ctx->arena, sizeof(Node));
-            memset(release_call, 0, sizeof(Node));
-            release_call->type = NODE_METHOD_CALL;
-            release_call->offset = node->offset;
-            release_call->line = node->line;
-            release_call->column = node->column;
-            release_call->as.method_call.object = res;
-            release_call->as.method_call.method_name = "release";
-            release_call->as.method_call.method_name_size = 7;
-
-            node->as.with_stmt.release = release_call;
+            Node* release_call = node->as.with_stmt.release;
+            if (!release_call) {
+                release_call = node_new(ctx->arena, NODE_METHOD_CALL, node->loc);
+                release_call->as.method_call.object = res;
+                release_call->as.method_call.method_name = "release";
+                release_call->as.method_call.method_name_size = 7;
+                release_call->as.method_call.method_name_atom = ATOM_RELEASE;
+
+                node->as.with_stmt.release = release_call;
+            }
 
             ctx->with_releases[ctx->with_depth++] = release_call;
             check_body(ctx, &node->as.with_stmt.body);
@@ -2375,8 +2754,8 @@ static void check_stmt(CheckContext* ctx, Node* node) {
 
     case NODE_BREAK_STMT:
         if (ctx->loop_depth == 0) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "'break' used outside of loop or match");
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "'break' used outside of loop or match");
         } else if (ctx->with_depth > 0 && ctx->real_loop_depth > 0) {
             int loop_with_base = ctx->with_depth_at_loop[ctx->real_loop_depth - 1];
             int cleanup_count = ctx->with_depth - loop_with_base;
@@ -2392,8 +2771,8 @@ static void check_stmt(CheckContext* ctx, Node* node) {
 
     case NODE_CONTINUE_STMT:
         if (ctx->real_loop_depth == 0) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "'continue' used outside of loop");
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "'continue' used outside of loop");
         } else if (ctx->with_depth > 0) {
             int loop_with_base = ctx->with_depth_at_loop[ctx->real_loop_depth - 1];
             int cleanup_count = ctx->with_depth - loop_with_base;
@@ -2416,15 +2795,18 @@ static void check_stmt(CheckContext* ctx, Node* node) {
             for (size_t j = 0; j < vals->count; j++) {
                 Type* val_type = check_expr(ctx, vals->nodes[j]);
                 if (val_type && subject && !type_equals(val_type, subject)) {
-                    errors_push(ctx->errors, SEVERITY_ERROR,
-                                vals->nodes[j]->offset, vals->nodes[j]->line, vals->nodes[j]->column,
-                                "match case type mismatch: expected '%s', got '%s'",
-                                type_name(subject), type_name(val_type));
+                    errors_push_at(ctx->errors, SEVERITY_ERROR, vals->nodes[j]->loc,
+                                   "match case type mismatch: expected '%s', got '%s'",
+                                   type_name(subject), type_name(val_type));
                 }
             }
             check_body(ctx, &cases->cases[i].body);
         }
 
+        if (subject && type_is_integer(subject) && !ctx->inst) {
+            fold_case_labels(ctx, cases, subject);
+        }
+
         // check for duplicate case values (O(n^2) — case counts are small)
         for (size_t i = 0; i < cases->count; i++) {
             NodeList* vals_i = &cases->cases[i].values;
@@ -2455,9 +2837,8 @@ static void check_stmt(CheckContext* ctx, Node* node) {
                             dup = true;
                         }
                         if (dup) {
-                            errors_push(ctx->errors, SEVERITY_ERROR,
-                                        b->offset, b->line, b->column,
-                                        "duplicate match case value");
+                            errors_push_at(ctx->errors, SEVERITY_ERROR, b->loc,
+                                           "duplicate match case value");
                         }
                     }
                 }
@@ -2473,28 +2854,27 @@ static void check_stmt(CheckContext* ctx, Node* node) {
 
     case NODE_ASSIGN_STMT: {
         if (!is_lvalue(node->as.assign_stmt.target)) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "cannot assign to this expression");
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "cannot assign to this expression");
         }
         if (node->as.assign_stmt.target->type == NODE_IDENTIFIER) {
-            Symbol* sym = scope_lookup(ctx,
-                node->as.assign_stmt.target->as.identifier.name,
-                node->as.assign_stmt.target->as.identifier.name_size);
+            Symbol* sym = scope_lookup(ctx, node->as.assign_stmt.target->as.identifier.name_atom);
             if (sym && sym->kind == SYMBOL_CONST) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "cannot assign to constant '%.*s'",
-                            (int)node->as.assign_stmt.target->as.identifier.name_size,
-                            node->as.assign_stmt.target->as.identifier.name);
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "cannot assign to constant '%.*s'",
+                               (int)node->as.assign_stmt.target->as.identifier.name_size,
+                               node->as.assign_stmt.target->as.identifier.name);
             }
         }
+        receiver_invalidate(ctx, node->as.assign_stmt.target);
         Type* target = check_expr(ctx, node->as.assign_stmt.target);
         Type* value = check_expr(ctx, node->as.assign_stmt.value);
         if (target && value &&
             !types_compatible(ctx, target, value, node->as.assign_stmt.value)) {
             if (!check_iface_compat(ctx, target, value, node)) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "assignment type mismatch: expected '%s', got '%s'",
-                            type_name(target), type_name(value));
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "assignment type mismatch: expected '%s', got '%s'",
+                               type_name(target), type_name(value));
             }
         }
         break;
@@ -2502,18 +2882,16 @@ static void check_stmt(CheckContext* ctx, Node* node) {
 
     case NODE_COMPOUND_ASSIGN_STMT: {
         if (!is_lvalue(node->as.compound_assign_stmt.target)) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "cannot assign to this expression");
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "cannot assign to this expression");
         }
         if (node->as.compound_assign_stmt.target->type == NODE_IDENTIFIER) {
-            Symbol* sym = scope_lookup(ctx,
-                node->as.compound_assign_stmt.target->as.identifier.name,
-                node->as.compound_assign_stmt.target->as.identifier.name_size);
+            Symbol* sym = scope_lookup(ctx, node->as.compound_assign_stmt.target->as.identifier.name_atom);
             if (sym && sym->kind == SYMBOL_CONST) {
-                errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                            "cannot assign to constant '%.*s'",
-                            (int)node->as.compound_assign_stmt.target->as.identifier.name_size,
-                            node->as.compound_assign_stmt.target->as.identifier.name);
+                errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                               "cannot assign to constant '%.*s'",
+                               (int)node->as.compound_assign_stmt.target->as.identifier.name_size,
+                               node->as.compound_assign_stmt.target->as.identifier.name);
             }
         }
         Type* target = check_expr(ctx, node->as.compound_assign_stmt.target);
@@ -2524,14 +2902,14 @@ static void check_stmt(CheckContext* ctx, Node* node) {
             (node->as.compound_assign_stmt.op == TOKEN_PLUS_ASSIGN ||
              node->as.compound_assign_stmt.op == TOKEN_MINUS_ASSIGN);
         if (target && !type_is_numeric(target) && !is_ptr_arith) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "compound assignment target must be numeric or pointer, got '%s'", type_name(target));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "compound assignment target must be numeric or pointer, got '%s'", type_name(target));
         }
         if (!is_ptr_arith && target && value &&
             !types_compatible(ctx, target, value, node->as.compound_assign_stmt.value)) {
-            errors_push(ctx->errors, SEVERITY_ERROR, node->offset, node->line, node->column,
-                        "compound assignment type mismatch: '%s' vs '%s'",
-                        type_name(target), type_name(value));
+            errors_push_at(ctx->errors, SEVERITY_ERROR, node->loc,
+                           "compound assignment type mismatch: '%s' vs '%s'",
+                           type_name(target), type_name(value));
         }
         break;
     }
@@ -2546,8 +2924,7 @@ static void check_stmt(CheckContext* ctx, Node* node) {
 }
 
 static void check_body(CheckContext* ctx, NodeList* body) {
-    Scope* prev = ctx->scope;
-    scope_push(ctx);
+    size_t prev = scope_push(ctx);
     for (size_t i = 0; i < body->count; i++) {
         check_stmt(ctx, body->nodes[i]);
     }
@@ -2560,33 +2937,73 @@ static void check_func_body(CheckContext* ctx, Node* func_node) {
     Type* func_type = (Type*)func_node->resolved_type;
     if (!func_type || func_type->kind != TYPE_FUNC) return;
 
+    Type* prev_return = ctx->return_type;
     ctx->return_type = func_type->as.func_type.return_type;
+    size_t receiver_start = ctx->receivers->receiver_count;
+    size_t call_start = ctx->receivers->call_count;
+
+    // instance bodies are the template's, read under the instance's bindings
+    GenericInst* prev_inst = ctx->inst;
+    ctx->inst = func_node->as.func_decl.inst;
 
     int prev_loop = ctx->loop_depth;
     int prev_real_loop = ctx->real_loop_depth;
     ctx->loop_depth = 0;
     ctx->real_loop_depth = 0;
 
-    Scope* prev = ctx->scope;
-    scope_push(ctx);
+    // a generic instantiated mid-body gets its own frame, hiding the caller's locals
+    size_t prev_frame = ctx->scopes->frame_start;
+    ctx->scopes->frame_start = ctx->scopes->count;
+    size_t prev = scope_push(ctx);
 
     // add parameters to scope
     ParamList* params = &func_node->as.func_decl.params;
     for (size_t i = 0; i < params->count; i++) {
         Type* param_type = func_type->as.func_type.param_types[i];
-        scope_add(ctx, SYMBOL_VAR, params->params[i].name, params->params[i].name_size, param_type, NULL);
+        scope_add(ctx, SYMBOL_VAR, params->params[i].name, params->params[i].name_size,
+                  params->params[i].name_atom, param_type, NULL);
     }
 
     // check body statements (not wrapped in check_body to avoid double scope push)
-    NodeList* body = &func_node->as.func_decl.body;
+    NodeList* body = parser_func_body(func_node);
     for (size_t i = 0; i < body->count; i++) {
         check_stmt(ctx, body->nodes[i]);
     }
 
+    receivers_resolve(ctx, receiver_start, call_start);
     scope_pop(ctx, prev);
+    ctx->scopes->frame_start = prev_frame;
     ctx->loop_depth = prev_loop;
     ctx->real_loop_depth = prev_real_loop;
-    ctx->return_type = NULL;
+    ctx->inst = prev_inst;
+    ctx->return_type = prev_return;
+}
+
+static void check_method_body(CheckContext* ctx, Node* method, Type* struct_type) {
+    Type* prev_self = ctx->self_type;
+    ctx->self_type = type_ref(ctx->reg, struct_type);
+
+    // resolve method type if not already done
+    if (!method->resolved_type) {
+        ParamList* params = &method->as.func_decl.params;
+        int param_count = (int)params->count;
+        Type** param_types = NULL;
+        if (param_count > 0) {
+            param_types = arena_alloc(ctx->arena, sizeof(Type*) * param_count);
+            for (int j = 0; j < param_count; j++) {
+                param_types[j] = resolve_type_node(ctx->reg, ctx->errors, ctx->mod->symbols,
+                                                    method->as.func_decl.inst,
+                                                    params->params[j].type_node);
+            }
+        }
+        Type* ret = resolve_type_node(ctx->reg, ctx->errors, ctx->mod->symbols,
+                                       method->as.func_decl.inst,
+                                       method->as.func_decl.return_type);
+        method->resolved_type = type_func(ctx->reg, param_types, param_count, ret);
+    }
+
+    check_func_body(ctx, method);
+    ctx->self_type = prev_self;
 }
 
 static void check_struct_methods(CheckContext* ctx, Node* struct_node) {
@@ -2595,40 +3012,110 @@ static void check_struct_methods(CheckContext* ctx, Node* struct_node) {
     Type* struct_type = (Type*)struct_node->resolved_type;
     if (!struct_type) return;
 
-    Type* self_ref = type_ref(ctx->reg, struct_type);
-    Type* prev_self = ctx->self_type;
-    ctx->self_type = self_ref;
-
     NodeList* methods = &struct_node->as.struct_decl.methods;
     for (size_t i = 0; i < methods->count; i++) {
         Node* method = methods->nodes[i];
         if (method->type != NODE_FUNC_DECL) continue;
         if (method->as.func_decl.type_params.count > 0) continue; // skip generic methods
+        if (method->as.func_decl.inst) continue; // instance methods are queued once reached
 
-        // resolve method type if not already done
-        if (!method->resolved_type) {
-            ParamList* params = &method->as.func_decl.params;
-            int param_count = (int)params->count;
-            Type** param_types = NULL;
-            if (param_count > 0) {
-                param_types = arena_alloc(ctx->arena, sizeof(Type*) * param_count);
-                for (int j = 0; j < param_count; j++) {
-                    param_types[j] = resolve_type_node(ctx->reg, ctx->errors,
-                                                        ctx->mod->symbols, params->params[j].type_node);
-                }
-            }
-            Type* ret = resolve_type_node(ctx->reg, ctx->errors,
-                                           ctx->mod->symbols, method->as.func_decl.return_type);
-            method->resolved_type = type_func(ctx->reg, param_types, param_count, ret);
+        check_method_body(ctx, method, struct_type);
+    }
+}
+
+// Check queued instance bodies; checking one may queue more.
+static void check_pending_bodies(CheckContext* ctx) {
+    PendingList* list = ctx->pending;
+    Module* prev_mod = ctx->mod;
+    for (size_t i = 0; i < list->count; i++) {
+        PendingBody item = list->items[i];
+        ctx->mod = item.mod;
+        if (item.self_type) {
+            check_method_body(ctx, item.func, item.self_type);
+        } else {
+            check_func_body(ctx, item.func);
         }
+    }
+    list->count = 0;
+    ctx->mod = prev_mod;
+}
 
-        check_func_body(ctx, method);
+static bool expr_has_call(Node* node) {
+    if (!node) return false;
+    switch (node->type) {
+    case NODE_CALL_EXPR:
+    case NODE_METHOD_CALL:
+        return true;
+    case NODE_BINARY_EXPR:
+        return expr_has_call(node->as.binary_expr.left) || expr_has_call(node->as.binary_expr.right);
+    case NODE_UNARY_EXPR:
+        return expr_has_call(node->as.unary_expr.operand);
+    case NODE_PAREN_EXPR:
+        return expr_has_call(node->as.paren_expr.inner);
+    case NODE_CAST_EXPR:
+        return expr_has_call(node->as.cast_expr.expr);
+    case NODE_FIELD_ACCESS:
+        return expr_has_call(node->as.field_access.object);
+    case NODE_INDEX_EXPR:
+        return expr_has_call(node->as.index_expr.object) || expr_has_call(node->as.index_expr.index);
+    case NODE_STRUCT_LITERAL: {
+        FieldInitList* inits = &node->as.struct_literal.fields;
+        for (size_t i = 0; i < inits->count; i++) {
+            if (expr_has_call(inits->inits[i].value)) return true;
+        }
+        return false;
     }
+    case NODE_ARRAY_LITERAL: {
+        NodeList* elements = &node->as.array_literal.elements;
+        for (size_t i = 0; i < elements->count; i++) {
+            if (expr_has_call(elements->nodes[i])) return true;
+        }
+        return false;
+    }
+    default:
+        return false;
+    }
+}
 
-    ctx->self_type = prev_self;
+// Fold integer and bool values of an initializer, element by element in
+// struct and array literals.
+static void fold_init_values(CheckContext* ctx, ConstEval* ev, Node** slot) {
+    Node* node = *slot;
+    if (node->type == NODE_STRUCT_LITERAL) {
+        FieldInitList* inits = &node->as.struct_literal.fields;
+        for (size_t i = 0; i < inits->count; i++) fold_init_values(ctx, ev, &inits->inits[i].value);
+        return;
+    }
+    if (node->type == NODE_ARRAY_LITERAL) {
+        NodeList* elements = &node->as.array_literal.elements;
+        for (size_t i = 0; i < elements->count; i++) fold_init_values(ctx, ev, &elements->nodes[i]);
+        return;
+    }
+    if (node->type == NODE_INTEGER_LITERAL || node->type == NODE_BOOL_LITERAL) return;
+    Type* type = node_type(ctx, node);
+    ConstValue v;
+    if (!type || !(type_is_integer(type) || type->kind == TYPE_BOOL)) return;
+    if (const_eval(ev, node, &v)) *slot = const_value_node(ctx->arena, &v, type, node->loc);
 }
 
-static void check_module_bodies(Arena* arena, Errors* errors, TypeRegistry* reg, Module* mod) {
+// Global initializers are emitted as C static initializers, which must be
+// constant. Calls to pure functions are evaluated here; any call left over
+// would need code to run before main.
+static void fold_global_init(CheckContext* ctx, Symbol* sym, Node** slot) {
+    ConstEval ev;
+    const_eval_init(&ev, ctx->reg, ctx->mod->symbols);
+    fold_init_values(ctx, &ev, slot);
+    const_eval_free(&ev);
+    if (expr_has_call(*slot)) {
+        errors_push_at(ctx->errors, SEVERITY_ERROR, (*slot)->loc,
+                       "initializer of '%.*s' is not a compile-time constant",
+                       (int)sym->name_size, sym->name);
+    }
+}
+
+static void check_module_bodies(Arena* arena, Errors* errors, TypeRegistry* reg,
+                                ScopeStack* scopes, ImplCache* impls, PendingList* pending,
+                                ReceiverList* receivers, Module* mod) {
     if (!mod->symbols) return;
 
     CheckContext ctx;
@@ -2636,7 +3123,11 @@ static void check_module_bodies(Arena* arena, Errors* errors, TypeRegistry* reg,
     ctx.errors = errors;
     ctx.reg = reg;
     ctx.mod = mod;
-    ctx.scope = NULL;
+    ctx.scopes = scopes;
+    ctx.impls = impls;
+    ctx.pending = pending;
+    ctx.receivers = receivers;
+    ctx.inst = NULL;
     ctx.return_type = NULL;
     ctx.self_type = NULL;
     ctx.loop_depth = 0;
@@ -2650,6 +3141,7 @@ static void check_module_bodies(Arena* arena, Errors* errors, TypeRegistry* reg,
         case SYMBOL_FUNC:
             if (sym->node->as.func_decl.type_params.count > 0) break;
             if (sym->node->as.func_decl.is_extern) break;
+            if (sym->node->as.func_decl.inst) break; // instances are checked from the queue
             check_func_body(&ctx, sym->node);
             break;
         case SYMBOL_STRUCT:
@@ -2665,6 +3157,7 @@ static void check_module_bodies(Arena* arena, Errors* errors, TypeRegistry* reg,
                     if (!sym->node->resolved_type) {
                         sym->node->resolved_type = init;
                     }
+                    fold_global_init(&ctx, sym, &sym->node->as.var_decl.value);
                 }
             }
             if (sym->kind == SYMBOL_CONST && sym->node->as.const_decl.value) {
@@ -2673,6 +3166,7 @@ static void check_module_bodies(Arena* arena, Errors* errors, TypeRegistry* reg,
                     if (!sym->node->resolved_type) {
                         sym->node->resolved_type = init;
                     }
+                    fold_global_init(&ctx, sym, &sym->node->as.const_decl.value);
                 }
             }
             break;
@@ -2680,6 +3174,8 @@ static void check_module_bodies(Arena* arena, Errors* errors, TypeRegistry* reg,
             break;
         }
     }
+
+    check_pending_bodies(&ctx);
 }
 
 void sema_analyze(Arena* arena, Errors* errors, ModuleGraph* graph) {
@@ -2708,7 +3204,17 @@ void sema_analyze(Arena* arena, Errors* errors, ModuleGraph* graph) {
     }
 
     // pass 4: check function bodies and expressions
+    // (one binding stack, reused by every function body)
+    ScopeStack scopes = {0};
+    ImplCache impls = {0};
+    PendingList pending = {0};
+    ReceiverList receivers = {0};
     for (Module* m = graph->first; m; m = m->next) {
-        check_module_bodies(arena, errors, &reg, m);
+        if (graph->main_bodies_only && m != graph->first) break;
+        check_module_bodies(arena, errors, &reg, &scopes, &impls, &pending, &receivers, m);
     }
+    free(receivers.receivers);
+    free(receivers.calls);
+    free(pending.items);
+    scope_stack_free(&scopes);
 }
@@ -5,11 +5,13 @@
 #include "error.h"
 #include "ast.h"
 #include "type.h"
+#include "intern.h"
 
 #include <stdbool.h>
 #include <stddef.h>
 
 typedef struct Module Module;
+typedef struct GenericInst GenericInst;
 
 typedef enum SymbolKind {
     SYMBOL_FUNC,
@@ -26,21 +28,37 @@ typedef struct Symbol {
     SymbolKind kind;
     char* name;
     size_t name_size;
+    Atom name_atom;
     bool is_export;
     Node* node;
     Module* source;
     Type* resolved_type;
 } Symbol;
 
+// Symbols are kept in insertion order through first/next; lookups go through
+// an open-addressed index keyed on the interned name once the table outgrows a
+// linear scan. A zeroed SymbolTable is a valid empty table.
 typedef struct SymbolTable {
     Symbol* first;
     Symbol* last;
     int count;
+    Symbol** slots;
+    size_t slot_capacity;
 } SymbolTable;
 
 typedef struct ModuleGraph ModuleGraph;
 
 void sema_analyze(Arena* arena, Errors* errors, ModuleGraph* graph);
 Symbol* symbol_find(SymbolTable* table, char* name, size_t name_size);
+Symbol* symbol_find_atom(SymbolTable* table, Atom name_atom);
+
+// What checking inst recorded for a node of its template: the node's type
+// and the generic instance it names, or NULL.
+Type* generic_inst_type(GenericInst* inst, Node* node);
+GenericInst* generic_inst_target(GenericInst* inst, Node* node);
+
+// Makes copy, a private copy of a template node, stand for original in the
+// side tables of every instance of the template.
+void generic_inst_alias(Arena* arena, GenericInst* inst, Node* copy, Node* original);
 
 #endif
@@ -1,5 +1,6 @@
 #include "type.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -26,6 +27,9 @@ void type_registry_init(TypeRegistry* reg, Arena* arena) {
     reg->type_float = make_primitive(arena, TYPE_FLOAT);
     reg->type_double = make_primitive(arena, TYPE_DOUBLE);
     reg->type_string = make_primitive(arena, TYPE_STRING);
+    reg->composite_slots = NULL;
+    reg->composite_capacity = 0;
+    reg->composite_count = 0;
 }
 
 Type* type_void(TypeRegistry* reg) { return reg->type_void; }
@@ -43,6 +47,26 @@ Type* type_float(TypeRegistry* reg) { return reg->type_float; }
 Type* type_double(TypeRegistry* reg) { return reg->type_double; }
 Type* type_string(TypeRegistry* reg) { return reg->type_string; }
 
+Type* type_primitive(TypeRegistry* reg, Atom name_atom) {
+    switch (name_atom) {
+    case ATOM_VOID:   return type_void(reg);
+    case ATOM_BOOL:   return type_bool(reg);
+    case ATOM_BYTE:   return type_byte(reg);
+    case ATOM_SHORT:  return type_short(reg);
+    case ATOM_USHORT: return type_ushort(reg);
+    case ATOM_INT:    return type_int(reg);
+    case ATOM_UINT:   return type_uint(reg);
+    case ATOM_LONG:   return type_long(reg);
+    case ATOM_ULONG:  return type_ulong(reg);
+    case ATOM_ISIZE:  return type_isize(reg);
+    case ATOM_USIZE:  return type_usize(reg);
+    case ATOM_FLOAT:  return type_float(reg);
+    case ATOM_DOUBLE: return type_double(reg);
+    case ATOM_STRING: return type_string(reg);
+    default:          return NULL;
+    }
+}
+
 Type* type_struct(TypeRegistry* reg, char* name, size_t name_size,
                   Module* module, FieldList* fields, NodeList* methods) {
     Type* t = arena_alloc(reg->arena, sizeof(Type));
@@ -67,48 +91,145 @@ Type* type_interface(TypeRegistry* reg, char* name, size_t name_size,
     return t;
 }
 
-Type* type_func(TypeRegistry* reg, Type** param_types, int param_count,
-                Type* return_type) {
+// ---------------------------------------------------------------------------
+// Composite type interning
+// ---------------------------------------------------------------------------
+
+static uint32_t hash_mix(uint32_t h, uintptr_t v) {
+    h ^= (uint32_t)v + 0x9e3779b9u + (h << 6) + (h >> 2);
+    h ^= (uint32_t)((uint64_t)v >> 32);
+    return h;
+}
+
+// children are already canonical, so hashing and comparing them by address is enough
+static uint32_t composite_hash(Type* key) {
+    uint32_t h = hash_mix(0, (uintptr_t)key->kind);
+    switch (key->kind) {
+    case TYPE_REF:
+        return hash_mix(h, (uintptr_t)key->as.ref_type.inner);
+    case TYPE_PTR:
+        return hash_mix(h, (uintptr_t)key->as.ptr_type.inner);
+    case TYPE_ARRAY:
+        h = hash_mix(h, (uintptr_t)key->as.array_type.element);
+        return hash_mix(h, (uintptr_t)key->as.array_type.size);
+    case TYPE_SLICE:
+        return hash_mix(h, (uintptr_t)key->as.slice_type.element);
+    case TYPE_FUNC:
+        h = hash_mix(h, (uintptr_t)key->as.func_type.return_type);
+        h = hash_mix(h, (uintptr_t)key->as.func_type.param_count);
+        for (int i = 0; i < key->as.func_type.param_count; i++) {
+            h = hash_mix(h, (uintptr_t)key->as.func_type.param_types[i]);
+        }
+        return h;
+    default:
+        return h;
+    }
+}
+
+static bool composite_same(Type* a, Type* b) {
+    if (a->kind != b->kind) return false;
+    switch (a->kind) {
+    case TYPE_REF:
+        return a->as.ref_type.inner == b->as.ref_type.inner;
+    case TYPE_PTR:
+        return a->as.ptr_type.inner == b->as.ptr_type.inner;
+    case TYPE_ARRAY:
+        return a->as.array_type.element == b->as.array_type.element
+            && a->as.array_type.size == b->as.array_type.size;
+    case TYPE_SLICE:
+        return a->as.slice_type.element == b->as.slice_type.element;
+    case TYPE_FUNC:
+        if (a->as.func_type.return_type != b->as.func_type.return_type) return false;
+        if (a->as.func_type.param_count != b->as.func_type.param_count) return false;
+        for (int i = 0; i < a->as.func_type.param_count; i++) {
+            if (a->as.func_type.param_types[i] != b->as.func_type.param_types[i]) return false;
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void composite_put(Type** slots, size_t capacity, Type* t) {
+    size_t mask = capacity - 1;
+    size_t i = composite_hash(t) & mask;
+    while (slots[i]) i = (i + 1) & mask;
+    slots[i] = t;
+}
+
+static void composite_grow(TypeRegistry* reg) {
+    size_t capacity = reg->composite_capacity ? reg->composite_capacity * 2 : 256;
+    Type** slots = arena_alloc(reg->arena, sizeof(Type*) * capacity);
+    memset(slots, 0, sizeof(Type*) * capacity);
+    for (size_t i = 0; i < reg->composite_capacity; i++) {
+        if (reg->composite_slots[i]) composite_put(slots, capacity, reg->composite_slots[i]);
+    }
+    reg->composite_slots = slots;
+    reg->composite_capacity = capacity;
+}
+
+// Return the canonical type equal to key, allocating it on first sight.
+static Type* composite_intern(TypeRegistry* reg, Type* key) {
+    if (reg->composite_capacity) {
+        size_t mask = reg->composite_capacity - 1;
+        for (size_t i = composite_hash(key) & mask; reg->composite_slots[i]; i = (i + 1) & mask) {
+            if (composite_same(reg->composite_slots[i], key)) return reg->composite_slots[i];
+        }
+    }
+
+    // keep the load factor under 1/2
+    if ((reg->composite_count + 1) * 2 > reg->composite_capacity) {
+        composite_grow(reg);
+    }
     Type* t = arena_alloc(reg->arena, sizeof(Type));
-    memset(t, 0, sizeof(Type));
-    t->kind = TYPE_FUNC;
-    t->as.func_type.param_types = param_types;
-    t->as.func_type.param_count = param_count;
-    t->as.func_type.return_type = return_type;
+    *t = *key;
+    composite_put(reg->composite_slots, reg->composite_capacity, t);
+    reg->composite_count++;
     return t;
 }
 
+Type* type_func(TypeRegistry* reg, Type** param_types, int param_count,
+                Type* return_type) {
+    Type key;
+    memset(&key, 0, sizeof(Type));
+    key.kind = TYPE_FUNC;
+    key.as.func_type.param_types = param_types;
+    key.as.func_type.param_count = param_count;
+    key.as.func_type.return_type = return_type;
+    return composite_intern(reg, &key);
+}
+
 Type* type_ref(TypeRegistry* reg, Type* inner) {
-    Type* t = arena_alloc(reg->arena, sizeof(Type));
-    memset(t, 0, sizeof(Type));
-    t->kind = TYPE_REF;
-    t->as.ref_type.inner = inner;
-    return t;
+    Type key;
+    memset(&key, 0, sizeof(Type));
+    key.kind = TYPE_REF;
+    key.as.ref_type.inner = inner;
+    return composite_intern(reg, &key);
 }
 
 Type* type_ptr(TypeRegistry* reg, Type* inner) {
-    Type* t = arena_alloc(reg->arena, sizeof(Type));
-    memset(t, 0, sizeof(Type));
-    t->kind = TYPE_PTR;
-    t->as.ptr_type.inner = inner;
-    return t;
+    Type key;
+    memset(&key, 0, sizeof(Type));
+    key.kind = TYPE_PTR;
+    key.as.ptr_type.inner = inner;
+    return composite_intern(reg, &key);
 }
 
 Type* type_array(TypeRegistry* reg, Type* element, int size) {
-    Type* t = arena_alloc(reg->arena, sizeof(Type));
-    memset(t, 0, sizeof(Type));
-    t->kind = TYPE_ARRAY;
-    t->as.array_type.element = element;
-    t->as.array_type.size = size;
-    return t;
+    Type key;
+    memset(&key, 0, sizeof(Type));
+    key.kind = TYPE_ARRAY;
+    key.as.array_type.element = element;
+    key.as.array_type.size = size;
+    return composite_intern(reg, &key);
 }
 
 Type* type_slice(TypeRegistry* reg, Type* element) {
-    Type* t = arena_alloc(reg->arena, sizeof(Type));
-    memset(t, 0, sizeof(Type));
-    t->kind = TYPE_SLICE;
-    t->as.slice_type.element = element;
-    return t;
+    Type key;
+    memset(&key, 0, sizeof(Type));
+    key.kind = TYPE_SLICE;
+    key.as.slice_type.element = element;
+    return composite_intern(reg, &key);
 }
 
 Type* type_enum(TypeRegistry* reg, char* name, size_t name_size,
@@ -194,34 +315,25 @@ const char* type_name(Type* type) {
     return buf;
 }
 
-bool type_equals(Type* a, Type* b) {
-    if (a == b) return true;
-    if (!a || !b) return false;
-    if (a->kind != b->kind) return false;
-
-    switch (a->kind) {
-    case TYPE_REF:
-        return type_equals(a->as.ref_type.inner, b->as.ref_type.inner);
-    case TYPE_PTR:
-        return type_equals(a->as.ptr_type.inner, b->as.ptr_type.inner);
-    case TYPE_FUNC: {
-        if (a->as.func_type.param_count != b->as.func_type.param_count) return false;
-        if (!type_equals(a->as.func_type.return_type, b->as.func_type.return_type)) return false;
-        for (int i = 0; i < a->as.func_type.param_count; i++) {
-            if (!type_equals(a->as.func_type.param_types[i], b->as.func_type.param_types[i]))
-                return false;
-        }
-        return true;
-    }
-    case TYPE_ARRAY:
-        return type_equals(a->as.array_type.element, b->as.array_type.element)
-            && a->as.array_type.size == b->as.array_type.size;
-    case TYPE_SLICE:
-        return type_equals(a->as.slice_type.element, b->as.slice_type.element);
-    default:
-        // primitives, structs, interfaces: pointer equality already checked above
-        return false;
+// Name of a type as it appears inside mangled generic names. Types are
+// canonical, so the rendering is cached on the type after the first call.
+char* type_mangle_name(Arena* arena, Type* type, size_t* out_size) {
+    if (!type->mangle) {
+        char buf[256];
+        int len = type_name_write(type, buf, sizeof(buf));
+        if (len >= (int)sizeof(buf)) len = (int)sizeof(buf) - 1;
+        type->mangle = arena_alloc(arena, (size_t)len + 1);
+        memcpy(type->mangle, buf, (size_t)len + 1);
+        type->mangle_size = (size_t)len;
     }
+    *out_size = type->mangle_size;
+    return type->mangle;
+}
+
+// Types are canonical: primitives are registry singletons, structs, interfaces
+// and enums are nominal, and composites are hash-consed by the registry.
+bool type_equals(Type* a, Type* b) {
+    return a == b;
 }
 
 bool type_is_integer(Type* type) {
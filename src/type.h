@@ -37,6 +37,8 @@ typedef enum TypeKind {
 
 struct Type {
     TypeKind kind;
+    char* mangle;        // cached type_mangle_name result
+    size_t mangle_size;
     union {
         struct {
             char* name;
@@ -44,6 +46,8 @@ struct Type {
             Module* module;
             FieldList* fields;
             NodeList* methods;
+            Node** method_slots; // methods indexed by name atom, built in pass 3
+            size_t method_slot_capacity;
         } struct_type;
 
         struct {
@@ -100,6 +104,12 @@ typedef struct TypeRegistry {
     Type* type_float;
     Type* type_double;
     Type* type_string;
+
+    // composite types (ref, ptr, array, slice, func) are hash-consed here so
+    // each distinct type exists once and type_equals is pointer equality
+    Type** composite_slots;
+    size_t composite_capacity;
+    size_t composite_count;
 } TypeRegistry;
 
 void type_registry_init(TypeRegistry* reg, Arena* arena);
@@ -118,6 +128,8 @@ Type* type_usize(TypeRegistry* reg);
 Type* type_float(TypeRegistry* reg);
 Type* type_double(TypeRegistry* reg);
 Type* type_string(TypeRegistry* reg);
+// Built-in type named by a type name, or NULL.
+Type* type_primitive(TypeRegistry* reg, Atom name_atom);
 
 Type* type_struct(TypeRegistry* reg, char* name, size_t name_size,
                   Module* module, FieldList* fields, NodeList* methods);
@@ -133,6 +145,7 @@ Type* type_enum(TypeRegistry* reg, char* name, size_t name_size,
                 Module* module, EnumVariantList* variants);
 
 const char* type_name(Type* type);
+char* type_mangle_name(Arena* arena, Type* type, size_t* out_size);
 bool type_equals(Type* a, Type* b);
 bool type_is_numeric(Type* type);
 bool type_is_integer(Type* type);
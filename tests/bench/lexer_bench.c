@@ -0,0 +1,149 @@
+// Lexer micro-benchmark: tokenizes a synthetic .anc corpus and reports MB/s for
+// each supported scan level, checking that all of them produce identical tokens.
+//
+//   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release
+//   cmake --build build --target lexer_bench
+//   bin/lexer_bench [corpus_mb] [iterations]
+
+#include "../../src/arena.h"
+#include "../../src/error.h"
+#include "../../src/lexer.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// One chunk of representative source; %d is replaced with a running counter so
+// identifiers don't all intern to the same atom.
+static const char* chunk_template =
+    "# Point utilities, generated chunk %d\n"
+    "# ---------------------------------------------------------------------------------------------\n"
+    "struct Point%d\n"
+    "    x: int\n"
+    "    y: int\n"
+    "\n"
+    "    func length_squared(self: &Point%d) int\n"
+    "        return self.x * self.x + self.y * self.y\n"
+    "    end\n"
+    "end\n"
+    "\n"
+    "export func sum_points_%d(points: []Point%d, limit: usize) int\n"
+    "    var total: int = 0\n"
+    "    for i in 0 until limit step 1\n"
+    "        if points[i].x >= 0 and points[i].y <= 1024 then_value_%d\n"
+    "            total += points[i].length_squared()\n"
+    "        elseif not (points[i].x == 0)\n"
+    "            total -= 1\n"
+    "        else\n"
+    "            continue\n"
+    "        end\n"
+    "    end\n"
+    "    var label: string = \"sum of points in chunk %d, computed with a loop\"\n"
+    "    var table: string = \"00 01 02 03 04 05 06 07 08 09 0a 0b 0c 0d 0e 0f 10 11 12 13 14 15 16 17\n"
+    "18 19 1a 1b 1c 1d 1e 1f 20 21 22 23 24 25 26 27 28 29 2a 2b 2c 2d 2e 2f\"\n"
+    "    var ratio: double = 3.25f\n"
+    "    return total\n"
+    "end\n"
+    "\n";
+
+static char* corpus_build(size_t target_size, size_t* out_size) {
+    size_t capacity = target_size + 4096;
+    char* buffer = malloc(capacity);
+    size_t size = 0;
+
+    for (int i = 0; size < target_size; i++) {
+        int written = snprintf(buffer + size, capacity - size, chunk_template, i, i, i, i, i, i, i);
+        if (written < 0 || (size_t)written >= capacity - size) {
+            break;
+        }
+        size += (size_t)written;
+    }
+
+    buffer[size] = '\0';
+    *out_size = size;
+    return buffer;
+}
+
+static bool tokens_equal(Tokens* a, Tokens* b) {
+    if (a->count != b->count || a->line_count != b->line_count) return false;
+    for (size_t i = 0; i < a->count; i++) {
+        Token* x = &a->tokens[i];
+        Token* y = &b->tokens[i];
+        if (x->type != y->type || x->offset != y->offset || x->size != y->size) {
+            fprintf(stderr, "Error: token %zu differs (offset %u vs %u).\n", i, x->offset, y->offset);
+            return false;
+        }
+    }
+    return memcmp(a->line_starts, b->line_starts, a->line_count * sizeof(uint32_t)) == 0;
+}
+
+int main(int argc, char** argv) {
+    static const char* level_names[] = {
+        [LEXER_SCAN_SCALAR] = "scalar",
+        [LEXER_SCAN_SSE2] = "sse2",
+        [LEXER_SCAN_AVX2] = "avx2",
+    };
+
+    size_t corpus_mb = argc >= 2 ? (size_t)strtoul(argv[1], NULL, 10) : 32;
+    int iterations = argc >= 3 ? atoi(argv[2]) : 5;
+    if (corpus_mb == 0) corpus_mb = 1;
+    if (iterations <= 0) iterations = 1;
+
+    size_t corpus_size;
+    char* corpus = corpus_build(corpus_mb * 1024 * 1024, &corpus_size);
+    double mb = (double)corpus_size / (1024.0 * 1024.0);
+
+    // Scalar tokens are the reference every SIMD level must reproduce exactly.
+    Arena reference_arena;
+    arena_init(&reference_arena, 16 * 1024 * 1024);
+    Tokens reference = {0};
+    int status = EXIT_SUCCESS;
+
+    LexerScanLevel supported = lexer_scan_detect();
+    for (int level = LEXER_SCAN_SCALAR; level <= (int)supported; level++) {
+        lexer_scan_select((LexerScanLevel)level);
+        double best = 0.0;
+
+        for (int i = 0; i < iterations; i++) {
+            bool keep = level == LEXER_SCAN_SCALAR && i == 0;
+            Arena arena;
+            arena_init(&arena, 16 * 1024 * 1024);
+            Arena* target = keep ? &reference_arena : &arena;
+
+            Errors errors;
+            errors_init(target, &errors);
+
+            Tokens tokens;
+            clock_t start = clock();
+            lexer_tokenize(target, &tokens, &errors, corpus, corpus_size);
+            clock_t end = clock();
+
+            double seconds = (double)(end - start) / CLOCKS_PER_SEC;
+            if (i == 0 || seconds < best) best = seconds;
+
+            if (errors.count > 0) {
+                fprintf(stderr, "Error: corpus produced %zu lexer errors.\n", errors.count);
+                status = EXIT_FAILURE;
+            }
+            if (keep) {
+                reference = tokens;
+            } else if (!tokens_equal(&reference, &tokens)) {
+                fprintf(stderr, "Error: %s tokens differ from scalar.\n", level_names[level]);
+                status = EXIT_FAILURE;
+            }
+
+            arena_free(&arena);
+            if (status != EXIT_SUCCESS) break;
+        }
+
+        if (status != EXIT_SUCCESS) break;
+        printf("%-7s corpus %.1f MB, %zu tokens, best of %d: %.3f s, %.1f MB/s\n",
+               level_names[level], mb, reference.count, iterations, best, best > 0.0 ? mb / best : 0.0);
+    }
+
+    arena_free(&reference_arena);
+    free(corpus);
+    return status;
+}
@@ -1,4 +1,6 @@
 import argparse
+import re
+import shutil
 import subprocess
 import sys
 from pathlib import Path
@@ -47,6 +49,46 @@ def run_test(ancc, path):
     return "SKIP", f"unknown directive '{kind}' in {path.name}"
 
 
+# Build reports over the package tests: package, --report value, and patterns
+# that must each match a line of stdout. Object sizes depend on the toolchain,
+# so rows are only matched up to their C bytes column.
+REPORT_TESTS = [
+    (
+        "generic",
+        "generics,size",
+        [
+            r"^main: 5 generic instances \(2 structs, 3 functions, 0 methods\), 3 bodies checked",
+            r"^  max +3 +\d+",
+            r"^    max\[int\] +\d+",
+            r"^    max\[double\] +\d+",
+            r"^    max\[float\] +\d+",
+            r"^  List +1 +0",
+            r"^    Pair\[int, float\] +0",
+            r"^size: 4 functions, \d+ C bytes",
+            r"^ +\d+( +\d+)?  anc__generic__main__max__int$",
+        ],
+    ),
+]
+
+
+def run_report_test(ancc, package, reports, patterns):
+    package_dir = Path(__file__).parent / package
+    result = subprocess.run(
+        [ancc, "build", str(package_dir), f"--report={reports}"],
+        capture_output=True,
+        text=True,
+        timeout=60,
+    )
+    shutil.rmtree(package_dir / "build", ignore_errors=True)
+
+    if result.returncode != 0:
+        return "FAIL", f"build failed: {result.stderr.strip()}"
+    for pattern in patterns:
+        if not re.search(pattern, result.stdout, re.MULTILINE):
+            return "FAIL", f"no line matching '{pattern}' in:\n{result.stdout}"
+    return "PASS", None
+
+
 def main():
     parser = argparse.ArgumentParser()
     parser.add_argument("--filter", default="")
@@ -74,6 +116,18 @@ def main():
             print(f"  FAIL  {name}: {msg}")
             failed += 1
 
+    for package, reports, patterns in REPORT_TESTS:
+        name = f"report_{package}"
+        if args.filter not in name:
+            continue
+        status, msg = run_report_test(args.ancc, package, reports, patterns)
+        if status == "PASS":
+            print(f"  PASS  {name}")
+            passed += 1
+        else:
+            print(f"  FAIL  {name}: {msg}")
+            failed += 1
+
     print(f"\n{passed} passed, {failed} failed, {skipped} skipped")
     sys.exit(1 if failed else 0)
 
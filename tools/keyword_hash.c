@@ -0,0 +1,116 @@
+// Generates the keyword perfect-hash table in src/lexer.c.
+//
+// Searches for multipliers that send every keyword to its own slot under
+//     (size + b*s[0] + c*s[1] + d*s[size-1]) & (slots - 1)
+// with as few slots as possible, then prints the block between the
+// "generated by tools/keyword_hash.c" markers in src/lexer.c. After adding
+// a keyword to the list below, rebuild and paste the output over that block:
+//
+//   cmake --build build --target keyword_hash
+//   bin/keyword_hash
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct KeywordSpec {
+    const char* name;
+    const char* token;
+} KeywordSpec;
+
+static const KeywordSpec keywords[] = {
+    { "and", "TOKEN_AND" },
+    { "as", "TOKEN_AS" },
+    { "break", "TOKEN_BREAK" },
+    { "case", "TOKEN_CASE" },
+    { "const", "TOKEN_CONST" },
+    { "continue", "TOKEN_CONTINUE" },
+    { "else", "TOKEN_ELSE" },
+    { "elseif", "TOKEN_ELSEIF" },
+    { "end", "TOKEN_END" },
+    { "enum", "TOKEN_ENUM" },
+    { "export", "TOKEN_EXPORT" },
+    { "extern", "TOKEN_EXTERN" },
+    { "false", "TOKEN_FALSE" },
+    { "for", "TOKEN_FOR" },
+    { "from", "TOKEN_FROM" },
+    { "func", "TOKEN_FUNC" },
+    { "if", "TOKEN_IF" },
+    { "import", "TOKEN_IMPORT" },
+    { "in", "TOKEN_IN" },
+    { "interface", "TOKEN_INTERFACE" },
+    { "match", "TOKEN_MATCH" },
+    { "not", "TOKEN_NOT" },
+    { "null", "TOKEN_NULL" },
+    { "or", "TOKEN_OR" },
+    { "return", "TOKEN_RETURN" },
+    { "self", "TOKEN_SELF" },
+    { "sizeof", "TOKEN_SIZEOF" },
+    { "step", "TOKEN_STEP" },
+    { "struct", "TOKEN_STRUCT" },
+    { "true", "TOKEN_TRUE" },
+    { "until", "TOKEN_UNTIL" },
+    { "var", "TOKEN_VAR" },
+    { "while", "TOKEN_WHILE" },
+    { "with", "TOKEN_WITH" },
+};
+
+#define KEYWORD_COUNT (sizeof(keywords) / sizeof(keywords[0]))
+#define MAX_MULTIPLIER 63
+
+static unsigned slot_of(const char* name, unsigned b, unsigned c, unsigned d, unsigned slots) {
+    const unsigned char* s = (const unsigned char*)name;
+    size_t size = strlen(name);
+    return (unsigned)(size + b * s[0] + c * s[1] + d * s[size - 1]) & (slots - 1);
+}
+
+static bool is_perfect(unsigned b, unsigned c, unsigned d, unsigned slots, int* table) {
+    for (unsigned i = 0; i < slots; i++) table[i] = -1;
+    for (size_t k = 0; k < KEYWORD_COUNT; k++) {
+        unsigned slot = slot_of(keywords[k].name, b, c, d, slots);
+        if (table[slot] >= 0) return false;
+        table[slot] = (int)k;
+    }
+    return true;
+}
+
+int main(void) {
+    int table[1024];
+    size_t min_size = 1000;
+    size_t max_size = 0;
+    for (size_t k = 0; k < KEYWORD_COUNT; k++) {
+        size_t size = strlen(keywords[k].name);
+        if (size < min_size) min_size = size;
+        if (size > max_size) max_size = size;
+    }
+
+    unsigned slots = 1;
+    while (slots < KEYWORD_COUNT) slots *= 2;
+    for (; slots <= 1024; slots *= 2) {
+        for (unsigned d = 1; d <= MAX_MULTIPLIER; d++) {
+            for (unsigned c = 1; c <= MAX_MULTIPLIER; c++) {
+                for (unsigned b = 1; b <= MAX_MULTIPLIER; b++) {
+                    if (!is_perfect(b, c, d, slots, table)) continue;
+
+                    printf("// generated by tools/keyword_hash.c: begin\n");
+                    printf("#define KEYWORD_SLOTS %u\n", slots);
+                    printf("#define KEYWORD_MIN_SIZE %zu\n", min_size);
+                    printf("#define KEYWORD_MAX_SIZE %zu\n", max_size);
+                    printf("#define KEYWORD_HASH(s, size) ((size) + %u * (s)[0] + %u * (s)[1] + %u * (s)[(size) - 1])\n\n",
+                           b, c, d);
+                    printf("static const Keyword keyword_table[KEYWORD_SLOTS] = {\n");
+                    for (unsigned i = 0; i < slots; i++) {
+                        if (table[i] < 0) continue;
+                        const KeywordSpec* k = &keywords[table[i]];
+                        printf("    [%u] = { \"%s\", %zu, %s },\n", i, k->name, strlen(k->name), k->token);
+                    }
+                    printf("};\n");
+                    printf("// generated by tools/keyword_hash.c: end\n");
+                    return 0;
+                }
+            }
+        }
+    }
+    fprintf(stderr, "no perfect hash found\n");
+    return 1;
+}